@@ -0,0 +1,195 @@
+#pragma once
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+#include "hpc/simd.hpp"
+
+#if HPC_HAVE_NEON && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace hpc {
+
+/// Instruction-set levels the dispatched kernels are built for.
+enum class Isa { scalar, avx2, avx512, neon };
+
+inline const char* isa_name(Isa i) {
+    switch (i) {
+        case Isa::avx2:   return "avx2";
+        case Isa::avx512: return "avx512";
+        case Isa::neon:   return "neon";
+        default:          return "scalar";
+    }
+}
+
+/// Parse an isa_name() string; returns false for anything else.
+inline bool parse_isa(const char* s, Isa& out) {
+    for (Isa i : {Isa::scalar, Isa::avx2, Isa::avx512, Isa::neon}) {
+        if (std::strcmp(s, isa_name(i)) == 0) { out = i; return true; }
+    }
+    return false;
+}
+
+/// True when this build contains kernels for i.
+constexpr bool isa_compiled(Isa i) {
+    return i == Isa::scalar
+        || (i == Isa::avx2 && HPC_HAVE_AVX2)
+        || (i == Isa::avx512 && HPC_HAVE_AVX512)
+        || (i == Isa::neon && HPC_HAVE_NEON);
+}
+
+/// True when the running CPU and OS can execute i: cpuid/xgetbv on x86
+/// (__builtin_cpu_supports checks both), AT_HWCAP on aarch64 Linux.
+inline bool cpu_supports(Isa i) {
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    __builtin_cpu_init(); // may run before the runtime's own constructors
+#endif
+    switch (i) {
+        case Isa::scalar: return true;
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+        case Isa::avx2:   return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case Isa::avx512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2")
+                              && __builtin_cpu_supports("fma");
+#elif defined(_MSC_VER) && defined(_M_X64)
+        case Isa::avx2:
+        case Isa::avx512: {
+            int r[4];
+            __cpuid(r, 1);
+            const bool osxsave = (r[2] >> 27) & 1, fma = (r[2] >> 12) & 1;
+            if (!osxsave || !fma) return false;
+            const unsigned long long xcr0 = _xgetbv(0);
+            __cpuidex(r, 7, 0);
+            const bool avx2 = ((r[1] >> 5) & 1) && (xcr0 & 0x6) == 0x6;
+            if (i == Isa::avx2) return avx2;
+            return avx2 && ((r[1] >> 16) & 1) && (xcr0 & 0xe6) == 0xe6;
+        }
+#endif
+#if HPC_HAVE_NEON && defined(__linux__) && defined(HWCAP_ASIMD)
+        case Isa::neon:   return (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#elif HPC_HAVE_NEON
+        case Isa::neon:   return true; // Advanced SIMD is mandatory on AArch64
+#endif
+        default:          return false;
+    }
+}
+
+/// True when i is both compiled in and runnable here.
+inline bool isa_usable(Isa i) { return isa_compiled(i) && cpu_supports(i); }
+
+/// Widest usable level.
+inline Isa best_isa() {
+    for (Isa i : {Isa::avx512, Isa::avx2, Isa::neon}) {
+        if (isa_usable(i)) return i;
+    }
+    return Isa::scalar;
+}
+
+namespace detail {
+
+inline Isa initial_isa() {
+    Isa i = Isa::scalar;
+    if (const char* e = std::getenv("HPC_ISA")) {
+        if (parse_isa(e, i) && isa_usable(i)) return i;
+    }
+    return best_isa();
+}
+
+inline std::atomic<Isa>& isa_slot() {
+    static std::atomic<Isa> slot{initial_isa()};
+    return slot;
+}
+
+} // namespace detail
+
+/// ISA the dispatched kernels (GEMM micro-kernel, Kahan lanes, scan blocks)
+/// run with. Chosen on first use: $HPC_ISA if set and usable, else best_isa().
+inline Isa active_isa() { return detail::isa_slot().load(std::memory_order_relaxed); }
+
+/// Override the selection (benchmarks, tests). Returns false and keeps the
+/// current ISA when i is not usable on this build/CPU.
+inline bool set_active_isa(Isa i) {
+    if (!isa_usable(i)) return false;
+    detail::isa_slot().store(i, std::memory_order_relaxed);
+    return true;
+}
+
+/// Call f(std::integral_constant<Isa, active_isa()>{}); f instantiates the
+/// kernels of that level. Only compiled-in levels are instantiated.
+template <typename F>
+decltype(auto) isa_dispatch(F&& f) {
+    switch (active_isa()) {
+#if HPC_HAVE_AVX512
+        case Isa::avx512: return f(std::integral_constant<Isa, Isa::avx512>{});
+#endif
+#if HPC_HAVE_AVX2
+        case Isa::avx2:   return f(std::integral_constant<Isa, Isa::avx2>{});
+#endif
+#if HPC_HAVE_NEON
+        case Isa::neon:   return f(std::integral_constant<Isa, Isa::neon>{});
+#endif
+        default:          return f(std::integral_constant<Isa, Isa::scalar>{});
+    }
+}
+
+namespace detail {
+
+/// One namespace per compiled level, named like the Isa enumerator. The
+/// kernels in hpc/isa/*.inl are instantiated into each of them (see
+/// hpc/isa/foreach.inl) and find their vector ops here as ops<T>, plus
+/// half_ops<T> for shapes narrower than one ops<T> register, and
+/// scan_ops<T> (float, double and 4/8-byte integer lanes) for the scans.
+template <typename T, typename F32, typename F64>
+using float_ops = std::conditional_t<std::is_same<T, float>::value, F32, F64>;
+
+/// Lane ops for any arithmetic T: other integer widths run scalar.
+template <typename T, typename F32, typename F64, typename I32, typename I64>
+using lane_ops = std::conditional_t<
+    std::is_same<T, float>::value, F32,
+    std::conditional_t<std::is_same<T, double>::value, F64,
+    std::conditional_t<std::is_integral<T>::value && !std::is_same<T, bool>::value && sizeof(T) == 4, I32,
+    std::conditional_t<std::is_integral<T>::value && !std::is_same<T, bool>::value && sizeof(T) == 8, I64,
+    simd::scalar_ops<T>>>>>;
+
+namespace scalar {
+constexpr Isa isa = Isa::scalar;
+template <typename T> using ops = simd::scalar_ops<T>;
+template <typename T> using half_ops = simd::scalar_ops<T>;
+template <typename T> using scan_ops = simd::scalar_ops<T>;
+}
+
+#if HPC_HAVE_AVX2
+namespace avx2 {
+constexpr Isa isa = Isa::avx2;
+template <typename T> using ops = float_ops<T, simd::avx2_f32, simd::avx2_f64>;
+template <typename T> using half_ops = simd::scalar_ops<T>;
+template <typename T> using scan_ops = lane_ops<T, simd::avx2_f32, simd::avx2_f64, simd::avx2_i32<T>, simd::avx2_i64<T>>;
+}
+#endif
+
+#if HPC_HAVE_AVX512
+namespace avx512 {
+constexpr Isa isa = Isa::avx512;
+template <typename T> using ops = float_ops<T, simd::avx512_f32, simd::avx512_f64>;
+template <typename T> using half_ops = float_ops<T, simd::avx2_f32, simd::avx2_f64>;
+template <typename T> using scan_ops = lane_ops<T, simd::avx512_f32, simd::avx512_f64, simd::avx512_i32<T>, simd::avx512_i64<T>>;
+}
+#endif
+
+#if HPC_HAVE_NEON
+namespace neon {
+constexpr Isa isa = Isa::neon;
+template <typename T> using ops = float_ops<T, simd::neon_f32, simd::neon_f64>;
+template <typename T> using half_ops = simd::scalar_ops<T>;
+template <typename T> using scan_ops = lane_ops<T, simd::neon_f32, simd::neon_f64, simd::neon_i32<T>, simd::neon_i64<T>>;
+}
+#endif
+
+} // namespace detail
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace hpc {
+
+/// Element-wise GEMM epilogues, applied to C(i,j) = alpha*AB + beta*C once
+/// the last K panel of a tile is done, before the tile is stored: each is a
+/// functor `T operator()(T v, i, j)` on logical (row, column) of C. The
+/// packed micro-kernels have vector forms of the built-ins below (see
+/// hpc/isa/epilogue.inl); any other functor runs lane by lane on the
+/// register tile, which still saves the extra pass over C.
+namespace epilogue {
+
+/// No epilogue.
+struct none {
+    template <typename T>
+    T operator()(T v, std::size_t, std::size_t) const { return v; }
+};
+
+/// v + bias[j]: one bias per output column (N entries).
+template <typename T>
+struct bias {
+    const T* b = nullptr;
+
+    T operator()(T v, std::size_t, std::size_t j) const { return v + b[j]; }
+};
+
+/// max(v, 0).
+struct relu {
+    template <typename T>
+    T operator()(T v, std::size_t, std::size_t) const { return v > T(0) ? v : T(0); }
+};
+
+namespace detail {
+
+/// tanh for float as a 13/6 rational minimax on [-7.9, 7.9] (a few ulp):
+/// no libm call, so a loop over a register's lanes vectorizes.
+inline float tanh_rational(float x) {
+    const float c = 7.90531110763549805f;
+    x = x < -c ? -c : x > c ? c : x;
+    const float x2 = x * x;
+    float p = -2.76076847742355e-16f;
+    p = p * x2 + 2.00018790482477e-13f;
+    p = p * x2 - 8.60467152213735e-11f;
+    p = p * x2 + 5.12229709037114e-08f;
+    p = p * x2 + 1.48572235717979e-05f;
+    p = p * x2 + 6.37261928875436e-04f;
+    p = p * x2 + 4.89352455891786e-03f;
+    float q = 1.19825839466702e-06f;
+    q = q * x2 + 1.18534705686654e-04f;
+    q = q * x2 + 2.26843463243900e-03f;
+    q = q * x2 + 4.89352518554385e-03f;
+    return x * p / q;
+}
+
+} // namespace detail
+
+/// GELU, tanh form: 0.5 v (1 + tanh(sqrt(2/pi) (v + 0.044715 v^3))).
+/// float uses detail::tanh_rational, double std::tanh.
+struct gelu {
+    template <typename T>
+    T operator()(T v, std::size_t, std::size_t) const {
+        const T u = T(0.7978845608028654) * (v + T(0.044715) * v * v * v);
+        if constexpr (std::is_same<T, float>::value)
+            return 0.5f * v * (1.0f + detail::tanh_rational(u));
+        else
+            return T(0.5) * v * (T(1) + std::tanh(u));
+    }
+};
+
+/// v + R(i,j) for a row-major residual R with leading dimension ld.
+template <typename T>
+struct residual {
+    const T* r = nullptr;
+    std::size_t ld = 0;
+
+    T operator()(T v, std::size_t i, std::size_t j) const { return v + r[i * ld + j]; }
+};
+
+/// Apply E... left to right.
+template <typename... E>
+struct chain {
+    std::tuple<E...> parts;
+
+    template <typename T>
+    T operator()(T v, std::size_t i, std::size_t j) const {
+        return apply(v, i, j, std::index_sequence_for<E...>{});
+    }
+
+private:
+    template <typename T, std::size_t... I>
+    T apply(T v, [[maybe_unused]] std::size_t i, [[maybe_unused]] std::size_t j,
+            std::index_sequence<I...>) const {
+        ((v = std::get<I>(parts)(v, i, j)), ...);
+        return v;
+    }
+};
+
+template <typename... E>
+chain<E...> make_chain(E... e) { return chain<E...>{std::tuple<E...>(std::move(e)...)}; }
+
+} // namespace epilogue
+
+}
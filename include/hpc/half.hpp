@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace hpc {
+
+namespace detail {
+
+inline std::uint32_t float_bits(float f) {
+    std::uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+inline float bits_float(std::uint32_t u) {
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+/// Round to nearest even; NaNs stay (quiet) NaNs.
+inline std::uint16_t float_to_bf16_bits(float f) {
+    const std::uint32_t u = float_bits(f);
+    if ((u & 0x7fffffffu) > 0x7f800000u) return static_cast<std::uint16_t>((u >> 16) | 0x40u);
+    return static_cast<std::uint16_t>((u + 0x7fffu + ((u >> 16) & 1u)) >> 16);
+}
+
+inline float bf16_bits_to_float(std::uint16_t h) { return bits_float(std::uint32_t(h) << 16); }
+
+/// IEEE binary16, round to nearest even, overflow to inf, subnormals kept
+/// (F. Giesen's branch-light conversions; needs IEEE float arithmetic, i.e.
+/// no flush-to-zero).
+inline std::uint16_t float_to_fp16_bits(float f) {
+    const std::uint32_t f32_inf = 255u << 23;
+    const std::uint32_t f16_max = (127u + 16u) << 23;        // 2^16: rounds to inf
+    const float denorm_magic = bits_float(((127u - 15u) + (23u - 10u) + 1u) << 23);
+
+    std::uint32_t u = float_bits(f);
+    const std::uint32_t sign = u & 0x80000000u;
+    u ^= sign;
+
+    std::uint32_t o;
+    if (u >= f16_max) {
+        o = u > f32_inf ? 0x7e00u : 0x7c00u;
+    } else if (u < (113u << 23)) {
+        // Subnormal or zero: the FPU rounds the mantissa into place.
+        o = float_bits(bits_float(u) + denorm_magic) - float_bits(denorm_magic);
+    } else {
+        const std::uint32_t odd = (u >> 13) & 1u;
+        u += (std::uint32_t(15 - 127) << 23) + 0xfffu + odd;
+        o = u >> 13;
+    }
+    return static_cast<std::uint16_t>(o | (sign >> 16));
+}
+
+inline float fp16_bits_to_float(std::uint16_t h) {
+    const std::uint32_t shifted_exp = 0x7c00u << 13;
+    std::uint32_t o = (std::uint32_t(h) & 0x7fffu) << 13;
+    const std::uint32_t exp = shifted_exp & o;
+    o += (127u - 15u) << 23;
+
+    float f;
+    if (exp == shifted_exp) {
+        f = bits_float(o + ((128u - 16u) << 23));             // inf / NaN
+    } else if (exp == 0) {
+        f = bits_float(o + (1u << 23)) - bits_float(113u << 23); // subnormal
+    } else {
+        f = bits_float(o);
+    }
+    return bits_float(float_bits(f) | ((std::uint32_t(h) & 0x8000u) << 16));
+}
+
+} // namespace detail
+
+/// bfloat16 storage type: the top half of an IEEE float (8-bit exponent,
+/// 7-bit mantissa). Arithmetic is done in float; conversions are explicit.
+struct bf16 {
+    std::uint16_t bits = 0;
+
+    bf16() = default;
+    explicit bf16(float f) : bits(detail::float_to_bf16_bits(f)) {}
+    explicit operator float() const { return detail::bf16_bits_to_float(bits); }
+};
+
+/// IEEE half-precision storage type (5-bit exponent, 10-bit mantissa).
+struct fp16 {
+    std::uint16_t bits = 0;
+
+    fp16() = default;
+    explicit fp16(float f) : bits(detail::float_to_fp16_bits(f)) {}
+    explicit operator float() const { return detail::fp16_bits_to_float(bits); }
+};
+
+/// bf16 or fp16: stored narrow, computed in float.
+template <typename T>
+struct is_half : std::integral_constant<bool, std::is_same<T, bf16>::value || std::is_same<T, fp16>::value> {};
+
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include "hpc/timer.hpp"
+#include "hpc/perf.hpp"
+
+namespace hpc {
+
+/// How measure() warms up, how long it samples and what it does between reps.
+struct MeasureOptions {
+    std::size_t min_reps = 7;       // timed reps, at least
+    std::size_t max_reps = 1000;    // ... and at most
+    double min_time_s = 0.1;        // keep sampling until the reps add up to this
+    std::size_t max_warmup = 10;    // warm-up reps, at most (at least one always runs)
+    double max_warmup_s = 1.0;      // ... and the time budget for them
+    double warmup_tol = 0.05;       // stable: last 3 warm-up reps within 5% of each other
+    double min_rep_s = 1e-3;        // short calls are repeated until a rep lasts this long
+    bool flush_cache = false;       // evict caches before every rep (cold first call)
+    PerfCounters* counters = nullptr; // read around every timed rep when set
+};
+
+/// Summary of per-call times in seconds. ci_lo/ci_hi bound the median at
+/// ~95% confidence (distribution-free, from order statistics).
+struct TimingStats {
+    double min = 0.0;
+    double median = 0.0;
+    double mean = 0.0;
+    double p95 = 0.0;
+    double stddev = 0.0;
+    double ci_lo = 0.0;
+    double ci_hi = 0.0;
+};
+
+inline TimingStats timing_stats(std::vector<double> t) {
+    TimingStats s;
+    const std::size_t n = t.size();
+    if (n == 0) return s;
+    std::sort(t.begin(), t.end());
+
+    // Linear interpolation between closest ranks (numpy's default).
+    auto quantile = [&](double q) {
+        const double pos = q * static_cast<double>(n - 1);
+        const std::size_t i = static_cast<std::size_t>(pos);
+        const double f = pos - static_cast<double>(i);
+        return i + 1 < n ? t[i] + f * (t[i + 1] - t[i]) : t[n - 1];
+    };
+
+    s.min = t.front();
+    s.median = quantile(0.5);
+    s.p95 = quantile(0.95);
+    s.mean = std::accumulate(t.begin(), t.end(), 0.0) / static_cast<double>(n);
+    double ss = 0.0;
+    for (double x : t) ss += (x - s.mean) * (x - s.mean);
+    s.stddev = n > 1 ? std::sqrt(ss / static_cast<double>(n - 1)) : 0.0;
+
+    // Ranks n/2 -+ 1.96*sqrt(n)/2 bracket the median with ~95% probability.
+    const double h = 0.98 * std::sqrt(static_cast<double>(n));
+    const double lo = std::floor(static_cast<double>(n) / 2.0 - h);
+    const double hi = std::ceil(static_cast<double>(n) / 2.0 + h);
+    s.ci_lo = t[lo < 0.0 ? 0 : static_cast<std::size_t>(lo)];
+    s.ci_hi = t[std::min(n - 1, static_cast<std::size_t>(std::max(hi, 0.0)))];
+    return s;
+}
+
+/// Result of measure(). Times are seconds per call, in the order they ran.
+struct Measurement {
+    std::vector<double> warmup;
+    std::vector<double> times;
+    std::size_t calls_per_rep = 1;
+    bool stable = false;            // warm-up settled within warmup_tol
+    TimingStats stats;
+    PerfSample counters;            // per call; NaN without MeasureOptions::counters
+};
+
+/// Last-level cache size of this host (sysconf on Linux), 32 MiB if unknown.
+inline std::size_t llc_bytes() {
+    long b = 0;
+#if defined(__linux__) && defined(_SC_LEVEL3_CACHE_SIZE)
+    b = ::sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (b <= 0) b = ::sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    return b > 0 ? static_cast<std::size_t>(b) : (std::size_t(32) << 20);
+}
+
+/// Write every line of a buffer twice the LLC size, evicting the calling
+/// core's caches and the shared LLC (other cores' private caches only where
+/// the LLC is inclusive).
+inline void flush_caches() {
+    static std::vector<unsigned char> buf(2 * llc_bytes());
+    volatile unsigned char* p = buf.data();
+    for (std::size_t i = 0; i < buf.size(); i += 64) p[i] = static_cast<unsigned char>(p[i] + 1);
+}
+
+namespace detail {
+
+inline bool warmup_stable(const std::vector<double>& w, double tol) {
+    if (w.size() < 3) return false;
+    const auto last = w.end() - 3;
+    const auto mm = std::minmax_element(last, w.end());
+    return *mm.second - *mm.first <= tol * *mm.first;
+}
+
+/// One rep: prepare and flush untimed, then `calls` timed calls of run.
+template <class Run, class Prepare>
+double timed_rep(const MeasureOptions& o, std::size_t calls, Run& run, Prepare& prepare,
+                 PerfSample* acc)
+{
+    prepare();
+    if (o.flush_cache) flush_caches();
+
+    PerfSample c0;
+    if (acc) c0 = o.counters->read();
+    Timer t; t.start();
+    for (std::size_t i = 0; i < calls; ++i) run();
+    const double s = t.stop_s();
+    if (acc) *acc += o.counters->read() - c0;
+    return s;
+}
+
+template <class Run, class Prepare>
+Measurement measure_impl(const MeasureOptions& o, Run& run, Prepare& prepare, bool repeat_calls) {
+    Measurement m;
+
+    // Warm-up: until three reps in a row agree, or the budget runs out. Reps
+    // well below min_rep_s are discarded and grown until timer resolution
+    // no longer matters.
+    double spent = 0.0;
+    while (true) {
+        const double s = timed_rep(o, m.calls_per_rep, run, prepare, nullptr);
+        spent += s;
+        if (repeat_calls && s < 0.5 * o.min_rep_s) {
+            const double grow = std::ceil(o.min_rep_s / std::max(s, 1e-9));
+            m.calls_per_rep = static_cast<std::size_t>(static_cast<double>(m.calls_per_rep) * grow);
+            m.warmup.clear();
+            continue;
+        }
+        m.warmup.push_back(s / static_cast<double>(m.calls_per_rep));
+        m.stable = warmup_stable(m.warmup, o.warmup_tol);
+        if (m.stable || m.warmup.size() >= std::max<std::size_t>(o.max_warmup, 1)
+            || spent >= o.max_warmup_s) break;
+    }
+
+    PerfSample acc = PerfSample::zero();
+    double total = 0.0;
+    while (m.times.size() < std::max<std::size_t>(o.min_reps, 1)
+           || (total < o.min_time_s && m.times.size() < o.max_reps)) {
+        const double s = timed_rep(o, m.calls_per_rep, run, prepare, o.counters ? &acc : nullptr);
+        total += s;
+        m.times.push_back(s / static_cast<double>(m.calls_per_rep));
+    }
+
+    m.stats = timing_stats(m.times);
+    if (o.counters) {
+        acc /= static_cast<double>(m.times.size() * m.calls_per_rep);
+        m.counters = acc;
+    }
+    return m;
+}
+
+} // namespace detail
+
+/// Time run(): warm up until stable, then sample at least min_reps reps and
+/// at least min_time_s seconds. Calls shorter than min_rep_s are repeated
+/// within a rep and reported per call.
+template <class Run>
+Measurement measure(const MeasureOptions& o, Run&& run) {
+    auto none = [] {};
+    return detail::measure_impl(o, run, none, true);
+}
+
+/// As measure(), but prepare() runs untimed before every rep (e.g. to restore
+/// an input an in-place kernel overwrote); every rep is then a single call.
+template <class Prepare, class Run>
+Measurement measure(const MeasureOptions& o, Prepare&& prepare, Run&& run) {
+    return detail::measure_impl(o, run, prepare, false);
+}
+
+}
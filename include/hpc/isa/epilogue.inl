@@ -0,0 +1,63 @@
+// Vector forms of the hpc/epilogue.hpp built-ins for the current ISA; included
+// by hpc/isa/gemm.inl inside each target region (no include guard).
+
+namespace hpc::detail::HPC_ISA {
+
+/// v holds C(i, j..j+W-1). Functors without a vector form run per lane.
+template <typename Ops, typename Epi>
+struct epilogue_op {
+    static void apply(typename Ops::reg& v, const Epi& e, std::size_t i, std::size_t j) {
+        using T = typename Ops::value_type;
+        alignas(64) T t[Ops::width];
+        Ops::store(t, v);
+        for (std::size_t l = 0; l < Ops::width; ++l) t[l] = e(t[l], i, j + l);
+        v = Ops::load(t);
+    }
+};
+
+template <typename Ops, typename Epi>
+void epilogue_vec(typename Ops::reg& v, const Epi& e, std::size_t i, std::size_t j) {
+    epilogue_op<Ops, Epi>::apply(v, e, i, j);
+}
+
+template <typename Ops>
+struct epilogue_op<Ops, epilogue::none> {
+    static void apply(typename Ops::reg&, const epilogue::none&, std::size_t, std::size_t) {}
+};
+
+template <typename Ops, typename T>
+struct epilogue_op<Ops, epilogue::bias<T>> {
+    static void apply(typename Ops::reg& v, const epilogue::bias<T>& e, std::size_t, std::size_t j) {
+        v = Ops::add(v, Ops::loadu(e.b + j));
+    }
+};
+
+template <typename Ops>
+struct epilogue_op<Ops, epilogue::relu> {
+    static void apply(typename Ops::reg& v, const epilogue::relu&, std::size_t, std::size_t) {
+        v = Ops::max(v, Ops::zero());
+    }
+};
+
+template <typename Ops, typename T>
+struct epilogue_op<Ops, epilogue::residual<T>> {
+    static void apply(typename Ops::reg& v, const epilogue::residual<T>& e, std::size_t i, std::size_t j) {
+        v = Ops::add(v, Ops::loadu(e.r + i * e.ld + j));
+    }
+};
+
+template <typename Ops, typename... E>
+struct epilogue_op<Ops, epilogue::chain<E...>> {
+    static void apply(typename Ops::reg& v, const epilogue::chain<E...>& e, std::size_t i, std::size_t j) {
+        apply(v, e, i, j, std::index_sequence_for<E...>{});
+    }
+
+    template <std::size_t... I>
+    static void apply(typename Ops::reg& v, [[maybe_unused]] const epilogue::chain<E...>& e,
+                      [[maybe_unused]] std::size_t i, [[maybe_unused]] std::size_t j,
+                      std::index_sequence<I...>) {
+        (epilogue_vec<Ops>(v, std::get<I>(e.parts), i, j), ...);
+    }
+};
+
+} // namespace hpc::detail::HPC_ISA
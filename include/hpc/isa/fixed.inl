@@ -0,0 +1,94 @@
+// Compile-time shaped GEMM kernels, instantiated per ISA by hpc/isa/foreach.inl
+// (no include guard). The helpers live here too: a lambda compiled outside the
+// target region could not be inlined into these kernels.
+
+namespace hpc::detail::HPC_ISA {
+
+/// Call f(integral_constant<0>) ... f(integral_constant<N-1>): a loop the
+/// compiler must fully unroll, with the index usable as a constant.
+template <typename F, std::size_t... I>
+inline void static_for_impl(F&& f, std::index_sequence<I...>) {
+    (f(std::integral_constant<std::size_t, I>{}), ...);
+}
+
+template <std::size_t N, typename F>
+inline void static_for(F&& f) {
+    static_for_impl(f, std::make_index_sequence<N>{});
+}
+
+/// Widest vector ops whose width divides N: ops<T>, else half_ops<T>
+/// (AVX2 under AVX-512), else scalar.
+template <typename T, std::size_t N>
+using fixed_ops = std::conditional_t<N % ops<T>::width == 0, ops<T>,
+                  std::conditional_t<N % half_ops<T>::width == 0, half_ops<T>, simd::scalar_ops<T>>>;
+
+/// Rows R (at most RB) starting at row I0 of C = A·B; the R×NV register tile is fully unrolled.
+template <std::size_t I0, std::size_t R, std::size_t N, std::size_t K, typename Ops, typename T>
+inline void fixed_row_block(const T* A, std::size_t lda, const T* B, std::size_t ldb,
+                            T* C, std::size_t ldc)
+{
+    using reg = typename Ops::reg;
+    constexpr std::size_t W = Ops::width;
+    constexpr std::size_t NV = N / W;
+
+    reg acc[R][NV];
+    static_for<R>([&](auto r) { static_for<NV>([&](auto v) { acc[r][v] = Ops::zero(); }); });
+
+    // K has a constant trip count; the compiler unrolls it as it sees fit
+    // (a static_for here makes 32³ instantiations very slow to compile).
+    for (std::size_t k = 0; k < K; ++k) {
+        reg b[NV];
+        static_for<NV>([&](auto v) { b[v] = Ops::loadu(B + k * ldb + v * W); });
+        static_for<R>([&](auto r) {
+            const reg a = Ops::set1(A[(I0 + r) * lda + k]);
+            static_for<NV>([&](auto v) { acc[r][v] = Ops::fmadd(a, b[v], acc[r][v]); });
+        });
+    }
+
+    static_for<R>([&](auto r) {
+        static_for<NV>([&](auto v) { Ops::storeu(C + (I0 + r) * ldc + v * W, acc[r][v]); });
+    });
+}
+
+/// C(M×N, ldc) = A(M×K, lda) · B(K×N, ldb), row-major, register-blocked as RB
+/// rows × N/W vectors (RB picked so the accumulators fit the register file).
+template <std::size_t M, std::size_t N, std::size_t K, typename T>
+inline void fixed_gemm(const T* A, std::size_t lda, const T* B, std::size_t ldb,
+                       T* C, std::size_t ldc)
+{
+    using Ops = fixed_ops<T, N>;
+    constexpr std::size_t NV = N / Ops::width;
+    constexpr std::size_t regs = sizeof(typename Ops::reg) >= 64 ? 24 : 12; // accumulators budget
+    constexpr std::size_t RB0 = regs / NV > 0 ? regs / NV : 1;
+    constexpr std::size_t RB = RB0 < M ? RB0 : M;
+    constexpr std::size_t nblocks = (M + RB - 1) / RB;
+
+    static_for<nblocks>([&](auto blk) {
+        constexpr std::size_t i0 = decltype(blk)::value * RB;
+        constexpr std::size_t rows = (M - i0) < RB ? (M - i0) : RB;
+        fixed_row_block<i0, rows, N, K, Ops>(A, lda, B, ldb, C, ldc);
+    });
+}
+
+template <typename T, std::size_t S>
+void fixed_square(const T* A, std::size_t lda, const T* B, std::size_t ldb, T* C, std::size_t ldc) {
+    fixed_gemm<S, S, S, T>(A, lda, B, ldb, C, ldc);
+}
+
+} // namespace hpc::detail::HPC_ISA
+
+namespace hpc::detail {
+template <typename T> struct fixed_kernel_for<Isa::HPC_ISA, T> {
+    static fixed_fn<T> square(std::size_t s) {
+        switch (s) {
+            case 4:  return &HPC_ISA::fixed_square<T, 4>;
+            case 8:  return &HPC_ISA::fixed_square<T, 8>;
+            case 12: return &HPC_ISA::fixed_square<T, 12>;
+            case 16: return &HPC_ISA::fixed_square<T, 16>;
+            case 24: return &HPC_ISA::fixed_square<T, 24>;
+            case 32: return &HPC_ISA::fixed_square<T, 32>;
+            default: return nullptr;
+        }
+    }
+};
+}
@@ -0,0 +1,35 @@
+// Instantiate the kernel file named by HPC_ISA_KERNELS once per ISA in this
+// build. Each copy is compiled inside that ISA's target region with HPC_ISA
+// set to its namespace (hpc::detail::HPC_ISA, see hpc/dispatch.hpp).
+// Deliberately no include guard; include at global scope.
+#if !defined(HPC_ISA_KERNELS)
+#error "hpc/isa/foreach.inl: define HPC_ISA_KERNELS first"
+#endif
+
+#define HPC_ISA scalar
+#include HPC_ISA_KERNELS
+#undef HPC_ISA
+
+#if HPC_HAVE_AVX2
+HPC_TARGET_AVX2_BEGIN
+#define HPC_ISA avx2
+#include HPC_ISA_KERNELS
+#undef HPC_ISA
+HPC_TARGET_END
+#endif
+
+#if HPC_HAVE_AVX512
+HPC_TARGET_AVX512_BEGIN
+#define HPC_ISA avx512
+#include HPC_ISA_KERNELS
+#undef HPC_ISA
+HPC_TARGET_END
+#endif
+
+#if HPC_HAVE_NEON
+#define HPC_ISA neon
+#include HPC_ISA_KERNELS
+#undef HPC_ISA
+#endif
+
+#undef HPC_ISA_KERNELS
@@ -0,0 +1,100 @@
+// GEMM micro-kernel, instantiated per ISA by hpc/isa/foreach.inl (no include guard).
+
+#include "hpc/isa/epilogue.inl"
+
+namespace hpc::detail::HPC_ISA {
+
+/// MR×NR register-tile micro-kernel. NR = NV vector registers wide.
+/// Ap is an MR-row micro-panel (k-major), Bp an NR-column micro-panel (k-major).
+template <typename T, typename Ops, std::size_t MR_, std::size_t NV>
+struct MicroKernel {
+    using ops = Ops;
+    using reg = typename Ops::reg;
+    static constexpr std::size_t W  = Ops::width;
+    static constexpr std::size_t MR = MR_;
+    static constexpr std::size_t NR = NV * W;
+
+    /// C(mr×nr) = alpha*AB + beta*C, C element (i,j) at C[i*rsc + j*csc].
+    /// beta == 0 never reads C (BLAS semantics: stale NaNs are overwritten).
+    static void run(std::size_t kc, const T* Ap, const T* Bp,
+                    T* C, std::size_t rsc, std::size_t csc,
+                    std::size_t mr, std::size_t nr, T alpha, T beta)
+    {
+        run(kc, Ap, Bp, C, rsc, csc, mr, nr, alpha, beta, epilogue::none{}, 0, 0);
+    }
+
+    /// As above, then C(i,j) = epi(C(i,j), i0+i, j0+j) on the register tile
+    /// before the store; (i0, j0) is the tile's position in the full C.
+    template <typename Epi>
+    static void run(std::size_t kc, const T* Ap, const T* Bp,
+                    T* C, std::size_t rsc, std::size_t csc,
+                    std::size_t mr, std::size_t nr, T alpha, T beta,
+                    const Epi& epi, std::size_t i0, std::size_t j0)
+    {
+        reg acc[MR][NV];
+        for (std::size_t i = 0; i < MR; ++i)
+            for (std::size_t v = 0; v < NV; ++v)
+                acc[i][v] = Ops::zero();
+
+        for (std::size_t k = 0; k < kc; ++k) {
+            reg b[NV];
+            for (std::size_t v = 0; v < NV; ++v) b[v] = Ops::load(Bp + v * W);
+
+            for (std::size_t i = 0; i < MR; ++i) {
+                const reg a = Ops::set1(Ap[i]);
+                for (std::size_t v = 0; v < NV; ++v)
+                    acc[i][v] = Ops::fmadd(a, b[v], acc[i][v]);
+            }
+            Ap += MR;
+            Bp += NR;
+        }
+
+        if (alpha != T(1)) {
+            const reg va = Ops::set1(alpha);
+            for (std::size_t i = 0; i < MR; ++i)
+                for (std::size_t v = 0; v < NV; ++v)
+                    acc[i][v] = Ops::mul(acc[i][v], va);
+        }
+
+        if (mr == MR && nr == NR && csc == 1) {
+            const reg vb = Ops::set1(beta);
+            for (std::size_t i = 0; i < MR; ++i) {
+                T* c = C + i * rsc;
+                for (std::size_t v = 0; v < NV; ++v) {
+                    reg r = acc[i][v];
+                    if (beta == T(1)) r = Ops::add(r, Ops::loadu(c + v * W));
+                    else if (beta != T(0)) r = Ops::fmadd(vb, Ops::loadu(c + v * W), r);
+                    epilogue_vec<Ops>(r, epi, i0 + i, j0 + v * W);
+                    Ops::storeu(c + v * W, r);
+                }
+            }
+            return;
+        }
+
+        // Edge tile or strided C: spill the register tile and copy the valid part.
+        alignas(64) T tmp[MR * NR];
+        for (std::size_t i = 0; i < MR; ++i)
+            for (std::size_t v = 0; v < NV; ++v)
+                Ops::store(tmp + i * NR + v * W, acc[i][v]);
+
+        for (std::size_t i = 0; i < mr; ++i) {
+            for (std::size_t j = 0; j < nr; ++j) {
+                T& c = C[i * rsc + j * csc];
+                c = epi((beta == T(0)) ? tmp[i * NR + j] : beta * c + tmp[i * NR + j], i0 + i, j0 + j);
+            }
+        }
+    }
+};
+
+/// Kernel shape for T: x86 uses 12 accumulators (6 rows × 2 vectors) out of
+/// 16/32 registers, NEON 16 of 32, the scalar fallback a 4×4 tile.
+template <typename T>
+using gemm_kernel = MicroKernel<T, ops<T>,
+                                isa == Isa::scalar ? 4 : isa == Isa::neon ? 8 : 6,
+                                isa == Isa::scalar ? 4 : 2>;
+
+} // namespace hpc::detail::HPC_ISA
+
+namespace hpc::detail {
+template <typename T> struct gemm_kernel_for<Isa::HPC_ISA, T> { using type = HPC_ISA::gemm_kernel<T>; };
+}
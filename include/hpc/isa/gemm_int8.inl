@@ -0,0 +1,37 @@
+// u8×s8 GEMM micro-kernel, instantiated per ISA by hpc/isa/foreach.inl (no include guard).
+// Plain int32 loops; the target region lets the compiler widen and vectorize
+// them. AVX512-VNNI has its own kernel in hpc/matmul_int8.hpp.
+
+namespace hpc::detail::HPC_ISA {
+
+/// MR×NR int32 tile over kb k steps (a multiple of 4) in the plain layout:
+/// Ap byte (k, i) = A(i, k), Bp byte (k, j) = B(k, j). Widening 8-bit
+/// products vectorize well per row; the quad layout vpdpbusd wants would
+/// need a byte transpose per step here.
+struct QuantKernel {
+    static constexpr std::size_t MR = 4;
+    static constexpr std::size_t NR = 32;
+    static constexpr bool quads = false;
+
+    static void run(std::size_t kb, const std::uint8_t* Ap, const std::int8_t* Bp,
+                    std::int32_t* acc_out)
+    {
+        std::int32_t acc[MR][NR] = {};
+        for (std::size_t k = 0; k < kb; ++k) {
+            for (std::size_t i = 0; i < MR; ++i) {
+                const std::int32_t a = Ap[i];
+                for (std::size_t j = 0; j < NR; ++j) acc[i][j] += a * Bp[j];
+            }
+            Ap += MR;
+            Bp += NR;
+        }
+        for (std::size_t i = 0; i < MR; ++i)
+            for (std::size_t j = 0; j < NR; ++j) acc_out[i * NR + j] = acc[i][j];
+    }
+};
+
+} // namespace hpc::detail::HPC_ISA
+
+namespace hpc::detail {
+template <> struct quant_kernel_for<Isa::HPC_ISA> { using type = HPC_ISA::QuantKernel; };
+}
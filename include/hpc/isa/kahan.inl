@@ -0,0 +1,60 @@
+// Multi-lane Kahan kernel, instantiated per ISA by hpc/isa/foreach.inl (no include guard).
+
+namespace hpc::detail::HPC_ISA {
+
+/// Kahan over [x, x+n) with U independent vector accumulators of Ops::width lanes.
+/// Element i always lands in lane i % (U*width), so the result only depends on
+/// n and the ISA, never on where the caller split the work.
+template <typename T, typename Ops, std::size_t U>
+Compensated<T> kahan_lanes(const T* x, std::size_t n) {
+    using reg = typename Ops::reg;
+    constexpr std::size_t W = Ops::width;
+    constexpr std::size_t step = U * W;
+
+    reg s[U], c[U];
+    for (std::size_t u = 0; u < U; ++u) { s[u] = Ops::zero(); c[u] = Ops::zero(); }
+
+    std::size_t i = 0;
+    for (; i + step <= n; i += step) {
+        for (std::size_t u = 0; u < U; ++u) {
+            const reg y = Ops::sub(Ops::loadu(x + i + u * W), c[u]);
+            const reg t = Ops::add(s[u], y);
+            c[u] = Ops::sub(Ops::sub(t, s[u]), y);
+            s[u] = t;
+        }
+    }
+
+    // Fold lanes in a fixed order.
+    alignas(64) T ls[step];
+    alignas(64) T lc[step];
+    for (std::size_t u = 0; u < U; ++u) {
+        Ops::store(ls + u * W, s[u]);
+        Ops::store(lc + u * W, c[u]);
+    }
+
+    Compensated<T> acc{ls[0], lc[0]};
+    for (std::size_t l = 1; l < step; ++l) acc = compensated_merge(acc, Compensated<T>{ls[l], lc[l]});
+
+    // Scalar tail continues the same Kahan recurrence on the folded state.
+    for (; i < n; ++i) {
+        const T y = x[i] - acc.c;
+        const T t = acc.sum + y;
+        acc.c   = (t - acc.sum) - y;
+        acc.sum = t;
+    }
+    return acc;
+}
+
+/// 8 accumulators fill the 32-register AVX-512 file, 4 fit the 16 of AVX2/SSE.
+template <typename T>
+Compensated<T> kahan_sum_lanes(const T* x, std::size_t n) {
+    return kahan_lanes<T, ops<T>, sizeof(typename ops<T>::reg) >= 64 ? 8 : 4>(x, n);
+}
+
+} // namespace hpc::detail::HPC_ISA
+
+namespace hpc::detail {
+template <typename T> struct kahan_kernel_for<Isa::HPC_ISA, T> {
+    static Compensated<T> run(const T* x, std::size_t n) { return HPC_ISA::kahan_sum_lanes<T>(x, n); }
+};
+}
@@ -0,0 +1,50 @@
+// Philox bulk generator, instantiated per ISA by hpc/isa/foreach.inl (no include guard).
+// Blocks are processed L at a time, one block per lane: plain loops the
+// target region lets the compiler vectorize (32x32->64 multiplies per lane).
+
+namespace hpc::detail::HPC_ISA {
+
+template <typename T>
+void random_blocks(T* out, std::uint64_t b0, std::size_t nb, unsigned seed) {
+    constexpr std::size_t L = 16;
+    constexpr std::size_t P = random_per_block<T>;
+
+    std::size_t b = 0;
+    for (; b + L <= nb; b += L) {
+        std::uint32_t c0[L], c1[L], c2[L], c3[L];
+        for (std::size_t l = 0; l < L; ++l) {
+            const std::uint64_t ctr = b0 + b + l;
+            std::uint32_t x0 = std::uint32_t(ctr), x1 = std::uint32_t(ctr >> 32), x2 = 0u, x3 = 0u;
+            std::uint32_t k0 = seed, k1 = 0x5EEDu;
+            for (int r = 0; r < 10; ++r) {
+                const std::uint64_t p0 = std::uint64_t(0xD2511F53u) * x0;
+                const std::uint64_t p1 = std::uint64_t(0xCD9E8D57u) * x2;
+                x0 = std::uint32_t(p1 >> 32) ^ x1 ^ k0;
+                x1 = std::uint32_t(p1);
+                x2 = std::uint32_t(p0 >> 32) ^ x3 ^ k1;
+                x3 = std::uint32_t(p0);
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+            c0[l] = x0; c1[l] = x1; c2[l] = x2; c3[l] = x3;
+        }
+
+        T* o = out + b * P;
+        for (std::size_t l = 0; l < L; ++l) {
+            const std::uint32_t w[4] = {c0[l], c1[l], c2[l], c3[l]};
+            random_block_values<T>(w, o + l * P);
+        }
+    }
+
+    for (; b < nb; ++b) random_block<T>(b0 + b, seed, out + b * P);
+}
+
+} // namespace hpc::detail::HPC_ISA
+
+namespace hpc::detail {
+template <typename T> struct random_kernel_for<Isa::HPC_ISA, T> {
+    static void run(T* out, std::uint64_t b0, std::size_t nb, unsigned seed) {
+        HPC_ISA::random_blocks<T>(out, b0, nb, seed);
+    }
+};
+}
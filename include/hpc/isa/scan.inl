@@ -0,0 +1,126 @@
+// Serial scan blocks, instantiated per ISA by hpc/isa/foreach.inl (no include guard).
+// scan_ops<T> lanes: an in-register log-step prefix per vector plus a
+// broadcast carry between vectors; the scalar level keeps plain loops.
+
+namespace hpc::detail::HPC_ISA {
+
+/// Inclusive prefix within one register: log2(width) shift-and-add steps.
+template <typename Ops>
+typename Ops::reg prefix_lanes(typename Ops::reg v) {
+    if constexpr (Ops::width > 1) v = Ops::add(v, Ops::template shift_up<1>(v));
+    if constexpr (Ops::width > 2) v = Ops::add(v, Ops::template shift_up<2>(v));
+    if constexpr (Ops::width > 4) v = Ops::add(v, Ops::template shift_up<4>(v));
+    if constexpr (Ops::width > 8) v = Ops::add(v, Ops::template shift_up<8>(v));
+    return v;
+}
+
+template <typename T>
+T block_sum(const T* in, std::size_t n) {
+    using Ops = scan_ops<T>;
+    constexpr std::size_t W = Ops::width;
+    T acc = 0;
+    std::size_t i = 0;
+    if constexpr (W > 1) {
+        constexpr std::size_t U = 4;
+        typename Ops::reg s[U];
+        for (std::size_t u = 0; u < U; ++u) s[u] = Ops::zero();
+        for (; i + U * W <= n; i += U * W)
+            for (std::size_t u = 0; u < U; ++u) s[u] = Ops::add(s[u], Ops::loadu(in + i + u * W));
+        T l[U * W];
+        for (std::size_t u = 0; u < U; ++u) Ops::storeu(l + u * W, s[u]);
+        for (std::size_t j = 0; j < U * W; ++j) acc += l[j];
+    }
+    for (; i < n; ++i) acc += in[i];
+    return acc;
+}
+
+/// Serial scan of [in, in+n) into out, starting from offset. in may equal out.
+/// Float results differ from the sequential sum by reassociation within a
+/// vector only; integer results are exact.
+template <typename T>
+void block_scan(const T* in, T* out, std::size_t n, T offset, bool inclusive) {
+    using Ops = scan_ops<T>;
+    using reg = typename Ops::reg;
+    constexpr std::size_t W = Ops::width;
+    T acc = offset;
+    std::size_t i = 0;
+    if constexpr (W > 1) {
+        if (n >= W) {
+            reg carry = Ops::set1(offset);
+            if (inclusive) {
+                for (; i + W <= n; i += W) {
+                    const reg v = Ops::add(prefix_lanes<Ops>(Ops::loadu(in + i)), carry);
+                    Ops::storeu(out + i, v);
+                    carry = Ops::broadcast_last(v);
+                }
+            } else {
+                for (; i + W <= n; i += W) {
+                    const reg p = prefix_lanes<Ops>(Ops::loadu(in + i));
+                    Ops::storeu(out + i, Ops::add(Ops::template shift_up<1>(p), carry));
+                    carry = Ops::add(Ops::broadcast_last(p), carry);
+                }
+            }
+            T l[W];
+            Ops::storeu(l, carry);
+            acc = l[0];
+        }
+    }
+    if (inclusive) {
+        for (; i < n; ++i) { acc += in[i]; out[i] = acc; }
+    } else {
+        for (; i < n; ++i) { const T v = in[i]; out[i] = acc; acc += v; }
+    }
+}
+
+/// s, or 0 when reset, without a branch: compilers turn `f ? 0 : s` on
+/// doubles into a jump, which random segment lengths mispredict.
+template <typename T>
+T reset_if(T s, bool reset) {
+    if constexpr (std::is_floating_point<T>::value) {
+        using U = std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+        U b;
+        std::memcpy(&b, &s, sizeof b);
+        b &= U(reset) - 1;
+        std::memcpy(&s, &b, sizeof b);
+        return s;
+    } else {
+        return T(s * T(!reset));
+    }
+}
+
+/// Segmented scan of [in, in+n) under head flags: flags[i] != 0 restarts
+/// the running segment sum s at i, and out[i] = init + s (inclusive: after
+/// adding in[i]). Branch-free, so short segments cost no mispredictions.
+/// Returns s after the last element. in may equal out.
+template <typename T>
+T flag_scan(const T* in, T* out, const std::uint8_t* flags, std::size_t n, T s, T init, bool inclusive) {
+    if (inclusive) {
+        for (std::size_t i = 0; i < n; ++i) {
+            s = reset_if(s, flags[i] != 0);
+            s += in[i];
+            out[i] = init + s;
+        }
+    } else {
+        for (std::size_t i = 0; i < n; ++i) {
+            s = reset_if(s, flags[i] != 0);
+            const T v = in[i];
+            out[i] = init + s;
+            s += v;
+        }
+    }
+    return s;
+}
+
+} // namespace hpc::detail::HPC_ISA
+
+namespace hpc::detail {
+template <typename T> struct scan_kernel_for<Isa::HPC_ISA, T> {
+    static T sum(const T* in, std::size_t n) { return HPC_ISA::block_sum(in, n); }
+    static void scan(const T* in, T* out, std::size_t n, T offset, bool inclusive) {
+        HPC_ISA::block_scan(in, out, n, offset, inclusive);
+    }
+    static T flag_scan(const T* in, T* out, const std::uint8_t* flags, std::size_t n, T s, T init, bool inclusive) {
+        return HPC_ISA::flag_scan(in, out, flags, n, s, init, inclusive);
+    }
+};
+}
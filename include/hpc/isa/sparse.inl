@@ -0,0 +1,90 @@
+// CSR row kernels, instantiated per ISA by hpc/isa/foreach.inl (no include guard).
+
+namespace hpc::detail::HPC_ISA {
+
+/// sum_{k in [lo, hi)} val[k] * x[col[k]]: U registers of Ops::width
+/// entries (index load, gather of x, fmadd), one register at a time for the
+/// rest and a scalar tail. Rows shorter than one register only take the tail.
+template <typename T, typename Ops, std::size_t U>
+T csr_dot(const T* val, const std::uint32_t* col, std::size_t lo, std::size_t hi, const T* x) {
+    using reg = typename Ops::reg;
+    constexpr std::size_t W = Ops::width;
+    constexpr std::size_t step = U * W;
+
+    std::size_t k = lo;
+    T s = 0;
+    if (hi - lo >= W) {
+        reg acc[U];
+        for (std::size_t u = 0; u < U; ++u) acc[u] = Ops::zero();
+        for (; k + step <= hi; k += step)
+            for (std::size_t u = 0; u < U; ++u)
+                acc[u] = Ops::fmadd(Ops::loadu(val + k + u * W), Ops::gather(x, col + k + u * W), acc[u]);
+        for (; k + W <= hi; k += W)
+            acc[0] = Ops::fmadd(Ops::loadu(val + k), Ops::gather(x, col + k), acc[0]);
+        for (std::size_t u = 1; u < U; ++u) acc[0] = Ops::add(acc[0], acc[u]);
+        alignas(64) T l[W];
+        Ops::store(l, acc[0]);
+        for (std::size_t w = 0; w < W; ++w) s += l[w];
+    }
+    for (; k < hi; ++k) s += val[k] * x[col[k]];
+    return s;
+}
+
+/// c[0, n) = sum_{k in [lo, hi)} val[k] * B(col[k], 0..n). Column tiles of
+/// U registers stay in registers across the row's entries, so c is written
+/// once and every B row is streamed with unit stride.
+template <typename T, typename Ops, std::size_t U>
+void csr_row_times_dense(const T* val, const std::uint32_t* col, std::size_t lo, std::size_t hi,
+                         const T* B, std::size_t ldb, T* c, std::size_t n)
+{
+    using reg = typename Ops::reg;
+    constexpr std::size_t W = Ops::width;
+    constexpr std::size_t step = U * W;
+
+    std::size_t j = 0;
+    for (; j + step <= n; j += step) {
+        reg acc[U];
+        for (std::size_t u = 0; u < U; ++u) acc[u] = Ops::zero();
+        for (std::size_t k = lo; k < hi; ++k) {
+            const reg a = Ops::set1(val[k]);
+            const T* b = B + col[k] * ldb + j;
+            for (std::size_t u = 0; u < U; ++u) acc[u] = Ops::fmadd(a, Ops::loadu(b + u * W), acc[u]);
+        }
+        for (std::size_t u = 0; u < U; ++u) Ops::storeu(c + j + u * W, acc[u]);
+    }
+    for (; j + W <= n; j += W) {
+        reg acc = Ops::zero();
+        for (std::size_t k = lo; k < hi; ++k)
+            acc = Ops::fmadd(Ops::set1(val[k]), Ops::loadu(B + col[k] * ldb + j), acc);
+        Ops::storeu(c + j, acc);
+    }
+    if (j == n) return;
+    if constexpr (half_ops<T>::width > 1 && half_ops<T>::width < W) {
+        // Narrower registers for the rest (rhs = 8 floats on AVX-512).
+        csr_row_times_dense<T, half_ops<T>, 1>(val, col, lo, hi, B + j, ldb, c + j, n - j);
+    } else {
+        // Fewer than W columns left: one sweep of the row for all of them.
+        const std::size_t m = n - j;
+        T acc[W] = {};
+        for (std::size_t k = lo; k < hi; ++k) {
+            const T a = val[k];
+            const T* b = B + col[k] * ldb + j;
+            for (std::size_t t = 0; t < m; ++t) acc[t] += a * b[t];
+        }
+        for (std::size_t t = 0; t < m; ++t) c[j + t] = acc[t];
+    }
+}
+
+} // namespace hpc::detail::HPC_ISA
+
+namespace hpc::detail {
+template <typename T> struct sparse_kernel_for<Isa::HPC_ISA, T> {
+    static T dot(const T* val, const std::uint32_t* col, std::size_t lo, std::size_t hi, const T* x) {
+        return HPC_ISA::csr_dot<T, HPC_ISA::ops<T>, 2>(val, col, lo, hi, x);
+    }
+    static void row(const T* val, const std::uint32_t* col, std::size_t lo, std::size_t hi,
+                    const T* B, std::size_t ldb, T* c, std::size_t n) {
+        HPC_ISA::csr_row_times_dense<T, HPC_ISA::ops<T>, 4>(val, col, lo, hi, B, ldb, c, n);
+    }
+};
+}
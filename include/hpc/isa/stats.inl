@@ -0,0 +1,120 @@
+// Fused one-pass statistics kernel, instantiated per ISA by hpc/isa/foreach.inl
+// (no include guard). Uses fold_lanes from hpc/isa/sum.inl.
+
+namespace hpc::detail::HPC_ISA {
+
+/// Elements per block: x and y of a block stay in L1 for the deviation sweep.
+constexpr std::size_t stats_block = 1024;
+
+/// Stats of one block [x, x+n), n <= stats_block. The first sweep reads
+/// memory (TwoSum lanes for the sum, min, max and, when Dot, Dot2 lanes for
+/// x·y: fmsub recovers each product's rounding error exactly and it joins the
+/// TwoSum error of adding the product), the second sweeps the cached block
+/// for sum (x - block mean)^2.
+template <typename T, typename Ops, std::size_t U, bool Dot>
+Stats<T> stats_lanes(const T* x, const T* y, std::size_t n) {
+    using reg = typename Ops::reg;
+    constexpr std::size_t W = Ops::width;
+    constexpr std::size_t step = U * W;
+    const std::size_t nv = n / step * step;
+
+    reg s[U], c[U], lo[U], hi[U], d[U], dc[U];
+    for (std::size_t u = 0; u < U; ++u) {
+        s[u] = c[u] = d[u] = dc[u] = Ops::zero();
+        lo[u] = Ops::set1(std::numeric_limits<T>::infinity());
+        hi[u] = Ops::set1(-std::numeric_limits<T>::infinity());
+    }
+    for (std::size_t i = 0; i < nv; i += step) {
+        for (std::size_t u = 0; u < U; ++u) {
+            const reg v  = Ops::loadu(x + i + u * W);
+            const reg t  = Ops::add(s[u], v);
+            const reg bp = Ops::sub(t, s[u]);
+            c[u] = Ops::sub(c[u], Ops::add(Ops::sub(s[u], Ops::sub(t, bp)), Ops::sub(v, bp)));
+            s[u] = t;
+            lo[u] = Ops::min(lo[u], v);
+            hi[u] = Ops::max(hi[u], v);
+            if constexpr (Dot) {
+                const reg w  = Ops::loadu(y + i + u * W);
+                const reg p  = Ops::mul(v, w);
+                const reg pe = Ops::fmsub(v, w, p); // v*w - p, exact
+                const reg dt = Ops::add(d[u], p);
+                const reg dp = Ops::sub(dt, d[u]);
+                const reg e  = Ops::add(Ops::sub(d[u], Ops::sub(dt, dp)), Ops::sub(p, dp));
+                dc[u] = Ops::sub(dc[u], Ops::add(e, pe));
+                d[u] = dt;
+            }
+        }
+    }
+
+    Stats<T> r;
+    r.count = n;
+    alignas(64) T ls[step];
+    alignas(64) T lc[step];
+    alignas(64) T ll[step];
+    alignas(64) T lh[step];
+    for (std::size_t u = 0; u < U; ++u) {
+        Ops::store(ls + u * W, s[u]);
+        Ops::store(lc + u * W, c[u]);
+        Ops::store(ll + u * W, lo[u]);
+        Ops::store(lh + u * W, hi[u]);
+    }
+    for (std::size_t l = 0; l < step; ++l) {
+        r.sum = compensated_merge(r.sum, Compensated<T>{ls[l], lc[l]});
+        r.min = std::min(r.min, ll[l]);
+        r.max = std::max(r.max, lh[l]);
+    }
+    if constexpr (Dot) {
+        for (std::size_t u = 0; u < U; ++u) {
+            Ops::store(ls + u * W, d[u]);
+            Ops::store(lc + u * W, dc[u]);
+        }
+        for (std::size_t l = 0; l < step; ++l) r.dot = compensated_merge(r.dot, Compensated<T>{ls[l], lc[l]});
+    }
+    for (std::size_t i = nv; i < n; ++i) {
+        r.sum = compensated_merge(r.sum, Compensated<T>{x[i], T(0)});
+        r.min = std::min(r.min, x[i]);
+        r.max = std::max(r.max, x[i]);
+        if constexpr (Dot) {
+            const T p = x[i] * y[i];
+            r.dot = compensated_merge(r.dot, Compensated<T>{p, -std::fma(x[i], y[i], -p)});
+        }
+    }
+
+    r.mean = r.sum.value() / T(n);
+    const reg vm = Ops::set1(r.mean);
+    reg q[U];
+    for (std::size_t u = 0; u < U; ++u) q[u] = Ops::zero();
+    for (std::size_t i = 0; i < nv; i += step) {
+        for (std::size_t u = 0; u < U; ++u) {
+            const reg dv = Ops::sub(Ops::loadu(x + i + u * W), vm);
+            q[u] = Ops::fmadd(dv, dv, q[u]);
+        }
+    }
+    r.m2 = fold_lanes<T, Ops, U>(q);
+    for (std::size_t i = nv; i < n; ++i) r.m2 += (x[i] - r.mean) * (x[i] - r.mean);
+    return r;
+}
+
+/// Blocks of [x, x+n) merged in order with stats_merge.
+template <typename T, typename Ops, std::size_t U, bool Dot>
+Stats<T> stats_range(const T* x, const T* y, std::size_t n) {
+    Stats<T> acc;
+    for (std::size_t b = 0; b < n; b += stats_block) {
+        const std::size_t len = std::min(stats_block, n - b);
+        acc = stats_merge(acc, stats_lanes<T, Ops, U, Dot>(x + b, Dot ? y + b : nullptr, len));
+    }
+    return acc;
+}
+
+} // namespace hpc::detail::HPC_ISA
+
+namespace hpc::detail {
+template <typename T> struct stats_kernel_for<Isa::HPC_ISA, T> {
+    static Stats<T> run(const T* x, const T* y, std::size_t n) {
+        // Six accumulators per chain: 4 chains on AVX-512 fit the 32 registers.
+        constexpr std::size_t U = HPC_ISA::sum_unroll<T> / 2;
+        return y ? HPC_ISA::stats_range<T, HPC_ISA::ops<T>, U, true>(x, y, n)
+                 : HPC_ISA::stats_range<T, HPC_ISA::ops<T>, U, false>(x, y, n);
+    }
+};
+}
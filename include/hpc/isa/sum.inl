@@ -0,0 +1,190 @@
+// Pairwise, Neumaier and binned sum kernels, instantiated per ISA by
+// hpc/isa/foreach.inl (no include guard).
+
+namespace hpc::detail::HPC_ISA {
+
+/// Sum the step = U*width lanes of s in a fixed pairwise order.
+template <typename T, typename Ops, std::size_t U>
+T fold_lanes(const typename Ops::reg (&s)[U]) {
+    constexpr std::size_t step = U * Ops::width;
+    alignas(64) T l[step];
+    for (std::size_t u = 0; u < U; ++u) Ops::store(l + u * Ops::width, s[u]);
+    for (std::size_t w = step / 2; w > 0; w /= 2)
+        for (std::size_t i = 0; i < w; ++i) l[i] += l[i + w];
+    return l[0];
+}
+
+/// Plain sum of one pairwise leaf: U vector accumulators, each lane adding
+/// at most n / (U*width) elements in sequence.
+template <typename T, typename Ops, std::size_t U>
+T sum_leaf(const T* x, std::size_t n) {
+    using reg = typename Ops::reg;
+    constexpr std::size_t step = U * Ops::width;
+
+    reg s[U];
+    for (std::size_t u = 0; u < U; ++u) s[u] = Ops::zero();
+    std::size_t i = 0;
+    for (; i + step <= n; i += step)
+        for (std::size_t u = 0; u < U; ++u) s[u] = Ops::add(s[u], Ops::loadu(x + i + u * Ops::width));
+
+    T tail = T(0);
+    for (; i < n; ++i) tail += x[i];
+    return fold_lanes<T, Ops, U>(s) + tail;
+}
+
+/// Blocked pairwise sum: halves (kept on vector-step boundaries) recurse
+/// down to leaves of 16 elements per lane. Error O(eps log n).
+template <typename T, typename Ops, std::size_t U>
+T pairwise(const T* x, std::size_t n) {
+    constexpr std::size_t step = U * Ops::width;
+    if (n <= 16 * step) return sum_leaf<T, Ops, U>(x, n);
+    const std::size_t h = (n / 2 + step - 1) / step * step;
+    return pairwise<T, Ops, U>(x, h) + pairwise<T, Ops, U>(x + h, n - h);
+}
+
+/// Neumaier sum with TwoSum per lane: the branch-free form of Neumaier's
+/// correction (the same exact error of s + x, without comparing |s|, |x|),
+/// so it also holds when an addend dwarfs the running sum. Kahan sign
+/// convention in the result: value = sum - c.
+template <typename T, typename Ops, std::size_t U>
+Compensated<T> neumaier_lanes(const T* x, std::size_t n) {
+    using reg = typename Ops::reg;
+    constexpr std::size_t W = Ops::width;
+    constexpr std::size_t step = U * W;
+
+    reg s[U], c[U];
+    for (std::size_t u = 0; u < U; ++u) { s[u] = Ops::zero(); c[u] = Ops::zero(); }
+
+    std::size_t i = 0;
+    for (; i + step <= n; i += step) {
+        for (std::size_t u = 0; u < U; ++u) {
+            const reg v  = Ops::loadu(x + i + u * W);
+            const reg t  = Ops::add(s[u], v);
+            const reg bp = Ops::sub(t, s[u]);
+            const reg e  = Ops::add(Ops::sub(s[u], Ops::sub(t, bp)), Ops::sub(v, bp));
+            c[u] = Ops::sub(c[u], e);
+            s[u] = t;
+        }
+    }
+
+    alignas(64) T ls[step];
+    alignas(64) T lc[step];
+    for (std::size_t u = 0; u < U; ++u) {
+        Ops::store(ls + u * W, s[u]);
+        Ops::store(lc + u * W, c[u]);
+    }
+    Compensated<T> acc{ls[0], lc[0]};
+    for (std::size_t l = 1; l < step; ++l) acc = compensated_merge(acc, Compensated<T>{ls[l], lc[l]});
+    for (; i < n; ++i) acc = compensated_merge(acc, Compensated<T>{x[i], T(0)});
+    return acc;
+}
+
+/// max |x[i]| (0 for n == 0). NaNs may be skipped; the caller's fold
+/// arithmetic propagates them anyway.
+template <typename T, typename Ops, std::size_t U>
+T max_abs(const T* x, std::size_t n) {
+    using reg = typename Ops::reg;
+    constexpr std::size_t W = Ops::width;
+    constexpr std::size_t step = U * W;
+
+    reg m[U];
+    for (std::size_t u = 0; u < U; ++u) m[u] = Ops::zero();
+    std::size_t i = 0;
+    for (; i + step <= n; i += step) {
+        for (std::size_t u = 0; u < U; ++u) {
+            const reg v = Ops::loadu(x + i + u * W);
+            m[u] = Ops::max(m[u], Ops::max(v, Ops::sub(Ops::zero(), v)));
+        }
+    }
+    alignas(64) T l[step];
+    for (std::size_t u = 0; u < U; ++u) Ops::store(l + u * W, m[u]);
+    T r = T(0);
+    for (std::size_t j = 0; j < step; ++j) r = std::max(r, l[j]);
+    for (; i < n; ++i) r = std::max(r, std::abs(x[i]));
+    return r;
+}
+
+/// Binned folds in double: v = x*scale, then per fold k the part
+/// q = (M[k] + v) - M[k] on fold k's grid is added to acc[k] and v -= q.
+/// With the boundaries binned_sum picks every q, and every partial sum of
+/// them, is exact, so acc does not depend on the order of the additions.
+template <typename Ops, std::size_t U>
+void binned_block(const double* x, std::size_t n, double scale,
+                  const double (&M)[binned_folds], double (&acc)[binned_folds])
+{
+    using reg = typename Ops::reg;
+    constexpr std::size_t W = Ops::width;
+    constexpr std::size_t step = U * W;
+
+    reg a[binned_folds][U], vm[binned_folds];
+    const reg vs = Ops::set1(scale);
+    for (std::size_t k = 0; k < binned_folds; ++k) {
+        vm[k] = Ops::set1(M[k]);
+        for (std::size_t u = 0; u < U; ++u) a[k][u] = Ops::zero();
+    }
+
+    std::size_t i = 0;
+    for (; i + step <= n; i += step) {
+        for (std::size_t u = 0; u < U; ++u) {
+            reg v = Ops::mul(Ops::loadu(x + i + u * W), vs);
+            for (std::size_t k = 0; k < binned_folds; ++k) {
+                const reg q = Ops::sub(Ops::add(vm[k], v), vm[k]);
+                v = Ops::sub(v, q);
+                a[k][u] = Ops::add(a[k][u], q);
+            }
+        }
+    }
+    for (std::size_t k = 0; k < binned_folds; ++k) acc[k] += fold_lanes<double, Ops, U>(a[k]);
+
+    for (; i < n; ++i) {
+        double v = x[i] * scale;
+        for (std::size_t k = 0; k < binned_folds; ++k) {
+            const double q = (M[k] + v) - M[k];
+            v -= q;
+            acc[k] += q;
+        }
+    }
+}
+
+/// binned_block over T: float input is widened to double in short runs.
+template <typename T, std::size_t U>
+void binned_lanes(const T* x, std::size_t n, double scale,
+                  const double (&M)[binned_folds], double (&acc)[binned_folds])
+{
+    if constexpr (std::is_same<T, double>::value) {
+        binned_block<ops<double>, U>(x, n, scale, M, acc);
+    } else {
+        constexpr std::size_t run = 1024;
+        alignas(64) double w[run];
+        for (std::size_t i = 0; i < n; i += run) {
+            const std::size_t len = std::min(run, n - i);
+            for (std::size_t j = 0; j < len; ++j) w[j] = static_cast<double>(x[i + j]);
+            binned_block<ops<double>, U>(w, len, scale, M, acc);
+        }
+    }
+}
+
+/// Register budget as in kahan.inl: 8 chains on AVX-512, 4 elsewhere; the
+/// binned kernel already has binned_folds chains per accumulator.
+template <typename T>
+constexpr std::size_t sum_unroll = sizeof(typename ops<T>::reg) >= 64 ? 8 : 4;
+
+} // namespace hpc::detail::HPC_ISA
+
+namespace hpc::detail {
+template <typename T> struct sum_kernel_for<Isa::HPC_ISA, T> {
+    static T pairwise(const T* x, std::size_t n) {
+        return HPC_ISA::pairwise<T, HPC_ISA::ops<T>, HPC_ISA::sum_unroll<T>>(x, n);
+    }
+    static Compensated<T> neumaier(const T* x, std::size_t n) {
+        return HPC_ISA::neumaier_lanes<T, HPC_ISA::ops<T>, HPC_ISA::sum_unroll<T>>(x, n);
+    }
+    static T max_abs(const T* x, std::size_t n) {
+        return HPC_ISA::max_abs<T, HPC_ISA::ops<T>, HPC_ISA::sum_unroll<T>>(x, n);
+    }
+    static void binned(const T* x, std::size_t n, double scale,
+                       const double (&M)[binned_folds], double (&acc)[binned_folds]) {
+        HPC_ISA::binned_lanes<T, HPC_ISA::sum_unroll<double> / 2>(x, n, scale, M, acc);
+    }
+};
+}
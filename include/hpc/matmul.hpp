@@ -5,8 +5,44 @@
 #include <cassert>
 #include <algorithm>
 
+#include "hpc/tune.hpp"
+
 namespace hpc {
 
+/// Naive matrix multiply (i–k–j loop) on caller memory.
+/// A(M×K, row stride lda) · B(K×N, ldb) = C(M×N, ldc), row-major.
+/// C is overwritten: the k == 0 step stores instead of accumulating, so no
+/// separate zero-fill pass is needed.
+template <typename T>
+void matmul_naive(std::size_t M, std::size_t N, std::size_t K,
+                  const T* A, std::size_t lda,
+                  const T* B, std::size_t ldb,
+                  T* C, std::size_t ldc)
+{
+    static_assert(std::is_floating_point<T>::value, "matmul_naive: T must be float or double");
+
+    for (std::size_t i = 0; i < M; ++i) {
+        T* c = C + i * ldc;
+
+        if (K == 0) {
+            std::fill(c, c + N, T(0));
+            continue;
+        }
+
+        // NOTE: using i-k-j loop order for better cache reuse; tried i-j-k but slower in my tests
+        for (std::size_t k = 0; k < K; ++k) {
+            const T aik = A[i * lda + k];
+            const T* b = B + k * ldb;
+
+            if (k == 0) {
+                for (std::size_t j = 0; j < N; ++j) c[j] = aik * b[j];
+            } else {
+                for (std::size_t j = 0; j < N; ++j) c[j] += aik * b[j];
+            }
+        }
+    }
+}
+
 /// Naive matrix multiply (i–k–j loop).
 /// A(M×K) · B(K×N) = C(M×N), row-major.
 
@@ -22,38 +58,74 @@ void matmul_naive(std::size_t M, std::size_t N, std::size_t K,
     assert(A.size() == M * K);
     assert(B.size() == K * N);
 
-    C.assign(M * N, T(0));
+    C.resize(M * N);
+    matmul_naive<T>(M, N, K, A.data(), K, B.data(), N, C.data(), N);
+}
 
-    for (std::size_t i = 0; i < M; ++i) {
-        // NOTE: using i-k-j loop order for better cache reuse; tried i-j-k but slower in my tests
-        for (std::size_t k = 0; k < K; ++k) {
-            const T aik = A[i * K + k];
+namespace detail {
+
+/// One block step of matmul_blocked: C(i, jj:jjmax) (+)= A(i, kk:kkmax) · B(kk:kkmax, jj:jjmax)
+/// for i in [ii, iimax). The first visit of C(i, jj:jjmax) is kk == 0, k == 0,
+/// which stores. Walking kk in order for a tile gives the summation order
+/// of matmul_blocked, whatever order the tiles run in.
+template <typename T>
+void matmul_blocked_step(std::size_t ii, std::size_t iimax, std::size_t kk, std::size_t kkmax,
+                         std::size_t jj, std::size_t jjmax,
+                         const T* A, std::size_t lda, const T* B, std::size_t ldb, T* C, std::size_t ldc)
+{
+    for (std::size_t i = ii; i < iimax; ++i) {
+        for (std::size_t k = kk; k < kkmax; ++k) {
+            const T aik = A[i * lda + k];
+            const T* b = B + k * ldb;
+            T* c = C + i * ldc;
 
-            for (std::size_t j = 0; j < N; ++j) {
-                C[i * N + j] += aik * B[k * N + j];
+            if (k == 0) {
+                for (std::size_t j = jj; j < jjmax; ++j) c[j] = aik * b[j];
+            } else {
+                for (std::size_t j = jj; j < jjmax; ++j) c[j] += aik * b[j];
             }
         }
     }
 }
 
-/// Cache-blocked matrix multiply (ijk with block tiling).
-/// BS = block size (default 128).
+/// matmul_blocked block size: BS, else the tuned one for this shape class, else 128.
+template <typename T>
+std::size_t blocked_block_size(std::size_t M, std::size_t N, std::size_t K, std::size_t BS) {
+    if (BS) return BS;
+    const std::size_t tuned = tuned_params<T>(M, N, K).block;
+    return tuned ? tuned : 128;
+}
+
+} // namespace detail
+
+/// Cache-blocked matrix multiply (ijk with block tiling) on caller memory.
+/// Row-major with leading dimensions; C is overwritten (see matmul_naive).
+/// BS = 0 takes the tuned block size for this shape class, else 128.
 template <typename T>
 void matmul_blocked(std::size_t M, std::size_t N, std::size_t K,
-                    const std::vector<T>& A,
-                    const std::vector<T>& B,
-                    std::vector<T>& C,
-                    std::size_t BS = 128)
+                    const T* A, std::size_t lda,
+                    const T* B, std::size_t ldb,
+                    T* C, std::size_t ldc,
+                    std::size_t BS = 0)
 {
     static_assert(std::is_floating_point<T>::value,
                   "matmul_blocked: T must be float or double");
 
-    assert(A.size() == M * K);
-    assert(B.size() == K * N);
+    BS = detail::blocked_block_size<T>(M, N, K, BS);
+
+    if (K == 0) {
+        for (std::size_t i = 0; i < M; ++i) std::fill(C + i * ldc, C + i * ldc + N, T(0));
+        return;
+    }
 
-    C.assign(M * N, T(0));
+    // Row blocks write disjoint parts of C, so they are the parallel loop.
+    const std::ptrdiff_t nblocks = static_cast<std::ptrdiff_t>((M + BS - 1) / BS);
 
-    for (std::size_t ii = 0; ii < M; ii += BS) {
+#if defined(_OPENMP)
+    #pragma omp parallel for schedule(static)
+#endif
+    for (std::ptrdiff_t bi = 0; bi < nblocks; ++bi) {
+        const std::size_t ii = static_cast<std::size_t>(bi) * BS;
         const std::size_t iimax = std::min(ii + BS, M);
 
         for (std::size_t kk = 0; kk < K; kk += BS) {
@@ -61,20 +133,29 @@ void matmul_blocked(std::size_t M, std::size_t N, std::size_t K,
 
             for (std::size_t jj = 0; jj < N; jj += BS) {
                 const std::size_t jjmax = std::min(jj + BS, N);
-
-                // NOTE: Parallelize with OpenMP,
-                // #pragma omp parallel for
-                for (std::size_t i = ii; i < iimax; ++i) {
-                    for (std::size_t k = kk; k < kkmax; ++k) {
-                        const T aik = A[i * K + k];
-                        for (std::size_t j = jj; j < jjmax; ++j) {
-                            C[i * N + j] += aik * B[k * N + j];
-                        }
-                    }
-                }
+                detail::matmul_blocked_step(ii, iimax, kk, kkmax, jj, jjmax, A, lda, B, ldb, C, ldc);
             }
         }
     }
 }
 
+/// Cache-blocked matrix multiply (ijk with block tiling).
+/// BS = block size (0: tuned, else 128).
+template <typename T>
+void matmul_blocked(std::size_t M, std::size_t N, std::size_t K,
+                    const std::vector<T>& A,
+                    const std::vector<T>& B,
+                    std::vector<T>& C,
+                    std::size_t BS = 0)
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "matmul_blocked: T must be float or double");
+
+    assert(A.size() == M * K);
+    assert(B.size() == K * N);
+
+    C.resize(M * N);
+    matmul_blocked<T>(M, N, K, A.data(), K, B.data(), N, C.data(), N, BS);
+}
+
 }
\ No newline at end of file
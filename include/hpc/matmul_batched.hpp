@@ -0,0 +1,225 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+
+#include "hpc/view.hpp"
+#include "hpc/memory.hpp"
+#include "hpc/thread_pool.hpp"
+#include "hpc/matmul_packed.hpp"
+#include "hpc/matmul_fixed.hpp"
+
+namespace hpc {
+
+namespace detail {
+
+/// Elements needed to hold all of B(K×N) packed in Kern's panel order.
+template <typename Kern>
+std::size_t packed_B_size(std::size_t K, std::size_t N) {
+    return round_up(N, Kern::NR) * K;
+}
+
+/// Pack all of B into Bp, one KC×NC panel after another: the panel at (jc, pc)
+/// starts at Bp + jc*K + pc*round_up(nc, NR) and has the layout gemm_packed
+/// builds for a single panel. Micro-panels are spread over ctx's team.
+template <typename T, typename Kern>
+void pack_B_full(const ThreadContext& ctx, std::size_t K, std::size_t N,
+                 const T* B, std::size_t rsb, std::size_t csb,
+                 const GemmBlocking& blk, T* Bp)
+{
+    constexpr std::size_t NR = Kern::NR;
+    const std::size_t KC = std::max<std::size_t>(blk.KC, 1);
+    const std::size_t NC = round_up(std::max<std::size_t>(blk.NC, 1), NR);
+
+    std::size_t slot = 0;
+    for (std::size_t jc = 0; jc < N; jc += NC) {
+        const std::size_t nc = std::min(NC, N - jc);
+        const std::size_t ncp = round_up(nc, NR);
+        for (std::size_t pc = 0; pc < K; pc += KC) {
+            const std::size_t kc = std::min(KC, K - pc);
+            T* panel = Bp + jc * K + pc * ncp;
+            for (std::size_t jr = 0; jr < nc; jr += NR, ++slot) {
+                if (slot % ctx.nthreads != ctx.tid) continue;
+                pack_B<NR>(kc, std::min(NR, nc - jr),
+                           B + pc * rsb + (jc + jr) * csb, rsb, csb, panel + jr * kc);
+            }
+        }
+    }
+}
+
+/// Serial C = alpha*A·B + beta*C against a B already packed by pack_B_full
+/// (same blk). Only A is packed, into the calling thread's workspace arena.
+template <typename T, typename Kern>
+void gemm_prepacked_B(std::size_t M, std::size_t N, std::size_t K, T alpha,
+                      const T* A, std::size_t rsa, std::size_t csa, const T* Bp,
+                      T beta, T* C, std::size_t rsc, std::size_t csc,
+                      const GemmBlocking& blk)
+{
+    constexpr std::size_t MR = Kern::MR;
+    constexpr std::size_t NR = Kern::NR;
+
+    const std::size_t MC = round_up(std::max<std::size_t>(blk.MC, 1), MR);
+    const std::size_t KC = std::max<std::size_t>(blk.KC, 1);
+    const std::size_t NC = round_up(std::max<std::size_t>(blk.NC, 1), NR);
+
+    Arena& wa = workspace_arena();
+    ArenaScope scope(wa);
+    T* Ap = wa.allocate<T>(MC * std::min(KC, K));
+
+    for (std::size_t jc = 0; jc < N; jc += NC) {
+        const std::size_t nc = std::min(NC, N - jc);
+        const std::size_t ncp = round_up(nc, NR);
+
+        for (std::size_t pc = 0; pc < K; pc += KC) {
+            const std::size_t kc = std::min(KC, K - pc);
+            const T beta_p = (pc == 0) ? beta : T(1);
+            const T* panel = Bp + jc * K + pc * ncp;
+
+            for (std::size_t ic = 0; ic < M; ic += MC) {
+                const std::size_t mc = std::min(MC, M - ic);
+
+                pack_A<MR>(mc, kc, A + ic * rsa + pc * csa, rsa, csa, Ap);
+
+                for (std::size_t jr = 0; jr < nc; jr += NR) {
+                    const std::size_t nr = std::min(NR, nc - jr);
+
+                    for (std::size_t ir = 0; ir < mc; ir += MR) {
+                        Kern::run(kc, Ap + ir * kc, panel + jr * kc,
+                                  C + (ic + ir) * rsc + (jc + jr) * csc, rsc, csc,
+                                  std::min(MR, mc - ir), nr, alpha, beta_p);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// Matrices with at least this many multiply-adds are worth splitting across
+/// threads on their own when the batch is too short to keep the team busy.
+constexpr std::size_t batched_split_flops = std::size_t(1) << 21; // 128³
+
+/// Shared driver on micro-kernel Kern: a(i), b(i), c(i) return the row-major
+/// operands of item i.
+/// - batch >= nthreads, or matrices below batched_split_flops: the batch is
+///   split statically over the team and every item runs serially. A shared B
+///   is packed once, cooperatively, and reused by all items.
+/// - otherwise: items run one after the other on the full team.
+template <typename T, typename Kern, typename GetA, typename GetB, typename GetC>
+void gemm_batched_with(std::size_t batch, std::size_t M, std::size_t N, std::size_t K,
+                  T alpha, GetA a, std::size_t lda, GetB b, std::size_t ldb, bool shared_b,
+                  T beta, GetC c, std::size_t ldc,
+                  std::size_t nthreads, const GemmBlocking& blk)
+{
+    if (batch == 0 || M == 0 || N == 0) return;
+    nthreads = std::max<std::size_t>(nthreads, 1);
+
+    if (batch < nthreads && M * N * K >= batched_split_flops) {
+        for (std::size_t i = 0; i < batch; ++i)
+            gemm_packed_with<T, Kern>(M, N, K, alpha, a(i), lda, 1, b(i), ldb, 1,
+                                      beta, c(i), ldc, 1, blk, nthreads);
+        return;
+    }
+
+    nthreads = std::min(nthreads, batch);
+
+    // Tiny exact products go straight to the compile-time kernels.
+    const bool small = alpha == T(1) && beta == T(0) && K > 0
+                    && std::max({M, N, K}) <= fixed_sizes[std::size(fixed_sizes) - 1];
+    const bool prepack = shared_b && !small && K > 0 && alpha != T(0);
+
+    Arena& ws = workspace_arena();
+    ArenaScope scope(ws);
+    T* Bp = prepack ? ws.allocate<T>(packed_B_size<Kern>(K, N)) : nullptr;
+
+    default_pool().run(nthreads, [&](const ThreadContext& ctx) {
+        if (prepack) {
+            pack_B_full<T, Kern>(ctx, K, N, b(0), ldb, 1, blk, Bp);
+            ctx.barrier();
+        }
+
+        const auto r = split_range(batch, ctx.nthreads, ctx.tid);
+        for (std::size_t i = r.first; i < r.second; ++i) {
+            if (small)
+                matmul_small<T>(M, N, K, a(i), lda, b(i), ldb, c(i), ldc);
+            else if (prepack)
+                gemm_prepacked_B<T, Kern>(M, N, K, alpha, a(i), lda, 1, Bp, beta, c(i), ldc, 1, blk);
+            else
+                gemm_packed_with<T, Kern>(M, N, K, alpha, a(i), lda, 1, b(i), ldb, 1,
+                                          beta, c(i), ldc, 1, blk, 1);
+        }
+    });
+}
+
+/// gemm_batched_with on the micro-kernel of active_isa(), blk resolved once
+/// so a shared B is packed and consumed with the same panels.
+template <typename T, typename GetA, typename GetB, typename GetC>
+void gemm_batched(std::size_t batch, std::size_t M, std::size_t N, std::size_t K,
+                  T alpha, GetA a, std::size_t lda, GetB b, std::size_t ldb, bool shared_b,
+                  T beta, GetC c, std::size_t ldc,
+                  std::size_t nthreads, const GemmBlocking& blk)
+{
+    const GemmBlocking resolved = resolve_blocking<T>(blk, M, N, K);
+    isa_dispatch([&](auto isa) {
+        using Kern = typename gemm_kernel_for<decltype(isa)::value, T>::type;
+        gemm_batched_with<T, Kern>(batch, M, N, K, alpha, a, lda, b, ldb, shared_b,
+                                   beta, c, ldc, nthreads, resolved);
+    });
+}
+
+} // namespace detail
+
+/// Strided batched GEMM, row-major:
+/// C_i = alpha * A_i · B_i + beta * C_i for i in [0, batch), where
+/// A_i = A + i*stride_a (M×K, lda), B_i = B + i*stride_b (K×N, ldb) and
+/// C_i = C + i*stride_c (M×N, ldc). stride_b == 0 shares one B across the
+/// batch; it is then packed once. See detail::gemm_batched_with for threading.
+template <typename T>
+void matmul_batched(std::size_t batch, std::size_t M, std::size_t N, std::size_t K,
+                    detail::nodeduce_t<T> alpha,
+                    const T* A, std::size_t lda, std::size_t stride_a,
+                    const T* B, std::size_t ldb, std::size_t stride_b,
+                    detail::nodeduce_t<T> beta,
+                    T* C, std::size_t ldc, std::size_t stride_c,
+                    std::size_t nthreads = 1,
+                    GemmBlocking blk = {})
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "matmul_batched: T must be float or double");
+
+    detail::gemm_batched<T>(batch, M, N, K, alpha,
+        [=](std::size_t i) { return A + i * stride_a; }, lda,
+        [=](std::size_t i) { return B + i * stride_b; }, ldb, stride_b == 0,
+        beta,
+        [=](std::size_t i) { return C + i * stride_c; }, ldc,
+        nthreads, blk);
+}
+
+/// Pointer-array batched GEMM, row-major: C[i] = alpha * A[i] · B[i] + beta * C[i].
+/// Every item has the same shape and leading dimensions. When all B[i] are
+/// the same pointer, B is packed once for the whole batch.
+template <typename T>
+void matmul_batched(std::size_t batch, std::size_t M, std::size_t N, std::size_t K,
+                    detail::nodeduce_t<T> alpha,
+                    const T* const* A, std::size_t lda,
+                    const T* const* B, std::size_t ldb,
+                    detail::nodeduce_t<T> beta,
+                    T* const* C, std::size_t ldc,
+                    std::size_t nthreads = 1,
+                    GemmBlocking blk = {})
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "matmul_batched: T must be float or double");
+
+    bool shared_b = batch > 0;
+    for (std::size_t i = 1; i < batch && shared_b; ++i) shared_b = B[i] == B[0];
+
+    detail::gemm_batched<T>(batch, M, N, K, alpha,
+        [=](std::size_t i) { return A[i]; }, lda,
+        [=](std::size_t i) { return B[i]; }, ldb, shared_b,
+        beta,
+        [=](std::size_t i) { return C[i]; }, ldc,
+        nthreads, blk);
+}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#include "hpc/simd.hpp"
+#include "hpc/dispatch.hpp"
+#include "hpc/matmul.hpp"
+#include "hpc/matmul_packed.hpp"
+
+namespace hpc {
+
+namespace detail {
+
+template <typename T>
+using fixed_fn = void (*)(const T*, std::size_t, const T*, std::size_t, T*, std::size_t);
+
+/// Fixed-shape kernels of each ISA level: fixed_kernel_for<I, T>::square(s)
+/// returns the S×S×S kernel or nullptr; see hpc/isa/fixed.inl.
+template <Isa I, typename T>
+struct fixed_kernel_for;
+
+} // namespace detail
+
+}
+
+#define HPC_ISA_KERNELS "hpc/isa/fixed.inl"
+#include "hpc/isa/foreach.inl"
+
+namespace hpc {
+
+namespace detail {
+
+/// Kernels matching this translation unit's compiler flags, for matmul_fixed.
+#if defined(__AVX512F__) && HPC_HAVE_AVX512
+namespace fixed_native = avx512;
+#elif defined(__AVX2__) && defined(__FMA__) && HPC_HAVE_AVX2
+namespace fixed_native = avx2;
+#elif HPC_HAVE_NEON
+namespace fixed_native = neon;
+#else
+namespace fixed_native = scalar;
+#endif
+
+} // namespace detail
+
+/// Compile-time shaped GEMM for small matrices:
+/// A(M×K, lda) · B(K×N, ldb) = C(M×N, ldc), row-major, C overwritten.
+/// C is register-blocked as RB rows × N/W vectors (RB picked so the
+/// accumulators fit the register file); every bound is a compile-time constant.
+/// Inlined for the ISA this translation unit is compiled for, no dispatch.
+template <std::size_t M, std::size_t N, std::size_t K, typename T>
+void matmul_fixed(const T* A, std::size_t lda, const T* B, std::size_t ldb,
+                  T* C, std::size_t ldc)
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "matmul_fixed: T must be float or double");
+    static_assert(M > 0 && N > 0 && K > 0, "matmul_fixed: empty shape");
+
+    detail::fixed_native::fixed_gemm<M, N, K, T>(A, lda, B, ldb, C, ldc);
+}
+
+/// Tightly packed overload (lda = K, ldb = ldc = N).
+template <std::size_t M, std::size_t N, std::size_t K, typename T>
+void matmul_fixed(const T* A, const T* B, T* C) {
+    matmul_fixed<M, N, K, T>(A, K, B, N, C, N);
+}
+
+/// Square sizes with a compiled matmul_fixed specialization.
+constexpr std::size_t fixed_sizes[] = {4, 8, 12, 16, 24, 32};
+
+namespace detail {
+
+/// S×S×S kernel of active_isa(), nullptr when S is not in fixed_sizes.
+template <typename T>
+fixed_fn<T> fixed_square_kernel(std::size_t s) {
+    return isa_dispatch([s](auto isa) { return fixed_kernel_for<decltype(isa)::value, T>::square(s); });
+}
+
+} // namespace detail
+
+/// Runtime dispatcher for small GEMMs (row-major, C overwritten).
+/// 1. M == N == K == S in fixed_sizes: call that kernel of active_isa().
+/// 2. Otherwise take the smallest S >= max(M,N,K); if S³ is at most twice
+///    M·N·K, zero-pad the operands into S×S stack tiles and run that kernel.
+/// 3. Else fall back to matmul_naive (<= 64) or the packed engine.
+/// Returns true when a fixed specialization was used.
+template <typename T>
+bool matmul_small(std::size_t M, std::size_t N, std::size_t K,
+                  const T* A, std::size_t lda, const T* B, std::size_t ldb,
+                  T* C, std::size_t ldc)
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "matmul_small: T must be float or double");
+
+    if (M == 0 || N == 0) return false;
+
+    if (M == N && N == K) {
+        if (auto f = detail::fixed_square_kernel<T>(M)) {
+            f(A, lda, B, ldb, C, ldc);
+            return true;
+        }
+    }
+
+    const std::size_t mx = std::max({M, N, K});
+    std::size_t S = 0;
+    for (std::size_t s : fixed_sizes) {
+        if (s >= mx) { S = s; break; }
+    }
+
+    if (S != 0 && K != 0 && S * S * S <= 2 * M * N * K) {
+        alignas(64) T a[32 * 32], b[32 * 32], c[32 * 32];
+        std::fill(a, a + S * S, T(0));
+        std::fill(b, b + S * S, T(0));
+        for (std::size_t i = 0; i < M; ++i) std::copy(A + i * lda, A + i * lda + K, a + i * S);
+        for (std::size_t k = 0; k < K; ++k) std::copy(B + k * ldb, B + k * ldb + N, b + k * S);
+
+        detail::fixed_square_kernel<T>(S)(a, S, b, S, c, S);
+
+        for (std::size_t i = 0; i < M; ++i) std::copy(c + i * S, c + i * S + N, C + i * ldc);
+        return true;
+    }
+
+    if (mx <= 64) {
+        matmul_naive<T>(M, N, K, A, lda, B, ldb, C, ldc);
+    } else {
+        detail::gemm_packed<T>(M, N, K, T(1), A, lda, 1, B, ldb, 1, T(0), C, ldc, 1,
+                               GemmBlocking{}, 1);
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,318 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+#include "hpc/matmul_packed.hpp"
+
+namespace hpc {
+
+/// How the int32 product of u8 A and s8 B becomes float C:
+///   C(i,j) = scale * row_scale[i] * col_scale[j]
+///            * sum_k (A(i,k) - za(i)) * (B(k,j) - zb(j)) + beta * C(i,j)
+/// with za(i) = row_zero ? row_zero[i] : a_zero and zb(j) = col_zero ?
+/// col_zero[j] : 0. Null scale arrays count as 1 (per-tensor quantisation).
+struct QuantParams {
+    float scale = 1.0f;
+    const float* row_scale = nullptr;         // M entries: per-row (per-token) scale of A
+    const float* col_scale = nullptr;         // N entries: per-column (per-channel) scale of B
+    std::int32_t a_zero = 0;                  // zero point of A
+    const std::int32_t* row_zero = nullptr;   // M per-row zero points of A (replace a_zero)
+    const std::int32_t* col_zero = nullptr;   // N per-column zero points of B
+};
+
+namespace detail {
+
+/// Portable int8 micro-kernel of each ISA level; see hpc/isa/gemm_int8.inl.
+template <Isa I>
+struct quant_kernel_for;
+
+} // namespace detail
+
+}
+
+#define HPC_ISA_KERNELS "hpc/isa/gemm_int8.inl"
+#include "hpc/isa/foreach.inl"
+
+namespace hpc {
+
+namespace detail {
+
+/// Offset of element (k, x) in a packed micro-panel X wide: k quads
+/// ((k/4, x) holds k..k+3 of x, the vpdpbusd layout) or plain rows of k.
+template <std::size_t X, bool Quads>
+constexpr std::size_t panel_index(std::size_t k, std::size_t x) {
+    return Quads ? (k / 4) * 4 * X + 4 * x + k % 4 : k * X + x;
+}
+
+/// Pack mc×K of u8 A into MR-row micro-panels of kb = round_up(K, 4) steps,
+/// zero past K and mc, and store each row's sum of A in rowsum (for column
+/// zero points).
+template <std::size_t MR, bool Quads>
+void pack_A_int8(std::size_t mc, std::size_t K, const std::uint8_t* A, std::size_t lda,
+                 std::uint8_t* Ap, std::int32_t* rowsum)
+{
+    const std::size_t kb = round_up(K, 4);
+    for (std::size_t ir = 0; ir < mc; ir += MR) {
+        const std::size_t mr = std::min(MR, mc - ir);
+        for (std::size_t i = 0; i < MR; ++i) {
+            const std::uint8_t* a = i < mr ? A + (ir + i) * lda : A;
+            std::int32_t s = 0;
+            for (std::size_t k = 0; k < kb; ++k) {
+                const std::uint8_t v = (i < mr && k < K) ? a[k] : std::uint8_t(0);
+                Ap[panel_index<MR, Quads>(k, i)] = v;
+                s += v;
+            }
+            if (i < mr) rowsum[ir + i] = s;
+        }
+        Ap += kb * MR;
+    }
+}
+
+/// Pack K×nc of s8 B into NR-column micro-panels like pack_A_int8, with each
+/// column's sum in colsum.
+template <std::size_t NR, bool Quads>
+void pack_B_int8(std::size_t K, std::size_t nc, const std::int8_t* B, std::size_t ldb,
+                 std::int8_t* Bp, std::int32_t* colsum)
+{
+    const std::size_t kb = round_up(K, 4);
+    for (std::size_t jr = 0; jr < nc; jr += NR) {
+        const std::size_t nr = std::min(NR, nc - jr);
+        for (std::size_t j = 0; j < nr; ++j) colsum[jr + j] = 0;
+        for (std::size_t k = 0; k < kb; ++k) {
+            const std::int8_t* b = k < K ? B + k * ldb + jr : B;
+            for (std::size_t j = 0; j < NR; ++j) {
+                const std::int8_t v = (k < K && j < nr) ? b[j] : std::int8_t(0);
+                Bp[panel_index<NR, Quads>(k, j)] = v;
+                if (j < nr) colsum[jr + j] += v;
+            }
+        }
+        Bp += kb * NR;
+    }
+}
+
+/// Dequantise an mr×nr int32 tile (row stride NR) into C at rows i0.., columns
+/// j0..; rowsum/colsum hold the tile's own rows and columns. The zero-point
+/// correction is done modulo 2^32: the corrected sum itself fits in int32
+/// (K <= 2^15), so the wrapped result is exact.
+template <std::size_t NR>
+void dequant_tile(const std::int32_t* acc, std::size_t mr, std::size_t nr,
+                  std::size_t i0, std::size_t j0, std::size_t K,
+                  const std::int32_t* rowsum, const std::int32_t* colsum,
+                  const QuantParams& q, float beta, float* C, std::size_t ldc)
+{
+    std::uint32_t zb[NR];
+    float sc[NR];
+    for (std::size_t j = 0; j < nr; ++j) {
+        zb[j] = q.col_zero ? std::uint32_t(q.col_zero[j0 + j]) : 0u;
+        sc[j] = q.col_scale ? q.col_scale[j0 + j] : 1.0f;
+    }
+
+    for (std::size_t i = 0; i < mr; ++i) {
+        const std::uint32_t za = std::uint32_t(q.row_zero ? q.row_zero[i0 + i] : q.a_zero);
+        const std::uint32_t rs = std::uint32_t(rowsum[i]) - std::uint32_t(K) * za;
+        const float sr = q.scale * (q.row_scale ? q.row_scale[i0 + i] : 1.0f);
+        const std::int32_t* a = acc + i * NR;
+        float* c = C + (i0 + i) * ldc + j0;
+        for (std::size_t j = 0; j < nr; ++j) {
+            const std::uint32_t v = std::uint32_t(a[j]) - za * std::uint32_t(colsum[j]) - zb[j] * rs;
+            const float r = sr * sc[j] * static_cast<float>(static_cast<std::int32_t>(v));
+            c[j] = (beta == 0.0f) ? r : beta * c[j] + r;
+        }
+    }
+}
+
+/// True when the VNNI kernel is compiled in, the CPU has avx512vnni and the
+/// active ISA is avx512.
+inline bool vnni_usable() {
+#if HPC_HAVE_AVX512_VNNI
+    static const bool cpu = cpu_supports(Isa::avx512) && __builtin_cpu_supports("avx512vnni");
+    return cpu && active_isa() == Isa::avx512;
+#else
+    return false;
+#endif
+}
+
+} // namespace detail
+
+}
+
+#if HPC_HAVE_AVX512_VNNI
+HPC_TARGET_AVX512VNNI_BEGIN
+
+namespace hpc::detail::avx512_vnni {
+
+/// 6×32 int32 register tile on vpdpbusd: each step broadcasts one k quad of
+/// an A row and multiplies it with two vectors of B quads (64 MACs each).
+struct QuantKernel {
+    static constexpr std::size_t MR = 6;
+    static constexpr std::size_t NV = 2;
+    static constexpr std::size_t NR = NV * 16;
+    static constexpr bool quads = true;
+
+    static void run(std::size_t kb, const std::uint8_t* Ap, const std::int8_t* Bp,
+                    std::int32_t* acc_out)
+    {
+        __m512i acc[MR][NV];
+        for (std::size_t i = 0; i < MR; ++i)
+            for (std::size_t v = 0; v < NV; ++v)
+                acc[i][v] = _mm512_setzero_si512();
+
+        for (std::size_t q = 0; q < kb / 4; ++q) {
+            __m512i b[NV];
+            for (std::size_t v = 0; v < NV; ++v) b[v] = _mm512_load_si512(Bp + v * 64);
+
+            for (std::size_t i = 0; i < MR; ++i) {
+                std::int32_t w;
+                std::memcpy(&w, Ap + 4 * i, sizeof(w));
+                const __m512i a = _mm512_set1_epi32(w);
+                for (std::size_t v = 0; v < NV; ++v)
+                    acc[i][v] = _mm512_dpbusd_epi32(acc[i][v], a, b[v]);
+            }
+            Ap += 4 * MR;
+            Bp += 4 * NR;
+        }
+        for (std::size_t i = 0; i < MR; ++i)
+            for (std::size_t v = 0; v < NV; ++v)
+                _mm512_storeu_si512(acc_out + i * NR + v * 16, acc[i][v]);
+    }
+};
+
+} // namespace hpc::detail::avx512_vnni
+
+HPC_TARGET_END
+#endif
+
+namespace hpc {
+
+namespace detail {
+
+/// u8×s8 GEMM on kernel Kern. K is never split (the int32 sums stay in
+/// registers until dequant_tile writes C), so the blocking bounds the A
+/// block (mc×K bytes, ~L2) and the shared B panel (K×nc bytes, ~L3) instead.
+template <typename Kern>
+void gemm_u8s8_with(std::size_t M, std::size_t N, std::size_t K,
+                    const std::uint8_t* A, std::size_t lda, const std::int8_t* B, std::size_t ldb,
+                    float* C, std::size_t ldc, const QuantParams& q, float beta,
+                    GemmBlocking blk, std::size_t nthreads)
+{
+    constexpr std::size_t MR = Kern::MR;
+    constexpr std::size_t NR = Kern::NR;
+    const std::size_t kb = round_up(K, 4);
+
+    const std::size_t MC = round_up(std::max<std::size_t>(blk.MC ? blk.MC : (256u << 10) / kb, 1), MR);
+    const std::size_t NC = round_up(std::max<std::size_t>(blk.NC ? blk.NC : (4u << 20) / kb, 1), NR);
+
+    const std::size_t tiles = ((M + MR - 1) / MR) * ((N + NR - 1) / NR);
+    nthreads = std::max<std::size_t>(1, std::min(nthreads, tiles));
+
+    Arena& ws = workspace_arena();
+    ArenaScope scope(ws);
+    std::int8_t* Bp = ws.allocate<std::int8_t>(kb * NC);
+    std::int32_t* colsum = ws.allocate<std::int32_t>(NC);
+
+    auto body = [&](const ThreadContext& ctx) {
+        Arena& wa = workspace_arena();
+        ArenaScope scope_a(wa);
+        std::uint8_t* Ap = wa.allocate<std::uint8_t>(MC * kb);
+        std::int32_t* rowsum = wa.allocate<std::int32_t>(MC);
+        alignas(64) std::int32_t acc[MR * NR];
+
+        const auto grid = gemm_thread_grid(M, N, ctx.nthreads);
+        const std::size_t tm = ctx.tid / grid.second;
+        const std::size_t tn = ctx.tid % grid.second;
+        const auto mrange = split_range(M, grid.first, tm, MR);
+
+        for (std::size_t jc = 0; jc < N; jc += NC) {
+            const std::size_t nc = std::min(NC, N - jc);
+            const auto nrange = split_range(nc, grid.second, tn, NR);
+
+            const std::size_t npanels = (nc + NR - 1) / NR;
+            for (std::size_t p = ctx.tid; p < npanels; p += ctx.nthreads) {
+                const std::size_t jr = p * NR;
+                pack_B_int8<NR, Kern::quads>(K, std::min(NR, nc - jr), B + jc + jr, ldb,
+                                             Bp + jr * kb, colsum + jr);
+            }
+            ctx.barrier();
+
+            for (std::size_t ic = mrange.first; ic < mrange.second; ic += MC) {
+                const std::size_t mc = std::min(MC, mrange.second - ic);
+
+                pack_A_int8<MR, Kern::quads>(mc, K, A + ic * lda, lda, Ap, rowsum);
+
+                for (std::size_t jr = nrange.first; jr < nrange.second; jr += NR) {
+                    const std::size_t nr = std::min(NR, nc - jr);
+                    for (std::size_t ir = 0; ir < mc; ir += MR) {
+                        Kern::run(kb, Ap + ir * kb, Bp + jr * kb, acc);
+                        dequant_tile<NR>(acc, std::min(MR, mc - ir), nr, ic + ir, jc + jr, K,
+                                         rowsum + ir, colsum + jr, q, beta, C, ldc);
+                    }
+                }
+            }
+            ctx.barrier(); // B panel is repacked next iteration
+        }
+    };
+
+    default_pool().run(nthreads, body);
+}
+
+} // namespace detail
+
+/// Name of the kernel matmul_u8s8 runs right now: "avx512_vnni" or the
+/// active ISA (portable int32 loops).
+inline const char* quant_kernel_name() {
+    return detail::vnni_usable() ? "avx512_vnni" : isa_name(active_isa());
+}
+
+/// Quantized GEMM: u8 A(M×K) × s8 B(K×N) with exact int32 accumulation,
+/// dequantised into float C by q (scales, zero points) as each tile is
+/// written; row-major with leading dimensions. On AVX512-VNNI CPUs the
+/// inner product is vpdpbusd (four MACs per int32 lane). K <= 2^15 keeps
+/// every int32 sum exact for any zero points; blk.KC is ignored.
+inline void matmul_u8s8(std::size_t M, std::size_t N, std::size_t K,
+                        const std::uint8_t* A, std::size_t lda,
+                        const std::int8_t* B, std::size_t ldb,
+                        float* C, std::size_t ldc,
+                        const QuantParams& q = {}, float beta = 0.0f,
+                        std::size_t nthreads = 1, GemmBlocking blk = {})
+{
+    assert(lda >= K && ldb >= N && ldc >= N);
+    assert(K <= (std::size_t(1) << 15));
+
+    if (M == 0 || N == 0) return;
+
+    if (K == 0) {
+        for (std::size_t i = 0; i < M; ++i)
+            for (std::size_t j = 0; j < N; ++j) C[i * ldc + j] = beta == 0.0f ? 0.0f : beta * C[i * ldc + j];
+        return;
+    }
+
+#if HPC_HAVE_AVX512_VNNI
+    if (detail::vnni_usable()) {
+        detail::gemm_u8s8_with<detail::avx512_vnni::QuantKernel>(M, N, K, A, lda, B, ldb, C, ldc,
+                                                                 q, beta, blk, nthreads);
+        return;
+    }
+#endif
+    isa_dispatch([&](auto isa) {
+        using Kern = typename detail::quant_kernel_for<decltype(isa)::value>::type;
+        detail::gemm_u8s8_with<Kern>(M, N, K, A, lda, B, ldb, C, ldc, q, beta, blk, nthreads);
+    });
+}
+
+/// matmul_u8s8 on std::vectors: C resized to M×N.
+inline void matmul_u8s8(std::size_t M, std::size_t N, std::size_t K,
+                        const std::vector<std::uint8_t>& A, const std::vector<std::int8_t>& B,
+                        std::vector<float>& C, const QuantParams& q = {}, std::size_t nthreads = 1)
+{
+    assert(A.size() == M * K);
+    assert(B.size() == K * N);
+
+    C.resize(M * N);
+    matmul_u8s8(M, N, K, A.data(), K, B.data(), N, C.data(), N, q, 0.0f, nthreads);
+}
+
+}
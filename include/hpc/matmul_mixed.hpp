@@ -0,0 +1,312 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <cassert>
+#include <algorithm>
+
+#include "hpc/half.hpp"
+#include "hpc/matmul_packed.hpp"
+
+namespace hpc {
+
+/// Inner kernel of matmul_mixed:
+/// - widen: A and B become float in the packing step and the float
+///   micro-kernel of active_isa() runs (any ISA, bf16 and fp16).
+/// - dot: bf16 stays bf16 in the packed panels and AVX512-BF16 vdpbf16ps
+///   multiplies k pairs; falls back to widen for fp16 or without the
+///   instruction. Half the packing traffic, but vdpbf16ps issues at most
+///   once per cycle (as many flops as two FMAs), so it is not the default.
+enum class MixedKernel { widen, dot };
+
+namespace detail {
+
+/// Pack an mc×kc block of bf16 A into MR-row micro-panels of k pairs: word
+/// (kp, i) holds A(i, 2kp) in its low half and A(i, 2kp+1) in its high half,
+/// the layout vdpbf16ps multiplies pairwise. Odd kc and rows past mc are zero.
+template <std::size_t MR>
+void pack_A_pairs(std::size_t mc, std::size_t kc, const bf16* A, std::size_t rs, std::size_t cs,
+                  std::uint32_t* Ap)
+{
+    for (std::size_t ir = 0; ir < mc; ir += MR) {
+        const std::size_t mr = std::min(MR, mc - ir);
+        const bf16* a = A + ir * rs;
+
+        for (std::size_t k = 0; k < kc; k += 2) {
+            for (std::size_t i = 0; i < mr; ++i) {
+                const std::uint32_t lo = a[i * rs + k * cs].bits;
+                const std::uint32_t hi = k + 1 < kc ? a[i * rs + (k + 1) * cs].bits : 0u;
+                Ap[i] = lo | (hi << 16);
+            }
+            for (std::size_t i = mr; i < MR; ++i) Ap[i] = 0u;
+            Ap += MR;
+        }
+    }
+}
+
+/// Pack a kc×nc panel of bf16 B into NR-column micro-panels of k pairs
+/// (word (kp, j) = B(2kp, j) | B(2kp+1, j) << 16).
+template <std::size_t NR>
+void pack_B_pairs(std::size_t kc, std::size_t nc, const bf16* B, std::size_t rs, std::size_t cs,
+                  std::uint32_t* Bp)
+{
+    for (std::size_t jr = 0; jr < nc; jr += NR) {
+        const std::size_t nr = std::min(NR, nc - jr);
+        const bf16* b = B + jr * cs;
+
+        for (std::size_t k = 0; k < kc; k += 2) {
+            const bf16* b0 = b + k * rs;
+            const bf16* b1 = b0 + rs;
+            for (std::size_t j = 0; j < nr; ++j) {
+                const std::uint32_t hi = k + 1 < kc ? b1[j * cs].bits : 0u;
+                Bp[j] = std::uint32_t(b0[j * cs].bits) | (hi << 16);
+            }
+            for (std::size_t j = nr; j < NR; ++j) Bp[j] = 0u;
+            Bp += NR;
+        }
+    }
+}
+
+/// True when the bf16 dot-product kernel is compiled in and runnable, and the
+/// active ISA is avx512 (so set_active_isa(avx2) also disables it).
+inline bool bf16_dot_usable() {
+#if HPC_HAVE_AVX512_BF16
+    static const bool cpu = cpu_supports(Isa::avx512) && __builtin_cpu_supports("avx512bf16");
+    return cpu && active_isa() == Isa::avx512;
+#else
+    return false;
+#endif
+}
+
+} // namespace detail
+
+}
+
+#if HPC_HAVE_AVX512_BF16
+HPC_TARGET_AVX512BF16_BEGIN
+
+namespace hpc::detail::avx512_bf16 {
+
+/// 6×32 register tile on vdpbf16ps: each step multiplies one k pair of A
+/// (broadcast) with two vectors of B pairs and accumulates in fp32.
+struct DotKernel {
+    static constexpr std::size_t MR = 6;
+    static constexpr std::size_t NV = 2;
+    static constexpr std::size_t NR = NV * 16;
+
+    /// C(mr×nr) = alpha*AB + beta*C over kp k pairs; same epilogue (and beta
+    /// == 0 semantics) as MicroKernel.
+    static void run(std::size_t kp, const std::uint32_t* Ap, const std::uint32_t* Bp,
+                    float* C, std::size_t rsc, std::size_t csc,
+                    std::size_t mr, std::size_t nr, float alpha, float beta)
+    {
+        __m512 acc[MR][NV];
+        for (std::size_t i = 0; i < MR; ++i)
+            for (std::size_t v = 0; v < NV; ++v)
+                acc[i][v] = _mm512_setzero_ps();
+
+        for (std::size_t k = 0; k < kp; ++k) {
+            __m512bh b[NV];
+            for (std::size_t v = 0; v < NV; ++v)
+                b[v] = (__m512bh)_mm512_load_si512(Bp + v * 16);
+
+            for (std::size_t i = 0; i < MR; ++i) {
+                const __m512bh a = (__m512bh)_mm512_set1_epi32(static_cast<int>(Ap[i]));
+                for (std::size_t v = 0; v < NV; ++v)
+                    acc[i][v] = _mm512_dpbf16_ps(acc[i][v], a, b[v]);
+            }
+            Ap += MR;
+            Bp += NR;
+        }
+
+        if (alpha != 1.0f) {
+            const __m512 va = _mm512_set1_ps(alpha);
+            for (std::size_t i = 0; i < MR; ++i)
+                for (std::size_t v = 0; v < NV; ++v)
+                    acc[i][v] = _mm512_mul_ps(acc[i][v], va);
+        }
+
+        if (mr == MR && nr == NR && csc == 1) {
+            const __m512 vb = _mm512_set1_ps(beta);
+            for (std::size_t i = 0; i < MR; ++i) {
+                float* c = C + i * rsc;
+                for (std::size_t v = 0; v < NV; ++v) {
+                    __m512 r = acc[i][v];
+                    if (beta == 1.0f) r = _mm512_add_ps(r, _mm512_loadu_ps(c + v * 16));
+                    else if (beta != 0.0f) r = _mm512_fmadd_ps(vb, _mm512_loadu_ps(c + v * 16), r);
+                    _mm512_storeu_ps(c + v * 16, r);
+                }
+            }
+            return;
+        }
+
+        alignas(64) float tmp[MR * NR];
+        for (std::size_t i = 0; i < MR; ++i)
+            for (std::size_t v = 0; v < NV; ++v)
+                _mm512_store_ps(tmp + i * NR + v * 16, acc[i][v]);
+
+        for (std::size_t i = 0; i < mr; ++i) {
+            for (std::size_t j = 0; j < nr; ++j) {
+                float& c = C[i * rsc + j * csc];
+                c = (beta == 0.0f) ? tmp[i * NR + j] : beta * c + tmp[i * NR + j];
+            }
+        }
+    }
+};
+
+} // namespace hpc::detail::avx512_bf16
+
+HPC_TARGET_END
+#endif
+
+namespace hpc {
+
+namespace detail {
+
+#if HPC_HAVE_AVX512_BF16
+/// gemm_packed_with for bf16 operands on DotKernel: same loop nest, thread
+/// grid and arenas, but A and B stay bf16 and are packed as k pairs.
+inline void gemm_bf16_dot(std::size_t M, std::size_t N, std::size_t K, float alpha,
+                          const bf16* A, std::size_t rsa, std::size_t csa,
+                          const bf16* B, std::size_t rsb, std::size_t csb,
+                          float beta, float* C, std::size_t rsc, std::size_t csc,
+                          GemmBlocking blk, std::size_t nthreads)
+{
+    using Kern = avx512_bf16::DotKernel;
+    constexpr std::size_t MR = Kern::MR;
+    constexpr std::size_t NR = Kern::NR;
+
+    const std::size_t MC = round_up(std::max<std::size_t>(blk.MC, 1), MR);
+    const std::size_t KC = round_up(std::max<std::size_t>(blk.KC, 2), 2);
+    const std::size_t NC = round_up(std::max<std::size_t>(blk.NC, 1), NR);
+
+    const std::size_t tiles = ((M + MR - 1) / MR) * ((N + NR - 1) / NR);
+    nthreads = std::max<std::size_t>(1, std::min(nthreads, tiles));
+
+    Arena& ws = workspace_arena();
+    ArenaScope scope(ws);
+    std::uint32_t* Bp = ws.allocate<std::uint32_t>(KC / 2 * NC);
+
+    auto body = [&](const ThreadContext& ctx) {
+        Arena& wa = workspace_arena();
+        ArenaScope scope_a(wa);
+        std::uint32_t* Ap = wa.allocate<std::uint32_t>(MC * KC / 2);
+
+        const auto grid = gemm_thread_grid(M, N, ctx.nthreads);
+        const std::size_t tm = ctx.tid / grid.second;
+        const std::size_t tn = ctx.tid % grid.second;
+        const auto mrange = split_range(M, grid.first, tm, MR);
+
+        for (std::size_t jc = 0; jc < N; jc += NC) {
+            const std::size_t nc = std::min(NC, N - jc);
+            const auto nrange = split_range(nc, grid.second, tn, NR);
+
+            for (std::size_t pc = 0; pc < K; pc += KC) {
+                const std::size_t kc = std::min(KC, K - pc);
+                const std::size_t kp = (kc + 1) / 2;
+                const float beta_p = (pc == 0) ? beta : 1.0f;
+
+                const std::size_t npanels = (nc + NR - 1) / NR;
+                for (std::size_t p = ctx.tid; p < npanels; p += ctx.nthreads) {
+                    const std::size_t jr = p * NR;
+                    pack_B_pairs<NR>(kc, std::min(NR, nc - jr),
+                                     B + pc * rsb + (jc + jr) * csb, rsb, csb, Bp + jr * kp);
+                }
+                ctx.barrier();
+
+                for (std::size_t ic = mrange.first; ic < mrange.second; ic += MC) {
+                    const std::size_t mc = std::min(MC, mrange.second - ic);
+
+                    pack_A_pairs<MR>(mc, kc, A + ic * rsa + pc * csa, rsa, csa, Ap);
+
+                    for (std::size_t jr = nrange.first; jr < nrange.second; jr += NR) {
+                        const std::size_t nr = std::min(NR, nc - jr);
+
+                        for (std::size_t ir = 0; ir < mc; ir += MR) {
+                            Kern::run(kp, Ap + ir * kp, Bp + jr * kp,
+                                      C + (ic + ir) * rsc + (jc + jr) * csc, rsc, csc,
+                                      std::min(MR, mc - ir), nr, alpha, beta_p);
+                        }
+                    }
+                }
+                ctx.barrier();
+            }
+        }
+    };
+
+    default_pool().run(nthreads, body);
+}
+#endif
+
+/// C(float) = alpha*op(A)·op(B) + beta*C for half-precision A and B on
+/// kernel k (see MixedKernel). Accumulation is fp32 either way.
+template <typename Lo>
+void gemm_mixed(std::size_t M, std::size_t N, std::size_t K, float alpha,
+                const Lo* A, std::size_t rsa, std::size_t csa,
+                const Lo* B, std::size_t rsb, std::size_t csb,
+                float beta, float* C, std::size_t rsc, std::size_t csc,
+                GemmBlocking blk, std::size_t nthreads, MixedKernel k)
+{
+    blk = resolve_blocking<float>(blk, M, N, K);
+#if HPC_HAVE_AVX512_BF16
+    if constexpr (std::is_same<Lo, bf16>::value) {
+        if (k == MixedKernel::dot && M && N && K && alpha != 0.0f && bf16_dot_usable()) {
+            gemm_bf16_dot(M, N, K, alpha, A, rsa, csa, B, rsb, csb, beta, C, rsc, csc, blk, nthreads);
+            return;
+        }
+    }
+#else
+    (void)k;
+#endif
+    isa_dispatch([&](auto isa) {
+        using Kern = typename gemm_kernel_for<decltype(isa)::value, float>::type;
+        gemm_packed_with<float, Kern, Lo, Lo>(M, N, K, alpha, A, rsa, csa, B, rsb, csb,
+                                              beta, C, rsc, csc, blk, nthreads);
+    });
+}
+
+} // namespace detail
+
+/// Name of the kernel matmul_mixed<Lo>(..., k) runs right now: "avx512_bf16"
+/// for the dot-product path, else the active ISA (widening).
+template <typename Lo>
+const char* mixed_kernel_name(MixedKernel k = MixedKernel::widen) {
+    if (k == MixedKernel::dot && std::is_same<Lo, bf16>::value && detail::bf16_dot_usable())
+        return "avx512_bf16";
+    return isa_name(active_isa());
+}
+
+/// Mixed-precision GEMM: C = alpha * A·B + beta * C with bf16 or fp16
+/// A(M×K) and B(K×N), fp32 accumulation and fp32 C, all row-major with
+/// leading dimensions. Error is that of fp32 GEMM on the rounded inputs.
+template <typename Lo>
+void matmul_mixed(std::size_t M, std::size_t N, std::size_t K, float alpha,
+                  const Lo* A, std::size_t lda, const Lo* B, std::size_t ldb,
+                  float beta, float* C, std::size_t ldc,
+                  std::size_t nthreads = 1, GemmBlocking blk = {},
+                  MixedKernel k = MixedKernel::widen)
+{
+    static_assert(is_half<Lo>::value, "matmul_mixed: T must be bf16 or fp16");
+
+    assert(lda >= K && ldb >= N && ldc >= N);
+
+    detail::gemm_mixed<Lo>(M, N, K, alpha, A, lda, 1, B, ldb, 1,
+                           beta, C, ldc, 1, blk, nthreads, k);
+}
+
+/// matmul_mixed on std::vectors: C = A·B, C resized to M×N.
+template <typename Lo>
+void matmul_mixed(std::size_t M, std::size_t N, std::size_t K,
+                  const std::vector<Lo>& A, const std::vector<Lo>& B, std::vector<float>& C,
+                  std::size_t nthreads = 1, GemmBlocking blk = {},
+                  MixedKernel k = MixedKernel::widen)
+{
+    assert(A.size() == M * K);
+    assert(B.size() == K * N);
+
+    C.resize(M * N);
+    matmul_mixed<Lo>(M, N, K, 1.0f, A.data(), K, B.data(), N, 0.0f, C.data(), N, nthreads, blk, k);
+}
+
+}
@@ -0,0 +1,327 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <type_traits>
+#include <cassert>
+#include <algorithm>
+
+#include "hpc/memory.hpp"
+#include "hpc/simd.hpp"
+#include "hpc/dispatch.hpp"
+#include "hpc/epilogue.hpp"
+#include "hpc/tune.hpp"
+#include "hpc/thread_pool.hpp"
+#include "hpc/view.hpp"
+
+namespace hpc {
+
+/// Cache-level blocking for the packed GEMM engine.
+/// MC×KC block of A is sized for L2, KC×NC panel of B for L3,
+/// KC×NR micro-panel of B for L1.
+struct GemmBlocking {
+    std::size_t MC = 0;
+    std::size_t KC = 0;
+    std::size_t NC = 0;
+};
+
+namespace detail {
+
+/// Micro-kernel of each ISA level: gemm_kernel_for<I, T>::type has MR, NR and
+/// run(); see hpc/isa/gemm.inl.
+template <Isa I, typename T>
+struct gemm_kernel_for;
+
+} // namespace detail
+
+}
+
+#define HPC_ISA_KERNELS "hpc/isa/gemm.inl"
+#include "hpc/isa/foreach.inl"
+
+namespace hpc {
+
+namespace detail {
+
+/// Pack an mc×kc block of A (element (i,k) at A[i*rs + k*cs]) into MR-row micro-panels.
+/// Rows past mc are zero-padded so the micro-kernel never branches on edges.
+/// S may be a narrower storage type (bf16/fp16), widened to T while packing.
+template <std::size_t MR, typename S, typename T>
+void pack_A(std::size_t mc, std::size_t kc, const S* A, std::size_t rs, std::size_t cs, T* Ap)
+{
+    for (std::size_t ir = 0; ir < mc; ir += MR) {
+        const std::size_t mr = std::min(MR, mc - ir);
+        const S* a = A + ir * rs;
+
+        for (std::size_t k = 0; k < kc; ++k) {
+            for (std::size_t i = 0; i < mr; ++i) Ap[i] = static_cast<T>(a[i * rs + k * cs]);
+            for (std::size_t i = mr; i < MR; ++i) Ap[i] = T(0);
+            Ap += MR;
+        }
+    }
+}
+
+/// Pack a kc×nc panel of B (element (k,j) at B[k*rs + j*cs]) into NR-column
+/// micro-panels, widening S to T like pack_A.
+template <std::size_t NR, typename S, typename T>
+void pack_B(std::size_t kc, std::size_t nc, const S* B, std::size_t rs, std::size_t cs, T* Bp)
+{
+    for (std::size_t jr = 0; jr < nc; jr += NR) {
+        const std::size_t nr = std::min(NR, nc - jr);
+        const S* b = B + jr * cs;
+
+        for (std::size_t k = 0; k < kc; ++k) {
+            const S* bk = b + k * rs;
+            if (cs == 1 && nr == NR) {
+                for (std::size_t j = 0; j < NR; ++j) Bp[j] = static_cast<T>(bk[j]);
+            } else {
+                for (std::size_t j = 0; j < nr; ++j) Bp[j] = static_cast<T>(bk[j * cs]);
+                for (std::size_t j = nr; j < NR; ++j) Bp[j] = T(0);
+            }
+            Bp += NR;
+        }
+    }
+}
+
+inline std::size_t round_up(std::size_t x, std::size_t m) { return ((x + m - 1) / m) * m; }
+
+} // namespace detail
+
+/// Default MC/KC/NC for T. MC and NC are multiples of every ISA's MR and NR.
+template <typename T>
+GemmBlocking default_blocking() {
+    GemmBlocking b;
+    b.KC = 256;
+    b.MC = sizeof(T) == 4 ? 144 : 96;
+    b.NC = 4096;
+    return b;
+}
+
+/// Fill the zero fields of blk: tuned values for this CPU, ISA and shape class
+/// (hpc/tune.hpp), else default_blocking<T>().
+template <typename T>
+GemmBlocking resolve_blocking(GemmBlocking blk, std::size_t M, std::size_t N, std::size_t K) {
+    if (blk.MC && blk.KC && blk.NC) return blk;
+    const TuneParams& t = tuned_params<T>(M, N, K);
+    const GemmBlocking d = default_blocking<T>();
+    if (!blk.MC) blk.MC = t.MC ? t.MC : d.MC;
+    if (!blk.KC) blk.KC = t.KC ? t.KC : d.KC;
+    if (!blk.NC) blk.NC = t.NC ? t.NC : d.NC;
+    return blk;
+}
+
+/// Factor nthreads into an mt×nt grid whose per-thread C block is closest to square.
+inline std::pair<std::size_t, std::size_t>
+gemm_thread_grid(std::size_t M, std::size_t N, std::size_t nthreads)
+{
+    std::size_t best_m = 1;
+    double best = -1.0;
+
+    for (std::size_t mt = 1; mt <= nthreads; ++mt) {
+        if (nthreads % mt) continue;
+        const std::size_t nt = nthreads / mt;
+        const double bm = double(M) / double(mt), bn = double(N) / double(nt);
+        const double score = std::min(bm, bn) / std::max(bm, bn);
+        if (score > best) { best = score; best_m = mt; }
+    }
+    return {best_m, nthreads / best_m};
+}
+
+namespace detail {
+
+/// Kern::run with an epilogue; compiled only for kernels that take one.
+template <typename Kern, typename T, typename Epi>
+void run_fused(std::size_t kc, const T* Ap, const T* Bp, T* C, std::size_t rsc, std::size_t csc,
+               std::size_t mr, std::size_t nr, T alpha, T beta,
+               const Epi& epi, std::size_t i0, std::size_t j0)
+{
+    if constexpr (!std::is_same<Epi, epilogue::none>::value)
+        Kern::run(kc, Ap, Bp, C, rsc, csc, mr, nr, alpha, beta, epi, i0, j0);
+    else
+        Kern::run(kc, Ap, Bp, C, rsc, csc, mr, nr, alpha, beta);
+}
+
+/// C = alpha*op(A)·op(B) + beta*C on element strides with micro-kernel Kern.
+/// C is written in place: nothing is allocated (packing buffers are per-thread
+/// arenas) and C is never zero-filled, the first KC panel applies beta and the
+/// rest accumulate. A and B may be stored as TA/TB (e.g. bf16) and are
+/// widened to T in the packing step, so the kernel only ever sees T.
+/// epi (see hpc/epilogue.hpp) is applied by the kernel on the last KC panel,
+/// while each tile is still in registers.
+template <typename T, typename Kern, typename TA = T, typename TB = T,
+          typename Epi = epilogue::none>
+void gemm_packed_with(std::size_t M, std::size_t N, std::size_t K, T alpha,
+                      const TA* A, std::size_t rsa, std::size_t csa,
+                      const TB* B, std::size_t rsb, std::size_t csb,
+                      T beta, T* C, std::size_t rsc, std::size_t csc,
+                      GemmBlocking blk, std::size_t nthreads,
+                      const Epi& epi = {})
+{
+    constexpr bool fused = !std::is_same<Epi, epilogue::none>::value;
+    constexpr std::size_t MR = Kern::MR;
+    constexpr std::size_t NR = Kern::NR;
+
+    if (M == 0 || N == 0) return;
+
+    if (K == 0 || alpha == T(0)) {
+        for (std::size_t i = 0; i < M; ++i)
+            for (std::size_t j = 0; j < N; ++j) {
+                T& c = C[i * rsc + j * csc];
+                c = epi((beta == T(0)) ? T(0) : beta * c, i, j);
+            }
+        return;
+    }
+
+    const std::size_t MC = round_up(std::max<std::size_t>(blk.MC, 1), MR);
+    const std::size_t KC = std::max<std::size_t>(blk.KC, 1);
+    const std::size_t NC = round_up(std::max<std::size_t>(blk.NC, 1), NR);
+
+    // Never more threads than MR×NR tiles.
+    const std::size_t tiles = ((M + MR - 1) / MR) * ((N + NR - 1) / NR);
+    nthreads = std::max<std::size_t>(1, std::min(nthreads, tiles));
+
+    // Packing buffers come from the per-thread workspace arenas: the shared B
+    // panel from the caller's, each A block from its packing thread's.
+    Arena& ws = workspace_arena();
+    ArenaScope scope(ws);
+    T* Bp = ws.allocate<T>(KC * NC);
+
+    auto body = [&](const ThreadContext& ctx) {
+        Arena& wa = workspace_arena();
+        ArenaScope scope_a(wa);
+        T* Ap = wa.allocate<T>(MC * KC);
+
+        // Team size comes from ctx: nested calls may run with fewer threads.
+        const auto grid = gemm_thread_grid(M, N, ctx.nthreads);
+        const std::size_t tm = ctx.tid / grid.second;
+        const std::size_t tn = ctx.tid % grid.second;
+        const auto mrange = split_range(M, grid.first, tm, MR);
+
+        for (std::size_t jc = 0; jc < N; jc += NC) {
+            const std::size_t nc = std::min(NC, N - jc);
+            const auto nrange = split_range(nc, grid.second, tn, NR);
+
+            for (std::size_t pc = 0; pc < K; pc += KC) {
+                const std::size_t kc = std::min(KC, K - pc);
+                const T beta_p = (pc == 0) ? beta : T(1);
+                const bool last = pc + kc == K;
+
+                // Cooperative pack of the shared B panel, one NR micro-panel per slot.
+                const std::size_t npanels = (nc + NR - 1) / NR;
+                for (std::size_t p = ctx.tid; p < npanels; p += ctx.nthreads) {
+                    const std::size_t jr = p * NR;
+                    pack_B<NR>(kc, std::min(NR, nc - jr),
+                               B + pc * rsb + (jc + jr) * csb, rsb, csb, Bp + jr * kc);
+                }
+                ctx.barrier();
+
+                for (std::size_t ic = mrange.first; ic < mrange.second; ic += MC) {
+                    const std::size_t mc = std::min(MC, mrange.second - ic);
+
+                    pack_A<MR>(mc, kc, A + ic * rsa + pc * csa, rsa, csa, Ap);
+
+                    for (std::size_t jr = nrange.first; jr < nrange.second; jr += NR) {
+                        const std::size_t nr = std::min(NR, nc - jr);
+
+                        for (std::size_t ir = 0; ir < mc; ir += MR) {
+                            const std::size_t mr = std::min(MR, mc - ir);
+
+                            T* c = C + (ic + ir) * rsc + (jc + jr) * csc;
+                            if (fused && last)
+                                run_fused<Kern>(kc, Ap + ir * kc, Bp + jr * kc, c, rsc, csc,
+                                                mr, nr, alpha, beta_p, epi, ic + ir, jc + jr);
+                            else
+                                Kern::run(kc, Ap + ir * kc, Bp + jr * kc, c, rsc, csc,
+                                          mr, nr, alpha, beta_p);
+                        }
+                    }
+                }
+                ctx.barrier(); // B panel is repacked next iteration
+            }
+        }
+    };
+
+    default_pool().run(nthreads, body);
+}
+
+/// gemm_packed_with on the micro-kernel of active_isa(); zero fields of blk
+/// are resolved with resolve_blocking.
+template <typename T, typename Epi = epilogue::none>
+void gemm_packed(std::size_t M, std::size_t N, std::size_t K, T alpha,
+                 const T* A, std::size_t rsa, std::size_t csa,
+                 const T* B, std::size_t rsb, std::size_t csb,
+                 T beta, T* C, std::size_t rsc, std::size_t csc,
+                 GemmBlocking blk, std::size_t nthreads,
+                 const Epi& epi = {})
+{
+    blk = resolve_blocking<T>(blk, M, N, K);
+    isa_dispatch([&](auto isa) {
+        using Kern = typename gemm_kernel_for<decltype(isa)::value, T>::type;
+        gemm_packed_with<T, Kern, T, T, Epi>(M, N, K, alpha, A, rsa, csa, B, rsb, csb,
+                                             beta, C, rsc, csc, blk, nthreads, epi);
+    });
+}
+
+} // namespace detail
+
+/// BLAS-style GEMM on caller-owned views:
+/// C = alpha * op(A) · op(B) + beta * C, op() = identity or transpose.
+/// Any mix of row-/col-major operands and leading dimensions; nothing is
+/// allocated or zero-filled. Runs the packed engine on nthreads threads.
+/// Blocking fields left at 0 come from the tuning file (see hpc/tune.hpp).
+/// epi is fused into the store of C: C(i,j) = epi(C(i,j), i, j), e.g.
+/// epilogue::make_chain(epilogue::bias<float>{b}, epilogue::relu{}).
+template <typename T, typename Epi = epilogue::none>
+void gemm(Trans ta, Trans tb,
+          detail::nodeduce_t<T> alpha,
+          detail::nodeduce_t<MatrixView<const T>> A,
+          detail::nodeduce_t<MatrixView<const T>> B,
+          detail::nodeduce_t<T> beta,
+          MatrixView<T> C,
+          std::size_t nthreads = 1,
+          GemmBlocking blk = {},
+          const Epi& epi = {})
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "gemm: T must be float or double");
+
+    const auto a = detail::operand_layout(A, ta);
+    const auto b = detail::operand_layout(B, tb);
+
+    assert(a.cols == b.rows);
+    assert(C.rows == a.rows && C.cols == b.cols);
+    (void)b;
+
+    detail::gemm_packed<T>(C.rows, C.cols, a.cols, alpha,
+                           A.data, a.rs, a.cs, B.data, b.rs, b.cs,
+                           beta, C.data, C.rs(), C.cs(), blk, nthreads, epi);
+}
+
+/// Packed GEMM (BLIS-style 5-loop):
+/// A(M×K) · B(K×N) = C(M×N), row-major.
+/// A and B are copied into contiguous aligned micro-panels, and an MR×NR
+/// register-tile micro-kernel (FMA intrinsics) does the inner work.
+///
+/// With nthreads > 1 the region runs on default_pool(): the team packs each
+/// KC×NC panel of B once into a shared buffer, then C is split over an
+/// mt×nt thread grid (MR rows × NR columns granularity) and every thread
+/// packs its own A blocks.
+template <typename T>
+void matmul_packed(std::size_t M, std::size_t N, std::size_t K,
+                   const std::vector<T>& A,
+                   const std::vector<T>& B,
+                   std::vector<T>& C,
+                   GemmBlocking blk = {},
+                   std::size_t nthreads = 1)
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "matmul_packed: T must be float or double");
+
+    assert(A.size() == M * K);
+    assert(B.size() == K * N);
+
+    C.resize(M * N);
+    detail::gemm_packed<T>(M, N, K, T(1), A.data(), K, 1, B.data(), N, 1,
+                           T(0), C.data(), N, 1, blk, nthreads);
+}
+
+}
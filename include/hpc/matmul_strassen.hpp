@@ -0,0 +1,184 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+
+#include "hpc/memory.hpp"
+#include "hpc/thread_pool.hpp"
+#include "hpc/matmul_packed.hpp"
+
+namespace hpc {
+
+/// Default recursion cutoff of matmul_strassen: blocks whose smallest
+/// dimension is at or below it go to the packed engine.
+constexpr std::size_t strassen_default_crossover = 512;
+
+namespace detail {
+
+/// Cache-line rounded to whole elements of T.
+template <typename T>
+std::size_t strassen_round(std::size_t n) {
+    return round_up(n, cache_line_bytes / sizeof(T));
+}
+
+inline bool strassen_recurses(std::size_t M, std::size_t N, std::size_t K, std::size_t crossover) {
+    return std::min({M, N, K}) > std::max<std::size_t>(crossover, 1);
+}
+
+/// Elements of workspace the recursion needs for an M×N×K product: each
+/// level holds X (m/2 × max(k/2, n/2)) and Y (k/2 × n/2), and the sibling
+/// products of a level reuse the region below it.
+template <typename T>
+std::size_t strassen_workspace(std::size_t M, std::size_t N, std::size_t K, std::size_t crossover) {
+    std::size_t total = 0;
+    while (strassen_recurses(M, N, K, crossover)) {
+        M /= 2; N /= 2; K /= 2;
+        total += strassen_round<T>(M * std::max(K, N)) + strassen_round<T>(K * N);
+    }
+    return total;
+}
+
+/// Z = X + s*Y on an m×n block, rows split over nthreads.
+template <typename T>
+void strassen_axpy(std::size_t m, std::size_t n, const T* X, std::size_t ldx,
+                   T s, const T* Y, std::size_t ldy, T* Z, std::size_t ldz, std::size_t nthreads)
+{
+    auto rows = [&](std::size_t i0, std::size_t i1) {
+        for (std::size_t i = i0; i < i1; ++i) {
+            const T* x = X + i * ldx;
+            const T* y = Y + i * ldy;
+            T* z = Z + i * ldz;
+            for (std::size_t j = 0; j < n; ++j) z[j] = x[j] + s * y[j];
+        }
+    };
+    if (nthreads <= 1) { rows(0, m); return; }
+    default_pool().run(nthreads, [&](const ThreadContext& ctx) {
+        const auto r = split_range(m, ctx.nthreads, ctx.tid);
+        rows(r.first, r.second);
+    });
+}
+
+/// C(M×N) = A·B, all row-major; ws holds strassen_workspace<T>() elements.
+/// One Strassen-Winograd level (7 products, 15 additions) in the order of
+/// Boyer et al., "Memory efficient scheduling of Strassen-Winograd's matrix
+/// multiplication algorithm" (2009): the C quadrants are the scratch space
+/// for the products, so a level only needs X and Y. Odd dimensions are
+/// peeled: the even part recurses, the last row / column / k is fixed up
+/// with the packed engine.
+template <typename T>
+void strassen_rec(std::size_t M, std::size_t N, std::size_t K,
+                  const T* A, std::size_t lda, const T* B, std::size_t ldb,
+                  T* C, std::size_t ldc, T* ws,
+                  std::size_t crossover, GemmBlocking blk, std::size_t nthreads)
+{
+    if (!strassen_recurses(M, N, K, crossover)) {
+        gemm_packed<T>(M, N, K, T(1), A, lda, 1, B, ldb, 1, T(0), C, ldc, 1, blk, nthreads);
+        return;
+    }
+
+    const std::size_t m2 = M / 2, n2 = N / 2, k2 = K / 2;
+    const std::size_t ldx = std::max(k2, n2), ldy = n2;
+    T* X = ws;
+    T* Y = X + strassen_round<T>(m2 * ldx);
+    T* next = Y + strassen_round<T>(k2 * n2);
+
+    const T *A11 = A, *A12 = A + k2, *A21 = A + m2 * lda, *A22 = A21 + k2;
+    const T *B11 = B, *B12 = B + n2, *B21 = B + k2 * ldb, *B22 = B21 + n2;
+    T *C11 = C, *C12 = C + n2, *C21 = C + m2 * ldc, *C22 = C21 + n2;
+
+    auto add = [&](std::size_t m, std::size_t n, const T* P, std::size_t ldp, T s,
+                   const T* Q, std::size_t ldq, T* R, std::size_t ldr) {
+        strassen_axpy<T>(m, n, P, ldp, s, Q, ldq, R, ldr, nthreads);
+    };
+    auto mul = [&](const T* P, std::size_t ldp, const T* Q, std::size_t ldq, T* R, std::size_t ldr) {
+        strassen_rec<T>(m2, n2, k2, P, ldp, Q, ldq, R, ldr, next, crossover, blk, nthreads);
+    };
+
+    add(m2, k2, A11, lda, T(-1), A21, lda, X, ldx);   // S3 = A11 - A21
+    add(k2, n2, B22, ldb, T(-1), B12, ldb, Y, ldy);   // T3 = B22 - B12
+    mul(X, ldx, Y, ldy, C21, ldc);                     // P7 = S3·T3
+    add(m2, k2, A21, lda, T(1), A22, lda, X, ldx);    // S1 = A21 + A22
+    add(k2, n2, B12, ldb, T(-1), B11, ldb, Y, ldy);   // T1 = B12 - B11
+    mul(X, ldx, Y, ldy, C22, ldc);                     // P5 = S1·T1
+    add(m2, k2, X, ldx, T(-1), A11, lda, X, ldx);     // S2 = S1 - A11
+    add(k2, n2, B22, ldb, T(-1), Y, ldy, Y, ldy);     // T2 = B22 - T1
+    mul(X, ldx, Y, ldy, C12, ldc);                     // P6 = S2·T2
+    add(m2, k2, A12, lda, T(-1), X, ldx, X, ldx);     // S4 = A12 - S2
+    mul(X, ldx, B22, ldb, C11, ldc);                   // P3 = S4·B22
+    mul(A11, lda, B11, ldb, X, ldx);                   // P1 = A11·B11
+    add(m2, n2, X, ldx, T(1), C12, ldc, C12, ldc);    // U2 = P1 + P6
+    add(m2, n2, C12, ldc, T(1), C21, ldc, C21, ldc);  // U3 = U2 + P7
+    add(m2, n2, C12, ldc, T(1), C22, ldc, C12, ldc);  // U4 = U2 + P5
+    add(m2, n2, C21, ldc, T(1), C22, ldc, C22, ldc);  // C22 = U3 + P5
+    add(m2, n2, C12, ldc, T(1), C11, ldc, C12, ldc);  // C12 = U4 + P3
+    add(k2, n2, Y, ldy, T(-1), B21, ldb, Y, ldy);     // T4 = T2 - B21
+    mul(A22, lda, Y, ldy, C11, ldc);                   // P4 = A22·T4
+    add(m2, n2, C21, ldc, T(-1), C11, ldc, C21, ldc); // C21 = U3 - P4
+    mul(A12, lda, B21, ldb, C11, ldc);                 // P2 = A12·B21
+    add(m2, n2, C11, ldc, T(1), X, ldx, C11, ldc);    // C11 = P1 + P2
+
+    const std::size_t m = 2 * m2, n = 2 * n2, k = 2 * k2;
+    if (k < K) // C(0:m, 0:n) += A(0:m, k) · B(k, 0:n)
+        gemm_packed<T>(m, n, K - k, T(1), A + k, lda, 1, B + k * ldb, ldb, 1,
+                       T(1), C, ldc, 1, blk, nthreads);
+    if (n < N) // last column, all rows
+        gemm_packed<T>(M, N - n, K, T(1), A, lda, 1, B + n, ldb, 1,
+                       T(0), C + n, ldc, 1, blk, nthreads);
+    if (m < M) // last row, the even columns
+        gemm_packed<T>(M - m, n, K, T(1), A + m * lda, lda, 1, B, ldb, 1,
+                       T(0), C + m * ldc, ldc, 1, blk, nthreads);
+}
+
+} // namespace detail
+
+/// Strassen-Winograd GEMM on caller memory: C(M×N) = A(M×K)·B(K×N),
+/// row-major with leading dimensions, C overwritten. Each level halves all
+/// three dimensions and does 7 half-size products instead of 8; blocks whose
+/// smallest dimension is <= crossover (0: strassen_default_crossover) run on
+/// the packed engine with blk and nthreads, which also thread the additions.
+/// The temporaries of every level come from one workspace_arena() block
+/// sized up front. max |C - AB| / (K max|A| max|B|) roughly doubles per
+/// level, so the cutoff is an accuracy knob as well.
+template <typename T>
+void matmul_strassen(std::size_t M, std::size_t N, std::size_t K,
+                     const T* A, std::size_t lda,
+                     const T* B, std::size_t ldb,
+                     T* C, std::size_t ldc,
+                     std::size_t nthreads = 1,
+                     std::size_t crossover = 0,
+                     GemmBlocking blk = {})
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "matmul_strassen: T must be float or double");
+
+    if (M == 0 || N == 0) return;
+    if (crossover == 0) crossover = strassen_default_crossover;
+
+    Arena& ws = workspace_arena();
+    ArenaScope scope(ws);
+    T* w = ws.allocate<T>(detail::strassen_workspace<T>(M, N, K, crossover));
+    detail::strassen_rec<T>(M, N, K, A, lda, B, ldb, C, ldc, w, crossover, blk, nthreads);
+}
+
+/// Strassen-Winograd GEMM on vectors: C = A(M×K)·B(K×N), row-major.
+template <typename T>
+void matmul_strassen(std::size_t M, std::size_t N, std::size_t K,
+                     const std::vector<T>& A,
+                     const std::vector<T>& B,
+                     std::vector<T>& C,
+                     std::size_t nthreads = 1,
+                     std::size_t crossover = 0)
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "matmul_strassen: T must be float or double");
+
+    assert(A.size() == M * K);
+    assert(B.size() == K * N);
+
+    C.resize(M * N);
+    matmul_strassen<T>(M, N, K, A.data(), K, B.data(), N, C.data(), N, nthreads, crossover);
+}
+
+}
@@ -0,0 +1,295 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "hpc/thread_pool.hpp"
+
+namespace hpc {
+
+constexpr std::size_t cache_line_bytes = 64;
+constexpr std::size_t huge_page_bytes  = std::size_t(2) << 20;
+
+/// Page placement of a buffer across NUMA nodes.
+/// - local: the kernel's default, pages go to the node of the first toucher.
+/// - interleave: round-robin over all nodes (full-node bandwidth without pinning).
+/// - bind: every page on BufferOptions::numa_node.
+enum class NumaPolicy { local, interleave, bind };
+
+/// How a buffer is allocated and (optionally) first-touched.
+struct BufferOptions {
+    std::size_t alignment = cache_line_bytes; // power of two
+    bool huge_pages = false;                  // 2 MiB alignment + MADV_HUGEPAGE (Linux)
+    std::size_t first_touch_threads = 0;      // 0: leave pages untouched; N: zero them on N pool threads
+    std::size_t touch_grain = cache_line_bytes; // first-touch split unit in bytes; match the kernel's partition
+    NumaPolicy numa = NumaPolicy::local;
+    int numa_node = 0;                        // NumaPolicy::bind only
+};
+
+namespace detail {
+
+inline std::size_t align_up(std::size_t x, std::size_t a) { return (x + a - 1) & ~(a - 1); }
+
+inline std::size_t page_bytes() {
+#if defined(__linux__)
+    static const std::size_t n = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return n;
+#else
+    return 4096;
+#endif
+}
+
+inline std::size_t effective_alignment(const BufferOptions& o) {
+    const std::size_t a = std::max<std::size_t>(o.alignment, alignof(std::max_align_t));
+    if (o.huge_pages) return std::max(a, huge_page_bytes);
+    return o.numa == NumaPolicy::local ? a : std::max(a, page_bytes()); // mbind works on whole pages
+}
+
+/// Apply o.numa to the untouched pages [p, p+bytes) (mbind, moving pages
+/// already faulted in). Advisory like MADV_HUGEPAGE: false when it failed.
+inline bool apply_numa(void* p, std::size_t bytes, const BufferOptions& o) {
+    if (o.numa == NumaPolicy::local) return true;
+#if defined(__linux__) && defined(SYS_mbind)
+    constexpr int mpol_bind = 2, mpol_interleave = 3;   // <linux/mempolicy.h>
+    constexpr unsigned mpol_mf_move = 1u << 1;
+    constexpr std::size_t bits = 8 * sizeof(unsigned long);
+    unsigned long mask[1024 / bits] = {};
+    auto add = [&](int node) {
+        if (node >= 0 && node < 1024) mask[node / bits] |= 1ul << (node % bits);
+    };
+    if (o.numa == NumaPolicy::bind) add(o.numa_node);
+    else for (int n = 0; n < topology().nodes; ++n) add(n);
+
+    const int mode = o.numa == NumaPolicy::bind ? mpol_bind : mpol_interleave;
+    return ::syscall(SYS_mbind, p, bytes, mode, mask, 1024 + 1, mpol_mf_move) == 0;
+#else
+    (void)p; (void)bytes;
+    return false;
+#endif
+}
+
+/// Part tid of n elements of elem bytes, split for first touch in whole
+/// o.touch_grain units (rows, reduction chunks, ...), as the kernels split work.
+inline std::pair<std::size_t, std::size_t>
+touch_range(const BufferOptions& o, std::size_t n, std::size_t elem, std::size_t nthreads, std::size_t tid) {
+    const std::size_t grain = std::max<std::size_t>(1, o.touch_grain / elem);
+    return split_range(n, nthreads, tid, grain);
+}
+
+/// Zero [p, p+bytes) with the same static split the parallel kernels use, so
+/// every page is first touched by the thread (and NUMA node) that will use it.
+inline void first_touch(void* p, std::size_t bytes, const BufferOptions& o) {
+    auto* c = static_cast<unsigned char*>(p);
+    default_pool().run(o.first_touch_threads, [&](const ThreadContext& ctx) {
+        const auto r = touch_range(o, bytes, 1, ctx.nthreads, ctx.tid);
+        std::memset(c + r.first, 0, r.second - r.first);
+    });
+}
+
+} // namespace detail
+
+/// Allocate bytes with the requested alignment / huge-page policy.
+/// Returned size is rounded up to the alignment; release with aligned_free.
+inline void* aligned_malloc(std::size_t bytes, const BufferOptions& opt = {}) {
+    const std::size_t align = detail::effective_alignment(opt);
+    const std::size_t size = detail::align_up(std::max<std::size_t>(bytes, 1), align);
+
+    void* p = ::operator new(size, std::align_val_t(align));
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (opt.huge_pages) ::madvise(p, size, MADV_HUGEPAGE); // advisory; ignore failure
+#endif
+
+    detail::apply_numa(p, size, opt);
+    if (opt.first_touch_threads > 0) detail::first_touch(p, size, opt);
+    return p;
+}
+
+inline void aligned_free(void* p, const BufferOptions& opt = {}) {
+    if (p) ::operator delete(p, std::align_val_t(detail::effective_alignment(opt)));
+}
+
+/// Owning, move-only, aligned array of trivially copyable T.
+/// Contents are uninitialised unless first_touch_threads > 0 (then zeroed).
+template <typename T>
+class AlignedBuffer {
+public:
+    AlignedBuffer() = default;
+
+    explicit AlignedBuffer(std::size_t n, BufferOptions opt = {})
+        : n_(n), opt_(opt)
+    {
+        if (n_) p_ = static_cast<T*>(aligned_malloc(n_ * sizeof(T), opt_));
+    }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    AlignedBuffer(AlignedBuffer&& o) noexcept
+        : p_(std::exchange(o.p_, nullptr)), n_(std::exchange(o.n_, 0)), opt_(o.opt_) {}
+
+    AlignedBuffer& operator=(AlignedBuffer&& o) noexcept {
+        if (this != &o) {
+            aligned_free(p_, opt_);
+            p_ = std::exchange(o.p_, nullptr);
+            n_ = std::exchange(o.n_, 0);
+            opt_ = o.opt_;
+        }
+        return *this;
+    }
+
+    ~AlignedBuffer() { aligned_free(p_, opt_); }
+
+    T* data() { return p_; }
+    const T* data() const { return p_; }
+    std::size_t size() const { return n_; }
+    bool empty() const { return n_ == 0; }
+
+    T* begin() { return p_; }
+    T* end() { return p_ + n_; }
+    const T* begin() const { return p_; }
+    const T* end() const { return p_ + n_; }
+
+    T& operator[](std::size_t i) { return p_[i]; }
+    const T& operator[](std::size_t i) const { return p_[i]; }
+
+private:
+    T* p_ = nullptr;
+    std::size_t n_ = 0;
+    BufferOptions opt_{};
+};
+
+/// Bump allocator for kernel workspaces.
+/// allocate() is a pointer bump; release(mark)/reset() give memory back in
+/// LIFO order without freeing it. When a request does not fit, the next
+/// chained block is tried and only then a new one is added, so repeated calls
+/// with the same footprint stop touching the system allocator after the first.
+/// reset() also coalesces chained blocks into one of the high-water size.
+class Arena {
+public:
+    struct Mark {
+        std::size_t block = 0;
+        std::size_t offset = 0;
+    };
+
+    explicit Arena(std::size_t initial_bytes = 0, BufferOptions opt = {}) : opt_(opt) {
+        if (initial_bytes) add_block(initial_bytes);
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() { free_blocks(); }
+
+    void* allocate_bytes(std::size_t bytes, std::size_t align = cache_line_bytes) {
+        for (; cur_ < blocks_.size(); ++cur_, off_ = 0) {
+            Block& b = blocks_[cur_];
+            const std::size_t base = reinterpret_cast<std::uintptr_t>(b.ptr);
+            const std::size_t off = detail::align_up(base + off_, align) - base;
+            if (off + bytes <= b.size) {
+                off_ = off + bytes;
+                high_ = std::max(high_, used());
+                return b.ptr + off;
+            }
+            if (cur_ + 1 == blocks_.size()) break;
+        }
+
+        // Chain a new block big enough for this request (and geometric growth).
+        const std::size_t last = blocks_.empty() ? 0 : blocks_.back().size;
+        add_block(std::max(bytes + align, 2 * last));
+        cur_ = blocks_.size() - 1;
+        off_ = 0;
+        return allocate_bytes(bytes, align);
+    }
+
+    template <typename T>
+    T* allocate(std::size_t n, std::size_t align = cache_line_bytes) {
+        return static_cast<T*>(allocate_bytes(n * sizeof(T), std::max(align, alignof(T))));
+    }
+
+    Mark mark() const { return {cur_, off_}; }
+
+    /// Drop everything allocated after m.
+    void release(const Mark& m) {
+        cur_ = m.block;
+        off_ = m.offset;
+    }
+
+    /// Drop everything; coalesce chained blocks into one.
+    void reset() {
+        if (blocks_.size() > 1) {
+            const std::size_t total = high_;
+            free_blocks();
+            add_block(total);
+        }
+        cur_ = 0;
+        off_ = 0;
+    }
+
+    /// Bytes currently handed out (approximate across chained blocks).
+    std::size_t used() const {
+        std::size_t u = off_;
+        for (std::size_t i = 0; i < cur_; ++i) u += blocks_[i].size;
+        return u;
+    }
+
+    std::size_t capacity() const {
+        std::size_t c = 0;
+        for (const auto& b : blocks_) c += b.size;
+        return c;
+    }
+
+private:
+    struct Block {
+        unsigned char* ptr;
+        std::size_t size;
+    };
+
+    void add_block(std::size_t bytes) {
+        const std::size_t size = detail::align_up(bytes, detail::effective_alignment(opt_));
+        blocks_.push_back({static_cast<unsigned char*>(aligned_malloc(size, opt_)), size});
+    }
+
+    void free_blocks() {
+        for (auto& b : blocks_) aligned_free(b.ptr, opt_);
+        blocks_.clear();
+    }
+
+    BufferOptions opt_;
+    std::vector<Block> blocks_;
+    std::size_t cur_ = 0;
+    std::size_t off_ = 0;
+    std::size_t high_ = 0;
+};
+
+/// RAII: restores an arena to its state at construction.
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena& a) : a_(a), m_(a.mark()) {}
+    ~ArenaScope() { a_.release(m_); }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    Arena& a_;
+    Arena::Mark m_;
+};
+
+/// Per-thread workspace arena used by kernels for packing / scratch buffers.
+inline Arena& workspace_arena() {
+    thread_local Arena arena;
+    return arena;
+}
+
+}
@@ -0,0 +1,328 @@
+#pragma once
+#include <mpi.h>
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "hpc/view.hpp"
+#include "hpc/matmul_packed.hpp"
+#include "hpc/reduction.hpp"
+#include "hpc/scan.hpp"
+#include "hpc/thread_pool.hpp"
+
+// Distributed kernels over MPI on top of the single-node ones. Needs an MPI
+// build (cmake -DHPC_MPI=ON); the caller owns MPI_Init / MPI_Finalize.
+
+namespace hpc {
+
+namespace detail {
+
+template <typename T>
+MPI_Datatype mpi_type() {
+    if constexpr (std::is_same<T, float>::value) return MPI_FLOAT;
+    else if constexpr (std::is_same<T, double>::value) return MPI_DOUBLE;
+    else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value && sizeof(T) == 4) return MPI_INT32_T;
+    else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value && sizeof(T) == 8) return MPI_INT64_T;
+    else if constexpr (std::is_integral<T>::value && sizeof(T) == 4) return MPI_UINT32_T;
+    else {
+        static_assert(std::is_integral<T>::value && sizeof(T) == 8,
+                      "mpi_type: T must be float, double or a 32/64-bit integer");
+        return MPI_UINT64_T;
+    }
+}
+
+inline int mpi_count(std::size_t n) {
+    assert(n <= std::size_t(std::numeric_limits<int>::max()));
+    return static_cast<int>(n);
+}
+
+} // namespace detail
+
+/// Where one call spent this rank's time, in seconds: compute is the local
+/// kernels, comm the rest of the call (packing, posting and the part of the
+/// message waits the compute did not hide). bytes: payload this rank sent or
+/// received.
+struct MpiTimes {
+    double compute = 0;
+    double comm = 0;
+    std::size_t bytes = 0;
+
+    MpiTimes& operator+=(const MpiTimes& o) {
+        compute += o.compute;
+        comm += o.comm;
+        bytes += o.bytes;
+        return *this;
+    }
+};
+
+/// Process grid of `layers` stacked pr × pc layers (2.5D); pr × pc is the
+/// most square factorisation of size / layers. Rank r sits in layer
+/// r / (pr*pc) at row (r % (pr*pc)) / pc, column r % pc. row_comm holds a
+/// layer's grid row (ranked by column), col_comm its grid column (ranked by
+/// row), layer_comm the ranks at the same (row, col) across layers.
+class ProcessGrid {
+public:
+    explicit ProcessGrid(MPI_Comm comm = MPI_COMM_WORLD, int layers = 1) {
+        MPI_Comm_dup(comm, &world);
+        MPI_Comm_rank(world, &rank);
+        MPI_Comm_size(world, &size);
+        if (layers < 1 || size % layers != 0) {
+            MPI_Comm_free(&world);
+            throw std::runtime_error("ProcessGrid: " + std::to_string(layers)
+                                     + " layers do not divide " + std::to_string(size) + " ranks");
+        }
+        this->layers = layers;
+        const int q = size / layers;
+        pr = 1;
+        for (int d = 1; d * d <= q; ++d)
+            if (q % d == 0) pr = d;
+        pc = q / pr;
+        layer = rank / q;
+        row = (rank % q) / pc;
+        col = rank % pc;
+        MPI_Comm_split(world, layer * pr + row, col, &row_comm);
+        MPI_Comm_split(world, layer * pc + col, row, &col_comm);
+        MPI_Comm_split(world, rank % q, layer, &layer_comm);
+    }
+
+    ~ProcessGrid() {
+        MPI_Comm_free(&layer_comm);
+        MPI_Comm_free(&col_comm);
+        MPI_Comm_free(&row_comm);
+        MPI_Comm_free(&world);
+    }
+
+    ProcessGrid(const ProcessGrid&) = delete;
+    ProcessGrid& operator=(const ProcessGrid&) = delete;
+
+    MPI_Comm world = MPI_COMM_NULL, row_comm = MPI_COMM_NULL;
+    MPI_Comm col_comm = MPI_COMM_NULL, layer_comm = MPI_COMM_NULL;
+    int rank = 0, size = 1;
+    int layers = 1, layer = 0;
+    int pr = 1, pc = 1, row = 0, col = 0;
+};
+
+/// This rank's blocks of C = A·B (M×N, K inner) on grid g, as [begin, end)
+/// ranges from split_range: C and A rows, C and B columns, A columns, B rows.
+/// Every layer holds the same blocks.
+struct SummaBlocks {
+    std::pair<std::size_t, std::size_t> rows, cols, a_cols, b_rows;
+};
+
+inline SummaBlocks summa_blocks(const ProcessGrid& g, std::size_t M, std::size_t N, std::size_t K) {
+    return {split_range(M, std::size_t(g.pr), std::size_t(g.row)),
+            split_range(N, std::size_t(g.pc), std::size_t(g.col)),
+            split_range(K, std::size_t(g.pc), std::size_t(g.col)),
+            split_range(K, std::size_t(g.pr), std::size_t(g.row))};
+}
+
+namespace detail {
+
+/// Part p of split_range(n, parts, .) holding index k.
+inline int split_owner(std::size_t n, int parts, std::size_t k) {
+    int p = 0;
+    while (p + 1 < parts && split_range(n, std::size_t(parts), std::size_t(p)).second <= k) ++p;
+    return p;
+}
+
+/// K panels of layer l: its split_range(K, layers, l) slice cut at every
+/// A column / B row block boundary (so one rank owns each panel) and then
+/// into steps of at most kb.
+inline std::vector<std::pair<std::size_t, std::size_t>>
+summa_panels(const ProcessGrid& g, std::size_t K, std::size_t kb) {
+    const auto slice = split_range(K, std::size_t(g.layers), std::size_t(g.layer));
+    std::vector<std::size_t> cut{slice.first, slice.second};
+    for (int j = 1; j < g.pc; ++j) cut.push_back(split_range(K, std::size_t(g.pc), std::size_t(j)).first);
+    for (int i = 1; i < g.pr; ++i) cut.push_back(split_range(K, std::size_t(g.pr), std::size_t(i)).first);
+    std::sort(cut.begin(), cut.end());
+    cut.erase(std::unique(cut.begin(), cut.end()), cut.end());
+
+    std::vector<std::pair<std::size_t, std::size_t>> panels;
+    for (std::size_t c = 0; c + 1 < cut.size(); ++c) {
+        if (cut[c] < slice.first || cut[c + 1] > slice.second) continue;
+        for (std::size_t k = cut[c]; k < cut[c + 1]; k += kb) panels.push_back({k, std::min(k + kb, cut[c + 1])});
+    }
+    return panels;
+}
+
+/// Row slices a panel's local GEMM is cut into; the pending broadcasts are
+/// tested between slices so MPI libraries without a progress thread still
+/// move the next panel while this one is multiplied.
+constexpr std::size_t summa_progress_slices = 4;
+
+} // namespace detail
+
+/// SUMMA / 2.5D GEMM: C = alpha·A·B + beta·C over grid g, row-major blocks
+/// as given by summa_blocks (A: rows × a_cols, B: b_rows × cols, C: rows ×
+/// cols, leading dimensions lda / ldb / ldc).
+/// Each layer multiplies its K slice panel by panel: the owner column
+/// broadcasts an A panel along grid rows and the owner row a B panel down
+/// grid columns, and the next panel's non-blocking broadcasts are in flight
+/// while the packed gemm works on the current one. With layers > 1 the
+/// layers' partial C blocks are then summed with one allreduce; only layer 0
+/// applies beta. The layers trade memory (inputs replicated c times) for
+/// c times less broadcast volume per rank.
+template <typename T>
+MpiTimes summa_gemm(const ProcessGrid& g, std::size_t M, std::size_t N, std::size_t K,
+                    T alpha, const T* A, std::size_t lda, const T* B, std::size_t ldb,
+                    T beta, T* C, std::size_t ldc, std::size_t nthreads = 1, std::size_t kb = 256)
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "summa_gemm: T must be float or double");
+
+    const double t_start = MPI_Wtime();
+    MpiTimes st;
+    const SummaBlocks blk = summa_blocks(g, M, N, K);
+    const std::size_t m = blk.rows.second - blk.rows.first;
+    const std::size_t n = blk.cols.second - blk.cols.first;
+    const MPI_Datatype type = detail::mpi_type<T>();
+
+    kb = std::max<std::size_t>(kb, 1);
+    const auto panels = detail::summa_panels(g, K, kb);
+    const T beta0 = g.layer == 0 ? beta : T(0);
+
+    if (panels.empty()) {
+        for (std::size_t i = 0; i < m; ++i)
+            for (std::size_t j = 0; j < n; ++j) {
+                T& c = C[i * ldc + j];
+                c = beta0 == T(0) ? T(0) : beta0 * c;
+            }
+    }
+
+    // Double-buffered panels: slot p % 2 is multiplied while slot (p+1) % 2 arrives.
+    std::vector<T> abuf[2], bbuf[2];
+    for (int s = 0; s < 2; ++s) {
+        abuf[s].resize(m * kb);
+        bbuf[s].resize(kb * n);
+    }
+    MPI_Request req[2][2] = {{MPI_REQUEST_NULL, MPI_REQUEST_NULL}, {MPI_REQUEST_NULL, MPI_REQUEST_NULL}};
+
+    auto post = [&](std::size_t p) {
+        const std::size_t k0 = panels[p].first, w = panels[p].second - k0;
+        const int s = int(p % 2);
+        const int a_owner = detail::split_owner(K, g.pc, k0);
+        const int b_owner = detail::split_owner(K, g.pr, k0);
+        if (g.col == a_owner) {
+            const std::size_t off = k0 - blk.a_cols.first;
+            for (std::size_t i = 0; i < m; ++i)
+                std::copy(A + i * lda + off, A + i * lda + off + w, abuf[s].data() + i * w);
+        }
+        if (g.row == b_owner) {
+            const std::size_t off = k0 - blk.b_rows.first;
+            for (std::size_t k = 0; k < w; ++k)
+                std::copy(B + (off + k) * ldb, B + (off + k) * ldb + n, bbuf[s].data() + k * n);
+        }
+        MPI_Ibcast(abuf[s].data(), detail::mpi_count(m * w), type, a_owner, g.row_comm, &req[s][0]);
+        MPI_Ibcast(bbuf[s].data(), detail::mpi_count(w * n), type, b_owner, g.col_comm, &req[s][1]);
+        st.bytes += sizeof(T) * (m + n) * w;
+    };
+
+    if (!panels.empty()) post(0);
+    for (std::size_t p = 0; p < panels.size(); ++p) {
+        const int s = int(p % 2);
+        MPI_Waitall(2, req[s], MPI_STATUSES_IGNORE);
+        if (p + 1 < panels.size()) post(p + 1);
+
+        const std::size_t w = panels[p].second - panels[p].first;
+        const T beta_p = p == 0 ? beta0 : T(1);
+        const double t0 = MPI_Wtime();
+        for (std::size_t q = 0; q < detail::summa_progress_slices; ++q) {
+            const auto r = split_range(m, detail::summa_progress_slices, q);
+            if (r.first == r.second) continue;
+            gemm<T>(Trans::none, Trans::none, alpha,
+                    row_major_view<const T>(abuf[s].data() + r.first * w, r.second - r.first, w),
+                    row_major_view<const T>(bbuf[s].data(), w, n), beta_p,
+                    row_major_view<T>(C + r.first * ldc, r.second - r.first, n, ldc), nthreads);
+            if (p + 1 < panels.size()) {
+                int done = 0;
+                MPI_Testall(2, req[1 - s], &done, MPI_STATUSES_IGNORE);
+            }
+        }
+        st.compute += MPI_Wtime() - t0;
+    }
+
+    if (g.layers > 1) {
+        std::vector<T> sum(m * n);
+        for (std::size_t i = 0; i < m; ++i) std::copy(C + i * ldc, C + i * ldc + n, sum.data() + i * n);
+        MPI_Allreduce(MPI_IN_PLACE, sum.data(), detail::mpi_count(m * n), type, MPI_SUM, g.layer_comm);
+        for (std::size_t i = 0; i < m; ++i) std::copy(sum.data() + i * n, sum.data() + (i + 1) * n, C + i * ldc);
+        st.bytes += sizeof(T) * m * n;
+    }
+
+    st.comm = MPI_Wtime() - t_start - st.compute;
+    return st;
+}
+
+/// Sum of a vector spread over comm, x[0, n) on this rank. Each rank's
+/// compensated partial (the chunks and pairwise tree of kahan_sum_parallel)
+/// is gathered everywhere and merged with the same tree in rank order, so
+/// the rounding error stays at one Kahan sum's whatever the rank count, and
+/// every rank returns the same bits.
+template <typename T>
+T kahan_allreduce(const T* x, std::size_t n, MPI_Comm comm, std::size_t nthreads = 1,
+                  MpiTimes* times = nullptr, std::size_t chunk = reduction_chunk)
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "kahan_allreduce: T must be float or double");
+    static_assert(sizeof(Compensated<T>) == 2 * sizeof(T), "kahan_allreduce: Compensated<T> must be two T");
+
+    int size = 1;
+    MPI_Comm_size(comm, &size);
+
+    const double t0 = MPI_Wtime();
+    const Compensated<T> local = detail::kahan_parallel_partial(x, n, nthreads, chunk);
+    const double t1 = MPI_Wtime();
+
+    std::vector<Compensated<T>> part(static_cast<std::size_t>(size));
+    MPI_Allgather(&local, 2, detail::mpi_type<T>(), part.data(), 2, detail::mpi_type<T>(), comm);
+    const T sum = detail::combine_pairwise(part).value();
+
+    if (times) *times += {t1 - t0, MPI_Wtime() - t1, sizeof(Compensated<T>) * std::size_t(size)};
+    return sum;
+}
+
+/// Inclusive scan of a vector spread over comm in rank order: this rank holds
+/// in[0, n) and gets out[0, n) (in may equal out). Only block totals travel:
+/// each rank sums its block, MPI_Exscan gives it the total of the ranks
+/// before it, and the local two-pass scan starts from that offset. The
+/// exchange is one scalar per rank, so there is nothing worth overlapping.
+template <typename T>
+void distributed_inclusive_scan(const T* in, T* out, std::size_t n, MPI_Comm comm,
+                                std::size_t nthreads = 1, MpiTimes* times = nullptr)
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "distributed_inclusive_scan: T must be arithmetic");
+
+    const double t0 = MPI_Wtime();
+    const auto kern = detail::scan_kernels<T>();
+    const std::size_t nt = std::max<std::size_t>(1, std::min(nthreads, n / detail::scan_min_block));
+    std::vector<T> part(nt);
+    default_pool().run(nt, [&](const ThreadContext& ctx) {
+        const auto r = split_range(n, ctx.nthreads, ctx.tid);
+        part[ctx.tid] = kern.block_sum(in + r.first, r.second - r.first);
+    });
+    T total = T(0);
+    for (T p : part) total += p;
+    const double t1 = MPI_Wtime();
+
+    int rank = 0;
+    MPI_Comm_rank(comm, &rank);
+    T offset = T(0);
+    MPI_Exscan(&total, &offset, 1, detail::mpi_type<T>(), MPI_SUM, comm);
+    if (rank == 0) offset = T(0); // MPI_Exscan leaves rank 0's result undefined
+    const double t2 = MPI_Wtime();
+
+    detail::scan_two_pass<T>(in, out, n, nthreads, offset, true);
+
+    if (times) *times += {(t1 - t0) + (MPI_Wtime() - t2), t2 - t1, 2 * sizeof(T)};
+}
+
+}
@@ -0,0 +1,461 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HPC_POSIX_IO 1
+#else
+#include <fstream>
+#endif
+
+#include "hpc/memory.hpp"
+#include "hpc/matmul_packed.hpp"
+#include "hpc/scan.hpp"
+
+namespace hpc {
+
+/// Binary file accessed at explicit byte offsets (pread/pwrite), usable
+/// from several threads at once. Throws std::runtime_error on failure.
+class File {
+public:
+    enum Mode { read, write, read_write }; // write and read_write create the file
+
+    File() = default;
+
+    File(const std::string& path, Mode m) : path_(path) {
+#if HPC_POSIX_IO
+        const int flags = m == read ? O_RDONLY : (m == write ? O_WRONLY : O_RDWR) | O_CREAT;
+        fd_ = ::open(path.c_str(), flags, 0644);
+        if (fd_ < 0) throw std::runtime_error("File: cannot open " + path);
+#else
+        auto flags = std::ios::binary | std::ios::in;
+        if (m != read) flags |= std::ios::out;
+        if (m != read) std::ofstream(path, std::ios::binary | std::ios::app); // create
+        f_.open(path, flags);
+        if (!f_) throw std::runtime_error("File: cannot open " + path);
+#endif
+    }
+
+    File(File&& o) noexcept { swap(o); }
+    File& operator=(File&& o) noexcept { File t(std::move(o)); swap(t); return *this; }
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    ~File() {
+#if HPC_POSIX_IO
+        if (fd_ >= 0) ::close(fd_);
+#endif
+    }
+
+    const std::string& path() const { return path_; }
+
+    std::uint64_t size() const {
+#if HPC_POSIX_IO
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) throw std::runtime_error("File: cannot stat " + path_);
+        return static_cast<std::uint64_t>(st.st_size);
+#else
+        std::lock_guard<std::mutex> lk(m_);
+        f_.seekg(0, std::ios::end);
+        return static_cast<std::uint64_t>(f_.tellg());
+#endif
+    }
+
+    /// Grow or truncate to bytes.
+    void resize(std::uint64_t bytes) {
+#if HPC_POSIX_IO
+        if (::ftruncate(fd_, static_cast<off_t>(bytes)) != 0)
+            throw std::runtime_error("File: cannot resize " + path_);
+#else
+        if (bytes > size()) {
+            const char zero = 0;
+            write_at(&zero, 1, bytes - 1);
+        }
+#endif
+    }
+
+    void read_at(void* p, std::size_t bytes, std::uint64_t off) const {
+#if HPC_POSIX_IO
+        auto* c = static_cast<char*>(p);
+        while (bytes > 0) {
+            const ssize_t r = ::pread(fd_, c, bytes, static_cast<off_t>(off));
+            if (r <= 0) throw std::runtime_error("File: short read from " + path_);
+            c += r; off += static_cast<std::uint64_t>(r); bytes -= static_cast<std::size_t>(r);
+        }
+#else
+        std::lock_guard<std::mutex> lk(m_);
+        f_.seekg(static_cast<std::streamoff>(off));
+        if (!f_.read(static_cast<char*>(p), static_cast<std::streamsize>(bytes)))
+            throw std::runtime_error("File: short read from " + path_);
+#endif
+    }
+
+    void write_at(const void* p, std::size_t bytes, std::uint64_t off) {
+#if HPC_POSIX_IO
+        auto* c = static_cast<const char*>(p);
+        while (bytes > 0) {
+            const ssize_t r = ::pwrite(fd_, c, bytes, static_cast<off_t>(off));
+            if (r <= 0) throw std::runtime_error("File: short write to " + path_);
+            c += r; off += static_cast<std::uint64_t>(r); bytes -= static_cast<std::size_t>(r);
+        }
+#else
+        std::lock_guard<std::mutex> lk(m_);
+        f_.seekp(static_cast<std::streamoff>(off));
+        if (!f_.write(static_cast<const char*>(p), static_cast<std::streamsize>(bytes)))
+            throw std::runtime_error("File: short write to " + path_);
+#endif
+    }
+
+    /// Advisory: [off, off+bytes) is done with, drop it from the page cache
+    /// so a stream larger than RAM does not evict everything else.
+    void drop_cache(std::uint64_t off, std::uint64_t bytes) const {
+#if HPC_POSIX_IO && defined(POSIX_FADV_DONTNEED)
+        ::posix_fadvise(fd_, static_cast<off_t>(off), static_cast<off_t>(bytes), POSIX_FADV_DONTNEED);
+#else
+        (void)off; (void)bytes;
+#endif
+    }
+
+private:
+    void swap(File& o) noexcept {
+        std::swap(path_, o.path_);
+#if HPC_POSIX_IO
+        std::swap(fd_, o.fd_);
+#else
+        std::swap(f_, o.f_);
+#endif
+    }
+
+    std::string path_;
+#if HPC_POSIX_IO
+    int fd_ = -1;
+#else
+    mutable std::fstream f_;
+    mutable std::mutex m_;
+#endif
+};
+
+/// Tuning of the streaming kernels.
+struct StreamOptions {
+    std::size_t panel_bytes = std::size_t(64) << 20; // per I/O buffer; two per stream
+    std::size_t nthreads = 1;                         // compute threads (the pool)
+    bool drop_cache = true;                           // File::drop_cache after each panel
+};
+
+/// What a streaming call did. io_seconds is the time the I/O threads spent
+/// in read/write, stall_seconds the time compute waited on them.
+struct StreamStats {
+    double seconds = 0.0;
+    double io_seconds = 0.0;
+    double stall_seconds = 0.0;
+    std::uint64_t bytes_read = 0;
+    std::uint64_t bytes_written = 0;
+
+    /// Share of the I/O time hidden behind compute (1 = fully overlapped).
+    double overlap() const {
+        return io_seconds > 0.0 ? std::max(0.0, 1.0 - stall_seconds / io_seconds) : 1.0;
+    }
+};
+
+namespace detail {
+
+using stream_clock = std::chrono::steady_clock;
+
+inline double seconds_since(stream_clock::time_point t0) {
+    return std::chrono::duration<double>(stream_clock::now() - t0).count();
+}
+
+/// Byte range of a file.
+struct Extent {
+    std::uint64_t offset;
+    std::size_t bytes;
+};
+
+/// Reads extents in order into two alternating buffers on its own thread:
+/// extent i+1 is read while the caller works on extent i.
+class PrefetchReader {
+public:
+    PrefetchReader(const File& f, std::vector<Extent> ext, std::size_t capacity, bool drop)
+        : f_(f), ext_(std::move(ext)), drop_(drop)
+    {
+        for (auto& b : buf_) b = AlignedBuffer<unsigned char>(std::max<std::size_t>(capacity, 1));
+        thread_ = std::thread([this] { run(); });
+    }
+
+    ~PrefetchReader() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    /// Data of the next extent, valid until the following call.
+    const void* next() {
+        const auto t0 = stream_clock::now();
+        std::unique_lock<std::mutex> lk(m_);
+        if (taken_ > 0) ++released_; // the caller is done with the previous buffer
+        cv_.notify_all();
+        cv_.wait(lk, [&] { return read_ > taken_ || error_; });
+        stall_ += seconds_since(t0);
+        if (error_) std::rethrow_exception(error_);
+        return buf_[taken_++ % 2].data();
+    }
+
+    double io_seconds() const { return io_; }
+    double stall_seconds() const { return stall_; }
+    std::uint64_t bytes() const { return bytes_; }
+
+private:
+    void run() {
+        try {
+            for (std::size_t i = 0; i < ext_.size(); ++i) {
+                {
+                    std::unique_lock<std::mutex> lk(m_);
+                    cv_.wait(lk, [&] { return i < released_ + 2 || stop_; });
+                    if (stop_) return;
+                }
+                const auto t0 = stream_clock::now();
+                f_.read_at(buf_[i % 2].data(), ext_[i].bytes, ext_[i].offset);
+                if (drop_) f_.drop_cache(ext_[i].offset, ext_[i].bytes);
+                io_ += seconds_since(t0);
+                bytes_ += ext_[i].bytes;
+                {
+                    std::lock_guard<std::mutex> lk(m_);
+                    ++read_;
+                }
+                cv_.notify_all();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lk(m_);
+            error_ = std::current_exception();
+            cv_.notify_all();
+        }
+    }
+
+    const File& f_;
+    std::vector<Extent> ext_;
+    bool drop_;
+    AlignedBuffer<unsigned char> buf_[2];
+    std::thread thread_;
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::size_t read_ = 0, taken_ = 0, released_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_;
+    double io_ = 0.0, stall_ = 0.0; // io_ is written by the thread, read after finish
+    std::uint64_t bytes_ = 0;
+};
+
+/// Writes buffers in submission order on its own thread. acquire() hands
+/// out the buffer whose previous write has finished, so the caller fills
+/// one buffer while the other is written.
+class AsyncWriter {
+public:
+    AsyncWriter(File& f, std::size_t capacity, bool drop) : f_(f), drop_(drop) {
+        for (auto& b : buf_) b = AlignedBuffer<unsigned char>(std::max<std::size_t>(capacity, 1));
+        thread_ = std::thread([this] { run(); });
+    }
+
+    ~AsyncWriter() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    void* acquire() {
+        wait_until(submitted_ < 2 ? 0 : submitted_ - 1);
+        return buf_[submitted_ % 2].data();
+    }
+
+    /// Write the buffer from the last acquire() to [offset, offset+bytes).
+    void submit(Extent e) {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            ext_[submitted_ % 2] = e;
+            ++submitted_;
+        }
+        cv_.notify_all();
+    }
+
+    /// Wait for every submitted write; rethrows a write error.
+    void finish() { wait_until(submitted_); }
+
+    double io_seconds() const { return io_; }
+    double stall_seconds() const { return stall_; }
+    std::uint64_t bytes() const { return bytes_; }
+
+private:
+    void wait_until(std::size_t n) {
+        const auto t0 = stream_clock::now();
+        std::unique_lock<std::mutex> lk(m_);
+        cv_.wait(lk, [&] { return written_ >= n || error_; });
+        stall_ += seconds_since(t0);
+        if (error_) std::rethrow_exception(error_);
+    }
+
+    void run() {
+        for (std::size_t i = 0;; ++i) {
+            Extent e;
+            {
+                std::unique_lock<std::mutex> lk(m_);
+                cv_.wait(lk, [&] { return submitted_ > i || stop_; });
+                if (submitted_ <= i) return;
+                e = ext_[i % 2];
+            }
+            try {
+                const auto t0 = stream_clock::now();
+                f_.write_at(buf_[i % 2].data(), e.bytes, e.offset);
+                if (drop_) f_.drop_cache(e.offset, e.bytes);
+                io_ += seconds_since(t0);
+                bytes_ += e.bytes;
+            } catch (...) {
+                std::lock_guard<std::mutex> lk(m_);
+                error_ = std::current_exception();
+                cv_.notify_all();
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lk(m_);
+                ++written_;
+            }
+            cv_.notify_all();
+        }
+    }
+
+    File& f_;
+    bool drop_;
+    AlignedBuffer<unsigned char> buf_[2];
+    Extent ext_[2] = {};
+    std::thread thread_;
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::size_t submitted_ = 0, written_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_;
+    double io_ = 0.0, stall_ = 0.0;
+    std::uint64_t bytes_ = 0;
+};
+
+template <typename R, typename W>
+StreamStats stream_stats(const R& r, const R* r2, const W& w, stream_clock::time_point t0) {
+    StreamStats s;
+    s.seconds = seconds_since(t0);
+    s.io_seconds = r.io_seconds() + (r2 ? r2->io_seconds() : 0.0) + w.io_seconds();
+    s.stall_seconds = r.stall_seconds() + (r2 ? r2->stall_seconds() : 0.0) + w.stall_seconds();
+    s.bytes_read = r.bytes() + (r2 ? r2->bytes() : 0);
+    s.bytes_written = w.bytes();
+    return s;
+}
+
+} // namespace detail
+
+/// Out-of-core GEMM: C(M×N) = A(M×K)·B(K×N), each a row-major array of T
+/// at a byte offset in a file (C is written, the file grows as needed).
+/// A is streamed in row panels and, for each, B in row panels of about
+/// opt.panel_bytes; the packed engine accumulates the C panel in memory,
+/// which is written back while the next one is computed. Reads run one
+/// panel ahead on a background thread per operand. B is read once per A
+/// panel, M·K·N / MB bytes in total, unless it fits in one panel (then it is
+/// read once and kept). Memory: two buffers per operand, ~6 × panel_bytes.
+template <typename T>
+StreamStats matmul_stream(std::size_t M, std::size_t N, std::size_t K,
+                          const File& A, std::uint64_t a_off,
+                          const File& B, std::uint64_t b_off,
+                          File& C, std::uint64_t c_off,
+                          const StreamOptions& opt = {})
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "matmul_stream: T must be float or double");
+
+    const auto t0 = detail::stream_clock::now();
+    const std::size_t sz = sizeof(T);
+    const std::size_t pb = std::max(opt.panel_bytes, sz);
+    const std::size_t MB = std::max<std::size_t>(1, std::min(M, pb / (sz * std::max<std::size_t>({K, N, 1}))));
+    const std::size_t KB = std::max<std::size_t>(1, std::min(K, pb / (sz * std::max<std::size_t>(N, 1))));
+    const std::size_t na = (M + MB - 1) / MB, nb = (K + KB - 1) / KB;
+    const bool b_resident = nb == 1;
+
+    std::vector<detail::Extent> ea, eb;
+    for (std::size_t i = 0; i < na; ++i)
+        ea.push_back({a_off + std::uint64_t(i * MB) * K * sz, std::min(MB, M - i * MB) * K * sz});
+    for (std::size_t r = 0; r < (b_resident ? 1 : na) && K > 0; ++r)
+        for (std::size_t k = 0; k < nb; ++k)
+            eb.push_back({b_off + std::uint64_t(k * KB) * N * sz, std::min(KB, K - k * KB) * N * sz});
+
+    detail::PrefetchReader ra(A, std::move(ea), MB * K * sz, opt.drop_cache);
+    detail::PrefetchReader rb(B, std::move(eb), KB * N * sz, opt.drop_cache && !b_resident);
+    detail::AsyncWriter wc(C, MB * N * sz, opt.drop_cache);
+
+    const T* Bp = nullptr;
+    for (std::size_t i = 0; i < na; ++i) {
+        const std::size_t mb = std::min(MB, M - i * MB);
+        const T* Ap = static_cast<const T*>(ra.next());
+        T* Cp = static_cast<T*>(wc.acquire());
+        if (K == 0) std::fill(Cp, Cp + mb * N, T(0));
+        for (std::size_t k = 0; k < nb && K > 0; ++k) {
+            if (!b_resident || !Bp) Bp = static_cast<const T*>(rb.next());
+            detail::gemm_packed<T>(mb, N, std::min(KB, K - k * KB), T(1), Ap + k * KB, K, 1, Bp, N, 1,
+                                   k == 0 ? T(0) : T(1), Cp, N, 1, GemmBlocking{}, opt.nthreads);
+        }
+        wc.submit({c_off + std::uint64_t(i * MB) * N * sz, mb * N * sz});
+    }
+    wc.finish();
+    return detail::stream_stats(ra, &rb, wc, t0);
+}
+
+/// Out-of-core inclusive scan of n elements of T from in (at in_off) to
+/// out (at out_off); in and out may be the same file and offset. Chunks of
+/// opt.panel_bytes are scanned on the pool with the running total as the
+/// offset, read one chunk ahead and written back one behind.
+template <typename T>
+StreamStats inclusive_scan_stream(const File& in, std::uint64_t in_off,
+                                  File& out, std::uint64_t out_off, std::size_t n,
+                                  const StreamOptions& opt = {})
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "inclusive_scan_stream: T must be arithmetic");
+
+    const auto t0 = detail::stream_clock::now();
+    const std::size_t sz = sizeof(T);
+    const std::size_t chunk = std::max<std::size_t>(1, opt.panel_bytes / sz);
+
+    std::vector<detail::Extent> ext;
+    for (std::size_t i = 0; i < n; i += chunk)
+        ext.push_back({in_off + std::uint64_t(i) * sz, std::min(chunk, n - i) * sz});
+
+    detail::PrefetchReader r(in, std::move(ext), chunk * sz, opt.drop_cache);
+    detail::AsyncWriter w(out, chunk * sz, opt.drop_cache);
+
+    T carry = T(0);
+    for (std::size_t i = 0; i < n; i += chunk) {
+        const std::size_t len = std::min(chunk, n - i);
+        const T* x = static_cast<const T*>(r.next());
+        T* y = static_cast<T*>(w.acquire());
+        detail::scan_two_pass<T>(x, y, len, opt.nthreads, carry, true);
+        carry = y[len - 1];
+        w.submit({out_off + std::uint64_t(i) * sz, len * sz});
+    }
+    w.finish();
+    return detail::stream_stats<detail::PrefetchReader, detail::AsyncWriter>(r, nullptr, w, t0);
+}
+
+}
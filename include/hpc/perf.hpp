@@ -0,0 +1,179 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__linux__) && __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define HPC_HAVE_PERF_EVENT 1
+#else
+#define HPC_HAVE_PERF_EVENT 0
+#endif
+
+namespace hpc {
+
+/// Hardware counter totals of one measured region. Events the host does not
+/// expose (no PMU, virtualised CPU, paranoid setting, other vendor) are NaN,
+/// and NaN propagates through the arithmetic below.
+struct PerfSample {
+    static constexpr double none = std::numeric_limits<double>::quiet_NaN();
+
+    double cycles = none;
+    double instructions = none;
+    double l1d_misses = none;   // L1D read misses
+    double llc_misses = none;   // last-level cache misses
+    double fp_ops = none;       // retired floating-point operations (FMA = 2)
+
+    /// Memory traffic estimate: every LLC miss moves one 64-byte line.
+    double dram_bytes() const { return llc_misses * 64.0; }
+
+    /// Measured arithmetic intensity, FLOP per DRAM byte.
+    double intensity() const { return fp_ops / dram_bytes(); }
+
+    PerfSample& operator+=(const PerfSample& o) {
+        cycles += o.cycles; instructions += o.instructions;
+        l1d_misses += o.l1d_misses; llc_misses += o.llc_misses; fp_ops += o.fp_ops;
+        return *this;
+    }
+
+    PerfSample& operator/=(double d) {
+        cycles /= d; instructions /= d; l1d_misses /= d; llc_misses /= d; fp_ops /= d;
+        return *this;
+    }
+
+    /// All counters zero (start value for accumulation).
+    static PerfSample zero() { return {0.0, 0.0, 0.0, 0.0, 0.0}; }
+};
+
+inline PerfSample operator-(const PerfSample& a, const PerfSample& b) {
+    return {a.cycles - b.cycles, a.instructions - b.instructions,
+            a.l1d_misses - b.l1d_misses, a.llc_misses - b.llc_misses, a.fp_ops - b.fp_ops};
+}
+
+/// perf_event_open counters for this process, user space only.
+/// Every event is opened on its own with inherit set, so threads created
+/// after open() (the thread pool's workers) are counted too: open before the
+/// first parallel region. Counts are scaled by time_enabled/time_running when
+/// the kernel multiplexes. FP ops use FP_ARITH_INST_RETIRED on Intel
+/// (Skylake and later, weighted by lanes) and RETIRED_SSE_AVX_FLOPS on AMD Zen.
+class PerfCounters {
+public:
+    PerfCounters() { fds_.fill(-1); }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() { close(); }
+
+    /// Open what the host allows; returns true if at least one event counts.
+    bool open() {
+        close();
+#if HPC_HAVE_PERF_EVENT
+        fds_[cycles] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds_[instructions] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds_[l1d_misses] = open_event(PERF_TYPE_HW_CACHE,
+            PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        fds_[llc_misses] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+
+        auto add_fp = [&](std::uint64_t config, double weight) {
+            const int fd = open_event(PERF_TYPE_RAW, config);
+            if (fd >= 0) fp_[nfp_++] = {fd, weight};
+        };
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_is("intel")) {
+            // Event 0xC7, umask per width; umasks with equal FLOP/instruction merged.
+            add_fp(0xc7 | (0x03 << 8), 1.0);   // scalar double | single
+            add_fp(0xc7 | (0x04 << 8), 2.0);   // 128-bit packed double
+            add_fp(0xc7 | (0x18 << 8), 4.0);   // 128-bit single | 256-bit double
+            add_fp(0xc7 | (0x60 << 8), 8.0);   // 256-bit single | 512-bit double
+            add_fp(0xc7 | (0x80 << 8), 16.0);  // 512-bit single
+        } else if (__builtin_cpu_is("amd")) {
+            add_fp(0x03 | (0xff << 8), 1.0);   // counts FLOPs directly
+        }
+#endif
+#endif
+        return any();
+    }
+
+    void close() {
+#if HPC_HAVE_PERF_EVENT
+        for (int fd : fds_) {
+            if (fd >= 0) ::close(fd);
+        }
+        for (std::size_t i = 0; i < nfp_; ++i) ::close(fp_[i].fd);
+#endif
+        fds_.fill(-1);
+        nfp_ = 0;
+    }
+
+    /// True when at least one event was opened.
+    bool any() const {
+        for (int fd : fds_) {
+            if (fd >= 0) return true;
+        }
+        return nfp_ > 0;
+    }
+
+    /// Running totals since open(); take differences around a region.
+    PerfSample read() const {
+        PerfSample s;
+        s.cycles = read_fd(fds_[cycles]);
+        s.instructions = read_fd(fds_[instructions]);
+        s.l1d_misses = read_fd(fds_[l1d_misses]);
+        s.llc_misses = read_fd(fds_[llc_misses]);
+        if (nfp_ > 0) {
+            s.fp_ops = 0.0;
+            for (std::size_t i = 0; i < nfp_; ++i) s.fp_ops += fp_[i].weight * read_fd(fp_[i].fd);
+        }
+        return s;
+    }
+
+private:
+    enum Event { cycles, instructions, l1d_misses, llc_misses, event_count };
+
+    struct FpEvent {
+        int fd;
+        double weight;
+    };
+
+#if HPC_HAVE_PERF_EVENT
+    static int open_event(std::uint32_t type, std::uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        const long fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        return fd < 0 ? -1 : static_cast<int>(fd);
+    }
+#endif
+
+    static double read_fd(int fd) {
+#if HPC_HAVE_PERF_EVENT
+        if (fd < 0) return PerfSample::none;
+        std::uint64_t v[3] = {0, 0, 0}; // value, time_enabled, time_running
+        if (::read(fd, v, sizeof(v)) != static_cast<ssize_t>(sizeof(v))) return PerfSample::none;
+        if (v[2] == 0) return 0.0;
+        return static_cast<double>(v[0]) * (static_cast<double>(v[1]) / static_cast<double>(v[2]));
+#else
+        (void)fd;
+        return PerfSample::none;
+#endif
+    }
+
+    std::array<int, event_count> fds_;
+    std::array<FpEvent, 5> fp_{};
+    std::size_t nfp_ = 0;
+};
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#include "hpc/matmul.hpp"
+#include "hpc/reduction.hpp"
+#include "hpc/scan.hpp"
+#include "hpc/task_graph.hpp"
+
+namespace hpc {
+
+/// Kernels split into TaskGraph tasks, so a chain such as matmul →
+/// reduction → scan runs as one graph: a reduction chunk or scan block
+/// starts as soon as the tiles writing its inputs are done. Each builder
+/// takes the TaskRanges of its input and returns those of its output.
+/// Only read-after-write is tracked: a kernel writing in place over a
+/// buffer another task still reads must be ordered by the caller.
+
+/// Tasks of matmul_blocked: one per BS×BS tile of C, each running the
+/// tile's K blocks in order, so C is bitwise what matmul_blocked gives.
+/// Every tile also waits for `after`. Output parts are C's row blocks,
+/// [ii*ldc, iimax*ldc) in flat elements.
+template <typename T>
+TaskRanges matmul_blocked_tasks(TaskGraph& g, std::size_t M, std::size_t N, std::size_t K,
+                                const T* A, std::size_t lda, const T* B, std::size_t ldb,
+                                T* C, std::size_t ldc, std::size_t BS = 0,
+                                const std::vector<TaskId>& after = {})
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "matmul_blocked_tasks: T must be float or double");
+
+    BS = detail::blocked_block_size<T>(M, N, K, BS);
+    TaskRanges r;
+    for (std::size_t ii = 0; ii < M; ii += BS) {
+        const std::size_t iimax = std::min(ii + BS, M);
+        r.bound.push_back(ii * ldc);
+        r.tasks.emplace_back();
+        for (std::size_t jj = 0; jj < N; jj += BS) {
+            const std::size_t jjmax = std::min(jj + BS, N);
+            r.tasks.back().push_back(g.add([=] {
+                if (K == 0) {
+                    for (std::size_t i = ii; i < iimax; ++i) std::fill(C + i * ldc + jj, C + i * ldc + jjmax, T(0));
+                    return;
+                }
+                for (std::size_t kk = 0; kk < K; kk += BS)
+                    detail::matmul_blocked_step(ii, iimax, kk, std::min(kk + BS, K), jj, jjmax, A, lda, B, ldb, C, ldc);
+            }, after));
+        }
+    }
+    r.bound.push_back(M * ldc);
+    return r;
+}
+
+/// Tasks of kahan_sum_parallel(x, n, nthreads, chunk): one per chunk, after
+/// the producers of its elements, then one task combining the partials with
+/// the same pairwise tree and storing the sum to *result. Same bits as
+/// kahan_sum_parallel. Returns the combining task.
+template <typename T>
+TaskId kahan_sum_tasks(TaskGraph& g, const T* x, std::size_t n, T* result,
+                       const TaskRanges& input = {}, std::size_t chunk = reduction_chunk)
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "kahan_sum_tasks: T must be float or double");
+
+    chunk = std::max<std::size_t>(chunk, 1);
+    const std::size_t nchunks = (n + chunk - 1) / chunk;
+    auto part = std::make_shared<std::vector<Compensated<T>>>(nchunks);
+
+    std::vector<TaskId> chunks;
+    for (std::size_t b = 0; b < nchunks; ++b) {
+        const std::size_t lo = b * chunk, len = std::min(chunk, n - lo);
+        chunks.push_back(g.add([=] { (*part)[b] = detail::kahan_kernel<T>()(x + lo, len); },
+                               input.covering(lo, lo + len)));
+    }
+    // Every run rewrites the partials, so the tree may merge them in place.
+    return g.add([=] { *result = detail::combine_pairwise(*part).value(); }, chunks);
+}
+
+/// Tasks of an inclusive scan of [in, in+n) into out in blocks of `block`
+/// elements: per block a sum task (after the block's producers), a carry
+/// task chaining the block offsets, and a scan task. Block b is scanned as
+/// soon as the blocks before it are summed, not once the whole input is
+/// ready. in may equal out. Output parts are the blocks, by scan task.
+template <typename T>
+TaskRanges inclusive_scan_tasks(TaskGraph& g, const T* in, T* out, std::size_t n,
+                                const TaskRanges& input = {}, std::size_t block = detail::scan_min_block)
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "inclusive_scan_tasks: T must be arithmetic");
+
+    block = std::max<std::size_t>(block, 1);
+    const std::size_t nblocks = (n + block - 1) / block;
+    // sum[b]: total of block b; offset[b]: total of the blocks before b.
+    auto sum = std::make_shared<std::vector<T>>(nblocks);
+    auto offset = std::make_shared<std::vector<T>>(nblocks);
+
+    TaskRanges r;
+    TaskId prev_carry = 0, prev_sum = 0;
+    for (std::size_t b = 0; b < nblocks; ++b) {
+        const std::size_t lo = b * block, len = std::min(block, n - lo);
+        const TaskId s = g.add([=] { (*sum)[b] = detail::scan_kernels<T>().block_sum(in + lo, len); },
+                               input.covering(lo, lo + len));
+        const TaskId c = b == 0
+            ? g.add([=] { (*offset)[0] = T(0); })
+            : g.add([=] { (*offset)[b] = (*offset)[b - 1] + (*sum)[b - 1]; }, {prev_carry, prev_sum});
+        const TaskId t = g.add([=] {
+            detail::scan_kernels<T>().block_scan(in + lo, out + lo, len, (*offset)[b], true);
+        }, {c, s});
+        r.bound.push_back(lo);
+        r.tasks.push_back({t});
+        prev_carry = c;
+        prev_sum = s;
+    }
+    r.bound.push_back(n);
+    return r;
+}
+
+}
@@ -1,28 +1,212 @@
 #pragma once
 #include <vector>
-#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <type_traits>
 
+#include "hpc/dispatch.hpp"
+#include "hpc/half.hpp"
+#include "hpc/memory.hpp"
+#include "hpc/thread_pool.hpp"
+
 namespace hpc {
 
-/// Generate a reproducible random vector of length n in [-1, 1].
+namespace detail {
+
+/// Philox4x32-10 (Salmon et al., SC'11): 128-bit counter block ctr under a
+/// 64-bit key, ten rounds. Output block i depends only on (i, key), so any
+/// range of the stream can be generated on its own.
+inline void philox4x32(std::uint32_t ctr[4], std::uint32_t k0, std::uint32_t k1) {
+    for (int r = 0; r < 10; ++r) {
+        const std::uint64_t p0 = std::uint64_t(0xD2511F53u) * ctr[0];
+        const std::uint64_t p1 = std::uint64_t(0xCD9E8D57u) * ctr[2];
+        const std::uint32_t c1 = ctr[1], c3 = ctr[3];
+        ctr[0] = std::uint32_t(p1 >> 32) ^ c1 ^ k0;
+        ctr[1] = std::uint32_t(p1);
+        ctr[2] = std::uint32_t(p0 >> 32) ^ c3 ^ k1;
+        ctr[3] = std::uint32_t(p0);
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+}
+
+/// Values per Philox block: four floats (24 bits each) or two doubles (53 bits).
+template <typename T>
+constexpr std::size_t random_per_block = sizeof(T) == 4 ? 4 : 2;
 
+/// Map one output block to random_per_block<T> values in [-1, 1), exactly.
 template <typename T>
-std::vector<T> make_random(std::size_t n, unsigned seed) {
+inline void random_block_values(const std::uint32_t w[4], T* out) {
+    if constexpr (sizeof(T) == 4) {
+        for (int j = 0; j < 4; ++j)
+            out[j] = static_cast<T>(static_cast<std::int32_t>(w[j] >> 8)) * T(1.0f / 8388608.0f) - T(1);
+    } else {
+        for (int j = 0; j < 2; ++j) {
+            const std::uint64_t m = (std::uint64_t(w[2 * j]) << 21) ^ (w[2 * j + 1] >> 11);
+            out[j] = static_cast<T>(static_cast<std::int64_t>(m)) * T(1.0 / 4503599627370496.0) - T(1);
+        }
+    }
+}
 
-    static_assert(std::is_floating_point<T>::value,
-                  "make_random: T must be float/double");
+/// Block b of the stream for seed.
+template <typename T>
+inline void random_block(std::uint64_t b, unsigned seed, T* out) {
+    std::uint32_t w[4] = {std::uint32_t(b), std::uint32_t(b >> 32), 0u, 0u};
+    philox4x32(w, seed, 0x5EEDu);
+    random_block_values<T>(w, out);
+}
 
-    std::mt19937 rng(seed); // PRNG engine
-    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+/// Per-ISA bulk generator: random_kernel_for<I, T>::run(out, b0, nb, seed)
+/// writes blocks [b0, b0+nb) to out; see hpc/isa/rand.inl.
+template <Isa I, typename T>
+struct random_kernel_for;
 
-    std::vector<T> v(n);
-    
-    for (std::size_t i = 0; i < n; ++i) {
-        v[i] = static_cast<T>(dist(rng));
+} // namespace detail
+
+}
+
+#define HPC_ISA_KERNELS "hpc/isa/rand.inl"
+#include "hpc/isa/foreach.inl"
+
+namespace hpc {
+
+namespace detail {
+
+template <typename T>
+using random_fn = void (*)(T*, std::uint64_t, std::size_t, unsigned);
+
+template <typename T>
+random_fn<T> random_kernel() {
+    return isa_dispatch([](auto isa) -> random_fn<T> {
+        return &random_kernel_for<decltype(isa)::value, T>::run;
+    });
+}
+
+/// Elements [first, first+n) of the stream into out, partial blocks at
+/// either end done one block at a time.
+template <typename T>
+void random_range(random_fn<T> kern, T* out, std::size_t first, std::size_t n, unsigned seed) {
+    constexpr std::size_t P = random_per_block<T>;
+    T tmp[P];
+    std::size_t i = first;
+    const std::size_t end = first + n;
+
+    while (i < end && i % P != 0) {
+        random_block<T>(i / P, seed, tmp);
+        out[i - first] = tmp[i % P];
+        ++i;
+    }
+
+    const std::size_t nb = (end - i) / P;
+    kern(out + (i - first), i / P, nb, seed);
+    i += nb * P;
+
+    if (i < end) {
+        random_block<T>(i / P, seed, tmp);
+        for (std::size_t j = 0; i < end; ++i, ++j) out[i - first] = tmp[j];
+    }
+}
+
+/// Element types the generator fills: float/double directly, bf16/fp16 and
+/// 8-bit integers from the float stream.
+template <typename T>
+struct is_random_type : std::integral_constant<bool, std::is_floating_point<T>::value || is_half<T>::value
+                                                  || (std::is_integral<T>::value && sizeof(T) == 1)> {};
+
+/// Float stream value v in [-1, 1) as T: rounded for bf16/fp16, the full
+/// range for 8-bit integers (v + 1 or v scaled by 128, exact as v has 23
+/// fraction bits).
+template <typename T>
+T random_narrow(float v) {
+    if constexpr (std::is_same<T, std::uint8_t>::value) return static_cast<T>((v + 1.0f) * 128.0f);
+    else if constexpr (std::is_integral<T>::value) return static_cast<T>(std::floor(v * 128.0f));
+    else return T(v);
+}
+
+/// random_range for any is_random_type: element i of a narrow stream is
+/// random_narrow<T>(float element i).
+template <typename T>
+void random_range_any(T* out, std::size_t first, std::size_t n, unsigned seed) {
+    if constexpr (!std::is_floating_point<T>::value) {
+        const auto kern = random_kernel<float>();
+        float tmp[1024];
+        for (std::size_t i = 0; i < n; i += 1024) {
+            const std::size_t m = std::min<std::size_t>(1024, n - i);
+            random_range<float>(kern, tmp, first + i, m, seed);
+            for (std::size_t j = 0; j < m; ++j) out[i + j] = random_narrow<T>(tmp[j]);
+        }
+    } else {
+        random_range<T>(random_kernel<T>(), out, first, n, seed);
+    }
+}
+
+} // namespace detail
+
+/// Fill out[0..n) with elements [first, first+n) of the counter-based stream
+/// for seed (uniform in [-1, 1)). Element i never depends on n or first, so
+/// chunks can be generated independently and in any order.
+template <typename T>
+void fill_random_range(T* out, std::size_t first, std::size_t n, unsigned seed) {
+    static_assert(detail::is_random_type<T>::value,
+                  "fill_random_range: T must be float/double/bf16/fp16/int8/uint8");
+
+    detail::random_range_any<T>(out, first, n, seed);
+}
+
+/// Fill out[0..n) with the same reproducible sequence make_random returns.
+/// With nthreads > 1 the range is split over the pool like
+/// detail::first_touch splits a buffer; the values do not depend on nthreads.
+template <typename T>
+void fill_random(T* out, std::size_t n, unsigned seed, std::size_t nthreads = 1) {
+
+    static_assert(detail::is_random_type<T>::value,
+                  "fill_random: T must be float/double/bf16/fp16/int8/uint8");
+
+    if (nthreads <= 1) {
+        detail::random_range_any<T>(out, 0, n, seed);
+        return;
     }
+    default_pool().run(nthreads, [&](const ThreadContext& ctx) {
+        const auto r = split_range(n, ctx.nthreads, ctx.tid, cache_line_bytes / sizeof(T));
+        detail::random_range_any<T>(out + r.first, r.first, r.second - r.first, seed);
+    });
+}
+
+/// Generate a reproducible random vector of length n in [-1, 1) (8-bit
+/// integers: uniform over their whole range).
+
+template <typename T>
+std::vector<T> make_random(std::size_t n, unsigned seed) {
+
+    static_assert(detail::is_random_type<T>::value,
+                  "make_random: T must be float/double/bf16/fp16/int8/uint8");
+
+    std::vector<T> v(n);
+    fill_random(v.data(), n, seed);
+
+    return v;
+}
 
+/// Reproducible random values in 64-byte aligned (optionally huge-page,
+/// NUMA-placed) storage; same sequence as make_random. With
+/// opt.first_touch_threads the values themselves are written by those
+/// threads, split like detail::first_touch (opt.touch_grain), so each page is
+/// first touched on the node of the thread whose share it holds.
+
+template <typename T>
+AlignedBuffer<T> make_random_aligned(std::size_t n, unsigned seed, BufferOptions opt = {}) {
+    BufferOptions untouched = opt;
+    untouched.first_touch_threads = 0;
+    AlignedBuffer<T> v(n, untouched);
+
+    T* p = v.data();
+    default_pool().run(opt.first_touch_threads, [&](const ThreadContext& ctx) {
+        const auto r = detail::touch_range(opt, n, sizeof(T), ctx.nthreads, ctx.tid);
+        detail::random_range_any<T>(p + r.first, r.first, r.second - r.first, seed);
+    });
     return v;
 }
 
-}
\ No newline at end of file
+}
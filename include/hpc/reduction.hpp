@@ -1,22 +1,35 @@
 #pragma once
 #include <vector>
+#include <cmath>
+#include <limits>
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
 #include <type_traits>
 
+#include "hpc/simd.hpp"
+#include "hpc/dispatch.hpp"
+#include "hpc/thread_pool.hpp"
+
+#if defined(__FAST_MATH__)
+#pragma message("hpc/reduction.hpp: -ffast-math lets the compiler cancel the Kahan compensation terms and the binned pre-rounding")
+#endif
+
 namespace hpc {
 
-// Compute the sum of a vector using Kahan compensated summation.
+// Compute the sum of x[0..n) using Kahan compensated summation.
 
 template <typename T>
-T kahan_sum(const std::vector<T>& x) {
-    
+T kahan_sum(const T* x, std::size_t n) {
+
     static_assert(std::is_floating_point<T>::value,
                   "kahan_sum: T must be float or double");
 
     T sum = 0;
     T c   = 0;
 
-    for (auto v : x) {
-        T y = v - c;
+    for (std::size_t i = 0; i < n; ++i) {
+        T y = x[i] - c;
         T t = sum + y;
         c   = (t - sum) - y;
         sum = t;
@@ -24,4 +37,458 @@ T kahan_sum(const std::vector<T>& x) {
     return sum;
 }
 
-}
\ No newline at end of file
+// Compute the sum of a vector using Kahan compensated summation.
+
+template <typename T>
+T kahan_sum(const std::vector<T>& x) {
+    return kahan_sum(x.data(), x.size());
+}
+
+/// Kahan state: the running total is (sum - c).
+template <typename T>
+struct Compensated {
+    T sum = 0;
+    T c   = 0;
+
+    T value() const { return sum - c; }
+};
+
+/// Merge two compensated partials. TwoSum recovers the rounding error of
+/// sum_a + sum_b exactly, so merging lanes/chunks loses no more than Kahan does.
+template <typename T>
+Compensated<T> compensated_merge(const Compensated<T>& a, const Compensated<T>& b) {
+    const T t  = a.sum + b.sum;
+    const T bp = t - a.sum;
+    const T e  = (a.sum - (t - bp)) + (b.sum - bp);
+    return {t, (a.c + b.c) - e};
+}
+
+namespace detail {
+
+/// Kahan lanes of each ISA level: kahan_kernel_for<I, T>::run(x, n); see hpc/isa/kahan.inl.
+template <Isa I, typename T>
+struct kahan_kernel_for;
+
+} // namespace detail
+
+}
+
+#define HPC_ISA_KERNELS "hpc/isa/kahan.inl"
+#include "hpc/isa/foreach.inl"
+
+namespace hpc {
+
+namespace detail {
+
+template <typename T>
+using kahan_fn = Compensated<T> (*)(const T*, std::size_t);
+
+/// Lane kernel of active_isa(): results depend on n and the ISA, never on
+/// where the caller split the work.
+template <typename T>
+kahan_fn<T> kahan_kernel() {
+    return isa_dispatch([](auto isa) -> kahan_fn<T> {
+        return &kahan_kernel_for<decltype(isa)::value, T>::run;
+    });
+}
+
+} // namespace detail
+
+/// Multi-lane SIMD Kahan sum: U×width independent compensated lanes,
+/// merged with compensated_merge at the end.
+template <typename T>
+T kahan_sum_simd(const T* x, std::size_t n) {
+    static_assert(std::is_floating_point<T>::value,
+                  "kahan_sum_simd: T must be float or double");
+
+    return detail::kahan_kernel<T>()(x, n).value();
+}
+
+template <typename T>
+T kahan_sum_simd(const std::vector<T>& x) {
+    return kahan_sum_simd(x.data(), x.size());
+}
+
+/// Default kahan_sum_parallel chunk; thread t reduces a contiguous run of
+/// chunks (split_range over chunks), which is how benchmark buffers are
+/// first-touched for it (BufferOptions::touch_grain).
+constexpr std::size_t reduction_chunk = std::size_t(1) << 15;
+
+namespace detail {
+
+/// Pairwise combine tree over chunk index: (0,1) (2,3) ... then stride 2, 4, ...
+template <typename T>
+Compensated<T> combine_pairwise(std::vector<Compensated<T>>& part) {
+    const std::size_t nchunks = part.size();
+    if (nchunks == 0) return {};
+    for (std::size_t stride = 1; stride < nchunks; stride *= 2) {
+        for (std::size_t b = 0; b + stride < nchunks; b += 2 * stride) {
+            part[b] = compensated_merge(part[b], part[b + stride]);
+        }
+    }
+    return part[0];
+}
+
+/// kahan_sum_parallel before rounding to one value: the merged compensated
+/// state, e.g. to be merged further across processes (see hpc/mpi.hpp).
+template <typename T>
+Compensated<T> kahan_parallel_partial(const T* x, std::size_t n, std::size_t nthreads, std::size_t chunk) {
+    const auto lanes = kahan_kernel<T>();
+
+    chunk = std::max<std::size_t>(chunk, 1);
+    const std::size_t nchunks = (n + chunk - 1) / chunk;
+    if (nchunks == 0) return {};
+
+    std::vector<Compensated<T>> part(nchunks);
+    nthreads = std::max<std::size_t>(1, std::min(nthreads, nchunks));
+
+    default_pool().run(nthreads, [&](const ThreadContext& ctx) {
+        const auto r = split_range(nchunks, ctx.nthreads, ctx.tid);
+        for (std::size_t b = r.first; b < r.second; ++b) {
+            const std::size_t lo = b * chunk;
+            part[b] = lanes(x + lo, std::min(chunk, n - lo));
+        }
+    });
+
+    return combine_pairwise(part);
+}
+
+} // namespace detail
+
+/// Multithreaded SIMD Kahan sum.
+/// [0, n) is cut into fixed chunks of `chunk` elements independent of the
+/// thread count; threads reduce whole chunks, and chunk partials are combined
+/// by a fixed pairwise tree. The result is bitwise identical for any nthreads
+/// (for a given active_isa()).
+template <typename T>
+T kahan_sum_parallel(const T* x, std::size_t n, std::size_t nthreads,
+                     std::size_t chunk = reduction_chunk)
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "kahan_sum_parallel: T must be float or double");
+
+    return detail::kahan_parallel_partial(x, n, nthreads, chunk).value();
+}
+
+template <typename T>
+T kahan_sum_parallel(const std::vector<T>& x, std::size_t nthreads) {
+    return kahan_sum_parallel(x.data(), x.size(), nthreads);
+}
+
+/// One-pass statistics of a range: count, compensated sum, extrema, mean,
+/// m2 = sum of (x - mean)^2, and the compensated (Dot2: exact product errors
+/// plus TwoSum) dot product with a second range (zero without one), as
+/// accurate as a plain dot in twice the precision. min/max are unspecified
+/// when x holds NaNs.
+template <typename T>
+struct Stats {
+    std::size_t count = 0;
+    Compensated<T> sum;
+    T min = std::numeric_limits<T>::infinity();
+    T max = -std::numeric_limits<T>::infinity();
+    T mean = 0;
+    T m2 = 0;
+    Compensated<T> dot;
+
+    T total() const { return sum.value(); }
+    T dot_value() const { return dot.value(); }
+    /// m2 / (count - ddof): ddof = 0 population, 1 sample variance.
+    T variance(std::size_t ddof = 0) const {
+        return count > ddof ? m2 / T(count - ddof) : std::numeric_limits<T>::quiet_NaN();
+    }
+    T stddev(std::size_t ddof = 0) const { return std::sqrt(variance(ddof)); }
+};
+
+/// Statistics of the concatenation of two ranges; mean and m2 follow Chan,
+/// Golub & LeVeque's pairwise update, which stays stable for any split.
+template <typename T>
+Stats<T> stats_merge(const Stats<T>& a, const Stats<T>& b) {
+    if (a.count == 0) return b;
+    if (b.count == 0) return a;
+
+    Stats<T> r;
+    r.count = a.count + b.count;
+    r.sum = compensated_merge(a.sum, b.sum);
+    r.min = std::min(a.min, b.min);
+    r.max = std::max(a.max, b.max);
+    const T delta = b.mean - a.mean;
+    const T wb = T(b.count) / T(r.count);
+    r.mean = a.mean + delta * wb;
+    r.m2 = (a.m2 + b.m2) + delta * delta * T(a.count) * wb;
+    r.dot = compensated_merge(a.dot, b.dot);
+    return r;
+}
+
+namespace detail {
+
+/// Folds of binned_sum: each resolves 53 - (bit_width(n) + 2) bits of the
+/// input below the previous one.
+constexpr std::size_t binned_folds = 3;
+
+/// Pairwise, Neumaier, max-abs and binned kernels of each ISA level; see
+/// hpc/isa/sum.inl.
+template <Isa I, typename T>
+struct sum_kernel_for;
+
+/// Fused statistics kernel of each ISA level: stats_kernel_for<I, T>::run(x, y, n)
+/// (y may be null); see hpc/isa/stats.inl.
+template <Isa I, typename T>
+struct stats_kernel_for;
+
+} // namespace detail
+
+}
+
+#define HPC_ISA_KERNELS "hpc/isa/sum.inl"
+#include "hpc/isa/foreach.inl"
+#define HPC_ISA_KERNELS "hpc/isa/stats.inl"
+#include "hpc/isa/foreach.inl"
+
+namespace hpc {
+
+namespace detail {
+
+template <typename T>
+struct SumKernels {
+    T (*pairwise)(const T*, std::size_t);
+    Compensated<T> (*neumaier)(const T*, std::size_t);
+    T (*max_abs)(const T*, std::size_t);
+    void (*binned)(const T*, std::size_t, double,
+                   const double (&)[binned_folds], double (&)[binned_folds]);
+};
+
+template <typename T>
+using stats_fn = Stats<T> (*)(const T*, const T*, std::size_t);
+
+template <typename T>
+stats_fn<T> stats_kernel() {
+    return isa_dispatch([](auto isa) -> stats_fn<T> {
+        return &stats_kernel_for<decltype(isa)::value, T>::run;
+    });
+}
+
+template <typename T>
+SumKernels<T> sum_kernels() {
+    return isa_dispatch([](auto isa) -> SumKernels<T> {
+        using K = sum_kernel_for<decltype(isa)::value, T>;
+        return {&K::pairwise, &K::neumaier, &K::max_abs, &K::binned};
+    });
+}
+
+/// Sum of a range holding an inf or NaN, decided from the special values
+/// alone so that it does not depend on the order either.
+template <typename T>
+T nonfinite_sum(const T* x, std::size_t n) {
+    bool nan = false, pos = false, neg = false;
+    for (std::size_t i = 0; i < n; ++i) {
+        nan |= std::isnan(x[i]);
+        pos |= x[i] == std::numeric_limits<T>::infinity();
+        neg |= x[i] == -std::numeric_limits<T>::infinity();
+    }
+    if (nan || (pos && neg)) return std::numeric_limits<T>::quiet_NaN();
+    return pos ? std::numeric_limits<T>::infinity() : -std::numeric_limits<T>::infinity();
+}
+
+} // namespace detail
+
+/// Blocked pairwise sum: vector leaves of 16 elements per lane combined by
+/// a halving tree. About the speed of a plain SIMD sum, error O(eps log n)
+/// instead of O(eps n).
+template <typename T>
+T pairwise_sum(const T* x, std::size_t n) {
+    static_assert(std::is_floating_point<T>::value,
+                  "pairwise_sum: T must be float or double");
+
+    return detail::sum_kernels<T>().pairwise(x, n);
+}
+
+template <typename T>
+T pairwise_sum(const std::vector<T>& x) {
+    return pairwise_sum(x.data(), x.size());
+}
+
+/// Multi-lane Neumaier sum: every addition's rounding error is recovered
+/// exactly (TwoSum), so unlike Kahan it stays accurate when an addend is
+/// larger than the running total, e.g. {1, 1e100, 1, -1e100} sums to 2.
+template <typename T>
+T neumaier_sum(const T* x, std::size_t n) {
+    static_assert(std::is_floating_point<T>::value,
+                  "neumaier_sum: T must be float or double");
+
+    return detail::sum_kernels<T>().neumaier(x, n).value();
+}
+
+template <typename T>
+T neumaier_sum(const std::vector<T>& x) {
+    return neumaier_sum(x.data(), x.size());
+}
+
+/// Reproducible binned sum, after Demmel & Nguyen, "Parallel reproducible
+/// summation" (2015). A first pass finds max|x|; with it and n, fold k gets
+/// a fixed boundary M_k = 2^b_k, and every x is pre-rounded against M_1,
+/// M_2, M_3 in turn. Each fold only adds multiples of ulp(M_k) that stay
+/// below M_k, so its sum is exact, and the result is bitwise identical for
+/// any order of x, any nthreads, any chunk and any ISA. The three folds
+/// keep about 3 (53 - log2 n) bits below max|x| (float is summed in double),
+/// which for real data is the correctly rounded sum or one ulp off; inputs
+/// with inf or NaN give the IEEE answer. Costs two passes over x.
+template <typename T>
+T binned_sum(const T* x, std::size_t n, std::size_t nthreads = 1,
+             std::size_t chunk = reduction_chunk)
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "binned_sum: T must be float or double");
+
+    constexpr std::size_t F = detail::binned_folds;
+    const auto k = detail::sum_kernels<T>();
+
+    chunk = std::max<std::size_t>(chunk, 1);
+    const std::size_t nchunks = (n + chunk - 1) / chunk;
+    if (nchunks == 0) return T(0);
+    nthreads = std::max<std::size_t>(1, std::min(nthreads, nchunks));
+
+    std::vector<T> peak(nthreads, T(0));
+    default_pool().run(nthreads, [&](const ThreadContext& ctx) {
+        const auto r = split_range(nchunks, ctx.nthreads, ctx.tid);
+        for (std::size_t b = r.first; b < r.second; ++b) {
+            const std::size_t lo = b * chunk;
+            peak[ctx.tid] = std::max(peak[ctx.tid], k.max_abs(x + lo, std::min(chunk, n - lo)));
+        }
+    });
+    const double m = *std::max_element(peak.begin(), peak.end());
+    if (!std::isfinite(m)) return detail::nonfinite_sum(x, n);
+    if (m == 0) return T(0);
+
+    // n partial sums of |q| <= 2^(b_k - L) stay below 2^(b_k - 1).
+    const int L = int(std::log2(double(n))) + 3;
+    assert(L < 53);
+    int b = std::ilogb(m) + 1 + L;
+    int shift = 0;                              // keep M_1 finite
+    if (b > 1020) { shift = b - 1020; b = 1020; }
+    const double scale = std::ldexp(1.0, -shift);
+    double M[F];
+    for (std::size_t f = 0; f < F; ++f, b -= 53 - L) M[f] = std::ldexp(1.0, b);
+
+    std::vector<double> acc(nthreads * F, 0.0);
+    default_pool().run(nthreads, [&](const ThreadContext& ctx) {
+        const auto r = split_range(nchunks, ctx.nthreads, ctx.tid);
+        double a[F] = {};
+        for (std::size_t c = r.first; c < r.second; ++c) {
+            const std::size_t lo = c * chunk;
+            k.binned(x + lo, std::min(chunk, n - lo), scale, M, a);
+        }
+        std::copy(a, a + F, acc.begin() + ctx.tid * F);
+    });
+
+    // Exact in any order; only the final fold combine rounds.
+    double f[F] = {};
+    for (std::size_t t = 0; t < nthreads; ++t)
+        for (std::size_t j = 0; j < F; ++j) f[j] += acc[t * F + j];
+    double s = 0;
+    for (std::size_t j = F; j-- > 0;) s += f[j];
+    return T(std::ldexp(s, shift));
+}
+
+template <typename T>
+T binned_sum(const std::vector<T>& x, std::size_t nthreads = 1) {
+    return binned_sum(x.data(), x.size(), nthreads);
+}
+
+/// All of Stats in one read of x (and y, for the dot product; may be null):
+/// the SIMD kernel takes L1-sized blocks, sums them with TwoSum lanes while
+/// tracking extrema and a compensated x·y, then gets the block's squared deviations about
+/// its own mean from the cached copy, and merges blocks with stats_merge.
+/// Chunks and threads work as in kahan_sum_parallel, so the result is
+/// bitwise identical for any nthreads (for a given active_isa()).
+template <typename T>
+Stats<T> fused_stats(const T* x, std::size_t n, std::size_t nthreads = 1,
+                     const T* y = nullptr, std::size_t chunk = reduction_chunk)
+{
+    static_assert(std::is_floating_point<T>::value,
+                  "fused_stats: T must be float or double");
+
+    const auto run = detail::stats_kernel<T>();
+
+    chunk = std::max<std::size_t>(chunk, 1);
+    const std::size_t nchunks = (n + chunk - 1) / chunk;
+    if (nchunks == 0) return Stats<T>{};
+
+    std::vector<Stats<T>> part(nchunks);
+    nthreads = std::max<std::size_t>(1, std::min(nthreads, nchunks));
+
+    default_pool().run(nthreads, [&](const ThreadContext& ctx) {
+        const auto r = split_range(nchunks, ctx.nthreads, ctx.tid);
+        for (std::size_t b = r.first; b < r.second; ++b) {
+            const std::size_t lo = b * chunk;
+            part[b] = run(x + lo, y ? y + lo : nullptr, std::min(chunk, n - lo));
+        }
+    });
+
+    for (std::size_t stride = 1; stride < nchunks; stride *= 2) {
+        for (std::size_t b = 0; b + stride < nchunks; b += 2 * stride) {
+            part[b] = stats_merge(part[b], part[b + stride]);
+        }
+    }
+    part[0].mean = part[0].total() / T(part[0].count);
+    return part[0];
+}
+
+template <typename T>
+Stats<T> fused_stats(const std::vector<T>& x, std::size_t nthreads = 1) {
+    return fused_stats(x.data(), x.size(), nthreads);
+}
+
+/// fused_stats with the dot product x·y.
+template <typename T>
+Stats<T> fused_stats(const std::vector<T>& x, const std::vector<T>& y, std::size_t nthreads = 1) {
+    assert(x.size() == y.size());
+    return fused_stats(x.data(), x.size(), nthreads, y.data());
+}
+
+/// Correctly rounded sum of x in double (Shewchuk, "Adaptive precision
+/// floating-point arithmetic", 1997, as in Python's math.fsum): the running
+/// total is kept as a non-overlapping expansion. Scalar, and slow when the
+/// expansion grows; meant as the reference for the sums above. Finite input.
+template <typename T>
+double exact_sum(const T* x, std::size_t n) {
+    static_assert(std::is_floating_point<T>::value,
+                  "exact_sum: T must be float or double");
+
+    std::vector<double> p;
+    for (std::size_t i = 0; i < n; ++i) {
+        double v = x[i];
+        std::size_t kept = 0;
+        for (double y : p) {
+            if (std::abs(v) < std::abs(y)) std::swap(v, y);
+            const double hi = v + y;
+            const double lo = y - (hi - v);
+            if (lo != 0) p[kept++] = lo;
+            v = hi;
+        }
+        p.resize(kept);
+        p.push_back(v);
+    }
+
+    // Round the expansion once, from the top, with the half-way correction.
+    std::size_t j = p.size();
+    if (j == 0) return 0.0;
+    double hi = p[--j], lo = 0;
+    while (j > 0) {
+        const double a = hi, y = p[--j];
+        hi = a + y;
+        lo = y - (hi - a);
+        if (lo != 0) break;
+    }
+    if (j > 0 && ((lo < 0 && p[j - 1] < 0) || (lo > 0 && p[j - 1] > 0))) {
+        const double y = lo * 2, a = hi + y;
+        if (y == a - hi) hi = a;
+    }
+    return hi;
+}
+
+template <typename T>
+double exact_sum(const std::vector<T>& x) {
+    return exact_sum(x.data(), x.size());
+}
+
+}
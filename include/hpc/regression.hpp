@@ -0,0 +1,148 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <algorithm>
+
+#include "hpc/harness.hpp"
+
+namespace hpc {
+
+/// One-sided Mann–Whitney U test on two samples of rep times: the p-value
+/// of "b tends to take longer than a" (normal approximation with tie and
+/// continuity corrections). Rank based, so an outlier rep cannot fake or
+/// hide a shift. 1 when either sample is empty or every time is equal.
+inline double mann_whitney_p_greater(const std::vector<double>& a, const std::vector<double>& b) {
+    const std::size_t na = a.size(), nb = b.size(), n = na + nb;
+    if (na == 0 || nb == 0) return 1.0;
+
+    std::vector<std::pair<double, bool>> v; // (time, from b)
+    v.reserve(n);
+    for (double x : a) v.push_back({x, false});
+    for (double x : b) v.push_back({x, true});
+    std::sort(v.begin(), v.end());
+
+    // Average ranks over ties; ties also shrink the variance.
+    double rank_b = 0.0, ties = 0.0;
+    for (std::size_t i = 0; i < n;) {
+        std::size_t j = i;
+        while (j < n && v[j].first == v[i].first) ++j;
+        const double r = 0.5 * static_cast<double>(i + j + 1); // ranks i+1 .. j
+        for (std::size_t k = i; k < j; ++k)
+            if (v[k].second) rank_b += r;
+        const double t = static_cast<double>(j - i);
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    const double fa = static_cast<double>(na), fb = static_cast<double>(nb), fn = static_cast<double>(n);
+    const double u = rank_b - fb * (fb + 1.0) / 2.0;
+    const double var = fa * fb / 12.0 * ((fn + 1.0) - ties / (fn * (fn - 1.0)));
+    if (var <= 0.0) return 1.0;
+    const double z = (u - fa * fb / 2.0 - 0.5) / std::sqrt(var);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+/// Holm–Bonferroni adjusted p-values, in the order of p: comparing each to
+/// alpha keeps the chance of any false alarm across the whole set below
+/// alpha, where a plain per-test alpha would fire on some case of a large
+/// suite by chance alone.
+inline std::vector<double> holm_adjust(const std::vector<double>& p) {
+    const std::size_t m = p.size();
+    std::vector<std::size_t> order(m);
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::sort(order.begin(), order.end(), [&](std::size_t x, std::size_t y) { return p[x] < p[y]; });
+
+    std::vector<double> adj(m);
+    double running = 0.0;
+    for (std::size_t k = 0; k < m; ++k) {
+        running = std::max(running, std::min(1.0, static_cast<double>(m - k) * p[order[k]]));
+        adj[order[k]] = running;
+    }
+    return adj;
+}
+
+/// Current rep times of one case against its baseline, each given as the
+/// rounds it was measured in (separate passes over a suite, so the time
+/// between them samples the host's drift). ratio is median / base_median
+/// (> 1: slower) over the pooled reps; p_slower / p_faster are the one-sided
+/// Mann–Whitney p-values of each direction, before any adjustment. noise is
+/// the larger relative spread, max / min - 1, of the per-round medians of
+/// either side: reps of one round share its conditions (clock, neighbours),
+/// so the rep-level test alone would call any drift between runs significant.
+struct TimingComparison {
+    double base_median = 0.0;
+    double median = 0.0;
+    double ratio = 1.0;
+    double p_slower = 1.0;
+    double p_faster = 1.0;
+    double noise = 0.0;
+};
+
+namespace detail {
+
+inline std::vector<double> pooled(const std::vector<std::vector<double>>& rounds) {
+    std::vector<double> all;
+    for (const auto& r : rounds) all.insert(all.end(), r.begin(), r.end());
+    return all;
+}
+
+inline double round_spread(const std::vector<std::vector<double>>& rounds) {
+    double lo = 0.0, hi = 0.0;
+    for (const auto& r : rounds) {
+        if (r.empty()) continue;
+        const double m = timing_stats(r).median;
+        lo = lo > 0.0 ? std::min(lo, m) : m;
+        hi = std::max(hi, m);
+    }
+    return lo > 0.0 ? hi / lo - 1.0 : 0.0;
+}
+
+} // namespace detail
+
+inline TimingComparison compare_timings(const std::vector<std::vector<double>>& base,
+                                        const std::vector<std::vector<double>>& cur)
+{
+    const std::vector<double> b = detail::pooled(base), c = detail::pooled(cur);
+    TimingComparison r;
+    r.base_median = timing_stats(b).median;
+    r.median = timing_stats(c).median;
+    r.ratio = r.base_median > 0.0 ? r.median / r.base_median : 1.0;
+    r.p_slower = mann_whitney_p_greater(b, c);
+    r.p_faster = mann_whitney_p_greater(c, b);
+    r.noise = std::max(detail::round_spread(base), detail::round_spread(cur));
+    return r;
+}
+
+/// A change counts when it is significant (adjusted p below alpha) and
+/// larger than both min_change and the comparison's round-to-round noise:
+/// with hundreds of reps even a 0.5% drift is significant.
+struct RegressionOptions {
+    double alpha = 0.01;
+    double min_change = 0.05;
+};
+
+enum class Verdict { same, slower, faster, missing };
+
+inline const char* verdict_name(Verdict v) {
+    switch (v) {
+        case Verdict::slower:  return "slower";
+        case Verdict::faster:  return "faster";
+        case Verdict::missing: return "no_baseline";
+        default:               return "same";
+    }
+}
+
+/// p_slower_adj / p_faster_adj: the comparison's p-values after holm_adjust
+/// over every case of the run.
+inline Verdict classify(const TimingComparison& c, double p_slower_adj, double p_faster_adj,
+                        const RegressionOptions& o = {})
+{
+    const double change = std::max(o.min_change, c.noise);
+    if (p_slower_adj < o.alpha && c.ratio > 1.0 + change) return Verdict::slower;
+    if (p_faster_adj < o.alpha && c.ratio < 1.0 / (1.0 + change)) return Verdict::faster;
+    return Verdict::same;
+}
+
+}
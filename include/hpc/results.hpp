@@ -0,0 +1,367 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <utility>
+#include <variant>
+#include <fstream>
+#include <stdexcept>
+#include <filesystem>
+#include <type_traits>
+#include <initializer_list>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/utsname.h>
+#include <unistd.h>
+#endif
+
+#include "hpc/dispatch.hpp"
+#include "hpc/thread_pool.hpp"
+#include "hpc/tune.hpp"
+
+// Build description recorded in the run metadata; CMake defines both for hpc_bench.
+#ifndef HPC_BUILD_FLAGS
+#define HPC_BUILD_FLAGS "unknown"
+#endif
+#ifndef HPC_GIT_SHA
+#define HPC_GIT_SHA "unknown"
+#endif
+
+namespace hpc {
+
+enum class ColumnType { integer, real, text };
+
+/// A named, typed column. `format` is the printf conversion used for real
+/// values in text outputs (default %.17g, round-trips doubles).
+struct Column {
+    std::string name;
+    ColumnType type;
+    const char* format = nullptr;
+};
+
+/// Ordered columns of a result table.
+class Schema {
+public:
+    Schema(std::initializer_list<Column> cols) : cols_(cols) {}
+
+    std::size_t size() const { return cols_.size(); }
+    const Column& operator[](std::size_t i) const { return cols_[i]; }
+
+    std::size_t index(const std::string& name) const {
+        for (std::size_t i = 0; i < cols_.size(); ++i) {
+            if (cols_[i].name == name) return i;
+        }
+        throw std::out_of_range("Schema: no column " + name);
+    }
+
+    std::string csv_header() const {
+        std::string h;
+        for (std::size_t i = 0; i < cols_.size(); ++i) h += (i ? "," : "") + cols_[i].name;
+        return h;
+    }
+
+private:
+    std::vector<Column> cols_;
+};
+
+/// Cell value; monostate is null (empty CSV field, JSON null).
+using Value = std::variant<std::monostate, std::int64_t, double, std::string>;
+
+/// One row of a Schema, filled by column name. Values must match the column
+/// type (integers also fill real columns); non-finite reals are stored as null.
+class Row {
+public:
+    explicit Row(const Schema& s) : s_(&s), v_(s.size()) {}
+
+    template <typename V>
+    Row& set(const std::string& name, const V& v) {
+        const std::size_t i = s_->index(name);
+        const ColumnType t = (*s_)[i].type;
+        if constexpr (std::is_integral<V>::value) {
+            if (t == ColumnType::integer) v_[i] = static_cast<std::int64_t>(v);
+            else if (t == ColumnType::real) v_[i] = static_cast<double>(v);
+            else throw std::invalid_argument("Row::set: column " + name + " is text");
+        } else if constexpr (std::is_floating_point<V>::value) {
+            if (t != ColumnType::real) throw std::invalid_argument("Row::set: column " + name + " is not real");
+            if (std::isfinite(v)) v_[i] = static_cast<double>(v);
+            else v_[i] = std::monostate{};
+        } else {
+            if (t != ColumnType::text) throw std::invalid_argument("Row::set: column " + name + " is not text");
+            v_[i] = std::string(v);
+        }
+        return *this;
+    }
+
+    const Schema& schema() const { return *s_; }
+    const Value& operator[](std::size_t i) const { return v_[i]; }
+
+private:
+    const Schema* s_;
+    std::vector<Value> v_;
+};
+
+/// Output encodings of ResultSink.
+/// - csv: header line, then one line per row.
+/// - jsonl: one JSON object per row.
+/// - binary: "HPCRES1\n", then records in host byte order. 'S' + u32 count +
+///   (u8 type, u32 length, name) per column starts a schema (one per sink, so
+///   appended runs stay readable). 'R' + one cell per column is a row, with
+///   u8 0 for null or u8 1 followed by i64 / f64 / u32 length + bytes.
+///   scripts/plot_bench.py reads it.
+enum class ResultFormat { csv, jsonl, binary };
+
+inline bool parse_result_format(const std::string& s, ResultFormat& out) {
+    if (s == "csv") out = ResultFormat::csv;
+    else if (s == "jsonl") out = ResultFormat::jsonl;
+    else if (s == "binary") out = ResultFormat::binary;
+    else return false;
+    return true;
+}
+
+/// Format implied by a file name: .jsonl/.ndjson, .hpcr/.bin, else csv.
+inline ResultFormat result_format_for(const std::string& path) {
+    const std::string ext = std::filesystem::path(path).extension().string();
+    if (ext == ".jsonl" || ext == ".ndjson") return ResultFormat::jsonl;
+    if (ext == ".hpcr" || ext == ".bin") return ResultFormat::binary;
+    return ResultFormat::csv;
+}
+
+namespace detail {
+
+inline void csv_field(std::string& out, const std::string& s) {
+    if (s.find_first_of(",\"\n\r") == std::string::npos) { out += s; return; }
+    out += '"';
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+inline void json_string(std::string& out, const std::string& s) {
+    out += '"';
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += static_cast<char>(c); }
+        else if (c == '\n') out += "\\n";
+        else if (c == '\t') out += "\\t";
+        else if (c < 0x20) {
+            char u[8];
+            std::snprintf(u, sizeof(u), "\\u%04x", c);
+            out += u;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    out += '"';
+}
+
+template <typename T>
+void put_bytes(std::string& out, const T& v) {
+    char b[sizeof(T)];
+    std::memcpy(b, &v, sizeof(T));
+    out.append(b, sizeof(T));
+}
+
+} // namespace detail
+
+/// Appends rows to one open file. Rows are encoded into an in-memory buffer
+/// that goes out in a single write once it exceeds buffer_bytes, on flush()
+/// and on destruction. A CSV file that already has a different header is
+/// rejected rather than mixing schemas.
+class ResultSink {
+public:
+    ResultSink(const std::string& path, const Schema& schema, ResultFormat fmt,
+               std::size_t buffer_bytes = std::size_t(1) << 16)
+        : schema_(schema), fmt_(fmt), limit_(buffer_bytes)
+    {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        const bool fresh = !fs::exists(path, ec) || fs::file_size(path, ec) == 0;
+
+        if (!fresh && fmt_ == ResultFormat::csv) {
+            std::ifstream in(path);
+            std::string first;
+            std::getline(in, first);
+            if (first != schema_.csv_header()) {
+                throw std::runtime_error("ResultSink: " + path + " has a different header; write to a new file");
+            }
+        }
+
+        f_.open(path, std::ios::app | std::ios::binary);
+        if (!f_) {
+            throw std::runtime_error("ResultSink: cannot open file " + path);
+        }
+
+        if (fmt_ == ResultFormat::csv && fresh) {
+            buf_ += schema_.csv_header();
+            buf_ += '\n';
+        } else if (fmt_ == ResultFormat::binary) {
+            if (fresh) buf_ += "HPCRES1\n";
+            buf_ += 'S';
+            detail::put_bytes(buf_, static_cast<std::uint32_t>(schema_.size()));
+            for (std::size_t i = 0; i < schema_.size(); ++i) {
+                buf_ += static_cast<char>(schema_[i].type);
+                detail::put_bytes(buf_, static_cast<std::uint32_t>(schema_[i].name.size()));
+                buf_ += schema_[i].name;
+            }
+        }
+    }
+
+    ResultSink(const ResultSink&) = delete;
+    ResultSink& operator=(const ResultSink&) = delete;
+
+    ~ResultSink() {
+        try { flush(); } catch (...) {}
+    }
+
+    const Schema& schema() const { return schema_; }
+
+    void write(const Row& r) {
+        if (&r.schema() != &schema_) {
+            throw std::invalid_argument("ResultSink::write: row of another schema");
+        }
+        switch (fmt_) {
+            case ResultFormat::csv:    encode_csv(r); break;
+            case ResultFormat::jsonl:  encode_jsonl(r); break;
+            case ResultFormat::binary: encode_binary(r); break;
+        }
+        if (buf_.size() >= limit_) flush();
+    }
+
+    void flush() {
+        if (buf_.empty()) return;
+        f_.write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+        f_.flush();
+        buf_.clear();
+        if (!f_) throw std::runtime_error("ResultSink: write failed");
+    }
+
+private:
+    void text_value(const Value& v, const Column& c, bool json) {
+        char b[64];
+        if (auto i = std::get_if<std::int64_t>(&v)) {
+            std::snprintf(b, sizeof(b), "%lld", static_cast<long long>(*i));
+            buf_ += b;
+        } else if (auto d = std::get_if<double>(&v)) {
+            std::snprintf(b, sizeof(b), c.format ? c.format : "%.17g", *d);
+            buf_ += b;
+        } else if (auto s = std::get_if<std::string>(&v)) {
+            if (json) detail::json_string(buf_, *s);
+            else detail::csv_field(buf_, *s);
+        } else if (json) {
+            buf_ += "null";
+        }
+    }
+
+    void encode_csv(const Row& r) {
+        for (std::size_t i = 0; i < schema_.size(); ++i) {
+            if (i) buf_ += ',';
+            text_value(r[i], schema_[i], false);
+        }
+        buf_ += '\n';
+    }
+
+    void encode_jsonl(const Row& r) {
+        buf_ += '{';
+        for (std::size_t i = 0; i < schema_.size(); ++i) {
+            if (i) buf_ += ',';
+            detail::json_string(buf_, schema_[i].name);
+            buf_ += ':';
+            text_value(r[i], schema_[i], true);
+        }
+        buf_ += "}\n";
+    }
+
+    void encode_binary(const Row& r) {
+        buf_ += 'R';
+        for (std::size_t i = 0; i < schema_.size(); ++i) {
+            const Value& v = r[i];
+            buf_ += static_cast<char>(std::holds_alternative<std::monostate>(v) ? 0 : 1);
+            if (auto n = std::get_if<std::int64_t>(&v)) detail::put_bytes(buf_, *n);
+            else if (auto d = std::get_if<double>(&v)) detail::put_bytes(buf_, *d);
+            else if (auto s = std::get_if<std::string>(&v)) {
+                detail::put_bytes(buf_, static_cast<std::uint32_t>(s->size()));
+                buf_ += *s;
+            }
+        }
+    }
+
+    const Schema& schema_;
+    ResultFormat fmt_;
+    std::size_t limit_;
+    std::ofstream f_;
+    std::string buf_;
+};
+
+/// Key/value description of this run: id, time, host, OS, CPU, ISA, thread,
+/// core, socket and NUMA node counts, compiler, build flags and git revision
+/// (the last two as configured).
+inline std::vector<std::pair<std::string, std::string>> host_metadata() {
+    std::vector<std::pair<std::string, std::string>> m;
+    const std::time_t now = std::time(nullptr);
+    char ts[32];
+    std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    std::string host = "unknown", os = "unknown";
+    long pid = 0;
+#if defined(__unix__) || defined(__APPLE__)
+    char h[256] = {};
+    if (::gethostname(h, sizeof(h) - 1) == 0) host = h;
+    struct utsname u;
+    if (::uname(&u) == 0) os = std::string(u.sysname) + " " + u.release + " " + u.machine;
+    pid = static_cast<long>(::getpid());
+#endif
+
+    std::string compiler = "unknown";
+#if defined(__clang__)
+    compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    compiler = "msvc " + std::to_string(_MSC_VER);
+#endif
+
+    char id[64];
+    std::snprintf(id, sizeof(id), "%lld-%ld", static_cast<long long>(now), pid);
+
+    m.push_back({"run_id", id});
+    m.push_back({"time", ts});
+    m.push_back({"host", host});
+    m.push_back({"os", os});
+    m.push_back({"cpu", cpu_model()});
+    m.push_back({"isa", isa_name(active_isa())});
+    m.push_back({"hardware_threads", std::to_string(hardware_threads())});
+    m.push_back({"cores", std::to_string(topology().cores())});
+    m.push_back({"packages", std::to_string(topology().packages)});
+    m.push_back({"numa_nodes", std::to_string(topology().nodes)});
+    m.push_back({"compiler", compiler});
+    m.push_back({"flags", HPC_BUILD_FLAGS});
+    m.push_back({"git_sha", HPC_GIT_SHA});
+    return m;
+}
+
+/// Append meta to path as one JSON object line.
+inline void write_metadata_line(const std::string& path,
+                                const std::vector<std::pair<std::string, std::string>>& meta)
+{
+    std::string line = "{";
+    for (std::size_t i = 0; i < meta.size(); ++i) {
+        if (i) line += ',';
+        detail::json_string(line, meta[i].first);
+        line += ':';
+        detail::json_string(line, meta[i].second);
+    }
+    line += "}\n";
+
+    std::ofstream f(path, std::ios::app);
+    if (!f) {
+        throw std::runtime_error("write_metadata_line: cannot open file " + path);
+    }
+    f << line;
+}
+
+}
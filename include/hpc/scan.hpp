@@ -1,24 +1,252 @@
 #pragma once
 #include <vector>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <algorithm>
 #include <type_traits>
 
+#include "hpc/dispatch.hpp"
+#include "hpc/thread_pool.hpp"
+
 namespace hpc {
 
+namespace detail {
+
+/// Serial block sum / scan of each ISA level; see hpc/isa/scan.inl.
+template <Isa I, typename T>
+struct scan_kernel_for;
+
+} // namespace detail
+
+}
+
+#define HPC_ISA_KERNELS "hpc/isa/scan.inl"
+#include "hpc/isa/foreach.inl"
+
+namespace hpc {
+
+namespace detail {
+
+/// block_sum(in, n), block_scan(in, out, n, offset, inclusive) and
+/// flag_scan(in, out, flags, n, s, init, inclusive) of active_isa().
+template <typename T>
+struct ScanKernels {
+    T (*block_sum)(const T*, std::size_t);
+    void (*block_scan)(const T*, T*, std::size_t, T, bool);
+    T (*flag_scan)(const T*, T*, const std::uint8_t*, std::size_t, T, T, bool);
+};
+
+template <typename T>
+ScanKernels<T> scan_kernels() {
+    return isa_dispatch([](auto isa) {
+        using K = scan_kernel_for<decltype(isa)::value, T>;
+        return ScanKernels<T>{&K::sum, &K::scan, &K::flag_scan};
+    });
+}
+
+/// Below this many elements per thread the fork/barrier cost beats the scan.
+constexpr std::size_t scan_min_block = std::size_t(1) << 14;
+
+/// Two-pass (reduce-then-scan) parallel scan.
+/// Pass 1: each thread sums its contiguous block. Barrier.
+/// Pass 2: each thread adds up the totals of the blocks before it and scans
+/// its block with that offset. in may equal out.
+template <typename T>
+void scan_two_pass(const T* in, T* out, std::size_t n, std::size_t nthreads,
+                   T init, bool inclusive)
+{
+    const auto kern = scan_kernels<T>();
+    nthreads = std::max<std::size_t>(1, std::min(nthreads, n / scan_min_block));
+    if (nthreads == 1) {
+        kern.block_scan(in, out, n, init, inclusive);
+        return;
+    }
+
+    std::vector<T> totals(nthreads);
+
+    default_pool().run(nthreads, [&](const ThreadContext& ctx) {
+        const auto r = split_range(n, ctx.nthreads, ctx.tid);
+        const std::size_t len = r.second - r.first;
+
+        totals[ctx.tid] = kern.block_sum(in + r.first, len);
+        ctx.barrier();
+
+        T offset = init;
+        for (std::size_t t = 0; t < ctx.tid; ++t) offset += totals[t];
+
+        kern.block_scan(in + r.first, out + r.first, len, offset, inclusive);
+    });
+}
+
+/// Per-tile look-back descriptor, one cache line each to avoid false sharing.
+/// flag: 0 = nothing published, 1 = aggregate valid, 2 = inclusive prefix valid.
+template <typename T>
+struct alignas(64) TileStatus {
+    std::atomic<std::uint32_t> flag{0};
+    T aggregate{};
+    T inclusive{};
+};
+
+constexpr std::uint32_t tile_aggregate = 1;
+constexpr std::uint32_t tile_prefix    = 2;
+
+/// Single-pass scan with decoupled look-back.
+/// Tiles are claimed in order from an atomic counter. A tile sums itself,
+/// publishes its aggregate, then walks back over predecessors adding their
+/// aggregates until it meets a published inclusive prefix. It publishes its
+/// own prefix and scans the tile (still cache resident) with that offset,
+/// so DRAM sees each element read and written once.
+/// Integer results are exact; for floating point the look-back order depends
+/// on timing, so the last bits may vary across runs. in may equal out.
+template <typename T>
+void scan_lookback(const T* in, T* out, std::size_t n, std::size_t nthreads,
+                   T init, bool inclusive, std::size_t tile)
+{
+    const auto kern = scan_kernels<T>();
+    tile = std::max<std::size_t>(tile, 1);
+    const std::size_t ntiles = (n + tile - 1) / tile;
+    nthreads = std::max<std::size_t>(1, std::min(nthreads, ntiles));
+    if (nthreads == 1) {
+        kern.block_scan(in, out, n, init, inclusive);
+        return;
+    }
+
+    std::unique_ptr<TileStatus<T>[]> status(new TileStatus<T>[ntiles]);
+    std::atomic<std::size_t> next{0};
+
+    default_pool().run(nthreads, [&](const ThreadContext&) {
+        for (;;) {
+            const std::size_t b = next.fetch_add(1, std::memory_order_relaxed);
+            if (b >= ntiles) break;
+
+            const std::size_t lo = b * tile;
+            const std::size_t len = std::min(tile, n - lo);
+            const T agg = kern.block_sum(in + lo, len);
+            TileStatus<T>& st = status[b];
+
+            T exclusive = init;
+            if (b == 0) {
+                st.inclusive = init + agg;
+                st.flag.store(tile_prefix, std::memory_order_release);
+            } else {
+                st.aggregate = agg;
+                st.flag.store(tile_aggregate, std::memory_order_release);
+
+                T run = 0;
+                for (std::size_t j = b; j-- > 0;) {
+                    std::uint32_t f;
+                    for (int spin = 0; (f = status[j].flag.load(std::memory_order_acquire)) == 0; ++spin) {
+                        if (spin > 64) std::this_thread::yield();
+                    }
+                    if (f == tile_prefix) { run += status[j].inclusive; break; }
+                    run += status[j].aggregate;
+                }
+                exclusive = run;
+
+                st.inclusive = exclusive + agg;
+                st.flag.store(tile_prefix, std::memory_order_release);
+            }
+
+            kern.block_scan(in + lo, out + lo, len, exclusive, inclusive);
+        }
+    });
+}
+
+/// Default look-back tile: 16K elements, small enough to stay in L2 between
+/// the sum and the scan of the same tile.
+constexpr std::size_t lookback_tile = std::size_t(1) << 14;
+
+} // namespace detail
+
 /// In-place inclusive scan (prefix sum).
-/// After call, x[i] = sum_{j=0..i} original_x[j].
+/// After call, x[i] = sum_{j=0..i} original_x[j]. Runs the active ISA's
+/// in-register scan kernel.
 template <typename T>
 void inclusive_scan_inplace(std::vector<T>& x) {
 
     static_assert(std::is_arithmetic<T>::value,
                   "inclusive_scan_inplace: T must be arithmetic");
 
-    T acc = 0;
-    
-    for (std::size_t i = 0; i < x.size(); ++i) {
-        acc += x[i];
-        x[i] = acc;
-    }
+    detail::scan_kernels<T>().block_scan(x.data(), x.data(), x.size(), T(0), true);
 }
 
-}
\ No newline at end of file
+/// In-place inclusive scan on nthreads threads (two-pass, see scan_two_pass).
+template <typename T>
+void inclusive_scan_inplace(std::vector<T>& x, std::size_t nthreads) {
+    static_assert(std::is_arithmetic<T>::value,
+                  "inclusive_scan_inplace: T must be arithmetic");
+
+    detail::scan_two_pass<T>(x.data(), x.data(), x.size(), nthreads, T(0), true);
+}
+
+/// In-place exclusive scan: x[i] = init + sum_{j<i} original_x[j].
+template <typename T>
+void exclusive_scan_inplace(std::vector<T>& x, std::size_t nthreads = 1, T init = T(0)) {
+    static_assert(std::is_arithmetic<T>::value,
+                  "exclusive_scan_inplace: T must be arithmetic");
+
+    detail::scan_two_pass<T>(x.data(), x.data(), x.size(), nthreads, init, false);
+}
+
+/// Out-of-place inclusive scan: out[i] = sum_{j=0..i} in[j]. in may equal out.
+template <typename T>
+void inclusive_scan(const T* in, T* out, std::size_t n, std::size_t nthreads = 1) {
+    static_assert(std::is_arithmetic<T>::value,
+                  "inclusive_scan: T must be arithmetic");
+
+    detail::scan_two_pass<T>(in, out, n, nthreads, T(0), true);
+}
+
+/// Out-of-place exclusive scan: out[i] = init + sum_{j<i} in[j]. in may equal out.
+template <typename T>
+void exclusive_scan(const T* in, T* out, std::size_t n, std::size_t nthreads = 1, T init = T(0)) {
+    static_assert(std::is_arithmetic<T>::value,
+                  "exclusive_scan: T must be arithmetic");
+
+    detail::scan_two_pass<T>(in, out, n, nthreads, init, false);
+}
+
+/// Vector overloads; out is resized to in.size() (no reallocation when it already fits).
+template <typename T>
+void inclusive_scan(const std::vector<T>& in, std::vector<T>& out, std::size_t nthreads = 1) {
+    out.resize(in.size());
+    inclusive_scan(in.data(), out.data(), in.size(), nthreads);
+}
+
+template <typename T>
+void exclusive_scan(const std::vector<T>& in, std::vector<T>& out, std::size_t nthreads = 1, T init = T(0)) {
+    out.resize(in.size());
+    exclusive_scan(in.data(), out.data(), in.size(), nthreads, init);
+}
+
+/// Single-pass decoupled look-back scans (see detail::scan_lookback).
+template <typename T>
+void inclusive_scan_lookback(const T* in, T* out, std::size_t n, std::size_t nthreads,
+                             std::size_t tile = detail::lookback_tile)
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "inclusive_scan_lookback: T must be arithmetic");
+
+    detail::scan_lookback<T>(in, out, n, nthreads, T(0), true, tile);
+}
+
+template <typename T>
+void exclusive_scan_lookback(const T* in, T* out, std::size_t n, std::size_t nthreads,
+                             T init = T(0), std::size_t tile = detail::lookback_tile)
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "exclusive_scan_lookback: T must be arithmetic");
+
+    detail::scan_lookback<T>(in, out, n, nthreads, init, false, tile);
+}
+
+template <typename T>
+void inclusive_scan_lookback(std::vector<T>& x, std::size_t nthreads) {
+    inclusive_scan_lookback(x.data(), x.data(), x.size(), nthreads);
+}
+
+}
@@ -0,0 +1,281 @@
+#pragma once
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#include "hpc/scan.hpp"
+
+namespace hpc {
+
+namespace detail {
+
+/// segmented_scan works in tiles of this many elements; a tile holding more
+/// than one segment start per segment_dense elements takes the branch-free
+/// flag kernel, others scan whole runs with block_scan.
+constexpr std::size_t segment_tile = 2048;
+constexpr std::size_t segment_dense = 32;
+
+/// Runs shorter than this are scanned inline instead of through the kernel pointer.
+constexpr std::size_t segment_short_run = 16;
+
+template <typename T>
+void run_scan(const ScanKernels<T>& k, const T* in, T* out, std::size_t n, T offset, bool inclusive) {
+    if (n >= segment_short_run) { k.block_scan(in, out, n, offset, inclusive); return; }
+    T acc = offset;
+    if (inclusive) {
+        for (std::size_t i = 0; i < n; ++i) { acc += in[i]; out[i] = acc; }
+    } else {
+        for (std::size_t i = 0; i < n; ++i) { const T v = in[i]; out[i] = acc; acc += v; }
+    }
+}
+
+/// Segment starts from CSR-style offsets: segment s is [off[s], off[s+1]).
+struct OffsetHeads {
+    const std::size_t* off;
+    std::size_t nseg;
+
+    /// Walks the starts forward; positions passed in never decrease.
+    struct Cursor {
+        const std::size_t* off;
+        std::size_t k, nseg;
+
+        /// First segment start h with from <= h < end, else end.
+        std::size_t next(std::size_t from, std::size_t end) {
+            while (k < nseg && off[k] < from) ++k;
+            return k < nseg && off[k] < end ? off[k] : end;
+        }
+
+        /// Number of starts in [from, end).
+        std::size_t count(std::size_t from, std::size_t end) {
+            next(from, end);
+            return std::size_t(std::lower_bound(off + k, off + nseg, end) - (off + k));
+        }
+
+        /// Head flags of [from, end) in buf.
+        const std::uint8_t* flags(std::size_t from, std::size_t end, std::uint8_t* buf) {
+            std::memset(buf, 0, end - from);
+            for (std::size_t h = next(from, end); h < end; h = next(h + 1, end)) buf[h - from] = 1;
+            return buf;
+        }
+    };
+
+    Cursor cursor(std::size_t pos) const {
+        return {off, std::size_t(std::lower_bound(off, off + nseg, pos) - off), nseg};
+    }
+};
+
+/// Segment starts from head flags: a nonzero byte starts a segment.
+struct FlagHeads {
+    const std::uint8_t* head;
+
+    struct Cursor {
+        const std::uint8_t* head;
+
+        /// First flagged h with from <= h < end, else end; eight flags per test.
+        std::size_t next(std::size_t from, std::size_t end) {
+            std::size_t i = from;
+            for (; i + 8 <= end; i += 8) {
+                std::uint64_t w;
+                std::memcpy(&w, head + i, 8);
+                if (w != 0) break;
+            }
+            for (; i < end; ++i) if (head[i]) return i;
+            return end;
+        }
+
+        /// Set bits of the flags in [from, end): a lower bound on the starts
+        /// (exact for 0/1 flags), enough to pick a tile's path.
+        std::size_t count(std::size_t from, std::size_t end) {
+            std::size_t c = 0, i = from;
+            for (; i + 8 <= end; i += 8) {
+                std::uint64_t w;
+                std::memcpy(&w, head + i, 8);
+                c += std::size_t(__builtin_popcountll(w));
+            }
+            for (; i < end; ++i) c += head[i] != 0;
+            return c;
+        }
+
+        const std::uint8_t* flags(std::size_t from, std::size_t, std::uint8_t*) { return head + from; }
+    };
+
+    Cursor cursor(std::size_t) const { return {head}; }
+};
+
+/// Segmented scan of [0, n) in one pass per thread. Threads get equal
+/// element ranges, so one long segment is split like any other scan.
+/// Pass 1: a thread scans, tile by tile, everything from the first segment
+/// start in its range on, carrying s = sum since the last start, and
+/// publishes s (or the range total when no segment starts there). Barrier.
+/// Pass 2: the leading piece that continues an earlier segment is scanned
+/// with the carry gathered from the ranges before it. Each segment restarts
+/// at init. in may equal out.
+template <typename T, typename Heads>
+void segmented_scan(const T* in, T* out, std::size_t n, const Heads& heads,
+                    std::size_t nthreads, T init, bool inclusive)
+{
+    const auto k = scan_kernels<T>();
+    nthreads = std::max<std::size_t>(1, std::min(nthreads, n / scan_min_block));
+
+    std::vector<T> carry(nthreads);
+    std::vector<char> open(nthreads); // no segment starts in the range
+
+    default_pool().run(nthreads, [&](const ThreadContext& ctx) {
+        const auto r = split_range(n, ctx.nthreads, ctx.tid);
+        auto cur = heads.cursor(r.first);
+        const std::size_t first = r.first == 0 ? 0 : cur.next(r.first, r.second);
+        alignas(64) std::uint8_t buf[segment_tile];
+
+        T s = T(0);
+        for (std::size_t t = first; t < r.second; t += segment_tile) {
+            const std::size_t e = std::min(t + segment_tile, r.second);
+            if (cur.count(t, e) * segment_dense > e - t) {
+                s = k.flag_scan(in + t, out + t, cur.flags(t, e, buf), e - t, s, init, inclusive);
+                continue;
+            }
+            for (std::size_t h = t; h < e;) {
+                std::size_t nx = cur.next(h, e);
+                if (nx == h) { s = T(0); nx = cur.next(h + 1, e); }
+                // The tile's last run may go on in the next tile: keep its sum.
+                const T part = nx == e ? k.block_sum(in + h, nx - h) : T(0);
+                run_scan(k, in + h, out + h, nx - h, init + s, inclusive);
+                s += part;
+                h = nx;
+            }
+        }
+        open[ctx.tid] = first == r.second;
+        carry[ctx.tid] = open[ctx.tid] ? k.block_sum(in + r.first, r.second - r.first) : s;
+        ctx.barrier();
+
+        if (first > r.first) {
+            T c = T(0);
+            for (std::size_t t = ctx.tid; t-- > 0;) {
+                c = carry[t] + c;
+                if (!open[t]) break;
+            }
+            run_scan(k, in + r.first, out + r.first, first - r.first, init + c, inclusive);
+        }
+    });
+}
+
+/// Row-wise scan of a rows×cols matrix with leading dimensions; rows split
+/// over threads, each row restarting at init.
+template <typename T>
+void scan_rows(const T* in, std::size_t ld_in, T* out, std::size_t ld_out,
+               std::size_t rows, std::size_t cols, std::size_t nthreads, T init, bool inclusive)
+{
+    const auto k = scan_kernels<T>();
+    const std::size_t per = std::max<std::size_t>(1, scan_min_block / std::max<std::size_t>(cols, 1));
+    nthreads = std::max<std::size_t>(1, std::min(nthreads, rows / per));
+
+    default_pool().run(nthreads, [&](const ThreadContext& ctx) {
+        const auto r = split_range(rows, ctx.nthreads, ctx.tid);
+        for (std::size_t i = r.first; i < r.second; ++i)
+            run_scan(k, in + i * ld_in, out + i * ld_out, cols, init, inclusive);
+    });
+}
+
+} // namespace detail
+
+/// Segmented inclusive scan: for each segment s = [offsets[s], offsets[s+1]),
+/// out[i] = sum of in[offsets[s]..i]. offsets holds nsegments + 1 entries with
+/// offsets[0] == 0 and offsets[nsegments] == n (CSR row pointers; empty
+/// segments allowed). One parallel pass over the whole batch instead of a
+/// call per segment. in may equal out.
+template <typename T>
+void segmented_inclusive_scan(const T* in, T* out, std::size_t n,
+                              const std::size_t* offsets, std::size_t nsegments,
+                              std::size_t nthreads = 1)
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "segmented_inclusive_scan: T must be arithmetic");
+
+    assert(nsegments == 0 || (offsets[0] == 0 && offsets[nsegments] == n));
+    detail::segmented_scan<T>(in, out, n, detail::OffsetHeads{offsets, nsegments}, nthreads, T(0), true);
+}
+
+/// Segmented exclusive scan: out[i] = init + sum of in[offsets[s]..i).
+template <typename T>
+void segmented_exclusive_scan(const T* in, T* out, std::size_t n,
+                              const std::size_t* offsets, std::size_t nsegments,
+                              std::size_t nthreads = 1, T init = T(0))
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "segmented_exclusive_scan: T must be arithmetic");
+
+    assert(nsegments == 0 || (offsets[0] == 0 && offsets[nsegments] == n));
+    detail::segmented_scan<T>(in, out, n, detail::OffsetHeads{offsets, nsegments}, nthreads, init, false);
+}
+
+/// Segmented inclusive scan driven by head flags: heads[i] != 0 starts a
+/// new segment at i (index 0 always does).
+template <typename T>
+void segmented_inclusive_scan_flags(const T* in, T* out, std::size_t n,
+                                    const std::uint8_t* heads, std::size_t nthreads = 1)
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "segmented_inclusive_scan_flags: T must be arithmetic");
+
+    detail::segmented_scan<T>(in, out, n, detail::FlagHeads{heads}, nthreads, T(0), true);
+}
+
+template <typename T>
+void segmented_exclusive_scan_flags(const T* in, T* out, std::size_t n,
+                                    const std::uint8_t* heads, std::size_t nthreads = 1, T init = T(0))
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "segmented_exclusive_scan_flags: T must be arithmetic");
+
+    detail::segmented_scan<T>(in, out, n, detail::FlagHeads{heads}, nthreads, init, false);
+}
+
+/// Vector overloads; offsets.size() == number of segments + 1.
+template <typename T>
+void segmented_inclusive_scan(const std::vector<T>& in, std::vector<T>& out,
+                              const std::vector<std::size_t>& offsets, std::size_t nthreads = 1)
+{
+    assert(!offsets.empty());
+    out.resize(in.size());
+    segmented_inclusive_scan(in.data(), out.data(), in.size(), offsets.data(), offsets.size() - 1, nthreads);
+}
+
+template <typename T>
+void segmented_exclusive_scan(const std::vector<T>& in, std::vector<T>& out,
+                              const std::vector<std::size_t>& offsets, std::size_t nthreads = 1,
+                              T init = T(0))
+{
+    assert(!offsets.empty());
+    out.resize(in.size());
+    segmented_exclusive_scan(in.data(), out.data(), in.size(), offsets.data(), offsets.size() - 1,
+                             nthreads, init);
+}
+
+/// Row-wise inclusive scan of a rows×cols row-major matrix with leading
+/// dimensions: out(i, j) = sum_{c<=j} in(i, c). in may equal out when
+/// ld_in == ld_out.
+template <typename T>
+void inclusive_scan_rows(const T* in, std::size_t ld_in, T* out, std::size_t ld_out,
+                         std::size_t rows, std::size_t cols, std::size_t nthreads = 1)
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "inclusive_scan_rows: T must be arithmetic");
+
+    detail::scan_rows<T>(in, ld_in, out, ld_out, rows, cols, nthreads, T(0), true);
+}
+
+/// Row-wise exclusive scan: out(i, j) = init + sum_{c<j} in(i, c).
+template <typename T>
+void exclusive_scan_rows(const T* in, std::size_t ld_in, T* out, std::size_t ld_out,
+                         std::size_t rows, std::size_t cols, std::size_t nthreads = 1, T init = T(0))
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "exclusive_scan_rows: T must be arithmetic");
+
+    detail::scan_rows<T>(in, ld_in, out, ld_out, rows, cols, nthreads, init, false);
+}
+
+}
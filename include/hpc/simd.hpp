@@ -0,0 +1,422 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+/// Runtime dispatch (hpc/dispatch.hpp): on x86 the AVX2 and AVX-512 ops are
+/// compiled regardless of -m flags, inside target regions, so one binary can
+/// carry every level. Define HPC_NO_DISPATCH to only build what -march allows.
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64)) && !defined(HPC_NO_DISPATCH)
+#define HPC_X86_DISPATCH 1
+#else
+#define HPC_X86_DISPATCH 0
+#endif
+
+#if (defined(__AVX2__) && defined(__FMA__)) || HPC_X86_DISPATCH
+#define HPC_HAVE_AVX2 1
+#else
+#define HPC_HAVE_AVX2 0
+#endif
+
+#if (defined(__AVX512F__) && HPC_HAVE_AVX2) || HPC_X86_DISPATCH
+#define HPC_HAVE_AVX512 1
+#else
+#define HPC_HAVE_AVX512 0
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define HPC_HAVE_NEON 1
+#else
+#define HPC_HAVE_NEON 0
+#endif
+
+/// HPC_TARGET_<ISA>_BEGIN/END: every function defined in between is compiled
+/// for that ISA. MSVC needs nothing, its intrinsics are always available.
+#if defined(__clang__)
+#define HPC_TARGET_AVX2_BEGIN \
+    _Pragma("clang attribute push(__attribute__((target(\"avx2,fma\"))), apply_to = function)")
+#define HPC_TARGET_AVX512_BEGIN \
+    _Pragma("clang attribute push(__attribute__((target(\"avx512f,avx2,fma\"))), apply_to = function)")
+#define HPC_TARGET_AVX512BF16_BEGIN \
+    _Pragma("clang attribute push(__attribute__((target(\"avx512f,avx512bw,avx512bf16,avx2,fma\"))), apply_to = function)")
+#define HPC_TARGET_AVX512VNNI_BEGIN \
+    _Pragma("clang attribute push(__attribute__((target(\"avx512f,avx512bw,avx512vnni,avx2,fma\"))), apply_to = function)")
+#define HPC_TARGET_END _Pragma("clang attribute pop")
+#elif defined(__GNUC__)
+#define HPC_TARGET_AVX2_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx2,fma\")")
+#define HPC_TARGET_AVX512_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f,avx2,fma\")")
+#define HPC_TARGET_AVX512BF16_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f,avx512bw,avx512bf16,avx2,fma\")")
+#define HPC_TARGET_AVX512VNNI_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f,avx512bw,avx512vnni,avx2,fma\")")
+#define HPC_TARGET_END _Pragma("GCC pop_options")
+#else
+#define HPC_TARGET_AVX2_BEGIN
+#define HPC_TARGET_AVX512_BEGIN
+#define HPC_TARGET_END
+#endif
+
+/// AVX512-BF16 (vdpbf16ps, hpc/matmul_mixed.hpp) and AVX512-VNNI (vpdpbusd,
+/// hpc/matmul_int8.hpp) dot-product kernels; GCC/Clang only.
+#if HPC_HAVE_AVX512 && (defined(__GNUC__) || defined(__clang__)) && !defined(HPC_NO_DISPATCH)
+#define HPC_HAVE_AVX512_BF16 1
+#define HPC_HAVE_AVX512_VNNI 1
+#else
+#define HPC_HAVE_AVX512_BF16 0
+#define HPC_HAVE_AVX512_VNNI 0
+#endif
+
+#if HPC_HAVE_AVX512 || HPC_HAVE_AVX2
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace hpc::simd {
+
+/// Thin per-ISA wrappers over vector registers.
+/// Every ops struct exposes the same static interface (reg, width, zero,
+/// set1, load, loadu, store, storeu, add, sub, mul, min, max, fmadd, fmsub,
+/// gather, shift_up<K>, broadcast_last) so kernels can be written once as templates
+/// and instantiated for each instruction set. The integer lane structs
+/// (*_i32<T>, *_i64<T>) carry the subset the scans use: zero, set1, loadu,
+/// storeu, add, shift_up<K>, broadcast_last.
+
+template <typename T>
+struct scalar_ops {
+    using value_type = T;
+    using reg = T;
+    static constexpr std::size_t width = 1;
+
+    static reg zero() { return T(0); }
+    static reg set1(T a) { return a; }
+    static reg load(const T* p) { return *p; }
+    static reg loadu(const T* p) { return *p; }
+    static void store(T* p, reg v) { *p = v; }
+    static void storeu(T* p, reg v) { *p = v; }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg sub(reg a, reg b) { return a - b; }
+    static reg mul(reg a, reg b) { return a * b; }
+    static reg min(reg a, reg b) { return a < b ? a : b; }
+    static reg max(reg a, reg b) { return a > b ? a : b; }
+    static reg fmadd(reg a, reg b, reg c) { return a * b + c; } // a*b + c
+    /// a*b - c with one rounding (exact product errors need it fused).
+    static reg fmsub(reg a, reg b, reg c) { return std::fma(a, b, -c); }
+    /// Lanes base[idx[0]], ..., base[idx[width - 1]].
+    static reg gather(const T* base, const std::uint32_t* idx) { return base[*idx]; }
+    /// Lane i of the result is lane i-K of v, zero below K.
+    template <int K> static reg shift_up(reg) { return T(0); }
+    /// Every lane set to the last lane of v.
+    static reg broadcast_last(reg v) { return v; }
+};
+
+#if HPC_HAVE_AVX512
+HPC_TARGET_AVX512_BEGIN
+struct avx512_f32 {
+    using value_type = float;
+    using reg = __m512;
+    static constexpr std::size_t width = 16;
+
+    static reg zero() { return _mm512_setzero_ps(); }
+    static reg set1(float a) { return _mm512_set1_ps(a); }
+    static reg load(const float* p) { return _mm512_load_ps(p); }
+    static reg loadu(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, reg v) { _mm512_store_ps(p, v); }
+    static void storeu(float* p, reg v) { _mm512_storeu_ps(p, v); }
+    static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    static reg min(reg a, reg b) { return _mm512_min_ps(a, b); }
+    static reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+    static reg fmsub(reg a, reg b, reg c) { return _mm512_fmsub_ps(a, b, c); }
+    // Indices are zero-extended to 64 bits: the 32-bit gathers sign-extend them.
+    static reg gather(const float* base, const std::uint32_t* idx) {
+        const __m512i i = _mm512_loadu_si512(idx);
+        const __m256 lo = _mm512_i64gather_ps(_mm512_cvtepu32_epi64(_mm512_castsi512_si256(i)), base, 4);
+        const __m256 hi = _mm512_i64gather_ps(_mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(i, 1)), base, 4);
+        return _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castpd256_pd512(_mm256_castps_pd(lo)),
+                                                   _mm256_castps_pd(hi), 1));
+    }
+    template <int K> static reg shift_up(reg v) {
+        return _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(v), _mm512_setzero_si512(), 16 - K));
+    }
+    static reg broadcast_last(reg v) { return _mm512_permutexvar_ps(_mm512_set1_epi32(15), v); }
+};
+
+struct avx512_f64 {
+    using value_type = double;
+    using reg = __m512d;
+    static constexpr std::size_t width = 8;
+
+    static reg zero() { return _mm512_setzero_pd(); }
+    static reg set1(double a) { return _mm512_set1_pd(a); }
+    static reg load(const double* p) { return _mm512_load_pd(p); }
+    static reg loadu(const double* p) { return _mm512_loadu_pd(p); }
+    static void store(double* p, reg v) { _mm512_store_pd(p, v); }
+    static void storeu(double* p, reg v) { _mm512_storeu_pd(p, v); }
+    static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+    static reg min(reg a, reg b) { return _mm512_min_pd(a, b); }
+    static reg max(reg a, reg b) { return _mm512_max_pd(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+    static reg fmsub(reg a, reg b, reg c) { return _mm512_fmsub_pd(a, b, c); }
+    static reg gather(const double* base, const std::uint32_t* idx) {
+        const __m256i i = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx));
+        return _mm512_i64gather_pd(_mm512_cvtepu32_epi64(i), base, 8);
+    }
+    template <int K> static reg shift_up(reg v) {
+        return _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(v), _mm512_setzero_si512(), 8 - K));
+    }
+    static reg broadcast_last(reg v) { return _mm512_permutexvar_pd(_mm512_set1_epi64(7), v); }
+};
+
+template <typename T>
+struct avx512_i32 {
+    using value_type = T;
+    using reg = __m512i;
+    static constexpr std::size_t width = 16;
+
+    static reg zero() { return _mm512_setzero_si512(); }
+    static reg set1(T a) { return _mm512_set1_epi32(static_cast<int>(a)); }
+    static reg loadu(const T* p) { return _mm512_loadu_si512(p); }
+    static void storeu(T* p, reg v) { _mm512_storeu_si512(p, v); }
+    static reg add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+    template <int K> static reg shift_up(reg v) { return _mm512_alignr_epi32(v, _mm512_setzero_si512(), 16 - K); }
+    static reg broadcast_last(reg v) { return _mm512_permutexvar_epi32(_mm512_set1_epi32(15), v); }
+};
+
+template <typename T>
+struct avx512_i64 {
+    using value_type = T;
+    using reg = __m512i;
+    static constexpr std::size_t width = 8;
+
+    static reg zero() { return _mm512_setzero_si512(); }
+    static reg set1(T a) { return _mm512_set1_epi64(static_cast<long long>(a)); }
+    static reg loadu(const T* p) { return _mm512_loadu_si512(p); }
+    static void storeu(T* p, reg v) { _mm512_storeu_si512(p, v); }
+    static reg add(reg a, reg b) { return _mm512_add_epi64(a, b); }
+    template <int K> static reg shift_up(reg v) { return _mm512_alignr_epi64(v, _mm512_setzero_si512(), 8 - K); }
+    static reg broadcast_last(reg v) { return _mm512_permutexvar_epi64(_mm512_set1_epi64(7), v); }
+};
+HPC_TARGET_END
+#endif
+
+#if HPC_HAVE_AVX2
+HPC_TARGET_AVX2_BEGIN
+/// v moved up by B bytes across the whole register (zero fill), B in {4, 8, 16}:
+/// the low half shifted in below the high half, then a byte align per half.
+template <int B>
+inline __m256i avx2_shift_up_bytes(__m256i v) {
+    const __m256i lo = _mm256_permute2x128_si256(v, v, 0x08); // [0, v.lo]
+    if constexpr (B == 16) return lo;
+    else return _mm256_alignr_epi8(v, lo, 16 - B);
+}
+
+struct avx2_f32 {
+    using value_type = float;
+    using reg = __m256;
+    static constexpr std::size_t width = 8;
+
+    static reg zero() { return _mm256_setzero_ps(); }
+    static reg set1(float a) { return _mm256_set1_ps(a); }
+    static reg load(const float* p) { return _mm256_load_ps(p); }
+    static reg loadu(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, reg v) { _mm256_store_ps(p, v); }
+    static void storeu(float* p, reg v) { _mm256_storeu_ps(p, v); }
+    static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+    static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+    static reg fmsub(reg a, reg b, reg c) { return _mm256_fmsub_ps(a, b, c); }
+    static reg gather(const float* base, const std::uint32_t* idx) {
+        const __m256i i = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx));
+        const __m128 lo = _mm256_i64gather_ps(base, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(i)), 4);
+        const __m128 hi = _mm256_i64gather_ps(base, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(i, 1)), 4);
+        return _mm256_set_m128(hi, lo);
+    }
+    template <int K> static reg shift_up(reg v) {
+        return _mm256_castsi256_ps(avx2_shift_up_bytes<4 * K>(_mm256_castps_si256(v)));
+    }
+    static reg broadcast_last(reg v) { return _mm256_permutevar8x32_ps(v, _mm256_set1_epi32(7)); }
+};
+
+struct avx2_f64 {
+    using value_type = double;
+    using reg = __m256d;
+    static constexpr std::size_t width = 4;
+
+    static reg zero() { return _mm256_setzero_pd(); }
+    static reg set1(double a) { return _mm256_set1_pd(a); }
+    static reg load(const double* p) { return _mm256_load_pd(p); }
+    static reg loadu(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, reg v) { _mm256_store_pd(p, v); }
+    static void storeu(double* p, reg v) { _mm256_storeu_pd(p, v); }
+    static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+    static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+    static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+    static reg fmsub(reg a, reg b, reg c) { return _mm256_fmsub_pd(a, b, c); }
+    static reg gather(const double* base, const std::uint32_t* idx) {
+        const __m128i i = _mm_loadu_si128(reinterpret_cast<const __m128i*>(idx));
+        return _mm256_i64gather_pd(base, _mm256_cvtepu32_epi64(i), 8);
+    }
+    template <int K> static reg shift_up(reg v) {
+        return _mm256_castsi256_pd(avx2_shift_up_bytes<8 * K>(_mm256_castpd_si256(v)));
+    }
+    static reg broadcast_last(reg v) { return _mm256_permute4x64_pd(v, 0xFF); }
+};
+
+template <typename T>
+struct avx2_i32 {
+    using value_type = T;
+    using reg = __m256i;
+    static constexpr std::size_t width = 8;
+
+    static reg zero() { return _mm256_setzero_si256(); }
+    static reg set1(T a) { return _mm256_set1_epi32(static_cast<int>(a)); }
+    static reg loadu(const T* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void storeu(T* p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static reg add(reg a, reg b) { return _mm256_add_epi32(a, b); }
+    template <int K> static reg shift_up(reg v) { return avx2_shift_up_bytes<4 * K>(v); }
+    static reg broadcast_last(reg v) { return _mm256_permutevar8x32_epi32(v, _mm256_set1_epi32(7)); }
+};
+
+template <typename T>
+struct avx2_i64 {
+    using value_type = T;
+    using reg = __m256i;
+    static constexpr std::size_t width = 4;
+
+    static reg zero() { return _mm256_setzero_si256(); }
+    static reg set1(T a) { return _mm256_set1_epi64x(static_cast<long long>(a)); }
+    static reg loadu(const T* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void storeu(T* p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static reg add(reg a, reg b) { return _mm256_add_epi64(a, b); }
+    template <int K> static reg shift_up(reg v) { return avx2_shift_up_bytes<8 * K>(v); }
+    static reg broadcast_last(reg v) { return _mm256_permute4x64_epi64(v, 0xFF); }
+};
+HPC_TARGET_END
+#endif
+
+#if HPC_HAVE_NEON
+struct neon_f32 {
+    using value_type = float;
+    using reg = float32x4_t;
+    static constexpr std::size_t width = 4;
+
+    static reg zero() { return vdupq_n_f32(0.0f); }
+    static reg set1(float a) { return vdupq_n_f32(a); }
+    static reg load(const float* p) { return vld1q_f32(p); }
+    static reg loadu(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, reg v) { vst1q_f32(p, v); }
+    static void storeu(float* p, reg v) { vst1q_f32(p, v); }
+    static reg add(reg a, reg b) { return vaddq_f32(a, b); }
+    static reg sub(reg a, reg b) { return vsubq_f32(a, b); }
+    static reg mul(reg a, reg b) { return vmulq_f32(a, b); }
+    static reg min(reg a, reg b) { return vminq_f32(a, b); }
+    static reg max(reg a, reg b) { return vmaxq_f32(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return vfmaq_f32(c, a, b); }
+    static reg fmsub(reg a, reg b, reg c) { return vnegq_f32(vfmsq_f32(c, a, b)); }
+    // No gather instruction: the lanes are loaded one by one.
+    static reg gather(const float* base, const std::uint32_t* idx) {
+        const float l[4] = {base[idx[0]], base[idx[1]], base[idx[2]], base[idx[3]]};
+        return vld1q_f32(l);
+    }
+    template <int K> static reg shift_up(reg v) { return vextq_f32(vdupq_n_f32(0.0f), v, 4 - K); }
+    static reg broadcast_last(reg v) { return vdupq_laneq_f32(v, 3); }
+};
+
+struct neon_f64 {
+    using value_type = double;
+    using reg = float64x2_t;
+    static constexpr std::size_t width = 2;
+
+    static reg zero() { return vdupq_n_f64(0.0); }
+    static reg set1(double a) { return vdupq_n_f64(a); }
+    static reg load(const double* p) { return vld1q_f64(p); }
+    static reg loadu(const double* p) { return vld1q_f64(p); }
+    static void store(double* p, reg v) { vst1q_f64(p, v); }
+    static void storeu(double* p, reg v) { vst1q_f64(p, v); }
+    static reg add(reg a, reg b) { return vaddq_f64(a, b); }
+    static reg sub(reg a, reg b) { return vsubq_f64(a, b); }
+    static reg mul(reg a, reg b) { return vmulq_f64(a, b); }
+    static reg min(reg a, reg b) { return vminq_f64(a, b); }
+    static reg max(reg a, reg b) { return vmaxq_f64(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return vfmaq_f64(c, a, b); }
+    static reg fmsub(reg a, reg b, reg c) { return vnegq_f64(vfmsq_f64(c, a, b)); }
+    static reg gather(const double* base, const std::uint32_t* idx) {
+        const double l[2] = {base[idx[0]], base[idx[1]]};
+        return vld1q_f64(l);
+    }
+    template <int K> static reg shift_up(reg v) { return vextq_f64(vdupq_n_f64(0.0), v, 2 - K); }
+    static reg broadcast_last(reg v) { return vdupq_laneq_f64(v, 1); }
+};
+
+template <typename T>
+struct neon_i32 {
+    using value_type = T;
+    using reg = int32x4_t;
+    static constexpr std::size_t width = 4;
+
+    static reg zero() { return vdupq_n_s32(0); }
+    static reg set1(T a) { return vdupq_n_s32(static_cast<std::int32_t>(a)); }
+    static reg loadu(const T* p) { return vld1q_s32(reinterpret_cast<const std::int32_t*>(p)); }
+    static void storeu(T* p, reg v) { vst1q_s32(reinterpret_cast<std::int32_t*>(p), v); }
+    static reg add(reg a, reg b) { return vaddq_s32(a, b); }
+    template <int K> static reg shift_up(reg v) { return vextq_s32(vdupq_n_s32(0), v, 4 - K); }
+    static reg broadcast_last(reg v) { return vdupq_laneq_s32(v, 3); }
+};
+
+template <typename T>
+struct neon_i64 {
+    using value_type = T;
+    using reg = int64x2_t;
+    static constexpr std::size_t width = 2;
+
+    static reg zero() { return vdupq_n_s64(0); }
+    static reg set1(T a) { return vdupq_n_s64(static_cast<std::int64_t>(a)); }
+    static reg loadu(const T* p) { return vld1q_s64(reinterpret_cast<const std::int64_t*>(p)); }
+    static void storeu(T* p, reg v) { vst1q_s64(reinterpret_cast<std::int64_t*>(p), v); }
+    static reg add(reg a, reg b) { return vaddq_s64(a, b); }
+    template <int K> static reg shift_up(reg v) { return vextq_s64(vdupq_n_s64(0), v, 2 - K); }
+    static reg broadcast_last(reg v) { return vdupq_laneq_s64(v, 1); }
+};
+#endif
+
+/// Widest ops the compiler flags of this translation unit allow (no dispatch).
+template <typename T> struct native { using type = scalar_ops<T>; };
+
+#if defined(__AVX512F__)
+template <> struct native<float>  { using type = avx512_f32; };
+template <> struct native<double> { using type = avx512_f64; };
+#elif defined(__AVX2__) && defined(__FMA__)
+template <> struct native<float>  { using type = avx2_f32; };
+template <> struct native<double> { using type = avx2_f64; };
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+template <> struct native<float>  { using type = neon_f32; };
+template <> struct native<double> { using type = neon_f64; };
+#endif
+
+template <typename T>
+using native_t = typename native<T>::type;
+
+/// Name of the instruction set native_t<T> maps to (for logs / CSV).
+inline const char* native_isa_name() {
+#if defined(__AVX512F__)
+    return "avx512";
+#elif defined(__AVX2__) && defined(__FMA__)
+    return "avx2";
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+}
@@ -0,0 +1,250 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cctype>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "hpc/dispatch.hpp"
+#include "hpc/scan.hpp"
+#include "hpc/thread_pool.hpp"
+
+namespace hpc {
+
+/// Compressed sparse row matrix: row r holds entries [row_ptr[r], row_ptr[r+1])
+/// of col / val, columns ascending and unique within a row.
+template <typename T>
+struct CsrMatrix {
+    std::size_t rows = 0, cols = 0;
+    std::vector<std::size_t> row_ptr{0}; // rows + 1 entries
+    std::vector<std::uint32_t> col;
+    std::vector<T> val;
+
+    std::size_t nnz() const { return val.size(); }
+};
+
+/// CSR from coordinate triplets (r[k], c[k], v[k]) in any order. Row
+/// pointers come from an inclusive scan of the row counts; entries are sorted
+/// by column within each row and duplicates are summed in input order.
+template <typename T>
+CsrMatrix<T> csr_from_coo(std::size_t rows, std::size_t cols,
+                          const std::vector<std::size_t>& r, const std::vector<std::size_t>& c,
+                          const std::vector<T>& v)
+{
+    assert(r.size() == c.size() && r.size() == v.size());
+    assert(cols <= (std::size_t(1) << 32));
+
+    CsrMatrix<T> A;
+    A.rows = rows;
+    A.cols = cols;
+    A.row_ptr.assign(rows + 1, 0);
+    for (std::size_t k = 0; k < r.size(); ++k) {
+        assert(r[k] < rows && c[k] < cols);
+        ++A.row_ptr[r[k] + 1];
+    }
+    inclusive_scan_inplace(A.row_ptr);
+
+    std::vector<std::pair<std::uint32_t, T>> e(r.size());
+    std::vector<std::size_t> next(A.row_ptr.begin(), A.row_ptr.end() - 1);
+    for (std::size_t k = 0; k < r.size(); ++k) e[next[r[k]]++] = {std::uint32_t(c[k]), v[k]};
+
+    A.col.resize(e.size());
+    A.val.resize(e.size());
+    std::size_t w = 0;
+    for (std::size_t i = 0; i < rows; ++i) {
+        const auto first = e.begin() + std::ptrdiff_t(A.row_ptr[i]);
+        const auto last = e.begin() + std::ptrdiff_t(A.row_ptr[i + 1]);
+        std::stable_sort(first, last, [](const auto& a, const auto& b) { return a.first < b.first; });
+        const std::size_t start = w;
+        for (auto it = first; it != last; ++it) {
+            if (w > start && A.col[w - 1] == it->first) { A.val[w - 1] += it->second; continue; }
+            A.col[w] = it->first;
+            A.val[w] = it->second;
+            ++w;
+        }
+        A.row_ptr[i] = start;
+    }
+    A.row_ptr[rows] = w;
+    A.col.resize(w);
+    A.val.resize(w);
+    return A;
+}
+
+/// Read a Matrix Market coordinate file (real, integer or pattern; general,
+/// symmetric or skew-symmetric). Symmetric storage is expanded to both
+/// triangles. Throws std::runtime_error on an unreadable or unsupported file.
+template <typename T>
+CsrMatrix<T> read_matrix_market(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("read_matrix_market: cannot open " + path);
+
+    std::string line, banner, object, format, field, symmetry;
+    std::getline(in, line);
+    std::istringstream hs(line);
+    hs >> banner >> object >> format >> field >> symmetry;
+    for (std::string* s : {&object, &format, &field, &symmetry})
+        std::transform(s->begin(), s->end(), s->begin(), [](unsigned char ch) { return char(std::tolower(ch)); });
+    if (banner != "%%MatrixMarket" || object != "matrix" || format != "coordinate")
+        throw std::runtime_error("read_matrix_market: not a coordinate matrix: " + path);
+    if (field != "real" && field != "integer" && field != "pattern")
+        throw std::runtime_error("read_matrix_market: unsupported field " + field + " in " + path);
+    if (symmetry != "general" && symmetry != "symmetric" && symmetry != "skew-symmetric")
+        throw std::runtime_error("read_matrix_market: unsupported symmetry " + symmetry + " in " + path);
+
+    while (std::getline(in, line) && (line.empty() || line[0] == '%')) {}
+    std::size_t rows = 0, cols = 0, entries = 0;
+    if (!(std::istringstream(line) >> rows >> cols >> entries))
+        throw std::runtime_error("read_matrix_market: bad size line in " + path);
+
+    const bool pattern = field == "pattern";
+    const bool mirror = symmetry != "general";
+    const T sign = symmetry == "skew-symmetric" ? T(-1) : T(1);
+    std::vector<std::size_t> r, c;
+    std::vector<T> v;
+    r.reserve(mirror ? 2 * entries : entries);
+    c.reserve(r.capacity());
+    v.reserve(r.capacity());
+    for (std::size_t k = 0; k < entries; ++k) {
+        std::size_t i, j;
+        double x = 1.0;
+        if (!(in >> i >> j) || (!pattern && !(in >> x)) || i == 0 || j == 0 || i > rows || j > cols)
+            throw std::runtime_error("read_matrix_market: bad entry " + std::to_string(k) + " in " + path);
+        r.push_back(i - 1);
+        c.push_back(j - 1);
+        v.push_back(T(x));
+        if (mirror && i != j) {
+            r.push_back(j - 1);
+            c.push_back(i - 1);
+            v.push_back(sign * T(x));
+        }
+    }
+    return csr_from_coo<T>(rows, cols, r, c, v);
+}
+
+namespace detail {
+
+/// CSR row kernels of each ISA level: sparse_kernel_for<I, T>::dot / row; see hpc/isa/sparse.inl.
+template <Isa I, typename T>
+struct sparse_kernel_for;
+
+} // namespace detail
+
+}
+
+#define HPC_ISA_KERNELS "hpc/isa/sparse.inl"
+#include "hpc/isa/foreach.inl"
+
+namespace hpc {
+
+namespace detail {
+
+/// dot(val, col, lo, hi, x): one row of A·x; row(val, col, lo, hi, B, ldb, c, n):
+/// one row of A·B into c[0, n). Both of active_isa().
+template <typename T>
+struct SparseKernels {
+    T (*dot)(const T*, const std::uint32_t*, std::size_t, std::size_t, const T*);
+    void (*row)(const T*, const std::uint32_t*, std::size_t, std::size_t, const T*, std::size_t, T*, std::size_t);
+};
+
+template <typename T>
+SparseKernels<T> sparse_kernels() {
+    return isa_dispatch([](auto isa) {
+        using K = sparse_kernel_for<decltype(isa)::value, T>;
+        return SparseKernels<T>{&K::dot, &K::row};
+    });
+}
+
+/// Fewer nonzeros than this per thread do not pay for the fork/join.
+constexpr std::size_t sparse_min_nnz = std::size_t(1) << 14;
+
+/// Calls row(r, lo, hi, dst) for entries [lo, hi) of row r, writing width
+/// values to dst. Threads take equal shares of the nonzeros, not of the
+/// rows, so a few dense rows (power-law matrices) do not leave threads idle.
+/// A thread computes the rows that start in its share straight into
+/// out + r*ld; the piece of a row begun by an earlier thread goes to that
+/// thread's carry slot and is added to out after the join.
+template <typename T, typename RowFn>
+void csr_by_nnz(const CsrMatrix<T>& A, std::size_t nthreads, std::size_t min_nnz,
+                std::size_t width, T* out, std::size_t ld, RowFn row)
+{
+    const std::size_t nnz = A.nnz();
+    const std::size_t* rp = A.row_ptr.data();
+    nthreads = std::max<std::size_t>(1, std::min(nthreads, nnz / std::max<std::size_t>(min_nnz, 1)));
+
+    std::vector<T> carry(nthreads * width);
+    std::vector<std::size_t> carry_row(nthreads, A.rows); // A.rows: none
+
+    default_pool().run(nthreads, [&](const ThreadContext& ctx) {
+        const auto s = split_range(nnz, ctx.nthreads, ctx.tid);
+        const std::size_t a = s.first, b = s.second;
+        const std::size_t r0 = std::size_t(std::lower_bound(rp, rp + A.rows, a) - rp);
+        const std::size_t r1 = ctx.tid + 1 == ctx.nthreads
+            ? A.rows : std::size_t(std::lower_bound(rp, rp + A.rows, b) - rp);
+
+        const std::size_t head_end = std::min(rp[r0], b);
+        if (a < head_end) {
+            row(r0 - 1, a, head_end, carry.data() + ctx.tid * width);
+            carry_row[ctx.tid] = r0 - 1;
+        }
+        for (std::size_t r = r0; r < r1; ++r) row(r, rp[r], std::min(rp[r + 1], b), out + r * ld);
+    });
+
+    for (std::size_t t = 0; t < nthreads; ++t) {
+        if (carry_row[t] == A.rows) continue;
+        T* dst = out + carry_row[t] * ld;
+        for (std::size_t j = 0; j < width; ++j) dst[j] += carry[t * width + j];
+    }
+}
+
+} // namespace detail
+
+/// y = A·x: x has A.cols entries, y A.rows. Work is split by nonzeros
+/// (see detail::csr_by_nnz); a row shared by threads is summed in a fixed
+/// order for a given nthreads.
+template <typename T>
+void spmv(const CsrMatrix<T>& A, const T* x, T* y, std::size_t nthreads = 1) {
+    static_assert(std::is_floating_point<T>::value, "spmv: T must be float or double");
+
+    const auto k = detail::sparse_kernels<T>();
+    const T* val = A.val.data();
+    const std::uint32_t* col = A.col.data();
+    detail::csr_by_nnz(A, nthreads, detail::sparse_min_nnz, 1, y, 1,
+                       [&](std::size_t, std::size_t lo, std::size_t hi, T* dst) {
+                           *dst = k.dot(val, col, lo, hi, x);
+                       });
+}
+
+template <typename T>
+void spmv(const CsrMatrix<T>& A, const std::vector<T>& x, std::vector<T>& y, std::size_t nthreads = 1) {
+    assert(x.size() == A.cols);
+    y.resize(A.rows);
+    spmv(A, x.data(), y.data(), nthreads);
+}
+
+/// C = A·B with dense row-major B (A.cols × n, leading dimension ldb) and
+/// C (A.rows × n, leading dimension ldc).
+template <typename T>
+void spmm(const CsrMatrix<T>& A, const T* B, std::size_t ldb, std::size_t n,
+          T* C, std::size_t ldc, std::size_t nthreads = 1)
+{
+    static_assert(std::is_floating_point<T>::value, "spmm: T must be float or double");
+    assert(ldb >= n && ldc >= n);
+
+    const auto k = detail::sparse_kernels<T>();
+    const T* val = A.val.data();
+    const std::uint32_t* col = A.col.data();
+    const std::size_t min_nnz = detail::sparse_min_nnz / std::max<std::size_t>(n, 1);
+    detail::csr_by_nnz(A, nthreads, min_nnz, n, C, ldc,
+                       [&](std::size_t, std::size_t lo, std::size_t hi, T* dst) {
+                           k.row(val, col, lo, hi, B, ldb, dst, n);
+                       });
+}
+
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "hpc/thread_pool.hpp"
+
+namespace hpc {
+
+using TaskId = std::size_t;
+
+namespace detail {
+
+/// Ready tasks of one thread. The owner pushes and pops at the back (the
+/// successor it just enabled, whose inputs are still in its cache); thieves
+/// take the oldest from the front. A mutex per deque: tasks are kernel
+/// tiles of many microseconds, so the lock is noise.
+class TaskDeque {
+public:
+    void push(TaskId t) {
+        std::lock_guard<std::mutex> lk(m_);
+        q_.push_back(t);
+    }
+
+    bool pop(TaskId& t) {
+        std::lock_guard<std::mutex> lk(m_);
+        if (q_.empty()) return false;
+        t = q_.back();
+        q_.pop_back();
+        return true;
+    }
+
+    bool steal(TaskId& t) {
+        std::lock_guard<std::mutex> lk(m_);
+        if (q_.empty()) return false;
+        t = q_.front();
+        q_.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex m_;
+    std::deque<TaskId> q_;
+};
+
+} // namespace detail
+
+/// Directed acyclic graph of tasks run by a work-stealing team on
+/// default_pool(). A task starts as soon as the tasks it depends on have
+/// finished, so chained kernels overlap instead of meeting at a barrier
+/// per call. Dependencies name earlier tasks, which keeps the graph acyclic.
+/// Tasks must not throw. Kernel calls inside a task run serially (nested
+/// regions do), so give them their share of the work through the graph.
+class TaskGraph {
+public:
+    using Task = std::function<void()>;
+
+    /// Add fn, to run after every task in deps; returns its id.
+    TaskId add(Task fn, const std::vector<TaskId>& deps = {}) {
+        const TaskId id = nodes_.size();
+        nodes_.push_back({std::move(fn), {}, 0});
+        for (TaskId d : deps) {
+            assert(d < id);
+            nodes_[d].next.push_back(id);
+            ++nodes_[id].ndeps;
+        }
+        return id;
+    }
+
+    std::size_t size() const { return nodes_.size(); }
+    void clear() { nodes_.clear(); }
+
+    /// Run every task once on nthreads threads and wait for all of them.
+    /// The graph is left as built, so it can be run again.
+    void run(std::size_t nthreads = 1) {
+        const std::size_t n = nodes_.size();
+        if (n == 0) return;
+        nthreads = std::max<std::size_t>(1, std::min(nthreads, n));
+
+        std::unique_ptr<std::atomic<std::size_t>[]> wait(new std::atomic<std::size_t>[n]);
+        std::vector<detail::TaskDeque> ready(nthreads);
+        std::size_t k = 0;
+        for (TaskId t = 0; t < n; ++t) {
+            wait[t].store(nodes_[t].ndeps, std::memory_order_relaxed);
+            if (nodes_[t].ndeps == 0) ready[k++ % nthreads].push(t);
+        }
+        std::atomic<std::size_t> done{0};
+
+        // A nested run gets one thread, which then steals every deque.
+        default_pool().run(nthreads, [&](const ThreadContext& ctx) {
+            const std::size_t me = ctx.tid;
+            for (int spin = 0; done.load(std::memory_order_acquire) < n;) {
+                TaskId t;
+                bool got = ready[me].pop(t);
+                for (std::size_t s = 1; !got && s < nthreads; ++s) got = ready[(me + s) % nthreads].steal(t);
+                if (!got) {
+                    if (++spin > 64) std::this_thread::yield();
+                    continue;
+                }
+                spin = 0;
+
+                nodes_[t].fn();
+                for (TaskId s : nodes_[t].next)
+                    if (wait[s].fetch_sub(1, std::memory_order_acq_rel) == 1) ready[me].push(s);
+                done.fetch_add(1, std::memory_order_release);
+            }
+        });
+    }
+
+private:
+    struct Node {
+        Task fn;
+        std::vector<TaskId> next; // tasks waiting on this one
+        std::size_t ndeps;
+    };
+    std::vector<Node> nodes_;
+};
+
+/// Which tasks write which part of a flat buffer: part i, elements
+/// [bound[i], bound[i+1]), is complete once every task in tasks[i] has
+/// finished. An empty TaskRanges means the buffer is ready up front.
+struct TaskRanges {
+    std::vector<std::size_t> bound;
+    std::vector<std::vector<TaskId>> tasks;
+
+    /// Tasks a reader of elements [b, e) has to wait for.
+    std::vector<TaskId> covering(std::size_t b, std::size_t e) const {
+        std::vector<TaskId> deps;
+        if (tasks.empty() || b >= e) return deps;
+        std::size_t i = std::size_t(std::upper_bound(bound.begin(), bound.end(), b) - bound.begin());
+        for (i = i ? i - 1 : 0; i < tasks.size() && bound[i] < e; ++i)
+            deps.insert(deps.end(), tasks[i].begin(), tasks[i].end());
+        std::sort(deps.begin(), deps.end());
+        deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+        return deps;
+    }
+};
+
+}
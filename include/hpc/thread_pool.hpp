@@ -0,0 +1,216 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "hpc/topology.hpp"
+
+namespace hpc {
+
+/// Reusable spin barrier (sense by generation counter).
+/// Spins briefly, then yields, so oversubscribed runs still make progress.
+class Barrier {
+public:
+    explicit Barrier(std::size_t n) : n_(n) {}
+
+    void wait() {
+        if (n_ <= 1) return;
+        const std::size_t gen = gen_.load(std::memory_order_acquire);
+
+        if (count_.fetch_add(1, std::memory_order_acq_rel) + 1 == n_) {
+            count_.store(0, std::memory_order_relaxed);
+            gen_.fetch_add(1, std::memory_order_release);
+            return;
+        }
+
+        for (int spin = 0; gen_.load(std::memory_order_acquire) == gen; ++spin) {
+            if (spin > 64) std::this_thread::yield();
+        }
+    }
+
+private:
+    std::size_t n_;
+    std::atomic<std::size_t> count_{0};
+    std::atomic<std::size_t> gen_{0};
+};
+
+/// What a parallel region body sees: its id, the team size and a team barrier.
+struct ThreadContext {
+    std::size_t tid = 0;
+    std::size_t nthreads = 1;
+    Barrier* bar = nullptr;
+
+    void barrier() const { if (bar) bar->wait(); }
+};
+
+/// Persistent fork-join pool. Workers are started once and parked on a
+/// condition variable between regions, so repeated kernel calls do not pay
+/// thread creation. The calling thread always takes part as tid 0.
+class ThreadPool {
+public:
+    using Body = std::function<void(const ThreadContext&)>;
+
+    explicit ThreadPool(std::size_t nthreads = 0) { reserve(nthreads); }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            stop_ = true;
+            ++gen_;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    /// Number of threads a region can use without growing the pool (incl. caller).
+    std::size_t size() const { return workers_.size() + 1; }
+
+    /// Make sure at least nthreads (incl. caller) can run a region.
+    void reserve(std::size_t nthreads) {
+        std::lock_guard<std::mutex> lk(run_m_);
+        grow(nthreads);
+    }
+
+    /// Pin thread i of every later region to cpus[i % cpus.size()] (see
+    /// bind_cpus): the calling thread (tid 0) right away, workers when they
+    /// next wake. Call it from the thread that runs the regions. Empty stops
+    /// pinning; threads keep the placement they already have.
+    void set_affinity(std::vector<int> cpus) {
+        std::lock_guard<std::mutex> run_lk(run_m_);
+        if (!cpus.empty()) pin_this_thread(cpus[0]);
+        std::lock_guard<std::mutex> lk(m_);
+        cpus_ = std::move(cpus);
+        ++affinity_gen_;
+    }
+
+    /// Run body on nthreads threads and wait for all of them.
+    /// Nested calls (from inside a region) run serially on the calling thread.
+    void run(std::size_t nthreads, const Body& body) {
+        if (nthreads <= 1 || in_region()) {
+            ThreadContext ctx;
+            body(ctx);
+            return;
+        }
+
+        std::lock_guard<std::mutex> run_lk(run_m_);
+        grow(nthreads);
+
+        Barrier bar(nthreads);
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            body_ = &body;
+            team_ = nthreads;
+            bar_ = &bar;
+            pending_.store(nthreads - 1, std::memory_order_relaxed);
+            ++gen_;
+        }
+        cv_.notify_all();
+
+        in_region() = true;
+        body(ThreadContext{0, nthreads, &bar});
+        in_region() = false;
+
+        for (int spin = 0; pending_.load(std::memory_order_acquire) != 0; ++spin) {
+            if (spin > 64) std::this_thread::yield();
+        }
+    }
+
+private:
+    static bool& in_region() {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    void grow(std::size_t nthreads) {
+        while (workers_.size() + 1 < nthreads) {
+            const std::size_t id = workers_.size() + 1;
+            std::size_t seen;
+            {
+                std::lock_guard<std::mutex> lk(m_);
+                seen = gen_;
+            }
+            workers_.emplace_back([this, id, seen] { worker(id, seen); });
+        }
+    }
+
+    void worker(std::size_t id, std::size_t seen) {
+        in_region() = true;
+        std::size_t pinned = 0;
+        for (;;) {
+            const Body* body;
+            std::size_t team;
+            Barrier* bar;
+            int cpu = -1;
+            {
+                std::unique_lock<std::mutex> lk(m_);
+                cv_.wait(lk, [&] { return gen_ != seen; });
+                seen = gen_;
+                if (stop_) return;
+                body = body_;
+                team = team_;
+                bar = bar_;
+                if (pinned != affinity_gen_) {
+                    pinned = affinity_gen_;
+                    if (!cpus_.empty()) cpu = cpus_[id % cpus_.size()];
+                }
+            }
+            if (cpu >= 0) pin_this_thread(cpu);
+            if (id < team) {
+                (*body)(ThreadContext{id, team, bar});
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex run_m_;                  // one region at a time
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::size_t gen_ = 0;
+    bool stop_ = false;
+
+    std::vector<int> cpus_;             // set_affinity placement, by tid
+    std::size_t affinity_gen_ = 0;
+
+    const Body* body_ = nullptr;
+    std::size_t team_ = 0;
+    Barrier* bar_ = nullptr;
+    std::atomic<std::size_t> pending_{0};
+};
+
+/// Hardware threads reported by the OS (at least 1).
+inline std::size_t hardware_threads() {
+    const unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+/// Process-wide pool shared by all kernels.
+inline ThreadPool& default_pool() {
+    static ThreadPool pool(hardware_threads());
+    return pool;
+}
+
+/// Static split of [0, n) into nparts contiguous ranges, each a multiple of
+/// grain (except the last). Returns [begin, end) of part p.
+inline std::pair<std::size_t, std::size_t>
+split_range(std::size_t n, std::size_t nparts, std::size_t p, std::size_t grain = 1)
+{
+    const std::size_t units = (n + grain - 1) / grain;
+    const std::size_t base = units / nparts, rem = units % nparts;
+    const std::size_t ub = p * base + (p < rem ? p : rem);
+    const std::size_t ue = ub + base + (p < rem ? 1 : 0);
+
+    const std::size_t b = ub * grain < n ? ub * grain : n;
+    const std::size_t e = ue * grain < n ? ue * grain : n;
+    return {b, e};
+}
+
+}
@@ -0,0 +1,228 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace hpc {
+
+/// One logical CPU the process may run on.
+struct Cpu {
+    int id = 0;        // OS cpu number
+    int core = 0;      // core_id within the package (SMT siblings share it)
+    int package = 0;   // socket
+    int node = 0;      // NUMA node
+};
+
+/// Logical CPUs of this process (its affinity mask at first use), sorted by id.
+struct Topology {
+    std::vector<Cpu> cpus;
+    int nodes = 1;
+    int packages = 1;
+
+    /// Physical cores: distinct (package, core) pairs.
+    std::size_t cores() const {
+        std::vector<std::pair<int, int>> c;
+        for (const Cpu& x : cpus) c.push_back({x.package, x.core});
+        std::sort(c.begin(), c.end());
+        return static_cast<std::size_t>(std::unique(c.begin(), c.end()) - c.begin());
+    }
+};
+
+/// Parse a Linux cpulist ("0-3,8,10-11"); false on malformed input.
+inline bool parse_cpu_list(const std::string& s, std::vector<int>& out) {
+    out.clear();
+    std::size_t i = 0;
+    auto number = [&](int& v) {
+        const std::size_t b = i;
+        v = 0;
+        while (i < s.size() && s[i] >= '0' && s[i] <= '9') v = v * 10 + (s[i++] - '0');
+        return i > b;
+    };
+    while (i < s.size()) {
+        int lo = 0, hi = 0;
+        if (!number(lo)) return false;
+        hi = lo;
+        if (i < s.size() && s[i] == '-') {
+            ++i;
+            if (!number(hi) || hi < lo) return false;
+        }
+        for (int c = lo; c <= hi; ++c) out.push_back(c);
+        if (i < s.size()) {
+            if (s[i] != ',' && s[i] != '\n') return false;
+            ++i;
+        }
+    }
+    return !out.empty();
+}
+
+namespace detail {
+
+inline bool read_int_file(const std::string& path, int& v) {
+    std::ifstream f(path);
+    return static_cast<bool>(f >> v);
+}
+
+inline Topology discover_topology() {
+    Topology t;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    const bool masked = ::sched_getaffinity(0, sizeof(set), &set) == 0;
+
+    const std::string base = "/sys/devices/system/cpu/cpu";
+    for (int id = 0; id < CPU_SETSIZE; ++id) {
+        if (masked && !CPU_ISSET(id, &set)) continue;
+        Cpu c;
+        c.id = id;
+        if (!read_int_file(base + std::to_string(id) + "/topology/core_id", c.core)) {
+            if (!masked) break;
+            c.core = id;
+        }
+        read_int_file(base + std::to_string(id) + "/topology/physical_package_id", c.package);
+        t.cpus.push_back(c);
+    }
+
+    // Nodes list their CPUs; node ids may be sparse.
+    for (int node = 0, seen = 0; node < 1024 && seen < 64; ++node) {
+        std::ifstream f("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!f) { ++seen; continue; }
+        std::string line;
+        std::getline(f, line);
+        std::vector<int> ids;
+        if (!parse_cpu_list(line, ids)) continue;
+        for (Cpu& c : t.cpus) {
+            if (std::find(ids.begin(), ids.end(), c.id) != ids.end()) c.node = node;
+        }
+        seen = 0;
+    }
+#endif
+    if (t.cpus.empty()) {
+        const unsigned n = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < n; ++i) t.cpus.push_back(Cpu{int(i), int(i), 0, 0});
+    }
+    for (const Cpu& c : t.cpus) {
+        t.nodes = std::max(t.nodes, c.node + 1);
+        t.packages = std::max(t.packages, c.package + 1);
+    }
+    return t;
+}
+
+} // namespace detail
+
+/// Topology of this host, discovered once (sysfs on Linux).
+inline const Topology& topology() {
+    static const Topology t = detail::discover_topology();
+    return t;
+}
+
+/// Where pool thread i runs: bind_cpus(...)[i % size].
+/// - none: not pinned (the OS scheduler decides).
+/// - compact: fill one node before the next, SMT siblings next to each other.
+/// - scatter: round-robin over nodes; within a node every core gets a thread
+///   before any core gets a second one.
+/// - list: the given cpu ids, in order.
+enum class BindPolicy { none, compact, scatter, list };
+
+/// CPU order for policy p on topology t (empty for none). list keeps `cpus`
+/// minus ids t does not contain.
+inline std::vector<int> bind_cpus(const Topology& t, BindPolicy p, const std::vector<int>& cpus = {}) {
+    std::vector<int> out;
+    if (p == BindPolicy::none) return out;
+    if (p == BindPolicy::list) {
+        for (int id : cpus) {
+            for (const Cpu& c : t.cpus) {
+                if (c.id == id) { out.push_back(id); break; }
+            }
+        }
+        return out;
+    }
+
+    // SMT rank: how many siblings of the same core come before this cpu.
+    std::vector<Cpu> v = t.cpus;
+    std::vector<int> smt(v.size(), 0);
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        for (std::size_t j = 0; j < i; ++j) {
+            if (v[j].package == v[i].package && v[j].core == v[i].core) ++smt[i];
+        }
+    }
+    std::vector<std::size_t> idx(v.size());
+    for (std::size_t i = 0; i < idx.size(); ++i) idx[i] = i;
+
+    if (p == BindPolicy::compact) {
+        std::sort(idx.begin(), idx.end(), [&](std::size_t a, std::size_t b) {
+            return std::make_tuple(v[a].node, v[a].package, v[a].core, smt[a], v[a].id)
+                 < std::make_tuple(v[b].node, v[b].package, v[b].core, smt[b], v[b].id);
+        });
+    } else {
+        // Rank within the node (cores first, then siblings), then interleave nodes.
+        std::sort(idx.begin(), idx.end(), [&](std::size_t a, std::size_t b) {
+            return std::make_tuple(v[a].node, smt[a], v[a].package, v[a].core, v[a].id)
+                 < std::make_tuple(v[b].node, smt[b], v[b].package, v[b].core, v[b].id);
+        });
+        std::vector<int> rank(v.size(), 0);
+        for (std::size_t k = 1; k < idx.size(); ++k) {
+            rank[idx[k]] = v[idx[k]].node == v[idx[k - 1]].node ? rank[idx[k - 1]] + 1 : 0;
+        }
+        std::stable_sort(idx.begin(), idx.end(), [&](std::size_t a, std::size_t b) {
+            return std::make_pair(rank[a], v[a].node) < std::make_pair(rank[b], v[b].node);
+        });
+    }
+    for (std::size_t i : idx) out.push_back(v[i].id);
+    return out;
+}
+
+/// Parse a --bind= value: none | compact | scatter | node:N (node N, compact)
+/// | cpu list ("0-3,8"). Returns false on anything else.
+inline bool parse_bind(const std::string& s, const Topology& t, std::vector<int>& cpus) {
+    cpus.clear();
+    if (s == "none" || s.empty()) return true;
+    if (s == "compact") { cpus = bind_cpus(t, BindPolicy::compact); return true; }
+    if (s == "scatter") { cpus = bind_cpus(t, BindPolicy::scatter); return true; }
+    if (s.compare(0, 5, "node:") == 0) {
+        std::vector<int> ids;
+        if (!parse_cpu_list(s.substr(5), ids) || ids.size() != 1) return false;
+        for (int id : bind_cpus(t, BindPolicy::compact)) {
+            for (const Cpu& c : t.cpus) {
+                if (c.id == id && c.node == ids[0]) cpus.push_back(id);
+            }
+        }
+        return !cpus.empty();
+    }
+    std::vector<int> ids;
+    if (!parse_cpu_list(s, ids)) return false;
+    cpus = bind_cpus(t, BindPolicy::list, ids);
+    return cpus.size() == ids.size();
+}
+
+/// Pin the calling thread to one cpu; false when the OS refuses (or off Linux).
+inline bool pin_this_thread(int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+/// Cpu the calling thread is running on, -1 if unknown.
+inline int current_cpu() {
+#if defined(__linux__)
+    return ::sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+}
@@ -0,0 +1,204 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+
+#include "hpc/dispatch.hpp"
+
+namespace hpc {
+
+/// GEMM shape buckets the tuning file is keyed by.
+/// small: max dim <= 128; skinny: the smallest dim is at least 8× below the
+/// largest; medium: max dim <= 768; large: everything else.
+enum class ShapeClass { small, skinny, medium, large };
+
+constexpr std::size_t shape_class_count = 4;
+
+inline const char* shape_class_name(ShapeClass c) {
+    switch (c) {
+        case ShapeClass::small:  return "small";
+        case ShapeClass::skinny: return "skinny";
+        case ShapeClass::medium: return "medium";
+        default:                 return "large";
+    }
+}
+
+inline ShapeClass shape_class(std::size_t M, std::size_t N, std::size_t K) {
+    const std::size_t mx = std::max({M, N, K});
+    const std::size_t mn = std::min({M, N, K});
+    if (mx <= 128) return ShapeClass::small;
+    if (mn * 8 <= mx) return ShapeClass::skinny;
+    if (mx <= 768) return ShapeClass::medium;
+    return ShapeClass::large;
+}
+
+/// Tuned GEMM parameters; 0 = not tuned (use the built-in default).
+/// MC/KC/NC drive the packed engine, block the BS of matmul_blocked.
+struct TuneParams {
+    std::size_t MC = 0;
+    std::size_t KC = 0;
+    std::size_t NC = 0;
+    std::size_t block = 0;
+};
+
+/// One line of the tuning file: the key and its winning parameters.
+struct TuneRecord {
+    std::string cpu;
+    std::string isa;
+    std::string dtype;
+    std::string shape;
+    TuneParams p;
+};
+
+constexpr const char* tune_file_header = "cpu,isa,dtype,shape,MC,KC,NC,block";
+
+/// CPU model used as the tuning key: "model name" from /proc/cpuinfo
+/// (AArch64: implementer/part), else "unknown". Commas become spaces.
+inline std::string cpu_model() {
+    std::string model, implementer, part;
+    std::ifstream f("/proc/cpuinfo");
+    for (std::string line; std::getline(f, line);) {
+        const auto colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string key = line.substr(0, colon);
+        key.erase(key.find_last_not_of(" \t") + 1);
+        std::string val = line.substr(std::min(colon + 2, line.size()));
+        if (key == "model name" && model.empty()) model = val;
+        else if (key == "CPU implementer" && implementer.empty()) implementer = val;
+        else if (key == "CPU part" && part.empty()) part = val;
+    }
+    if (model.empty() && !part.empty()) model = "arm " + implementer + ":" + part;
+    if (model.empty()) model = "unknown";
+    std::replace(model.begin(), model.end(), ',', ' ');
+    return model;
+}
+
+/// $HPC_TUNE_FILE, else $XDG_CACHE_HOME (or ~/.cache) /hpc_kernels/tuning.csv.
+inline std::string default_tune_path() {
+    if (const char* p = std::getenv("HPC_TUNE_FILE")) return p;
+    std::string base;
+    if (const char* x = std::getenv("XDG_CACHE_HOME")) base = x;
+    else if (const char* h = std::getenv("HOME")) base = std::string(h) + "/.cache";
+    else base = ".";
+    return base + "/hpc_kernels/tuning.csv";
+}
+
+/// All records in path, any CPU. A missing file yields none; malformed lines are skipped.
+inline std::vector<TuneRecord> read_tune_file(const std::string& path) {
+    std::vector<TuneRecord> recs;
+    std::ifstream f(path);
+    std::string line;
+    if (!std::getline(f, line)) return recs; // header
+
+    while (std::getline(f, line)) {
+        std::istringstream ss(line);
+        TuneRecord r;
+        std::string mc, kc, nc, bs;
+        if (!std::getline(ss, r.cpu, ',') || !std::getline(ss, r.isa, ',')
+            || !std::getline(ss, r.dtype, ',') || !std::getline(ss, r.shape, ',')
+            || !std::getline(ss, mc, ',') || !std::getline(ss, kc, ',')
+            || !std::getline(ss, nc, ',') || !std::getline(ss, bs)) continue;
+        try {
+            r.p = {std::stoull(mc), std::stoull(kc), std::stoull(nc), std::stoull(bs)};
+        } catch (const std::exception&) {
+            continue;
+        }
+        recs.push_back(r);
+    }
+    return recs;
+}
+
+/// Add r, replacing any record with the same cpu/isa/dtype/shape.
+inline void tune_upsert(std::vector<TuneRecord>& recs, const TuneRecord& r) {
+    for (auto& x : recs) {
+        if (x.cpu == r.cpu && x.isa == r.isa && x.dtype == r.dtype && x.shape == r.shape) {
+            x = r;
+            return;
+        }
+    }
+    recs.push_back(r);
+}
+
+inline void write_tune_file(const std::string& path, const std::vector<TuneRecord>& recs) {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::path(path).parent_path();
+    std::error_code ec;
+    if (!dir.empty()) fs::create_directories(dir, ec);
+
+    std::ofstream f(path, std::ios::trunc);
+    if (!f) {
+        throw std::runtime_error("write_tune_file: cannot open file " + path);
+    }
+    f << tune_file_header << "\n";
+    for (const auto& r : recs) {
+        f << r.cpu << "," << r.isa << "," << r.dtype << "," << r.shape << ","
+          << r.p.MC << "," << r.p.KC << "," << r.p.NC << "," << r.p.block << "\n";
+    }
+}
+
+/// Tuned parameters for the running CPU, indexed by ISA × dtype × shape class.
+/// The library consults tuning() whenever a caller leaves a parameter at 0.
+class TuningTable {
+public:
+    /// Replace the table with the records of path that match cpu_model().
+    void load(const std::string& path) {
+        p_.fill(TuneParams{});
+        const std::string cpu = cpu_model();
+        for (const auto& r : read_tune_file(path)) {
+            Isa isa = Isa::scalar;
+            const int d = dtype_index(r.dtype);
+            const int c = class_index(r.shape);
+            if (r.cpu != cpu || !parse_isa(r.isa.c_str(), isa) || d < 0 || c < 0) continue;
+            p_[index(isa, d, static_cast<std::size_t>(c))] = r.p;
+        }
+    }
+
+    const TuneParams& get(Isa isa, bool is_double, ShapeClass c) const {
+        return p_[index(isa, is_double ? 1 : 0, static_cast<std::size_t>(c))];
+    }
+
+private:
+    static int dtype_index(const std::string& s) {
+        return s == "float" ? 0 : s == "double" ? 1 : -1;
+    }
+
+    static int class_index(const std::string& s) {
+        for (std::size_t c = 0; c < shape_class_count; ++c) {
+            if (s == shape_class_name(static_cast<ShapeClass>(c))) return static_cast<int>(c);
+        }
+        return -1;
+    }
+
+    static std::size_t index(Isa isa, int d, std::size_t c) {
+        return (static_cast<std::size_t>(isa) * 2 + static_cast<std::size_t>(d)) * shape_class_count + c;
+    }
+
+    std::array<TuneParams, 4 * 2 * shape_class_count> p_{};
+};
+
+/// Process-wide table, loaded from default_tune_path() on first use.
+/// HPC_TUNE_FILE= (set but empty) disables tuning.
+inline TuningTable& tuning() {
+    static TuningTable t = [] {
+        TuningTable x;
+        const std::string path = default_tune_path();
+        if (!path.empty()) x.load(path);
+        return x;
+    }();
+    return t;
+}
+
+/// Tuned parameters for a T GEMM of this shape on active_isa().
+template <typename T>
+const TuneParams& tuned_params(std::size_t M, std::size_t N, std::size_t K) {
+    return tuning().get(active_isa(), sizeof(T) == sizeof(double), shape_class(M, N, K));
+}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+
+namespace hpc {
+
+/// Storage order of a matrix view.
+enum class Layout { row_major, col_major };
+
+/// BLAS-style operand transform.
+enum class Trans { none, transpose };
+
+/// Non-owning view of a rows×cols matrix in caller memory.
+/// ld is the leading dimension: distance between consecutive rows (row-major)
+/// or columns (col-major). ld == 0 means tightly packed.
+template <typename T>
+struct MatrixView {
+    T* data = nullptr;
+    std::size_t rows = 0;
+    std::size_t cols = 0;
+    std::size_t ld = 0;
+    Layout layout = Layout::row_major;
+
+    MatrixView() = default;
+    MatrixView(T* p, std::size_t r, std::size_t c, std::size_t ld_ = 0,
+               Layout l = Layout::row_major)
+        : data(p), rows(r), cols(c), ld(ld_), layout(l)
+    {
+        if (ld == 0) ld = (layout == Layout::row_major) ? cols : rows;
+    }
+
+    /// MatrixView<T> converts to MatrixView<const T>.
+    template <typename U, typename = std::enable_if_t<std::is_same<const U, T>::value>>
+    MatrixView(const MatrixView<U>& o)
+        : data(o.data), rows(o.rows), cols(o.cols), ld(o.ld), layout(o.layout) {}
+
+    /// Element strides: (i,j) lives at data[i*rs() + j*cs()].
+    std::size_t rs() const { return layout == Layout::row_major ? ld : 1; }
+    std::size_t cs() const { return layout == Layout::row_major ? 1 : ld; }
+
+    T& operator()(std::size_t i, std::size_t j) const { return data[i * rs() + j * cs()]; }
+};
+
+template <typename T>
+MatrixView<T> row_major_view(T* p, std::size_t rows, std::size_t cols, std::size_t ld = 0) {
+    return MatrixView<T>(p, rows, cols, ld, Layout::row_major);
+}
+
+template <typename T>
+MatrixView<T> col_major_view(T* p, std::size_t rows, std::size_t cols, std::size_t ld = 0) {
+    return MatrixView<T>(p, rows, cols, ld, Layout::col_major);
+}
+
+namespace detail {
+
+/// Blocks template argument deduction (std::type_identity before C++20).
+template <typename T> struct nodeduce { using type = T; };
+template <typename T> using nodeduce_t = typename nodeduce<T>::type;
+
+/// Shape and strides of op(X) for a view X.
+struct OperandLayout {
+    std::size_t rows, cols, rs, cs;
+};
+
+template <typename T>
+OperandLayout operand_layout(const MatrixView<T>& v, Trans t) {
+    if (t == Trans::none) return {v.rows, v.cols, v.rs(), v.cs()};
+    return {v.cols, v.rows, v.cs(), v.rs()};
+}
+
+} // namespace detail
+
+}
@@ -1,4 +1,5 @@
 import argparse
+import struct
 from pathlib import Path
 import pandas as pd
 import numpy as np
@@ -15,11 +16,62 @@ def ci95(x):
 
     return (med - lo, hi - med)
 
+def read_hpcr(path):
+    """Read a binary results file (ResultSink binary format, hpc/results.hpp)."""
+    data = Path(path).read_bytes()
+    if not data.startswith(b"HPCRES1\n"):
+        raise SystemExit(f"[error] {path} is not an HPCRES1 file")
+
+    pos, cols, rows = 8, [], []
+    while pos < len(data):
+        tag = data[pos:pos + 1]
+        pos += 1
+        if tag == b"S":
+            (n,) = struct.unpack_from("=I", data, pos)
+            pos += 4
+            cols = []
+            for _ in range(n):
+                t, ln = struct.unpack_from("=BI", data, pos)
+                pos += 5
+                cols.append((data[pos:pos + ln].decode(), t))
+                pos += ln
+        elif tag == b"R":
+            row = {}
+            for name, t in cols:
+                present = data[pos]
+                pos += 1
+                if not present:
+                    row[name] = None
+                elif t == 0:
+                    (row[name],) = struct.unpack_from("=q", data, pos)
+                    pos += 8
+                elif t == 1:
+                    (row[name],) = struct.unpack_from("=d", data, pos)
+                    pos += 8
+                else:
+                    (ln,) = struct.unpack_from("=I", data, pos)
+                    pos += 4
+                    row[name] = data[pos:pos + ln].decode()
+                    pos += ln
+            rows.append(row)
+        else:
+            raise SystemExit(f"[error] {path}: bad record at byte {pos - 1}")
+
+    return pd.DataFrame(rows)
+
+def read_results(path):
+    ext = Path(path).suffix
+    if ext in (".jsonl", ".ndjson"):
+        return pd.read_json(path, lines=True)
+    if ext in (".hpcr", ".bin"):
+        return read_hpcr(path)
+    return pd.read_csv(path)
+
 def load_csvs(paths):
     frames = []
 
     for p in paths:
-        df = pd.read_csv(p)
+        df = read_results(p)
 
         need = ["timestamp","op","M","N","K","size","dtype","reps","ns_per_rep","gflops","gbps","checksum"]
 
@@ -27,6 +79,13 @@ def load_csvs(paths):
         if missing:
             raise SystemExit(f"[error] {p} missing columns: {missing}")
         
+        if "threads" not in df.columns:
+            df["threads"] = 1
+
+        # --perf columns (empty when the host exposes no counters)
+        if "ai" not in df.columns:
+            df["ai"] = np.nan
+
         frames.append(df)
 
     return pd.concat(frames, ignore_index=True)
@@ -38,7 +97,7 @@ def summarize(df):
     df.loc[fallback, "size"] = (df.loc[fallback, "M"] * df.loc[fallback, "N"] * df.loc[fallback, "K"]).astype("int64")
 
     rows = []
-    for (op, size, dtype), g in df.groupby(["op","size","dtype"]):
+    for (op, size, dtype, threads), g in df.groupby(["op","size","dtype","threads"]):
         gflops_med = np.median(g["gflops"])
         gflops_lo, gflops_hi = ci95(g["gflops"])
 
@@ -48,10 +107,13 @@ def summarize(df):
         t_med = np.median(g["ns_per_rep"]) * 1e-9
         t_lo, t_hi = ci95(g["ns_per_rep"] * 1e-9)
 
-        rows.append(dict(op=op,size=int(size),dtype=dtype, gflops=gflops_med, gflops_lo=gflops_lo, gflops_hi=gflops_hi,
-                         gbps=gbps_med, gbps_lo=gbps_lo, gbps_hi=gbps_hi, t=t_med, t_lo=t_lo, t_hi=t_hi))
+        ai = pd.to_numeric(g["ai"], errors="coerce").dropna()
+        ai_med = float(np.median(ai)) if len(ai) else np.nan
+
+        rows.append(dict(op=op,size=int(size),dtype=dtype,threads=int(threads), gflops=gflops_med, gflops_lo=gflops_lo, gflops_hi=gflops_hi,
+                         gbps=gbps_med, gbps_lo=gbps_lo, gbps_hi=gbps_hi, t=t_med, t_lo=t_lo, t_hi=t_hi, ai=ai_med))
         
-    out = pd.DataFrame(rows).sort_values(["op","dtype","size"])
+    out = pd.DataFrame(rows).sort_values(["op","dtype","threads","size"])
     return out
 
 
@@ -80,7 +142,9 @@ def plot_metric(df, metric, ylabel, outpath_prefix):
     for op, g in df.groupby("op"):
         fig, ax = plt.subplots(figsize=(7,4.5))
         
-        for dtype, gg in g.groupby("dtype"):
+        multi = g["threads"].nunique() > 1
+
+        for (dtype, threads), gg in g.groupby(["dtype","threads"]):
             gg = gg.sort_values("size")
             y = gg[metric].to_numpy()
 
@@ -88,7 +152,8 @@ def plot_metric(df, metric, ylabel, outpath_prefix):
             hi = gg.get(f"{metric}_hi", pd.Series(np.zeros(len(gg)))).to_numpy()
 
             yerr = np.vstack((lo, hi))
-            ax.errorbar(gg["size"], y, yerr=yerr, fmt="o-", ms=4, lw=1.4, capsize=3, label=f"{dtype}")
+            label = f"{dtype}, {threads} thr" if multi else f"{dtype}"
+            ax.errorbar(gg["size"], y, yerr=yerr, fmt="o-", ms=4, lw=1.4, capsize=3, label=label)
 
         style(ax, f"{op} — {ylabel}", "Problem size (elements or M·N·K)", ylabel)
         fig.tight_layout()
@@ -99,7 +164,7 @@ def plot_metric(df, metric, ylabel, outpath_prefix):
         plt.close(fig)
 
 def plot_speedup(df, baseline_op, outdir):
-    base = df[df["op"]==baseline_op][["size","dtype","t"]].rename(columns={"t":"t_base"})
+    base = df[(df["op"]==baseline_op) & (df["threads"]==1)][["size","dtype","t"]].rename(columns={"t":"t_base"})
     outdir = Path(outdir); outdir.mkdir(parents=True, exist_ok=True)
 
     fig, ax = plt.subplots(figsize=(7,4.5))
@@ -121,13 +186,14 @@ def plot_speedup(df, baseline_op, outdir):
         if op == baseline_op:
             continue
 
-        for dtype, gg in g.groupby("dtype"):
+        for (dtype, threads), gg in g.groupby(["dtype","threads"]):
             merged = pd.merge(gg[["size","dtype","t"]], base[base["dtype"]==dtype], on=["size","dtype"], how="inner")
             if merged.empty:
                 continue
 
             spd = merged["t_base"] / merged["t"]
-            ax.plot(merged["size"], spd, "o-", ms=4, lw=1.4, label=f"{op} ({dtype})")
+            label = f"{op} ({dtype})" if threads == 1 else f"{op} ({dtype}, {threads} thr)"
+            ax.plot(merged["size"], spd, "o-", ms=4, lw=1.4, label=label)
             plotted_any = True
 
     style(ax, f"Speedup vs {baseline_op}", "Problem size", "Speedup (×)")
@@ -137,17 +203,52 @@ def plot_speedup(df, baseline_op, outdir):
     plt.close(fig)
 
 
+def plot_scaling(df, outdir):
+    """Strong scaling: speedup over the 1-thread run of the same op/size/dtype."""
+    outdir = Path(outdir); outdir.mkdir(parents=True, exist_ok=True)
+
+    for op, g in df.groupby("op"):
+        if g["threads"].nunique() < 2:
+            continue
+
+        fig, ax = plt.subplots(figsize=(7,4.5))
+        tmax = int(g["threads"].max())
+        ax.plot([1, tmax], [1, tmax], "--", lw=1.2, color="gray", label="ideal")
+
+        for (dtype, size), gg in g.groupby(["dtype","size"]):
+            t1 = gg[gg["threads"]==1]["t"]
+            if t1.empty:
+                continue
+
+            gg = gg.sort_values("threads")
+            ax.plot(gg["threads"], float(t1.iloc[0]) / gg["t"], "o-", ms=4, lw=1.4, label=f"{dtype}, size={size}")
+
+        style(ax, f"{op} — strong scaling", "Threads", "Speedup vs 1 thread (×)", logx=False)
+        fig.tight_layout()
+
+        plt.savefig(outdir / f"scaling_{op}.png", dpi=150)
+        plt.close(fig)
+
 def plot_roofline(df, outdir, peak_flops, peak_bw):
     fig, ax = plt.subplots(figsize=(7,4.5))
     intensities = np.logspace(-3, 3, 512)
     roof = np.minimum(peak_flops, peak_bw * intensities)
     ax.plot(intensities, roof, "-", lw=2, label=f"Roofline ({peak_flops:.1f} GF/s, {peak_bw:.1f} GB/s)")
 
+    # Measured intensity (--perf: FP ops / LLC-miss bytes) where available,
+    # otherwise the model gflops/gbps from the benchmark's byte formula.
     for op, g in df.groupby("op"):
         for dtype, gg in g.groupby("dtype"):
-            inten = (gg["gflops"]/gg["gbps"]).replace([np.inf, -np.inf], np.nan).dropna()
-            perf = gg.loc[inten.index, "gflops"]
-            ax.scatter(inten, perf, s=24, label=f"{op} ({dtype})")
+            model = (gg["gflops"]/gg["gbps"]).replace([np.inf, -np.inf], np.nan)
+            measured = gg["ai"].replace([np.inf, -np.inf], np.nan) if "ai" in gg else pd.Series(np.nan, index=gg.index)
+
+            m = measured.dropna()
+            if len(m):
+                ax.scatter(m, gg.loc[m.index, "gflops"], s=24, marker="o", label=f"{op} ({dtype}, measured)")
+
+            rest = model[measured.isna()].dropna()
+            if len(rest):
+                ax.scatter(rest, gg.loc[rest.index, "gflops"], s=24, marker="x", label=f"{op} ({dtype})")
 
     ax.set_xscale("log"); ax.set_yscale("log")
     ax.set_xlabel("Arithmetic intensity (F/B)")
@@ -166,7 +267,7 @@ def plot_roofline(df, outdir, peak_flops, peak_bw):
 def main():
     # TODO: maybe add PDF export for reports later
     ap = argparse.ArgumentParser()
-    ap.add_argument("csvs", nargs="+", help="benchmark CSV files")
+    ap.add_argument("csvs", nargs="+", help="benchmark results (.csv, .jsonl or .hpcr)")
     ap.add_argument("--outdir", default="plots", help="output directory for figures")
     ap.add_argument("--baseline", default="", help="baseline op for speedup (e.g., 'matmul_naive')")
     ap.add_argument("--roofline", default="", help="GFLOPS:GBPS, e.g., 220:60")
@@ -182,6 +283,8 @@ def main():
     if args.baseline:
         plot_speedup(summary, args.baseline, outdir)
 
+    plot_scaling(summary, outdir)
+
     if args.roofline:
         try:
             g, b = args.roofline.split(":")
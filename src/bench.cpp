@@ -6,229 +6,1762 @@
 #include <numeric>
 #include <cmath>
 #include <ctime>
+#include <filesystem>
+#include <array>
+#include <memory>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <tuple>
+#include <random>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 #include "hpc/matmul.hpp"
+#include "hpc/matmul_packed.hpp"
+#include "hpc/matmul_fixed.hpp"
+#include "hpc/matmul_batched.hpp"
+#include "hpc/matmul_strassen.hpp"
+#include "hpc/out_of_core.hpp"
+#include "hpc/matmul_mixed.hpp"
+#include "hpc/matmul_int8.hpp"
+#include "hpc/thread_pool.hpp"
+#include "hpc/dispatch.hpp"
+#include "hpc/tune.hpp"
 #include "hpc/reduction.hpp"
 #include "hpc/scan.hpp"
+#include "hpc/scan_segmented.hpp"
+#include "hpc/sparse.hpp"
+#include "hpc/pipeline.hpp"
 #include "hpc/timer.hpp"
-#include "hpc/csv.hpp"
+#include "hpc/perf.hpp"
+#include "hpc/harness.hpp"
+#include "hpc/results.hpp"
 #include "hpc/rand.hpp"
 
+#if defined(HPC_WITH_MPI)
+#include <mpi.h>
+#include "hpc/mpi.hpp"
+#endif
 
 struct Args {
-    std::string op = "matmul";           // operation: matmul, reduction, scan
+    std::string op = "matmul";           // operation: matmul, matmul_batched, reduction, scan, spmv, pipeline, mpi
     size_t M = 1024, N = 1024, K = 1024; // matrix dimensions
+    size_t batch = 64;                   // matrices per call (matmul_batched)
     size_t size = 1 << 24;               // vector size (for reduction/scan)
-    int reps = 7;                        // repetitions (median taken)
-    std::string dtype = "float";         // float or double
+    int reps = 7;                        // minimum timed repetitions (median taken)
+    size_t max_reps = 1000;              // upper bound when --min-time needs more reps
+    double min_time = 0.1;               // seconds of timed reps, at least
+    size_t warmup = 10;                  // warm-up reps, at most (stops once stable)
+    bool flush = false;                  // evict caches before every rep (cold runs)
+    std::string raw_out;                 // per-rep timings sidecar (empty: none)
+    std::string dtype = "float";         // float, double; bf16, fp16, int8 (matmul only)
     unsigned seed = 42u;                 // RNG seed
-    std::string out = "results.csv";     // output CSV
-    bool blocked = false;                // use blocked matmul
+    std::string out = "results.csv";     // results file
+    std::string format;                  // csv|jsonl|binary (default: from the --out extension)
+    bool blocked = false;                // use blocked matmul (same as --variant=blocked)
+    std::string variant;                 // kernel variant (per-op default, see parse)
+    size_t threads = 1;                  // worker threads (incl. the main thread)
+    bool hugepages = false;              // 2 MiB-aligned, MADV_HUGEPAGE input buffers
+    std::string bind = "none";           // thread pinning: none|compact|scatter|node:N|cpu list
+    std::string numa = "local";          // page placement: local|interleave|<node>
+    hpc::NumaPolicy numa_policy = hpc::NumaPolicy::local;
+    int numa_node = 0;
+    std::string isa;                     // force a dispatch level (default: best for this CPU)
+    bool autotune = false;               // search GEMM blocking and write the tuning file
+    std::string tune_file;               // tuning file (default: hpc::default_tune_path())
+    bool perf = false;                   // hardware counters around the timed reps
+    std::string epilogue;                // GEMM epilogue stages: bias,relu|gelu,residual (empty: none)
+    size_t crossover = 0;                // strassen: recursion cutoff (0: library default)
+    std::string input;                   // stream: operand file (matmul: A then B; scan: x)
+    size_t panel_mb = 64;                // stream: I/O buffer size in MiB
+    std::string segments = "geometric";  // segmented scans: length distribution fixed|uniform|geometric|powerlaw
+    size_t seg_len = 64;                 // segmented scans: mean segment length; rows: row length
+    std::string matrix;                  // spmv: Matrix Market file (empty: generated power-law matrix)
+    size_t row_nnz = 16;                 // spmv: mean nonzeros per generated row
+    size_t rhs = 8;                      // spmm: dense right-hand side columns
+    int layers = 1;                      // mpi summa: 2.5D layers of the process grid
+    bool weak = false;                   // mpi: sizes per rank (weak scaling) instead of global
+};
+
+/// Results table; column order is the CSV layout scripts/plot_bench.py reads.
+static const hpc::Schema& results_schema() {
+    using T = hpc::ColumnType;
+    static const hpc::Schema s{
+        {"timestamp", T::integer}, {"op", T::text},
+        {"M", T::integer}, {"N", T::integer}, {"K", T::integer}, {"size", T::integer},
+        {"dtype", T::text}, {"reps", T::integer}, {"ns_per_rep", T::real, "%.0f"},
+        {"gflops", T::real, "%.6f"}, {"gbps", T::real, "%.6f"}, {"checksum", T::real},
+        {"threads", T::integer}, {"isa", T::text},
+        {"ns_min", T::real, "%.1f"}, {"ns_p95", T::real, "%.1f"}, {"ns_ci_lo", T::real, "%.1f"},
+        {"ns_ci_hi", T::real, "%.1f"}, {"ns_stddev", T::real, "%.1f"},
+        {"warmup", T::integer}, {"stable", T::integer},
+        {"cycles", T::real, "%.0f"}, {"instructions", T::real, "%.0f"},
+        {"l1d_misses", T::real, "%.0f"}, {"llc_misses", T::real, "%.0f"},
+        {"dram_bytes", T::real, "%.0f"}, {"fp_ops", T::real, "%.0f"}, {"ai", T::real, "%.6g"},
+        {"run_id", T::text},
+        {"tops", T::real, "%.6f"},          // integer ops (int8 GEMM), 10^12/s
+        {"io_gbps", T::real, "%.6f"},       // --input: file bytes / I/O-thread busy time
+        {"overlap", T::real, "%.4f"},       // --input: share of I/O time hidden by compute
+        {"rel_error", T::real, "%.3e"},     // reduction: |sum - exact| / |exact| (exact_sum)
+        {"rank", T::integer},               // mpi: the rank this row describes
+        {"ranks", T::integer},              // mpi: ranks in the run
+        {"compute_ns", T::real, "%.0f"},    // mpi: this rank's local kernel time per rep
+        {"comm_ns", T::real, "%.0f"},       // mpi: this rank's communication time per rep
+    };
+    return s;
+}
+
+/// --raw-out: one row per warm-up and timed rep.
+static const hpc::Schema& raw_schema() {
+    using T = hpc::ColumnType;
+    static const hpc::Schema s{
+        {"timestamp", T::integer}, {"op", T::text},
+        {"M", T::integer}, {"N", T::integer}, {"K", T::integer}, {"size", T::integer},
+        {"dtype", T::text}, {"threads", T::integer}, {"isa", T::text},
+        {"phase", T::text}, {"rep", T::integer}, {"calls", T::integer}, {"ns", T::real, "%.1f"},
+        {"run_id", T::text},
+    };
+    return s;
+}
+
+/// Sweepable flags: comma lists of values and ranges. Every combination over
+/// the dimensions an op uses (M/N/K and batch for GEMMs, size for vectors)
+/// is one benchmark point, all run in this process.
+struct Sweep {
+    std::vector<std::string> ops, variants, dtypes, isas, segments;
+    std::vector<size_t> M, N, K, MNK, size, batch, threads, crossover, seg_len;
 };
 
 static bool starts_with(const char* s, const char* k) {
     return std::strncmp(s, k, std::strlen(k)) == 0;
 }
 
-Args parse(int argc, char** argv) {
+static std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> out;
+    size_t b = 0;
+    for (size_t e; (e = s.find(sep, b)) != std::string::npos; b = e + 1) out.push_back(s.substr(b, e - b));
+    out.push_back(s.substr(b));
+    return out;
+}
+
+/// 4096, 64k, 16M, 1G (binary multiples).
+static size_t parse_count(const std::string& s) {
+    size_t pos = 0;
+    const size_t v = std::stoull(s, &pos);
+    const std::string suf = s.substr(pos);
+    if (suf.empty()) return v;
+    if (suf == "k" || suf == "K") return v << 10;
+    if (suf == "m" || suf == "M") return v << 20;
+    if (suf == "g" || suf == "G") return v << 30;
+    throw std::invalid_argument(s);
+}
+
+/// Comma list of values and ranges lo:hi:xF (geometric) or lo:hi:+S
+/// (arithmetic); the step defaults to x2 and lo..hi is lo:hi, e.g.
+/// 256:4096:x2,6000 or 1k..1G.
+static std::vector<size_t> parse_counts(const std::string& spec) {
+    std::vector<size_t> out;
+    for (std::string item : split(spec, ',')) {
+        const size_t dots = item.find("..");
+        if (dots != std::string::npos) item.replace(dots, 2, ":");
+        std::vector<std::string> r = split(item, ':');
+
+        if (r.size() == 1) { out.push_back(parse_count(r[0])); continue; }
+        if (r.size() == 2) r.push_back("x2");
+        if (r.size() != 3 || r[2].size() < 2) throw std::invalid_argument(item);
+
+        const size_t lo = parse_count(r[0]), hi = parse_count(r[1]);
+        const size_t step = parse_count(r[2].substr(1));
+        if (r[2][0] == 'x' && step >= 2 && lo > 0) {
+            for (size_t v = lo; v <= hi; v *= step) out.push_back(v);
+        } else if (r[2][0] == '+' && step >= 1) {
+            for (size_t v = lo; v <= hi; v += step) out.push_back(v);
+        } else {
+            throw std::invalid_argument(item);
+        }
+    }
+    return out;
+}
+
+/// Epilogue stages are applied in the order bias, activation, residual.
+static bool valid_epilogue(const std::string& spec) {
+    static const std::vector<std::vector<std::string>> order{{"bias"}, {"relu", "gelu"}, {"residual"}};
+    size_t next = 0;
+    for (const std::string& stage : split(spec, ',')) {
+        while (next < order.size()
+               && std::find(order[next].begin(), order[next].end(), stage) == order[next].end()) ++next;
+        if (next == order.size()) return false;
+        ++next;
+    }
+    return true;
+}
+
+Args parse(int argc, char** argv, Sweep& sw) {
     Args a;
     for (int i = 1; i < argc; ++i) {
-        if (starts_with(argv[i], "--op=")) a.op = std::string(argv[i] + 5);
-        else if (starts_with(argv[i], "--M=")) a.M = std::stoull(argv[i] + 4);
-        else if (starts_with(argv[i], "--N=")) a.N = std::stoull(argv[i] + 4);
-        else if (starts_with(argv[i], "--K=")) a.K = std::stoull(argv[i] + 4);
-        else if (starts_with(argv[i], "--size=")) a.size = std::stoull(argv[i] + 7);
-        else if (starts_with(argv[i], "--reps=")) a.reps = std::stoi(argv[i] + 7);
-        else if (starts_with(argv[i], "--dtype=")) a.dtype = std::string(argv[i] + 8);
+        // flag -> sweep list, or a plain setting
+        auto counts = [&](const char* k, std::vector<size_t>& dst) {
+            if (!starts_with(argv[i], k)) return false;
+            try {
+                dst = parse_counts(argv[i] + std::strlen(k));
+            } catch (const std::exception&) {
+                std::cerr << "Bad value: " << argv[i] << "\n";
+                std::exit(1);
+            }
+            return true;
+        };
+        auto names = [&](const char* k, std::vector<std::string>& dst) {
+            if (!starts_with(argv[i], k)) return false;
+            dst = split(argv[i] + std::strlen(k), ',');
+            return true;
+        };
+
+        if (names("--op=", sw.ops) || names("--variant=", sw.variants) || names("--dtype=", sw.dtypes)
+            || names("--isa=", sw.isas) || names("--segments=", sw.segments)) continue;
+        if (counts("--M=", sw.M) || counts("--N=", sw.N) || counts("--K=", sw.K) || counts("--MNK=", sw.MNK)
+            || counts("--size=", sw.size) || counts("--batch=", sw.batch) || counts("--threads=", sw.threads)
+            || counts("--crossover=", sw.crossover) || counts("--seg-len=", sw.seg_len)) continue;
+
+        if (starts_with(argv[i], "--reps=")) a.reps = std::stoi(argv[i] + 7);
         else if (starts_with(argv[i], "--seed=")) a.seed = static_cast<unsigned>(std::stoul(argv[i] + 7));
         else if (starts_with(argv[i], "--out=")) a.out = std::string(argv[i] + 6);
         else if (std::strcmp(argv[i], "--blocked") == 0) a.blocked = true;
+        else if (std::strcmp(argv[i], "--hugepages") == 0) a.hugepages = true;
+        else if (starts_with(argv[i], "--bind=")) a.bind = std::string(argv[i] + 7);
+        else if (starts_with(argv[i], "--numa=")) a.numa = std::string(argv[i] + 7);
+        else if (std::strcmp(argv[i], "--autotune") == 0) a.autotune = true;
+        else if (std::strcmp(argv[i], "--perf") == 0) a.perf = true;
+        else if (starts_with(argv[i], "--max-reps=")) a.max_reps = std::stoull(argv[i] + 11);
+        else if (starts_with(argv[i], "--min-time=")) a.min_time = std::stod(argv[i] + 11);
+        else if (starts_with(argv[i], "--warmup=")) a.warmup = std::stoull(argv[i] + 9);
+        else if (std::strcmp(argv[i], "--flush") == 0) a.flush = true;
+        else if (starts_with(argv[i], "--raw-out=")) a.raw_out = std::string(argv[i] + 10);
+        else if (starts_with(argv[i], "--format=")) a.format = std::string(argv[i] + 9);
+        else if (starts_with(argv[i], "--tune-file=")) a.tune_file = std::string(argv[i] + 12);
+        else if (starts_with(argv[i], "--epilogue=")) a.epilogue = std::string(argv[i] + 11);
+        else if (starts_with(argv[i], "--input=")) a.input = std::string(argv[i] + 8);
+        else if (starts_with(argv[i], "--panel-mb=")) a.panel_mb = std::stoull(argv[i] + 11);
+        else if (starts_with(argv[i], "--matrix=")) a.matrix = std::string(argv[i] + 9);
+        else if (starts_with(argv[i], "--row-nnz=")) a.row_nnz = std::stoull(argv[i] + 10);
+        else if (starts_with(argv[i], "--rhs=")) a.rhs = std::stoull(argv[i] + 6);
+        else if (starts_with(argv[i], "--layers=")) a.layers = std::stoi(argv[i] + 9);
+        else if (std::strcmp(argv[i], "--weak") == 0) a.weak = true;
         else if (std::strcmp(argv[i], "--help") == 0) {
-            std::cout << "Usage: hpc_bench --op=matmul|reduction|scan "
-                         "[--M=] [--N=] [--K=] [--size=] "
-                         "[--reps=] [--dtype=float|double] "
-                         "[--seed=] [--out=path] [--blocked]\n";
+            std::cout << "Usage: hpc_bench --op=matmul|matmul_batched|reduction|scan|spmv|pipeline|mpi "
+                         "[--M=] [--N=] [--K=] [--MNK=] [--size=] [--batch=] "
+                         "[--reps=] [--dtype=float|double|bf16|fp16|int8] "
+                         "[--seed=] [--out=path] [--blocked] "
+                         "[--variant=] [--threads=] [--hugepages] [--bind=] [--numa=] "
+                         "[--isa=scalar|avx2|avx512|neon] [--autotune] [--tune-file=path] [--perf] "
+                         "[--min-time=s] [--max-reps=] [--warmup=] [--flush] [--raw-out=path] "
+                         "[--format=csv|jsonl|binary] [--epilogue=bias,relu|gelu,residual] "
+                         "[--input=file] [--panel-mb=] [--segments=] [--seg-len=] "
+                         "[--matrix=file.mtx] [--row-nnz=] [--rhs=] [--layers=] [--weak]\n"
+                         "  matmul variants:    naive|blocked|packed|fixed|strassen, bf16/fp16: packed|dot, int8: packed\n"
+                         "                      strassen: --crossover= (list) sets the recursion cutoff\n"
+                         "                      with --epilogue: packed (fused)|unfused (extra passes over C)\n"
+                         "  batched variants:   strided|pointers|shared_b\n"
+                         "  reduction variants: serial|simd|parallel (Kahan)|pairwise|neumaier|binned|stats\n"
+                         "                      stats: sum, min, max, variance and dot with a second vector in one pass\n"
+                         "  scan variants:      serial|parallel|parallel_exclusive|lookback|segmented|segmented_flags|rows\n"
+                         "                      segmented*: --segments=fixed|uniform|geometric|powerlaw (list) and\n"
+                         "                      --seg-len= (list, mean length); rows: --seg-len= is the row length\n"
+                         "  spmv variants:      spmv|spmm (--rhs= dense columns) on --matrix=file.mtx or a\n"
+                         "                      generated power-law matrix of --size nonzeros, --row-nnz= per row\n"
+                         "  pipeline variants:  graph|barrier: blocked matmul (--M/--N/--K), then a Kahan sum\n"
+                         "                      and a scan of C, as one task graph or back to back\n"
+                         "  mpi variants:       summa|allreduce|scan under mpiexec (build with -DHPC_MPI=ON):\n"
+                         "                      SUMMA GEMM (--M/--N/--K, --layers= for 2.5D), Kahan allreduce\n"
+                         "                      and distributed scan of --size; --weak makes sizes per rank\n"
+                         "  --input=file:       out-of-core matmul (A then B) or scan (x) streamed from\n"
+                         "                      file (created with random data if short), result in file.out\n"
+                         "  sweeps: --op/--variant/--dtype/--isa take comma lists; --M/--N/--K/--MNK\n"
+                         "  (M = N = K)/--size/--batch/--threads take lists and ranges such as\n"
+                         "  256:4096:x2, 1k..1G (powers of two), 100:1000:+100 or 1,2,4\n"
+                         "  --bind: none|compact|scatter|node:N|cpu list (0-3,8); thread i runs on\n"
+                         "  the i-th cpu of that order. --numa: local (first touch)|interleave|N\n";
             std::exit(0);
         } else {
             std::cerr << "Unknown arg: " << argv[i] << "\n";
             std::exit(1);
         }
     }
+    if (a.blocked) sw.variants = {"blocked"};
+    if (sw.ops.empty()) sw.ops = {a.op};
+    if (sw.dtypes.empty()) sw.dtypes = {a.dtype};
+    if (sw.M.empty()) sw.M = {a.M};
+    if (sw.N.empty()) sw.N = {a.N};
+    if (sw.K.empty()) sw.K = {a.K};
+    if (sw.size.empty()) sw.size = {a.size};
+    if (sw.batch.empty()) sw.batch = {a.batch};
+    if (sw.crossover.empty()) sw.crossover = {a.crossover};
+    if (sw.segments.empty()) sw.segments = {a.segments};
+    if (sw.seg_len.empty()) sw.seg_len = {a.seg_len};
+    if (sw.threads.empty()) sw.threads = {a.threads};
+    for (size_t& t : sw.threads) {
+        if (t == 0) t = hpc::hardware_threads();
+    }
+    if (a.numa == "interleave") {
+        a.numa_policy = hpc::NumaPolicy::interleave;
+    } else if (a.numa != "local") {
+        std::vector<int> node;
+        if (!hpc::parse_cpu_list(a.numa, node) || node.size() != 1 || node[0] >= hpc::topology().nodes) {
+            std::cerr << "Unknown --numa (local|interleave|node 0.." << hpc::topology().nodes - 1
+                      << "): " << a.numa << "\n";
+            std::exit(2);
+        }
+        a.numa_policy = hpc::NumaPolicy::bind;
+        a.numa_node = node[0];
+    }
+    if (!a.epilogue.empty() && !valid_epilogue(a.epilogue)) {
+        std::cerr << "Unknown --epilogue (bias, relu|gelu, residual in that order): " << a.epilogue << "\n";
+        std::exit(2);
+    }
+    for (const std::string& name : sw.isas) {
+        hpc::Isa isa = hpc::Isa::scalar;
+        if (!hpc::parse_isa(name.c_str(), isa) || !hpc::isa_usable(isa)) {
+            std::cerr << "ISA not available on this build/CPU: " << name << "\n";
+            std::exit(2);
+        }
+    }
     return a;
 }
 
 template <class T>
-double checksum_vec(const std::vector<T>& v) {
+double checksum_vec(const T* v, size_t n) {
     long double s = 0.0L;
-    for (auto x : v) s += static_cast<long double>(x);
+    for (size_t i = 0; i < n; ++i) s += static_cast<long double>(v[i]);
     return static_cast<double>(s);
 }
 
+/// ISA column: the runtime-selected level for dispatched kernels, otherwise
+/// whatever the compiler flags of this binary target.
+static const char* kernel_isa(bool dispatched) {
+    return dispatched ? hpc::isa_name(hpc::active_isa()) : hpc::simd::native_isa_name();
+}
+
+/// --perf counters, opened in main before the thread pool starts its workers.
+static hpc::PerfCounters& perf_counters() {
+    static hpc::PerfCounters c;
+    return c;
+}
+
+/// Harness settings from the command line.
+static hpc::MeasureOptions measure_options(const Args& a) {
+    hpc::MeasureOptions o;
+    o.min_reps = static_cast<size_t>(std::max(a.reps, 1));
+    o.max_reps = std::max(a.max_reps, o.min_reps);
+    o.min_time_s = a.min_time;
+    o.max_warmup = a.warmup;
+    o.flush_cache = a.flush;
+    o.counters = a.perf ? &perf_counters() : nullptr;
+    return o;
+}
+
+static void print_stats(const hpc::Measurement& m) {
+    std::cout << "  min " << m.stats.min * 1e3 << " ms, p95 " << m.stats.p95 * 1e3
+              << " ms, median 95% CI [" << m.stats.ci_lo * 1e3 << ", " << m.stats.ci_hi * 1e3
+              << "] ms, " << m.times.size() << " reps x " << m.calls_per_rep << " calls, warm-up "
+              << m.warmup.size() << (m.stable ? "" : " (not stable)") << "\n";
+}
+
+static void print_perf(const hpc::PerfSample& s) {
+    if (std::isnan(s.cycles) && std::isnan(s.llc_misses) && std::isnan(s.fp_ops)) return;
+    std::cout << "  per call: cycles=" << s.cycles << " IPC=" << s.instructions / s.cycles
+              << " L1D misses=" << s.l1d_misses << " LLC misses=" << s.llc_misses
+              << " DRAM bytes~" << s.dram_bytes() << " FP ops=" << s.fp_ops
+              << " AI=" << s.intensity() << " F/B\n";
+}
+
+/// Buffer roles: in0/in1 hold random data from seed / seed+1, out is scratch.
+/// aux holds GEMM epilogue operands (M×N residual, then N bias) from seed+2.
+enum Role { in0, in1, out, aux, role_count };
+
+/// Benchmark buffers: 64-byte (or huge-page) aligned, placed by --numa and
+/// first-touched by the same threads in the units the kernel splits them by
+/// (GEMM rows, batch items, reduction chunks), so page faults stay out of the
+/// timing and, with --bind, each share sits on its thread's node.
 template <class T>
-void bench_matmul(const Args& a) {
-    using namespace hpc;
+static hpc::BufferOptions buffer_options(const Args& a, Role r) {
+    hpc::BufferOptions o;
+    o.huge_pages = a.hugepages;
+    o.first_touch_threads = a.threads;
+    o.numa = a.numa_policy;
+    o.numa_node = a.numa_node;
+    if (a.op == "matmul" || a.op == "pipeline") {
+        o.touch_grain = sizeof(T) * (r == in0 ? a.K : a.N);
+    } else if (a.op == "matmul_batched") {
+        o.touch_grain = sizeof(T) * (r == in0 ? a.M * a.K : r == in1 ? a.K * a.N : a.M * a.N);
+    } else if (a.op == "reduction" && (a.variant == "parallel" || a.variant == "binned" || a.variant == "stats")) {
+        o.touch_grain = sizeof(T) * hpc::reduction_chunk;
+    }
+    return o;
+}
+
+/// Elements each role needs for point a.
+static std::array<size_t, role_count> buffer_need(const Args& a) {
+    if (!a.input.empty()) return {0, 0, 0, 0}; // streamed from the file
+    if (a.op == "matmul") return {a.M * a.K, a.K * a.N, a.M * a.N, a.epilogue.empty() ? 0 : a.M * a.N + a.N};
+    if (a.op == "matmul_batched") {
+        const size_t nb = a.variant == "shared_b" ? 1 : a.batch;
+        return {a.batch * a.M * a.K, nb * a.K * a.N, a.batch * a.M * a.N, 0};
+    }
+    if (a.op == "scan") return {a.size, 0, a.size, 0};
+    if (a.op == "spmv") return {0, 0, 0, 0}; // sized by the matrix
+    if (a.op == "pipeline") return {a.M * a.K, a.K * a.N, 2 * a.M * a.N, 0}; // out: C, then its scan
+    if (a.op == "mpi") return {0, 0, 0, 0}; // sized by the rank's block
+    return {a.size, 0, 0, 0};
+}
+
+/// Inputs and scratch reused across sweep points. A random role is refilled
+/// only when a point needs more elements or another seed; the first n values
+/// of a seed's sequence do not depend on the length, so a reused prefix is
+/// what make_random_aligned would return. reserve() sizes a role for the
+/// largest point up front, so a growing sweep fills it once. Pages keep the
+/// first-touch placement of the point that allocated them.
+template <class T>
+class BufferCache {
+public:
+    void reserve(Role r, size_t n) { reserved_[r] = std::max(reserved_[r], n); }
+
+    T* random(Role r, size_t n, unsigned seed, const hpc::BufferOptions& opt) {
+        Slot& s = slots_[r];
+        if (s.buf.size() < n || s.seed != seed) {
+            s.buf = hpc::make_random_aligned<T>(std::max(n, reserved_[r]), seed, opt);
+            s.seed = seed;
+        }
+        return s.buf.data();
+    }
 
-    auto A = make_random<T>(a.M * a.K, a.seed);
-    auto B = make_random<T>(a.K * a.N, a.seed + 1);
-    std::vector<T> C(a.M * a.N);
+    T* scratch(Role r, size_t n, const hpc::BufferOptions& opt) {
+        Slot& s = slots_[r];
+        if (s.buf.size() < n) s.buf = hpc::AlignedBuffer<T>(std::max(n, reserved_[r]), opt);
+        return s.buf.data();
+    }
+
+    void clear() {
+        for (Slot& s : slots_) s = Slot{};
+    }
 
-    const char* op_label = a.blocked ? "matmul_blocked" : "matmul_naive";
+private:
+    struct Slot {
+        hpc::AlignedBuffer<T> buf;
+        unsigned seed = 0;
+    };
+
+    std::array<Slot, role_count> slots_;
+    std::array<size_t, role_count> reserved_{};
+};
 
-    // warm-up
-    if (a.blocked) matmul_blocked<T>(a.M, a.N, a.K, A, B, C, 128);
-    else matmul_naive<T>(a.M, a.N, a.K, A, B, C);
+/// Output sinks and buffers shared by every point of a run.
+struct BenchContext {
+    std::string run_id;
+    std::unique_ptr<hpc::ResultSink> results;
+    std::unique_ptr<hpc::ResultSink> raw;       // --raw-out only
+    BufferCache<float> f32;
+    BufferCache<double> f64;
+    BufferCache<hpc::bf16> b16;
+    BufferCache<hpc::fp16> h16;
+    BufferCache<std::uint8_t> u8;        // int8 GEMM: A
+    BufferCache<std::int8_t> s8;         // int8 GEMM: B
+
+    template <class T>
+    BufferCache<T>& buffers() {
+        if constexpr (std::is_same<T, float>::value) return f32;
+        else if constexpr (std::is_same<T, double>::value) return f64;
+        else if constexpr (std::is_same<T, hpc::bf16>::value) return b16;
+        else if constexpr (std::is_same<T, hpc::fp16>::value) return h16;
+        else if constexpr (std::is_same<T, std::uint8_t>::value) return u8;
+        else return s8;
+    }
+
+    /// Size role r of dtype's cache for n elements. bf16/fp16/int8 points
+    /// keep their fp32 output in f32; int8 has u8 A and s8 B.
+    void reserve(const std::string& dtype, Role r, size_t n) {
+        if (dtype == "double") f64.reserve(r, n);
+        else if (dtype == "float" || r == out) f32.reserve(r, n);
+        else if (dtype == "bf16") b16.reserve(r, n);
+        else if (dtype == "fp16") h16.reserve(r, n);
+        else if (r == in0) u8.reserve(r, n);
+        else s8.reserve(r, n);
+    }
+
+    /// Free every cache dtype does not use.
+    void keep_only(const std::string& dtype) {
+        if (dtype == "double") f32.clear();
+        if (dtype != "double") f64.clear();
+        if (dtype != "bf16") b16.clear();
+        if (dtype != "fp16") h16.clear();
+        if (dtype != "int8") { u8.clear(); s8.clear(); }
+    }
+};
+
+/// Results row with the columns every op fills the same way; the caller
+/// adds the shape and the derived rates.
+static hpc::Row result_row(const BenchContext& ctx, const Args& a, const std::string& label,
+                           size_t threads, const char* isa, const hpc::Measurement& m)
+{
+    const hpc::PerfSample& c = m.counters;
+    hpc::Row r(results_schema());
+    r.set("timestamp", std::time(nullptr)).set("op", label).set("dtype", a.dtype)
+     .set("M", 0).set("N", 0).set("K", 0).set("size", 0)
+     .set("reps", m.times.size()).set("ns_per_rep", m.stats.median * 1e9)
+     .set("threads", threads).set("isa", isa)
+     .set("ns_min", m.stats.min * 1e9).set("ns_p95", m.stats.p95 * 1e9)
+     .set("ns_ci_lo", m.stats.ci_lo * 1e9).set("ns_ci_hi", m.stats.ci_hi * 1e9)
+     .set("ns_stddev", m.stats.stddev * 1e9)
+     .set("warmup", m.warmup.size()).set("stable", m.stable ? 1 : 0)
+     .set("cycles", c.cycles).set("instructions", c.instructions)
+     .set("l1d_misses", c.l1d_misses).set("llc_misses", c.llc_misses)
+     .set("dram_bytes", c.dram_bytes()).set("fp_ops", c.fp_ops).set("ai", c.intensity())
+     .set("run_id", ctx.run_id);
+    return r;
+}
+
+/// Write r and, with --raw-out, every rep of m keyed like it.
+static void emit(BenchContext& ctx, const Args& a, const hpc::Row& r, const std::string& label,
+                 size_t size, size_t threads, const char* isa, const hpc::Measurement& m)
+{
+    if (!ctx.results) return; // MPI ranks other than 0
+    ctx.results->write(r);
+    if (!ctx.raw) return;
+    auto rows = [&](const char* phase, const std::vector<double>& t) {
+        for (size_t i = 0; i < t.size(); ++i) {
+            hpc::Row w(raw_schema());
+            w.set("timestamp", std::get<std::int64_t>(r[results_schema().index("timestamp")]))
+             .set("op", label)
+             .set("M", a.M).set("N", a.N).set("K", a.K).set("size", size)
+             .set("dtype", a.dtype).set("threads", threads).set("isa", isa)
+             .set("phase", phase).set("rep", i).set("calls", m.calls_per_rep)
+             .set("ns", t[i] * 1e9).set("run_id", ctx.run_id);
+            ctx.raw->write(w);
+        }
+    };
+    rows("warmup", m.warmup);
+    rows("timed", m.times);
+}
 
-    // measure
-    std::vector<double> times(a.reps);
+template <class T>
+void bench_matmul(const Args& a, BenchContext& ctx) {
+    using namespace hpc;
 
-    for (int r = 0; r < a.reps; ++r) {
-        Timer t; t.start();
+    BufferCache<T>& bufs = ctx.buffers<T>();
+    const T* A = bufs.random(in0, a.M * a.K, a.seed, buffer_options<T>(a, in0));
+    const T* B = bufs.random(in1, a.K * a.N, a.seed + 1, buffer_options<T>(a, in1));
+    T* C = bufs.scratch(out, a.M * a.N, buffer_options<T>(a, out));
 
-        if (a.blocked) matmul_blocked<T>(a.M, a.N, a.K, A, B, C, 128);
-        else matmul_naive<T>(a.M, a.N, a.K, A, B, C);
+    std::string label = "matmul_" + a.variant;
+    const size_t crossover = a.crossover ? a.crossover : strassen_default_crossover;
+    if (a.variant == "strassen") label += "_x" + std::to_string(crossover);
 
-        times[r] = t.stop_s();
+    // naive is serial; blocked only parallelises through OpenMP builds.
+    size_t threads = 1;
+    if (a.variant == "packed" || a.variant == "strassen") threads = a.threads;
+#if defined(_OPENMP)
+    if (a.variant == "blocked") {
+        threads = a.threads;
+        omp_set_num_threads(static_cast<int>(threads));
     }
+#endif
+    const char* op_label = label.c_str();
+    const char* isa = kernel_isa(a.variant != "naive" && a.variant != "blocked");
+
+    auto run = [&]() {
+        if (a.variant == "blocked") {
+            matmul_blocked<T>(a.M, a.N, a.K, A, a.K, B, a.N, C, a.N);
+        } else if (a.variant == "fixed") {
+            matmul_small<T>(a.M, a.N, a.K, A, a.K, B, a.N, C, a.N);
+        } else if (a.variant == "packed") {
+            gemm<T>(Trans::none, Trans::none, T(1),
+                    row_major_view<const T>(A, a.M, a.K),
+                    row_major_view<const T>(B, a.K, a.N),
+                    T(0), row_major_view<T>(C, a.M, a.N), a.threads);
+        } else if (a.variant == "strassen") {
+            matmul_strassen<T>(a.M, a.N, a.K, A, a.K, B, a.N, C, a.N, a.threads, crossover);
+        } else {
+            matmul_naive<T>(a.M, a.N, a.K, A, a.K, B, a.N, C, a.N);
+        }
+    };
 
-    std::sort(times.begin(), times.end());
-    double t_med = times[times.size() / 2];
+    // Small shapes run in well under a microsecond; the harness repeats
+    // them within each rep and reports the per-call time.
+    const Measurement m = measure(measure_options(a), run);
+    double t_med = m.stats.median;
 
     // metrics
     double flops = 2.0 * (double)a.M * (double)a.N * (double)a.K;
     double gflops = (flops / t_med) / 1e9;
     double bytes = sizeof(T) * ((double)a.M * a.K + (double)a.K * a.N + 2.0 * (double)a.M * a.N);
     double gbps = (bytes / t_med) / 1e9;
-    double sumC = checksum_vec(C);
+    double sumC = checksum_vec(C, a.M * a.N);
 
-    // csv
-    std::time_t ts = std::time(nullptr);
+    Row r = result_row(ctx, a, label, threads, isa, m);
+    r.set("M", a.M).set("N", a.N).set("K", a.K)
+     .set("gflops", gflops).set("gbps", gbps).set("checksum", sumC);
+    emit(ctx, a, r, label, 0, threads, isa, m);
 
-    csv_write_header_if_new(a.out,
-        "timestamp,op,M,N,K,size,dtype,reps,ns_per_rep,gflops,gbps,checksum");
+    std::cout << "[" << op_label << "] median " << (t_med * 1e3) << " ms, "
+              << gflops << " GF/s, " << gbps << " GB/s, checksum=" << sumC
+              << ", isa=" << isa << "\n";
+    print_stats(m);
+    print_perf(m.counters);
+}
 
-    char line[512];
+/// c with x appended: epilogue chains are assembled one stage at a time.
+template <class... E, class X>
+static hpc::epilogue::chain<E..., X> then(const hpc::epilogue::chain<E...>& c, X x) {
+    return {std::tuple_cat(c.parts, std::make_tuple(x))};
+}
 
-    std::snprintf(line, sizeof(line),
-        "%lld,%s,%zu,%zu,%zu,0,%s,%d,%.0f,%.6f,%.6f,%.17g",
-        (long long)ts, op_label, a.M, a.N, a.K, a.dtype.c_str(), a.reps,
-        t_med * 1e9, gflops, gbps, sumC);
+/// f(chain) for the --epilogue stages, each combination compiled once.
+template <class T, class F>
+static void with_epilogue(const std::string& spec, const T* bias, const T* res, size_t ld, F&& f) {
+    using namespace hpc::epilogue;
+    const auto stages = split(spec, ',');
+    auto has = [&](const char* s) { return std::find(stages.begin(), stages.end(), s) != stages.end(); };
+    auto tail = [&](auto c) {
+        if (has("residual")) f(then(c, residual<T>{res, ld}));
+        else f(c);
+    };
+    auto act = [&](auto c) {
+        if (has("relu")) tail(then(c, relu{}));
+        else if (has("gelu")) tail(then(c, gelu{}));
+        else tail(c);
+    };
+    if (has("bias")) act(then(chain<>{}, hpc::epilogue::bias<T>{bias}));
+    else act(chain<>{});
+}
 
-    csv_append_line(a.out, line);
+/// --epilogue: packed GEMM with the stages fused into the micro-kernel's
+/// store, or (unfused) the same GEMM followed by one pass over C per stage.
+/// gbps counts each mode's own traffic, so the two rows show what fusing saves.
+template <class T>
+void bench_matmul_epilogue(const Args& a, BenchContext& ctx) {
+    using namespace hpc;
 
-    std::cout << "[" << op_label << "] median " << (t_med * 1e3) << " ms, "
-              << gflops << " GF/s, " << gbps << " GB/s, checksum=" << sumC << "\n";
+    BufferCache<T>& bufs = ctx.buffers<T>();
+    const T* A = bufs.random(in0, a.M * a.K, a.seed, buffer_options<T>(a, in0));
+    const T* B = bufs.random(in1, a.K * a.N, a.seed + 1, buffer_options<T>(a, in1));
+    T* C = bufs.scratch(out, a.M * a.N, buffer_options<T>(a, out));
+    const T* R = bufs.random(aux, a.M * a.N + a.N, a.seed + 2, buffer_options<T>(a, aux));
+    const T* bias = R + a.M * a.N;
+
+    std::string stages = a.epilogue;
+    std::replace(stages.begin(), stages.end(), ',', '_');
+    const std::string label = "matmul_" + a.variant + "_" + stages;
+    const bool fused = a.variant == "packed";
+    const char* isa = kernel_isa(true);
+
+    with_epilogue<T>(a.epilogue, bias, R, a.N, [&](const auto& epi) {
+        auto run = [&]() {
+            const auto Av = row_major_view<const T>(A, a.M, a.K);
+            const auto Bv = row_major_view<const T>(B, a.K, a.N);
+            const auto Cv = row_major_view<T>(C, a.M, a.N);
+            if (fused) {
+                gemm<T>(Trans::none, Trans::none, T(1), Av, Bv, T(0), Cv, a.threads, {}, epi);
+                return;
+            }
+            gemm<T>(Trans::none, Trans::none, T(1), Av, Bv, T(0), Cv, a.threads);
+            // One pass per stage over each thread's rows, on the GEMM's team.
+            std::apply([&](const auto&... e) {
+                if constexpr (sizeof...(e) > 0) {
+                    auto pass = [&](const auto& stage) {
+                        default_pool().run(a.threads, [&](const ThreadContext& tc) {
+                            const auto rows = split_range(a.M, tc.nthreads, tc.tid);
+                            for (size_t i = rows.first; i < rows.second; ++i)
+                                for (size_t j = 0; j < a.N; ++j) C[i * a.N + j] = stage(C[i * a.N + j], i, j);
+                        });
+                    };
+                    (pass(e), ...);
+                }
+            }, epi.parts);
+        };
+
+        const Measurement m = measure(measure_options(a), run);
+        const double t_med = m.stats.median;
+
+        // Operand traffic is the same in both modes; unfused adds a read and
+        // a write of C for every stage.
+        const double mn = double(a.M) * double(a.N);
+        const double npasses = double(std::tuple_size<decltype(epi.parts)>::value);
+        double operands = double(a.M) * a.K + double(a.K) * a.N + 2.0 * mn;
+        if (a.epilogue.find("bias") != std::string::npos) operands += double(a.N);
+        if (a.epilogue.find("residual") != std::string::npos) operands += mn;
+        const double passes = 2.0 * mn * npasses;
+        const double bytes = sizeof(T) * (operands + (fused ? 0.0 : passes));
+
+        const double flops = 2.0 * double(a.M) * double(a.N) * double(a.K);
+        const double gflops = (flops / t_med) / 1e9;
+        const double gbps = (bytes / t_med) / 1e9;
+        const double sumC = checksum_vec(C, a.M * a.N);
+
+        Row r = result_row(ctx, a, label, a.threads, isa, m);
+        r.set("M", a.M).set("N", a.N).set("K", a.K)
+         .set("gflops", gflops).set("gbps", gbps).set("checksum", sumC);
+        emit(ctx, a, r, label, 0, a.threads, isa, m);
+
+        std::cout << "[" << label << "] median " << (t_med * 1e3) << " ms, "
+                  << gflops << " GF/s, " << gbps << " GB/s, checksum=" << sumC
+                  << ", isa=" << isa << "\n";
+        std::cout << "  epilogue: " << npasses << " stage(s), "
+                  << (fused ? "fused, saves " : "unfused, costs ")
+                  << sizeof(T) * passes / 1e6 << " MB of passes over C\n";
+        print_stats(m);
+        print_perf(m.counters);
+    });
+}
+
+/// --dtype=bf16|fp16: matmul_mixed (fp32 accumulation and C). packed widens
+/// while packing; dot runs the AVX512-BF16 kernel where there is one.
+template <class Lo>
+void bench_matmul_mixed(const Args& a, BenchContext& ctx) {
+    using namespace hpc;
+
+    BufferCache<Lo>& bufs = ctx.buffers<Lo>();
+    const Lo* A = bufs.random(in0, a.M * a.K, a.seed, buffer_options<Lo>(a, in0));
+    const Lo* B = bufs.random(in1, a.K * a.N, a.seed + 1, buffer_options<Lo>(a, in1));
+    float* C = ctx.f32.scratch(out, a.M * a.N, buffer_options<float>(a, out));
+
+    const std::string label = "matmul_" + a.variant;
+    const MixedKernel kern = a.variant == "dot" ? MixedKernel::dot : MixedKernel::widen;
+    const char* isa = mixed_kernel_name<Lo>(kern);
+
+    auto run = [&]() {
+        matmul_mixed<Lo>(a.M, a.N, a.K, 1.0f, A, a.K, B, a.N, 0.0f, C, a.N, a.threads, {}, kern);
+    };
+    const Measurement m = measure(measure_options(a), run);
+    const double t_med = m.stats.median;
+
+    const double flops = 2.0 * (double)a.M * (double)a.N * (double)a.K;
+    const double gflops = (flops / t_med) / 1e9;
+    const double bytes = sizeof(Lo) * ((double)a.M * a.K + (double)a.K * a.N)
+                       + sizeof(float) * 2.0 * (double)a.M * a.N;
+    const double gbps = (bytes / t_med) / 1e9;
+    const double sumC = checksum_vec(C, a.M * a.N);
+
+    Row r = result_row(ctx, a, label, a.threads, isa, m);
+    r.set("M", a.M).set("N", a.N).set("K", a.K)
+     .set("gflops", gflops).set("gbps", gbps).set("checksum", sumC);
+    emit(ctx, a, r, label, 0, a.threads, isa, m);
+
+    std::cout << "[" << label << " " << a.dtype << "] median " << (t_med * 1e3) << " ms, "
+              << gflops << " GF/s, " << gbps << " GB/s, checksum=" << sumC
+              << ", isa=" << isa << "\n";
+    print_stats(m);
+    print_perf(m.counters);
+}
+
+/// --dtype=int8: matmul_u8s8 with a zero point on A and per-column scales,
+/// the usual activation × weight quantisation. gflops holds 10^9 int ops/s.
+static void bench_matmul_int8(const Args& a, BenchContext& ctx) {
+    using namespace hpc;
+
+    const std::uint8_t* A = ctx.u8.random(in0, a.M * a.K, a.seed, buffer_options<std::uint8_t>(a, in0));
+    const std::int8_t* B = ctx.s8.random(in1, a.K * a.N, a.seed + 1, buffer_options<std::int8_t>(a, in1));
+    float* C = ctx.f32.scratch(out, a.M * a.N, buffer_options<float>(a, out));
+
+    std::vector<float> col_scale(a.N);
+    for (size_t j = 0; j < a.N; ++j) col_scale[j] = 1.0f / (128.0f * (1.0f + j % 4));
+    QuantParams q;
+    q.scale = 1.0f / 128.0f;
+    q.a_zero = 128;
+    q.col_scale = col_scale.data();
+
+    const std::string label = "matmul_" + a.variant;
+    const char* isa = quant_kernel_name();
+
+    auto run = [&]() {
+        matmul_u8s8(a.M, a.N, a.K, A, a.K, B, a.N, C, a.N, q, 0.0f, a.threads);
+    };
+    const Measurement m = measure(measure_options(a), run);
+    const double t_med = m.stats.median;
+
+    const double ops = 2.0 * (double)a.M * (double)a.N * (double)a.K;
+    const double gops = (ops / t_med) / 1e9;
+    const double bytes = (double)a.M * a.K + (double)a.K * a.N + sizeof(float) * 2.0 * (double)a.M * a.N;
+    const double gbps = (bytes / t_med) / 1e9;
+    const double sumC = checksum_vec(C, a.M * a.N);
+
+    Row r = result_row(ctx, a, label, a.threads, isa, m);
+    r.set("M", a.M).set("N", a.N).set("K", a.K)
+     .set("gflops", gops).set("tops", gops / 1e3).set("gbps", gbps).set("checksum", sumC);
+    emit(ctx, a, r, label, 0, a.threads, isa, m);
+
+    std::cout << "[" << label << " int8] median " << (t_med * 1e3) << " ms, "
+              << gops / 1e3 << " TOPS (" << gops << " GOP/s), " << gbps << " GB/s, checksum=" << sumC
+              << ", isa=" << isa << "\n";
+    print_stats(m);
+    print_perf(m.counters);
 }
 
+/// Make sure f holds n random T of seed at element offset first: a shorter
+/// file gets them written chunk by chunk (same values as make_random).
 template <class T>
-void bench_reduction(const Args& a) {
+static void ensure_random_file(hpc::File& f, size_t first, size_t n, unsigned seed) {
+    const size_t chunk = size_t(1) << 20;
+    hpc::AlignedBuffer<T> buf(std::min(chunk, std::max<size_t>(n, 1)));
+    for (size_t i = 0; i < n; i += chunk) {
+        const size_t len = std::min(chunk, n - i);
+        hpc::fill_random_range<T>(buf.data(), i, len, seed);
+        f.write_at(buf.data(), len * sizeof(T), (first + i) * sizeof(T));
+    }
+    f.drop_cache(first * sizeof(T), n * sizeof(T));
+}
+
+/// Sum of the n T at the start of f, read in chunks.
+template <class T>
+static double checksum_file(const hpc::File& f, size_t n) {
+    const size_t chunk = size_t(1) << 20;
+    hpc::AlignedBuffer<T> buf(std::min(chunk, std::max<size_t>(n, 1)));
+    long double s = 0.0L;
+    for (size_t i = 0; i < n; i += chunk) {
+        const size_t len = std::min(chunk, n - i);
+        f.read_at(buf.data(), len * sizeof(T), i * sizeof(T));
+        for (size_t j = 0; j < len; ++j) s += static_cast<long double>(buf[j]);
+    }
+    return static_cast<double>(s);
+}
+
+/// --input=file: out-of-core matmul (A then B in the file, from seed and
+/// seed+1 like the in-memory runs) or scan (size elements), streamed with
+/// hpc/out_of_core.hpp in --panel-mb buffers. A file too short to hold the
+/// operands is filled first. The result goes to file.out. Prints how much
+/// of the I/O time compute hid (overlap).
+template <class T>
+void bench_stream(const Args& a, BenchContext& ctx) {
     using namespace hpc;
 
-    auto x = make_random<T>(a.size, a.seed);
-    volatile T sink = 0; // avoid DCE
+    const bool mm = a.op == "matmul";
+    const size_t na = mm ? a.M * a.K : a.size, nb = mm ? a.K * a.N : 0;
+    const size_t nout = mm ? a.M * a.N : a.size;
+    {
+        File f(a.input, File::read_write);
+        if (f.size() < (na + nb) * sizeof(T)) {
+            std::cout << "[stream] writing " << (na + nb) * sizeof(T) / 1e9 << " GB of inputs to " << a.input << "\n";
+            ensure_random_file<T>(f, 0, na, a.seed);
+            ensure_random_file<T>(f, na, nb, a.seed + 1);
+        }
+    }
+    const File in(a.input, File::read);
+    File out(a.input + ".out", File::read_write);
+    out.resize(nout * sizeof(T));
+
+    StreamOptions opt;
+    opt.panel_bytes = std::max<size_t>(a.panel_mb, 1) << 20;
+    opt.nthreads = a.threads;
+
+    const std::string label = a.op + "_stream";
+    const char* isa = kernel_isa(true);
+
+    StreamStats st;
+    auto run = [&]() {
+        st = mm ? matmul_stream<T>(a.M, a.N, a.K, in, 0, in, na * sizeof(T), out, 0, opt)
+                : inclusive_scan_stream<T>(in, 0, out, 0, a.size, opt);
+    };
+    const Measurement m = measure(measure_options(a), run);
+    const double t_med = m.stats.median;
+
+    const double flops = mm ? 2.0 * (double)a.M * (double)a.N * (double)a.K : (double)a.size;
+    const double gflops = (flops / t_med) / 1e9;
+    const double bytes = double(st.bytes_read + st.bytes_written);
+    const double gbps = (bytes / t_med) / 1e9;
+    const double io_gbps = st.io_seconds > 0.0 ? bytes / st.io_seconds / 1e9 : 0.0;
+    const double sumC = checksum_file<T>(out, nout);
+
+    Row r = result_row(ctx, a, label, a.threads, isa, m);
+    if (mm) r.set("M", a.M).set("N", a.N).set("K", a.K);
+    else r.set("size", a.size);
+    r.set("gflops", gflops).set("gbps", gbps).set("checksum", sumC)
+     .set("io_gbps", io_gbps).set("overlap", st.overlap());
+    emit(ctx, a, r, label, mm ? 0 : a.size, a.threads, isa, m);
+
+    std::cout << "[" << label << "] median " << (t_med * 1e3) << " ms, "
+              << gflops << " GF/s, " << gbps << " GB/s, checksum=" << sumC
+              << ", isa=" << isa << "\n";
+    std::cout << "  io (last rep): " << st.bytes_read / 1e9 << " GB read, " << st.bytes_written / 1e9
+              << " GB written, I/O threads busy " << st.io_seconds << " s (" << io_gbps
+              << " GB/s), compute stalled " << st.stall_seconds << " s of " << st.seconds
+              << " s, overlap " << 100.0 * st.overlap() << "%\n";
+    print_stats(m);
+    print_perf(m.counters);
+}
+
+/// Fastest per-call time of `reps` short harness reps (one warm-up rep).
+template <class F>
+static double time_best(F&& f, size_t reps = 3) {
+    hpc::MeasureOptions o;
+    o.min_reps = reps;
+    o.min_time_s = 0.0;
+    o.max_warmup = 1;
+    return hpc::measure(o, f).stats.min;
+}
+
+/// Tune one dtype on a representative shape per class. The packed blocking
+/// is searched by coordinate descent (KC, then MC, then NC, starting from the
+/// defaults); the blocked kernel's BS by a plain sweep.
+template <class T>
+void autotune_dtype(const Args& a, const char* dtype, std::vector<hpc::TuneRecord>& recs) {
+    using namespace hpc;
+
+    struct Shape { ShapeClass cls; size_t M, N, K; };
+    const Shape shapes[] = {
+        {ShapeClass::small, 96, 96, 96},
+        {ShapeClass::skinny, 1024, 1024, 64},
+        {ShapeClass::medium, 384, 384, 384},
+        {ShapeClass::large, 1024, 1024, 1024},
+    };
+    const size_t kcs[] = {128, 192, 256, 384, 512};
+    const size_t mcs[] = {48, 96, 144, 192, 288};
+    const size_t ncs[] = {1024, 2048, 4096, 8192};
+    const size_t bss[] = {32, 64, 128, 256};
+
+    for (const Shape& s : shapes) {
+        auto A = make_random_aligned<T>(s.M * s.K, a.seed, buffer_options<T>(a, in0));
+        auto B = make_random_aligned<T>(s.K * s.N, a.seed + 1, buffer_options<T>(a, in1));
+        AlignedBuffer<T> C(s.M * s.N, buffer_options<T>(a, out));
+        const double flops = 2.0 * (double)s.M * (double)s.N * (double)s.K;
+
+        auto packed = [&](GemmBlocking b) {
+            return time_best([&] {
+                gemm<T>(Trans::none, Trans::none, T(1),
+                        row_major_view<const T>(A.data(), s.M, s.K),
+                        row_major_view<const T>(B.data(), s.K, s.N),
+                        T(0), row_major_view<T>(C.data(), s.M, s.N), a.threads, b);
+            });
+        };
+
+        GemmBlocking best = default_blocking<T>();
+        const double t_default = packed(best);
+        double t_best = t_default;
+        auto try_blk = [&](GemmBlocking b) {
+            const double t = packed(b);
+            if (t < t_best) { t_best = t; best = b; }
+        };
+        for (size_t kc : kcs) try_blk({best.MC, kc, best.NC});
+        for (size_t mc : mcs) try_blk({mc, best.KC, best.NC});
+        for (size_t nc : ncs) try_blk({best.MC, best.KC, nc});
+
+        size_t best_bs = 128;
+        double t_bs = 1e300;
+        for (size_t bs : bss) {
+            const double t = time_best([&] {
+                matmul_blocked<T>(s.M, s.N, s.K, A.data(), s.K, B.data(), s.N, C.data(), s.N, bs);
+            }, 2);
+            if (t < t_bs) { t_bs = t; best_bs = bs; }
+        }
+
+        TuneRecord r;
+        r.cpu = cpu_model();
+        r.isa = isa_name(active_isa());
+        r.dtype = dtype;
+        r.shape = shape_class_name(s.cls);
+        r.p = {best.MC, best.KC, best.NC, best_bs};
+        tune_upsert(recs, r);
+
+        std::cout << "[autotune] " << dtype << " " << r.shape << " " << s.M << "x" << s.N << "x" << s.K
+                  << ": MC=" << best.MC << " KC=" << best.KC << " NC=" << best.NC
+                  << " (" << flops / t_best / 1e9 << " GF/s, default " << flops / t_default / 1e9
+                  << "), blocked BS=" << best_bs << " (" << flops / t_bs / 1e9 << " GF/s)\n";
+    }
+}
 
-    // warm-up
-    sink = kahan_sum<T>(x);
+/// --autotune: tune both dtypes and merge the winners into the tuning file,
+/// keeping entries of other CPUs / ISAs.
+static void run_autotune(const Args& a) {
+#if defined(_OPENMP)
+    omp_set_num_threads(static_cast<int>(a.threads));
+#endif
+    const std::string path = a.tune_file.empty() ? hpc::default_tune_path() : a.tune_file;
+    auto recs = hpc::read_tune_file(path);
 
-    // measure
-    std::vector<double> times(a.reps);
+    std::cout << "[autotune] cpu=\"" << hpc::cpu_model() << "\" isa=" << hpc::isa_name(hpc::active_isa())
+              << " threads=" << a.threads << "\n";
+    autotune_dtype<float>(a, "float", recs);
+    autotune_dtype<double>(a, "double", recs);
 
-    for (int r = 0; r < a.reps; ++r) {
-        Timer t; t.start();
+    hpc::write_tune_file(path, recs);
+    hpc::tuning().load(path);
+    std::cout << "[autotune] wrote " << path << "\n";
+}
+
+template <class T>
+void bench_matmul_batched(const Args& a, BenchContext& ctx) {
+    using namespace hpc;
 
-        sink = kahan_sum<T>(x);
-        times[r] = t.stop_s();
+    const size_t sa = a.M * a.K, sb = a.K * a.N, sc = a.M * a.N;
+    const bool shared = a.variant == "shared_b";
+
+    BufferCache<T>& bufs = ctx.buffers<T>();
+    const T* A = bufs.random(in0, a.batch * sa, a.seed, buffer_options<T>(a, in0));
+    const T* B = bufs.random(in1, shared ? sb : a.batch * sb, a.seed + 1, buffer_options<T>(a, in1));
+    T* C = bufs.scratch(out, a.batch * sc, buffer_options<T>(a, out));
+
+    // "pointers" runs the same strided data through the pointer-array overload.
+    std::vector<const T*> pa(a.batch), pb(a.batch);
+    std::vector<T*> pc(a.batch);
+    for (size_t i = 0; i < a.batch; ++i) {
+        pa[i] = A + i * sa;
+        pb[i] = B + i * sb;
+        pc[i] = C + i * sc;
     }
 
-    std::sort(times.begin(), times.end());
-    double t_med = times[times.size() / 2];
+    const std::string label = "matmul_batched_" + a.variant;
+    const char* isa = kernel_isa(true);
+
+    auto run = [&]() {
+        if (a.variant == "pointers") {
+            matmul_batched<T>(a.batch, a.M, a.N, a.K, T(1), pa.data(), a.K, pb.data(), a.N,
+                              T(0), pc.data(), a.N, a.threads);
+        } else {
+            matmul_batched<T>(a.batch, a.M, a.N, a.K, T(1), A, a.K, sa,
+                              B, a.N, shared ? 0 : sb, T(0), C, a.N, sc, a.threads);
+        }
+    };
+
+    const double flops = 2.0 * (double)a.M * (double)a.N * (double)a.K * (double)a.batch;
 
-    double flops = (double)a.size - 1.0;
+    const Measurement m = measure(measure_options(a), run);
+    double t_med = m.stats.median;
+
+    // metrics; the CSV size column carries the batch count
     double gflops = (flops / t_med) / 1e9;
-    double bytes = sizeof(T) * (double)a.size;
+    double mats = (double)a.batch / t_med;
+    double bytes = sizeof(T) * (double)a.batch * ((double)sa + (shared ? 0.0 : (double)sb) + 2.0 * (double)sc)
+                 + (shared ? sizeof(T) * (double)sb : 0.0);
     double gbps = (bytes / t_med) / 1e9;
-    double chk = (double)sink;
+    double sumC = checksum_vec(C, a.batch * sc);
 
-    std::time_t ts = std::time(nullptr);
+    Row r = result_row(ctx, a, label, a.threads, isa, m);
+    r.set("M", a.M).set("N", a.N).set("K", a.K).set("size", a.batch)
+     .set("gflops", gflops).set("gbps", gbps).set("checksum", sumC);
+    emit(ctx, a, r, label, a.batch, a.threads, isa, m);
 
-    csv_write_header_if_new(a.out,
-        "timestamp,op,M,N,K,size,dtype,reps,ns_per_rep,gflops,gbps,checksum");
-    
-    char line[512];
+    std::cout << "[" << label << "] median " << (t_med * 1e3) << " ms, "
+              << mats << " matrices/s, " << gflops << " GF/s, " << gbps
+              << " GB/s, checksum=" << sumC
+              << ", isa=" << isa << "\n";
+    print_stats(m);
+    print_perf(m.counters);
+}
 
-    std::snprintf(line, sizeof(line),
-        "%lld,reduction,0,0,0,%zu,%s,%d,%.0f,%.6f,%.6f,%.17g",
-        (long long)ts, a.size, a.dtype.c_str(), a.reps,
-        t_med * 1e9, gflops, gbps, chk);
-    
-    csv_append_line(a.out, line);
+template <class T>
+void bench_reduction(const Args& a, BenchContext& ctx) {
+    using namespace hpc;
+
+    const bool stats = a.variant == "stats";
+    const T* x = ctx.buffers<T>().random(in0, a.size, a.seed, buffer_options<T>(a, in0));
+    const T* y = stats ? ctx.buffers<T>().random(in1, a.size, a.seed + 1, buffer_options<T>(a, in1)) : nullptr;
+    volatile T sink = 0; // avoid DCE
+    Stats<T> st;
 
-    std::cout << "[reduction] median " << (t_med * 1e3) << " ms, "
-              << gflops << " GF/s, " << gbps << " GB/s, checksum=" << chk << "\n";
+    // "reduction" keeps the original label for the serial Kahan baseline.
+    const std::string label = a.variant == "serial" ? "reduction" : "reduction_" + a.variant;
+    const size_t threads = a.variant == "parallel" || a.variant == "binned" || stats ? a.threads : 1;
+    const char* isa = kernel_isa(a.variant != "serial");
+
+    auto run = [&]() -> T {
+        if (a.variant == "simd") return kahan_sum_simd<T>(x, a.size);
+        if (a.variant == "parallel") return kahan_sum_parallel<T>(x, a.size, threads);
+        if (a.variant == "pairwise") return pairwise_sum<T>(x, a.size);
+        if (a.variant == "neumaier") return neumaier_sum<T>(x, a.size);
+        if (a.variant == "binned") return binned_sum<T>(x, a.size, threads);
+        if (stats) { st = fused_stats<T>(x, a.size, threads, y); return st.total(); }
+        return kahan_sum<T>(x, a.size);
+    };
+
+    const Measurement m = measure(measure_options(a), [&] { sink = run(); });
+    double t_med = m.stats.median;
+
+    // stats: add, min, max, fma for x·y, and the deviation sweep's sub + fma.
+    double flops = stats ? 6.0 * (double)a.size : (double)a.size - 1.0;
+    double gflops = (flops / t_med) / 1e9;
+    double bytes = sizeof(T) * (double)a.size * (stats ? 2 : 1);
+    double gbps = (bytes / t_med) / 1e9;
+    double chk = (double)sink;
+    const double exact = exact_sum<T>(x, a.size);
+    const double err = std::abs(chk - exact) / (exact != 0 ? std::abs(exact) : 1.0);
+
+    Row r = result_row(ctx, a, label, threads, isa, m);
+    r.set("size", a.size).set("gflops", gflops).set("gbps", gbps).set("checksum", chk)
+     .set("rel_error", err);
+    emit(ctx, a, r, label, a.size, threads, isa, m);
+
+    std::cout << "[" << label << "] median " << (t_med * 1e3) << " ms, "
+              << gflops << " GF/s, " << gbps << " GB/s, checksum=" << chk
+              << ", rel_error=" << err << ", isa=" << isa << "\n";
+    if (stats)
+        std::cout << "  min " << st.min << ", max " << st.max << ", mean " << st.mean
+                  << ", variance " << st.variance() << ", dot " << st.dot_value() << "\n";
+    print_stats(m);
+    print_perf(m.counters);
+}
+
+/// Offsets of segments covering [0, n) with lengths of mean len drawn from
+/// dist: fixed, uniform on [0, 2 len], geometric, or powerlaw (Pareto with
+/// alpha = 2, so a few long segments hold much of the data). Seeded from seed.
+static std::vector<size_t> segment_offsets(size_t n, const std::string& dist, size_t len, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    const double mean = (double)std::max<size_t>(len, 1);
+    std::uniform_int_distribution<size_t> uniform(0, 2 * (size_t)mean);
+    std::geometric_distribution<size_t> geometric(1.0 / (mean + 1.0));
+    std::uniform_real_distribution<double> u01(0.0, 1.0);
+    auto draw = [&]() -> size_t {
+        if (dist == "fixed") return (size_t)mean;
+        if (dist == "uniform") return uniform(rng);
+        if (dist == "geometric") return geometric(rng);
+        if (dist == "powerlaw") return (size_t)(0.5 * mean / std::sqrt(1.0 - u01(rng)));
+        std::cerr << "Unknown --segments: " << dist << "\n";
+        std::exit(2);
+    };
+    std::vector<size_t> off = {0};
+    while (off.back() < n) off.push_back(std::min(n, off.back() + draw()));
+    return off;
 }
 
 template <class T>
-void bench_scan(const Args& a) {
+void bench_scan(const Args& a, BenchContext& ctx) {
     using namespace hpc;
 
-    auto x = make_random<T>(a.size, a.seed);
+    BufferCache<T>& bufs = ctx.buffers<T>();
+    const T* x = bufs.random(in0, a.size, a.seed, buffer_options<T>(a, in0));
 
-    // warm-up
-    inclusive_scan_inplace<T>(x);
+    // "scan" keeps the original label for the serial in-place baseline.
+    const bool serial = a.variant == "serial";
+    const bool segmented = a.variant == "segmented" || a.variant == "segmented_flags";
+    const bool rows = a.variant == "rows";
+    std::string label = serial ? "scan" : "scan_" + a.variant;
+    if (segmented) label += "_" + a.segments + std::to_string(a.seg_len);
+    if (rows) label += std::to_string(a.seg_len);
+    const size_t threads = serial ? 1 : a.threads;
+    const char* isa = kernel_isa(true);
 
-    // measure
-    std::vector<double> times(a.reps);
+    // Parallel variants scan out of place into y. The serial in-place
+    // baseline refreshes y from x before each rep, outside the timed region.
+    T* y = bufs.scratch(out, a.size, buffer_options<T>(a, out));
 
-    for (int r = 0; r < a.reps; ++r) {
-        auto tmp = x; // fresh copy each rep to simulate write traffic
-        Timer t; t.start();
-        inclusive_scan_inplace<T>(tmp);
-        times[r] = t.stop_s();
+    std::vector<size_t> offsets;
+    std::vector<std::uint8_t> heads;
+    double index_bytes = 0;
+    if (segmented) {
+        offsets = segment_offsets(a.size, a.segments, a.seg_len, a.seed);
+        if (a.variant == "segmented_flags") {
+            heads.assign(a.size, 0);
+            for (size_t s = 0; s + 1 < offsets.size(); ++s)
+                if (offsets[s] < a.size) heads[offsets[s]] = 1;
+            index_bytes = (double)a.size;
+        } else {
+            index_bytes = sizeof(size_t) * (double)offsets.size();
+        }
     }
+    const size_t cols = std::max<size_t>(1, std::min(a.seg_len, a.size));
+    const size_t nrows = a.size / cols;
 
-    std::sort(times.begin(), times.end());
-    double t_med = times[times.size() / 2];
+    auto run = [&]() {
+        if (a.variant == "parallel") inclusive_scan<T>(x, y, a.size, threads);
+        else if (a.variant == "parallel_exclusive") exclusive_scan<T>(x, y, a.size, threads);
+        else if (a.variant == "lookback") inclusive_scan_lookback<T>(x, y, a.size, threads);
+        else if (a.variant == "segmented")
+            segmented_inclusive_scan<T>(x, y, a.size, offsets.data(), offsets.size() - 1, threads);
+        else if (a.variant == "segmented_flags")
+            segmented_inclusive_scan_flags<T>(x, y, a.size, heads.data(), threads);
+        else if (rows) inclusive_scan_rows<T>(x, cols, y, cols, nrows, cols, threads);
+    };
 
-    double flops  = (double)a.size; // approx
+    const Measurement m = serial
+        ? measure(measure_options(a),
+                  [&] { std::copy(x, x + a.size, y); }, // fresh data each rep
+                  [&] { inclusive_scan<T>(y, y, a.size); })
+        : measure(measure_options(a), run);
+    double t_med = m.stats.median;
+
+    const size_t done = rows ? nrows * cols : a.size;
+    double flops  = (double)done; // approx; also elements/s
     double gflops = (flops / t_med) / 1e9;
-    double bytes  = sizeof(T) * 2.0 * (double)a.size; // read+write
+    double bytes  = sizeof(T) * 2.0 * (double)done + index_bytes; // read+write (+ offsets / flags)
     double gbps   = (bytes / t_med) / 1e9;
-    double chk    = std::accumulate(x.begin(), x.end(), 0.0);
+    double chk    = std::accumulate(y, y + done, 0.0); // last scan
 
-    std::time_t ts = std::time(nullptr);
+    Row r = result_row(ctx, a, label, threads, isa, m);
+    r.set("size", a.size).set("gflops", gflops).set("gbps", gbps).set("checksum", chk);
+    emit(ctx, a, r, label, a.size, threads, isa, m);
 
-    csv_write_header_if_new(a.out,
-        "timestamp,op,M,N,K,size,dtype,reps,ns_per_rep,gflops,gbps,checksum");
+    std::cout << "[" << label << "] median " << (t_med * 1e3) << " ms, "
+              << gflops << " GF/s, " << gbps << " GB/s, checksum=" << chk
+              << ", isa=" << isa << "\n";
+    if (segmented || rows)
+        std::cout << "  " << (rows ? nrows : offsets.size() - 1) << " segments, "
+                  << (double)done / t_med / 1e6 << " M elements/s\n";
+    print_stats(m);
+    print_perf(m.counters);
+}
 
-    char line[512];
+/// Square CSR matrix of about nnz nonzeros whose row lengths follow the
+/// Pareto law of segment_offsets (alpha = 2, mean row_nnz): a few rows
+/// hold much of the matrix. Columns are uniform and distinct per row,
+/// values uniform in [-1, 1). Seeded from seed.
+template <class T>
+static hpc::CsrMatrix<T> powerlaw_matrix(size_t nnz, size_t row_nnz, unsigned seed) {
+    hpc::CsrMatrix<T> A;
+    const double mean = (double)std::max<size_t>(row_nnz, 1);
+    A.rows = A.cols = std::max<size_t>(1, nnz / (size_t)mean);
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> u01(0.0, 1.0);
 
-    std::snprintf(line, sizeof(line),
-        "%lld,scan,0,0,0,%zu,%s,%d,%.0f,%.6f,%.6f,%.17g",
-        (long long)ts, a.size, a.dtype.c_str(), a.reps,
-        t_med * 1e9, gflops, gbps, chk);
+    A.row_ptr.assign(A.rows + 1, 0);
+    for (size_t r = 0; r < A.rows; ++r)
+        A.row_ptr[r + 1] = std::min(A.cols, (size_t)(0.5 * mean / std::sqrt(1.0 - u01(rng))));
+    hpc::inclusive_scan_inplace(A.row_ptr);
 
-    csv_append_line(a.out, line);
+    A.col.resize(A.row_ptr.back());
+    A.val.resize(A.row_ptr.back());
+    std::uniform_int_distribution<std::uint32_t> column(0, (std::uint32_t)(A.cols - 1));
+    for (size_t r = 0; r < A.rows; ++r) {
+        std::uint32_t* c = A.col.data() + A.row_ptr[r];
+        const size_t len = A.row_ptr[r + 1] - A.row_ptr[r];
+        for (size_t k = 0; k < len; ++k) c[k] = column(rng);
+        std::sort(c, c + len);
+        // Make the sorted draws distinct while keeping them inside [0, cols).
+        for (size_t k = 1; k < len; ++k) c[k] = std::max(c[k], c[k - 1] + 1);
+        for (size_t k = 0; k < len; ++k) c[k] = std::min(c[k], (std::uint32_t)(A.cols - len + k));
+        for (size_t k = 0; k < len; ++k) A.val[A.row_ptr[r] + k] = (T)(2.0 * u01(rng) - 1.0);
+    }
+    return A;
+}
 
-    std::cout << "[scan] median " << (t_med * 1e3) << " ms, "
-              << gflops << " GF/s, " << gbps << " GB/s, checksum=" << chk << "\n";
+template <class T>
+void bench_spmv(const Args& a, BenchContext& ctx) {
+    using namespace hpc;
+
+    // The matrix outlives the point, so thread / variant sweeps build it once.
+    static CsrMatrix<T> A;
+    static std::string key;
+    const std::string want = a.matrix.empty()
+        ? "powerlaw:" + std::to_string(a.size) + ":" + std::to_string(a.row_nnz) + ":" + std::to_string(a.seed)
+        : a.matrix;
+    if (key != want) {
+        A = a.matrix.empty() ? powerlaw_matrix<T>(a.size, a.row_nnz, a.seed) : read_matrix_market<T>(a.matrix);
+        key = want;
+    }
+
+    const bool spmm_variant = a.variant == "spmm";
+    const size_t n = spmm_variant ? std::max<size_t>(a.rhs, 1) : 1;
+    std::string label = a.variant + "_";
+    label += a.matrix.empty() ? "powerlaw" + std::to_string(a.row_nnz)
+                              : std::filesystem::path(a.matrix).stem().string();
+    const char* isa = kernel_isa(true);
+
+    BufferCache<T>& bufs = ctx.buffers<T>();
+    const T* x = bufs.random(in0, A.cols * n, a.seed, buffer_options<T>(a, in0));
+    T* y = bufs.scratch(out, A.rows * n, buffer_options<T>(a, out));
+
+    auto run = [&]() {
+        if (spmm_variant) spmm(A, x, n, n, y, n, a.threads);
+        else spmv(A, x, y, a.threads);
+    };
+    const Measurement m = measure(measure_options(a), run);
+    double t_med = m.stats.median;
+
+    // Effective bandwidth: values, column indices and row pointers once, plus
+    // the dense operands read and written once each (cache reuse of x not credited).
+    const double nnz = (double)A.nnz();
+    double bytes  = nnz * (sizeof(T) + sizeof(std::uint32_t)) + sizeof(size_t) * (double)(A.rows + 1)
+                  + sizeof(T) * (double)n * (double)(A.rows + A.cols);
+    double gbps   = (bytes / t_med) / 1e9;
+    double gflops = (2.0 * nnz * (double)n / t_med) / 1e9;
+    double chk    = std::accumulate(y, y + A.rows * n, 0.0);
+
+    Row r = result_row(ctx, a, label, a.threads, isa, m);
+    r.set("M", A.rows).set("N", n).set("K", A.cols).set("size", A.nnz())
+     .set("gflops", gflops).set("gbps", gbps).set("checksum", chk);
+    emit(ctx, a, r, label, A.nnz(), a.threads, isa, m);
+
+    std::cout << "[" << label << "] " << A.rows << "x" << A.cols << ", nnz " << A.nnz()
+              << ", median " << (t_med * 1e3) << " ms, " << gflops << " GF/s, "
+              << gbps << " GB/s, checksum=" << chk << ", isa=" << isa << "\n";
+    print_stats(m);
+    print_perf(m.counters);
 }
 
-int main(int argc, char** argv) {
-    auto a = parse(argc, argv);
-    bool is_float = (a.dtype == "float");
+/// C = A·B (matmul_blocked tiles), then sum(C) (Kahan chunks) and an
+/// inclusive scan of C. "graph" runs the three as one TaskGraph, so sum and
+/// scan blocks start as the row blocks of C they read complete; "barrier"
+/// runs them back to back, each call a fork-join over the pool. Same tiles,
+/// chunks and blocks in both.
+template <class T>
+void bench_pipeline(const Args& a, BenchContext& ctx) {
+    using namespace hpc;
+
+    BufferCache<T>& bufs = ctx.buffers<T>();
+    const T* A = bufs.random(in0, a.M * a.K, a.seed, buffer_options<T>(a, in0));
+    const T* B = bufs.random(in1, a.K * a.N, a.seed + 1, buffer_options<T>(a, in1));
+    T* C = bufs.scratch(out, 2 * a.M * a.N, buffer_options<T>(a, out));
+    T* S = C + a.M * a.N;
+    const size_t n = a.M * a.N;
+
+    const bool graph = a.variant == "graph";
+    const std::string label = "pipeline_" + a.variant;
+    const char* isa = kernel_isa(true);
+    T sum = 0;
+
+    TaskGraph full, gemm_only;
+    const TaskRanges c_parts = matmul_blocked_tasks<T>(full, a.M, a.N, a.K, A, a.K, B, a.N, C, a.N);
+    kahan_sum_tasks<T>(full, C, n, &sum, c_parts);
+    inclusive_scan_tasks<T>(full, C, S, n, c_parts);
+    matmul_blocked_tasks<T>(gemm_only, a.M, a.N, a.K, A, a.K, B, a.N, C, a.N);
+
+    auto run = [&]() {
+        if (graph) {
+            full.run(a.threads);
+        } else {
+            gemm_only.run(a.threads);
+            sum = kahan_sum_parallel<T>(C, n, a.threads);
+            inclusive_scan<T>(C, S, n, a.threads);
+        }
+    };
+    const Measurement m = measure(measure_options(a), run);
+    double t_med = m.stats.median;
+
+    double flops  = 2.0 * (double)a.M * (double)a.N * (double)a.K + 2.0 * (double)n;
+    double gflops = (flops / t_med) / 1e9;
+    double bytes  = sizeof(T) * ((double)a.M * a.K + (double)a.K * a.N + 4.0 * (double)n); // C out, sum and scan read it, S out
+    double gbps   = (bytes / t_med) / 1e9;
+    double chk    = (double)sum + (double)S[n ? n - 1 : 0];
+
+    Row r = result_row(ctx, a, label, a.threads, isa, m);
+    r.set("M", a.M).set("N", a.N).set("K", a.K).set("size", n)
+     .set("gflops", gflops).set("gbps", gbps).set("checksum", chk);
+    emit(ctx, a, r, label, n, a.threads, isa, m);
+
+    std::cout << "[" << label << "] M=" << a.M << " N=" << a.N << " K=" << a.K
+              << " median " << (t_med * 1e3) << " ms, " << gflops << " GF/s, checksum=" << chk
+              << ", tasks=" << (graph ? full.size() : gemm_only.size()) << ", isa=" << isa << "\n";
+    print_stats(m);
+    print_perf(m.counters);
+}
+
+#if defined(HPC_WITH_MPI)
+static int mpi_rank() {
+    int r = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &r);
+    return r;
+}
+
+static int mpi_size() {
+    int n = 1;
+    MPI_Comm_size(MPI_COMM_WORLD, &n);
+    return n;
+}
+
+/// --op=mpi, run under mpiexec: "summa" is summa_gemm on a --layers grid,
+/// "allreduce" kahan_allreduce and "scan" distributed_inclusive_scan. Sizes
+/// are global (strong scaling), or with --weak per rank: --size elements on
+/// every rank, and M×pr, N×pc, K×layers for summa so each rank keeps an
+/// M×N block of C and the same flops. adaptive measure() could stop at a
+/// different rep on each rank, so there is one warm-up and a fixed --reps,
+/// each rep starting at a barrier and timed as the slowest rank. Rank 0
+/// writes one row per rank with that rank's compute / communication split.
+template <class T>
+void bench_mpi(const Args& a, BenchContext& ctx) {
+    using namespace hpc;
+
+    const int rank = mpi_rank(), P = mpi_size();
+    const std::string label = "mpi_" + a.variant;
+    const char* isa = kernel_isa(true);
+    BufferCache<T>& bufs = ctx.buffers<T>();
+    const unsigned seed = a.seed + 3u * unsigned(rank); // in0, in1, aux seeds of each rank stay apart
+
+    size_t M = a.M, N = a.N, K = a.K, n = 0, local = 0;
+    double flops = 0, bytes = 0;
+    std::unique_ptr<ProcessGrid> grid;
+    std::function<MpiTimes()> run;
+    const T* x = nullptr;
+    T* y = nullptr;
+    T sum = 0;
+
+    if (a.variant == "summa") {
+        grid = std::make_unique<ProcessGrid>(MPI_COMM_WORLD, a.layers);
+        if (a.weak) { M *= size_t(grid->pr); N *= size_t(grid->pc); K *= size_t(a.layers); }
+        const SummaBlocks b = summa_blocks(*grid, M, N, K);
+        const size_t m = b.rows.second - b.rows.first, nc = b.cols.second - b.cols.first;
+        const size_t ka = b.a_cols.second - b.a_cols.first, kr = b.b_rows.second - b.b_rows.first;
+        const T* A = bufs.random(in0, m * ka, seed, buffer_options<T>(a, in0));
+        const T* B = bufs.random(in1, kr * nc, seed + 1, buffer_options<T>(a, in1));
+        y = bufs.scratch(out, m * nc, buffer_options<T>(a, out));
+        local = m * nc;
+        n = M * N;
+        flops = 2.0 * (double)M * (double)N * (double)K;
+        run = [&, A, B, ka, nc]() {
+            return summa_gemm<T>(*grid, M, N, K, T(1), A, ka, B, nc, T(0), y, nc, a.threads);
+        };
+    } else {
+        n = a.weak ? a.size * size_t(P) : a.size;
+        const auto r = split_range(n, size_t(P), size_t(rank));
+        local = r.second - r.first;
+        x = bufs.random(in0, local, seed, buffer_options<T>(a, in0));
+        if (a.variant == "allreduce") {
+            flops = (double)n;
+            bytes = sizeof(T) * (double)n;
+            run = [&]() {
+                MpiTimes t;
+                sum = kahan_allreduce<T>(x, local, MPI_COMM_WORLD, a.threads, &t);
+                return t;
+            };
+        } else {
+            y = bufs.scratch(out, local, buffer_options<T>(a, out));
+            flops = (double)n;
+            bytes = 3.0 * sizeof(T) * (double)n; // sum pass, then scan read and write
+            run = [&]() {
+                MpiTimes t;
+                distributed_inclusive_scan<T>(x, y, local, MPI_COMM_WORLD, a.threads, &t);
+                return t;
+            };
+        }
+    }
+
+    MpiTimes warm, total;
+    auto rep = [&](MpiTimes& acc) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        const double t0 = MPI_Wtime();
+        acc += run();
+        double dt = MPI_Wtime() - t0;
+        MPI_Allreduce(MPI_IN_PLACE, &dt, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        return dt;
+    };
+    Measurement m;
+    m.warmup.push_back(rep(warm));
+    for (int i = 0; i < std::max(a.reps, 1); ++i) m.times.push_back(rep(total));
+    m.stable = true;
+    m.stats = timing_stats(m.times);
+    const double t_med = m.stats.median;
+    const double nreps = (double)m.times.size();
+
+    double chk = a.variant == "allreduce" ? (double)sum : checksum_vec(y, local);
+    if (a.variant != "allreduce") MPI_Allreduce(MPI_IN_PLACE, &chk, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+    // Per rank: compute and communication seconds per rep.
+    const double mine[2] = {total.compute / nreps, total.comm / nreps};
+    std::vector<double> split(2 * size_t(P));
+    MPI_Gather(mine, 2, MPI_DOUBLE, split.data(), 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (rank != 0) return;
+
+    const double gflops = (flops / t_med) / 1e9;
+    const double gbps = (bytes / t_med) / 1e9;
+    const bool summa = a.variant == "summa";
+    for (int r = 0; r < P; ++r) {
+        Row row = result_row(ctx, a, label, a.threads, isa, m);
+        row.set("M", summa ? M : 0).set("N", summa ? N : 0).set("K", summa ? K : 0).set("size", n)
+           .set("gflops", gflops).set("checksum", chk)
+           .set("rank", r).set("ranks", P)
+           .set("compute_ns", split[2 * r] * 1e9).set("comm_ns", split[2 * r + 1] * 1e9);
+        if (!summa) row.set("gbps", gbps);
+        emit(ctx, a, row, label, n, a.threads, isa, m);
+    }
+
+    std::cout << "[" << label << "] ranks=" << P;
+    if (summa) std::cout << " grid=" << grid->pr << "x" << grid->pc << "x" << grid->layers
+                         << " M=" << M << " N=" << N << " K=" << K;
+    else std::cout << " n=" << n;
+    std::cout << (a.weak ? " (weak)" : "") << " median " << (t_med * 1e3) << " ms, " << gflops << " GF/s";
+    if (!summa) std::cout << ", " << gbps << " GB/s";
+    std::cout << ", checksum=" << chk << ", isa=" << isa << "\n";
+    for (int r = 0; r < P; ++r)
+        std::cout << "  rank " << r << ": compute " << split[2 * r] * 1e3 << " ms, comm "
+                  << split[2 * r + 1] * 1e3 << " ms\n";
+    print_stats(m);
+}
+#endif
+
+/// Variants of op, default first; empty for unknown ops.
+static std::vector<std::string> op_variants(const std::string& op) {
+    if (op == "matmul") return {"naive", "blocked", "packed", "fixed", "strassen", "unfused", "dot", "stream"};
+    if (op == "matmul_batched") return {"strided", "pointers", "shared_b"};
+    if (op == "reduction") return {"serial", "simd", "parallel", "pairwise", "neumaier", "binned", "stats"};
+    if (op == "scan") return {"serial", "parallel", "parallel_exclusive", "lookback", "segmented",
+                              "segmented_flags", "rows", "stream"};
+    if (op == "spmv") return {"spmv", "spmm"};
+    if (op == "pipeline") return {"graph", "barrier"};
+#if defined(HPC_WITH_MPI)
+    if (op == "mpi") return {"summa", "allreduce", "scan"};
+#endif
+    return {};
+}
+
+static bool is_segmented(const std::string& variant) {
+    return variant == "segmented" || variant == "segmented_flags";
+}
+
+/// Whether the variant runs on more than one thread; others are swept at 1.
+static bool uses_threads(const std::string& op, const std::string& variant) {
+    if (op == "matmul") {
+#if defined(_OPENMP)
+        if (variant == "blocked") return true;
+#endif
+        return variant == "packed" || variant == "dot" || variant == "unfused" || variant == "strassen"
+            || variant == "stream";
+    }
+    if (op == "matmul_batched") return true;
+    if (op == "reduction") return variant == "parallel" || variant == "binned" || variant == "stats";
+    return variant != "serial";
+}
+
+/// Every point of the sweep, ordered dtype > op > variant > isa > threads >
+/// batch > crossover > segments > seg_len > shape. --variant lists apply per op to the names that op knows.
+static std::vector<Args> expand(const Args& base, const Sweep& sw) {
+    std::vector<Args> pts;
+    for (const std::string& v : sw.variants) {
+        bool known = false;
+        for (const std::string& op : sw.ops) {
+            const auto vs = op_variants(op);
+            known = known || std::find(vs.begin(), vs.end(), v) != vs.end();
+        }
+        if (!known) {
+            std::cerr << "Unknown --variant: " << v << "\n";
+            std::exit(2);
+        }
+    }
+
+    struct Shape { size_t M, N, K; };
+    std::vector<Shape> shapes;
+    if (!sw.MNK.empty()) {
+        for (size_t n : sw.MNK) shapes.push_back({n, n, n});
+    } else {
+        for (size_t m : sw.M) for (size_t n : sw.N) for (size_t k : sw.K) shapes.push_back({m, n, k});
+    }
+    const std::vector<std::string> isas = sw.isas.empty() ? std::vector<std::string>{""} : sw.isas;
+
+    for (const std::string& dtype : sw.dtypes) {
+        const bool half = dtype == "bf16" || dtype == "fp16";
+        const bool narrow = half || dtype == "int8";
+        if (dtype != "float" && dtype != "double" && !narrow) {
+            std::cerr << "Unknown --dtype: " << dtype << "\n";
+            std::exit(2);
+        }
+        for (const std::string& op : sw.ops) {
+            auto known = op_variants(op);
+            if (known.empty() && op == "mpi") {
+                std::cerr << "--op=mpi needs a build with -DHPC_MPI=ON\n";
+                std::exit(2);
+            }
+            if (known.empty()) {
+                std::cerr << "Unknown --op: " << op << "\n";
+                std::exit(2);
+            }
+            // Narrow types only have their packed GEMMs; dot is bf16/fp16 only,
+            // unfused needs --epilogue and stream needs --input.
+            auto drop = [&](const char* v) { known.erase(std::remove(known.begin(), known.end(), v), known.end()); };
+            if (narrow) {
+                if (op != "matmul") {
+                    std::cerr << "--dtype=" << dtype << " needs --op=matmul\n";
+                    std::exit(2);
+                }
+                known = half ? std::vector<std::string>{"packed", "dot"} : std::vector<std::string>{"packed"};
+            } else if (!base.input.empty()) {
+                known = {"stream"};
+            } else {
+                drop("dot");
+                drop("stream");
+                if (base.epilogue.empty()) drop("unfused");
+                else known = {"packed", "unfused"};
+            }
+            if (!base.epilogue.empty() && (op != "matmul" || narrow || !base.input.empty())) {
+                std::cerr << "--epilogue needs --op=matmul and --dtype=float|double (in memory)\n";
+                std::exit(2);
+            }
+            if (!base.input.empty() && ((op != "matmul" && op != "scan") || narrow)) {
+                std::cerr << "--input needs --op=matmul|scan and --dtype=float|double\n";
+                std::exit(2);
+            }
+            std::vector<std::string> variants;
+            for (const std::string& v : sw.variants) {
+                if (std::find(known.begin(), known.end(), v) != known.end()) variants.push_back(v);
+            }
+            if (variants.empty()) variants = {known.front()};
 
-    if (a.op == "matmul") {
-        if (is_float) bench_matmul<float>(a);
-        else bench_matmul<double>(a);
+            const bool gemm = op == "matmul" || op == "matmul_batched" || op == "pipeline";
+            const std::vector<size_t> batches = op == "matmul_batched" ? sw.batch : std::vector<size_t>{base.batch};
+
+            for (const std::string& variant : variants)
+            for (const std::string& isa : isas)
+            for (size_t threads : uses_threads(op, variant) ? sw.threads : std::vector<size_t>{1})
+            for (size_t batch : batches)
+            for (size_t crossover : variant == "strassen" ? sw.crossover : std::vector<size_t>{0})
+            for (const std::string& segments : is_segmented(variant) ? sw.segments : std::vector<std::string>{base.segments})
+            for (size_t seg_len : is_segmented(variant) || variant == "rows" ? sw.seg_len : std::vector<size_t>{base.seg_len}) {
+                Args a = base;
+                a.op = op;
+                a.variant = variant;
+                a.dtype = dtype;
+                a.isa = isa;
+                a.threads = threads;
+                a.batch = batch;
+                a.crossover = crossover;
+                a.segments = segments;
+                a.seg_len = seg_len;
+                if (gemm || variant == "summa") {
+                    for (const Shape& sh : shapes) {
+                        a.M = sh.M; a.N = sh.N; a.K = sh.K;
+                        pts.push_back(a);
+                    }
+                } else {
+                    for (size_t n : sw.size) {
+                        a.size = n;
+                        pts.push_back(a);
+                    }
+                }
+            }
+        }
+    }
+    return pts;
+}
+
+/// Run metadata next to a results file: results.csv -> results.runs.jsonl.
+static std::string runs_path(const std::string& out) {
+    return std::filesystem::path(out).replace_extension(".runs.jsonl").string();
+}
+
+static void run_point(const Args& a, BenchContext& ctx) {
+    if (!a.isa.empty()) {
+        hpc::Isa isa = hpc::Isa::scalar;
+        hpc::parse_isa(a.isa.c_str(), isa);
+        hpc::set_active_isa(isa);
+    }
+    const bool is_float = a.dtype == "float";
+    if (!a.input.empty()) {
+        if (is_float) bench_stream<float>(a, ctx);
+        else bench_stream<double>(a, ctx);
+    } else if (a.op == "matmul") {
+        if (a.dtype == "bf16") bench_matmul_mixed<hpc::bf16>(a, ctx);
+        else if (a.dtype == "fp16") bench_matmul_mixed<hpc::fp16>(a, ctx);
+        else if (a.dtype == "int8") bench_matmul_int8(a, ctx);
+        else if (!a.epilogue.empty()) {
+            if (is_float) bench_matmul_epilogue<float>(a, ctx);
+            else bench_matmul_epilogue<double>(a, ctx);
+        }
+        else if (is_float) bench_matmul<float>(a, ctx);
+        else bench_matmul<double>(a, ctx);
+    } else if (a.op == "matmul_batched") {
+        if (is_float) bench_matmul_batched<float>(a, ctx);
+        else bench_matmul_batched<double>(a, ctx);
     } else if (a.op == "reduction") {
-        if (is_float) bench_reduction<float>(a);
-        else bench_reduction<double>(a);
-    } else if (a.op == "scan") {
-        if (is_float) bench_scan<float>(a);
-        else bench_scan<double>(a);
+        if (is_float) bench_reduction<float>(a, ctx);
+        else bench_reduction<double>(a, ctx);
+    } else if (a.op == "pipeline") {
+        if (is_float) bench_pipeline<float>(a, ctx);
+        else bench_pipeline<double>(a, ctx);
+    } else if (a.op == "spmv") {
+        if (is_float) bench_spmv<float>(a, ctx);
+        else bench_spmv<double>(a, ctx);
+#if defined(HPC_WITH_MPI)
+    } else if (a.op == "mpi") {
+        if (is_float) bench_mpi<float>(a, ctx);
+        else bench_mpi<double>(a, ctx);
+#endif
     } else {
-        std::cerr << "Unknown --op: " << a.op << "\n";
+        if (is_float) bench_scan<float>(a, ctx);
+        else bench_scan<double>(a, ctx);
+    }
+}
+
+int main(int argc, char** argv) {
+    Sweep sw;
+    auto a = parse(argc, argv, sw);
+
+#if defined(HPC_WITH_MPI)
+    // Every rank runs every point (non-mpi ops independently); rank 0 alone
+    // prints and writes the output files.
+    struct MpiSession {
+        MpiSession(int& argc, char**& argv) { MPI_Init(&argc, &argv); }
+        ~MpiSession() { MPI_Finalize(); }
+    } mpi_session(argc, argv);
+    const bool rank0 = mpi_rank() == 0;
+    if (!rank0) std::cout.rdbuf(nullptr);
+    if (a.layers < 1 || mpi_size() % a.layers != 0) {
+        if (rank0) std::cerr << "--layers=" << a.layers << " must divide the " << mpi_size() << " ranks\n";
+        return 2;
+    }
+#else
+    const bool rank0 = true;
+#endif
+
+    if (a.perf && !perf_counters().open()) {
+        std::cerr << "[warn] --perf: no hardware counters available (perf_event_paranoid, "
+                     "virtualised PMU or non-Linux); counter columns stay empty\n";
+    }
+
+    // Pin after the counters are open (they follow threads created later).
+    std::vector<int> cpus;
+    if (!hpc::parse_bind(a.bind, hpc::topology(), cpus)) {
+        std::cerr << "Unknown --bind or cpus outside this process's mask: " << a.bind << "\n";
         return 2;
     }
+    if (!cpus.empty()) {
+        hpc::default_pool().set_affinity(cpus);
+        std::cout << "[bind] " << a.bind << ":";
+        for (int c : cpus) std::cout << " " << c;
+        std::cout << "\n";
+        if (*std::max_element(sw.threads.begin(), sw.threads.end()) > cpus.size())
+            std::cerr << "[warn] --bind: more threads than cpus, threads share cpus\n";
+    }
+
+    if (a.autotune) {
+        if (sw.ops.size() != 1 || sw.ops[0] != "matmul") {
+            std::cerr << "--autotune needs --op=matmul\n";
+            return 2;
+        }
+        a.threads = sw.threads.front();
+        for (const std::string& name : sw.isas.empty() ? std::vector<std::string>{""} : sw.isas) {
+            hpc::Isa isa = hpc::Isa::scalar;
+            if (hpc::parse_isa(name.c_str(), isa)) hpc::set_active_isa(isa);
+            run_autotune(a);
+        }
+        return 0;
+    }
+    if (!a.tune_file.empty()) hpc::tuning().load(a.tune_file);
+
+    const std::vector<Args> points = expand(a, sw);
+
+    // One open sink per output for the whole run and the host metadata once,
+    // in <out stem>.runs.jsonl; buffers sized for the largest point.
+    hpc::ResultFormat fmt = hpc::result_format_for(a.out);
+    if (!a.format.empty() && !hpc::parse_result_format(a.format, fmt)) {
+        std::cerr << "Unknown --format: " << a.format << "\n";
+        return 2;
+    }
+    BenchContext ctx;
+    auto meta = hpc::host_metadata();
+    ctx.run_id = meta.front().second;
+    std::string cmd;
+    for (int i = 0; i < argc; ++i) cmd += (i ? " " : "") + std::string(argv[i]);
+    meta.push_back({"command", cmd});
+    if (rank0) try {
+        ctx.results = std::make_unique<hpc::ResultSink>(a.out, results_schema(), fmt);
+        if (!a.raw_out.empty()) {
+            ctx.raw = std::make_unique<hpc::ResultSink>(a.raw_out, raw_schema(),
+                                                        hpc::result_format_for(a.raw_out));
+        }
+        hpc::write_metadata_line(runs_path(a.out), meta);
+    } catch (const std::exception& e) {
+        std::cerr << "hpc_bench: " << e.what() << "\n";
+        return 2;
+    }
+    for (const Args& p : points) {
+        const auto need = buffer_need(p);
+        for (int r = 0; r < role_count; ++r) ctx.reserve(p.dtype, static_cast<Role>(r), need[r]);
+    }
+
+    hpc::Timer total; total.start();
+    if (points.size() > 1) std::cout << "[sweep] " << points.size() << " points\n";
+    for (size_t i = 0; i < points.size(); ++i) {
+        // Points are grouped by dtype: drop the other type's buffers on the switch.
+        if (i > 0 && points[i].dtype != points[i - 1].dtype) ctx.keep_only(points[i].dtype);
+        run_point(points[i], ctx);
+        if (ctx.results) ctx.results->flush();
+        if (ctx.raw) ctx.raw->flush();
+    }
+    if (points.size() > 1) std::cout << "[sweep] done in " << total.stop_s() << " s\n";
 
     return 0;
 }
@@ -0,0 +1,570 @@
+// hpc_perf_suite: a fixed matrix of kernels, sizes, dtypes and thread counts
+// measured with the harness and compared case by case against a stored
+// per-host baseline (hpc/regression.hpp). Writes a report in the results
+// format plot_bench.py reads, an SVG roofline of the run, and exits 1 when
+// any case got significantly slower.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cctype>
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+#include "hpc/matmul.hpp"
+#include "hpc/matmul_packed.hpp"
+#include "hpc/reduction.hpp"
+#include "hpc/scan.hpp"
+#include "hpc/sparse.hpp"
+#include "hpc/thread_pool.hpp"
+#include "hpc/dispatch.hpp"
+#include "hpc/harness.hpp"
+#include "hpc/results.hpp"
+#include "hpc/regression.hpp"
+#include "hpc/rand.hpp"
+
+namespace {
+
+struct Options {
+    std::string baseline;                // baseline file (default: <baseline_dir>/<host>.csv)
+    std::string baseline_dir = "perf/baselines";
+    std::string report = "perf_report.csv"; // this run's results and verdicts
+    std::string roofline;                // SVG roofline (default: <report stem>.roofline.svg)
+    bool update = false;                 // replace the baseline with this run
+    std::string filter;                  // run only cases whose name contains this
+    size_t threads = 0;                  // thread count of the threaded cases (0: all hardware threads)
+    size_t rounds = 3;                   // passes over the matrix (samples drift between them)
+    size_t reps = 10;                    // minimum timed reps per case and round
+    double min_time = 0.1;               // seconds of timed reps per case and round, at least
+    hpc::RegressionOptions cmp;
+};
+
+/// One point of the fixed matrix. prepare() allocates the inputs and returns
+/// the timed call, which owns them; flops / bytes are model counts per call.
+struct Case {
+    std::string name; // op/dtype/size/tN, the baseline key
+    std::string op, dtype;
+    size_t M = 0, N = 0, K = 0, size = 0, threads = 1;
+    double flops = 0, bytes = 0;
+    std::function<std::function<void()>()> prepare;
+};
+
+/// Rep times of a case per round, and their pooled summary.
+struct Result {
+    const Case* c = nullptr;
+    std::vector<std::vector<double>> rounds;
+    hpc::TimingStats stats;
+    hpc::TimingComparison cmp;
+    bool has_base = false;
+    hpc::Verdict verdict = hpc::Verdict::missing;
+    double p_slower_adj = 1.0, p_faster_adj = 1.0;
+};
+
+bool starts_with(const char* s, const char* k) {
+    return std::strncmp(s, k, std::strlen(k)) == 0;
+}
+
+/// Whole-string numbers; a bad or partly numeric value throws std::invalid_argument.
+size_t to_count(const char* s) {
+    size_t pos = 0;
+    const size_t v = std::stoull(s, &pos);
+    if (s[pos] != '\0' || std::strchr(s, '-')) throw std::invalid_argument(s);
+    return v;
+}
+
+double to_real(const char* s) {
+    size_t pos = 0;
+    const double v = std::stod(s, &pos);
+    if (s[pos] != '\0') throw std::invalid_argument(s);
+    return v;
+}
+
+template <class T>
+const char* dtype_name() { return std::is_same<T, float>::value ? "float" : "double"; }
+
+std::string case_name(const std::string& op, const char* dtype, size_t size, size_t threads) {
+    return op + "/" + dtype + "/" + std::to_string(size) + "/t" + std::to_string(threads);
+}
+
+template <class T>
+std::shared_ptr<hpc::AlignedBuffer<T>> random_buffer(size_t n, unsigned seed, size_t threads) {
+    hpc::BufferOptions o;
+    o.first_touch_threads = threads;
+    return std::make_shared<hpc::AlignedBuffer<T>>(hpc::make_random_aligned<T>(n, seed, o));
+}
+
+template <class T>
+std::shared_ptr<hpc::AlignedBuffer<T>> scratch_buffer(size_t n, size_t threads) {
+    hpc::BufferOptions o;
+    o.first_touch_threads = threads;
+    return std::make_shared<hpc::AlignedBuffer<T>>(n, o);
+}
+
+template <class T>
+void add_gemm(std::vector<Case>& cs, size_t n, size_t threads) {
+    Case c;
+    c.op = "gemm";
+    c.dtype = dtype_name<T>();
+    c.name = case_name(c.op, c.dtype.c_str(), n, threads);
+    c.M = c.N = c.K = n;
+    c.size = n * n * n;
+    c.threads = threads;
+    c.flops = 2.0 * (double)n * n * n;
+    c.bytes = sizeof(T) * 4.0 * (double)n * n; // A, B, C read and written
+    c.prepare = [n, threads]() -> std::function<void()> {
+        auto A = random_buffer<T>(n * n, 1, threads), B = random_buffer<T>(n * n, 2, threads);
+        auto C = scratch_buffer<T>(n * n, threads);
+        return [=] {
+            hpc::gemm<T>(hpc::Trans::none, hpc::Trans::none, T(1),
+                         hpc::row_major_view<const T>(A->data(), n, n),
+                         hpc::row_major_view<const T>(B->data(), n, n), T(0),
+                         hpc::row_major_view<T>(C->data(), n, n), threads);
+        };
+    };
+    cs.push_back(c);
+}
+
+template <class T>
+void add_blocked(std::vector<Case>& cs, size_t n) {
+    Case c;
+    c.op = "matmul_blocked";
+    c.dtype = dtype_name<T>();
+    c.name = case_name(c.op, c.dtype.c_str(), n, 1);
+    c.M = c.N = c.K = n;
+    c.size = n * n * n;
+    c.flops = 2.0 * (double)n * n * n;
+    c.bytes = sizeof(T) * 4.0 * (double)n * n;
+    c.prepare = [n]() -> std::function<void()> {
+        auto A = random_buffer<T>(n * n, 1, 1), B = random_buffer<T>(n * n, 2, 1);
+        auto C = scratch_buffer<T>(n * n, 1);
+        return [=] { hpc::matmul_blocked<T>(n, n, n, A->data(), n, B->data(), n, C->data(), n); };
+    };
+    cs.push_back(c);
+}
+
+template <class T>
+void add_reduction(std::vector<Case>& cs, size_t n, size_t threads) {
+    Case c;
+    c.op = "kahan_sum_parallel";
+    c.dtype = dtype_name<T>();
+    c.name = case_name(c.op, c.dtype.c_str(), n, threads);
+    c.size = n;
+    c.threads = threads;
+    c.flops = (double)n - 1.0;
+    c.bytes = sizeof(T) * (double)n;
+    c.prepare = [n, threads]() -> std::function<void()> {
+        auto x = random_buffer<T>(n, 1, threads);
+        auto sink = std::make_shared<T>(T(0)); // keeps the sum live
+        return [=] { *sink = hpc::kahan_sum_parallel<T>(x->data(), n, threads); };
+    };
+    cs.push_back(c);
+}
+
+template <class T>
+void add_scan(std::vector<Case>& cs, size_t n, size_t threads) {
+    Case c;
+    c.op = "inclusive_scan";
+    c.dtype = dtype_name<T>();
+    c.name = case_name(c.op, c.dtype.c_str(), n, threads);
+    c.size = n;
+    c.threads = threads;
+    c.flops = (double)n;
+    c.bytes = sizeof(T) * 2.0 * (double)n;
+    c.prepare = [n, threads]() -> std::function<void()> {
+        auto x = random_buffer<T>(n, 1, threads);
+        auto y = scratch_buffer<T>(n, threads);
+        return [=] { hpc::inclusive_scan<T>(x->data(), y->data(), n, threads); };
+    };
+    cs.push_back(c);
+}
+
+/// SpMV on a square matrix with row_nnz uniformly random columns per row.
+template <class T>
+void add_spmv(std::vector<Case>& cs, size_t rows, size_t row_nnz, size_t threads) {
+    const size_t nnz = rows * row_nnz;
+    Case c;
+    c.op = "spmv";
+    c.dtype = dtype_name<T>();
+    c.name = case_name(c.op, c.dtype.c_str(), nnz, threads);
+    c.M = c.K = rows;
+    c.N = 1;
+    c.size = nnz;
+    c.threads = threads;
+    c.flops = 2.0 * (double)nnz;
+    c.bytes = nnz * (sizeof(T) + sizeof(std::uint32_t)) + sizeof(size_t) * (double)(rows + 1)
+            + sizeof(T) * 2.0 * (double)rows;
+    c.prepare = [rows, row_nnz, nnz, threads]() -> std::function<void()> {
+        std::mt19937_64 rng(7);
+        std::uniform_int_distribution<size_t> col(0, rows - 1);
+        std::vector<size_t> r(nnz), cl(nnz);
+        for (size_t k = 0; k < nnz; ++k) { r[k] = k / row_nnz; cl[k] = col(rng); }
+        const auto v = hpc::make_random<T>(nnz, 1);
+        auto A = std::make_shared<hpc::CsrMatrix<T>>(hpc::csr_from_coo<T>(rows, rows, r, cl, v));
+        auto x = random_buffer<T>(rows, 2, threads);
+        auto y = scratch_buffer<T>(rows, threads);
+        return [=] { hpc::spmv<T>(*A, x->data(), y->data(), threads); };
+    };
+    cs.push_back(c);
+}
+
+/// The fixed matrix: every kernel family at a cache-resident and a
+/// memory-bound (or compute-bound) size, float and double, serial and on
+/// `threads` threads. Changing it invalidates the matching baseline cases.
+std::vector<Case> suite_cases(size_t threads) {
+    std::vector<size_t> ts{1};
+    if (threads > 1) ts.push_back(threads);
+
+    std::vector<Case> cs;
+    for (size_t t : ts) {
+        for (size_t n : {256, 1024}) { add_gemm<float>(cs, n, t); add_gemm<double>(cs, n, t); }
+        for (size_t n : {size_t(1) << 16, size_t(1) << 24}) {
+            add_reduction<float>(cs, n, t);
+            add_reduction<double>(cs, n, t);
+        }
+        add_scan<float>(cs, size_t(1) << 24, t);
+        add_scan<double>(cs, size_t(1) << 24, t);
+        add_spmv<double>(cs, size_t(1) << 18, 16, t);
+    }
+    add_blocked<float>(cs, 512);
+    add_blocked<double>(cs, 512);
+    return cs;
+}
+
+/// Baseline file: one row per timed rep of every case, keyed by name and ISA.
+const hpc::Schema& baseline_schema() {
+    using T = hpc::ColumnType;
+    static const hpc::Schema s{
+        {"case", T::text}, {"isa", T::text}, {"round", T::integer}, {"rep", T::integer},
+        {"ns", T::real, "%.1f"},
+    };
+    return s;
+}
+
+/// Report: the results.csv columns plot_bench.py needs, then the comparison.
+const hpc::Schema& report_schema() {
+    using T = hpc::ColumnType;
+    static const hpc::Schema s{
+        {"timestamp", T::integer}, {"op", T::text},
+        {"M", T::integer}, {"N", T::integer}, {"K", T::integer}, {"size", T::integer},
+        {"dtype", T::text}, {"reps", T::integer}, {"ns_per_rep", T::real, "%.0f"},
+        {"gflops", T::real, "%.6f"}, {"gbps", T::real, "%.6f"}, {"checksum", T::real},
+        {"threads", T::integer}, {"isa", T::text},
+        {"ns_ci_lo", T::real, "%.1f"}, {"ns_ci_hi", T::real, "%.1f"}, {"run_id", T::text},
+        {"case", T::text},
+        {"base_ns", T::real, "%.0f"},       // baseline median (empty: no baseline case)
+        {"ratio", T::real, "%.4f"},         // ns_per_rep / base_ns
+        {"noise", T::real, "%.4f"},         // round-to-round spread a change must exceed
+        {"p_slower", T::real, "%.3e"},      // Holm-adjusted Mann-Whitney p-values
+        {"p_faster", T::real, "%.3e"},
+        {"verdict", T::text},               // same|slower|faster|no_baseline
+    };
+    return s;
+}
+
+/// case -> (isa, rep times in seconds per round). A missing file is an empty baseline.
+using Baseline = std::map<std::string, std::pair<std::string, std::vector<std::vector<double>>>>;
+
+Baseline load_baseline(const std::string& path) {
+    Baseline b;
+    std::ifstream in(path);
+    if (!in) return b;
+    std::string line;
+    std::getline(in, line);
+    if (line != baseline_schema().csv_header())
+        throw std::runtime_error("load_baseline: " + path + " is not a baseline file");
+    while (std::getline(in, line)) {
+        std::istringstream ls(line);
+        std::string name, isa, round, rep, ns;
+        if (!std::getline(ls, name, ',') || !std::getline(ls, isa, ',') || !std::getline(ls, round, ',')
+            || !std::getline(ls, rep, ',') || !std::getline(ls, ns))
+            throw std::runtime_error("load_baseline: bad line in " + path + ": " + line);
+        auto& e = b[name];
+        e.first = isa;
+        const size_t k = std::stoull(round);
+        if (e.second.size() <= k) e.second.resize(k + 1);
+        e.second[k].push_back(std::stod(ns) * 1e-9);
+    }
+    return b;
+}
+
+/// Cases of this run replace theirs; baseline cases it did not run are kept.
+void write_baseline(const std::string& path, const std::vector<Result>& rs, const char* isa, const Baseline& old) {
+    namespace fs = std::filesystem;
+    const fs::path p(path);
+    if (p.has_parent_path()) fs::create_directories(p.parent_path());
+    fs::remove(p);
+    hpc::ResultSink out(path, baseline_schema(), hpc::ResultFormat::csv);
+    auto put = [&](const std::string& name, const std::string& case_isa,
+                   const std::vector<std::vector<double>>& rounds) {
+        for (size_t k = 0; k < rounds.size(); ++k) {
+            for (size_t i = 0; i < rounds[k].size(); ++i) {
+                hpc::Row w(baseline_schema());
+                w.set("case", name).set("isa", case_isa).set("round", k).set("rep", i).set("ns", rounds[k][i] * 1e9);
+                out.write(w);
+            }
+        }
+    };
+    for (const auto& kv : old) {
+        if (std::none_of(rs.begin(), rs.end(), [&](const Result& r) { return r.c->name == kv.first; }))
+            put(kv.first, kv.second.first, kv.second.second);
+    }
+    for (const Result& r : rs) put(r.c->name, isa, r.rounds);
+}
+
+double gflops_of(const Result& r) { return r.c->flops / r.stats.median / 1e9; }
+double gbps_of(const Result& r) { return r.c->bytes / r.stats.median / 1e9; }
+
+/// Log-log roofline of the run: ceilings at the best attained compute and
+/// bandwidth rates (empirical), one marker per case at its model intensity.
+void write_roofline_svg(const std::string& path, const std::vector<Result>& rs,
+                        double peak_gflops, double peak_gbps, const std::string& title)
+{
+    const double W = 760, H = 480, L = 70, R = 200, T = 40, B = 50;
+    const double x0 = std::log10(1.0 / 64), x1 = std::log10(1024.0);
+    double y1 = std::ceil(std::log10(std::max(peak_gflops, 1e-3) * 2));
+    double y0 = y1 - 5;
+    auto px = [&](double ai) { return L + (std::log10(ai) - x0) / (x1 - x0) * (W - L - R); };
+    auto py = [&](double g) {
+        const double v = std::min(std::max(std::log10(g), y0), y1);
+        return H - B - (v - y0) / (y1 - y0) * (H - T - B);
+    };
+
+    std::ofstream f(path);
+    if (!f) throw std::runtime_error("write_roofline_svg: cannot open file " + path);
+    f << "<svg xmlns='http://www.w3.org/2000/svg' width='" << W << "' height='" << H
+      << "' font-family='sans-serif' font-size='11'>\n<rect width='100%' height='100%' fill='white'/>\n"
+      << "<text x='" << L << "' y='22' font-size='14'>" << title << "</text>\n";
+    for (int e = int(x0); e <= int(x1); ++e) {
+        const double x = px(std::pow(10.0, e));
+        f << "<line x1='" << x << "' y1='" << T << "' x2='" << x << "' y2='" << H - B << "' stroke='#ddd'/>"
+          << "<text x='" << x - 10 << "' y='" << H - B + 15 << "'>1e" << e << "</text>\n";
+    }
+    for (int e = int(y0); e <= int(y1); ++e) {
+        const double y = py(std::pow(10.0, e));
+        f << "<line x1='" << L << "' y1='" << y << "' x2='" << W - R << "' y2='" << y << "' stroke='#ddd'/>"
+          << "<text x='" << L - 40 << "' y='" << y + 4 << "'>1e" << e << "</text>\n";
+    }
+    f << "<text x='" << (L + W - R) / 2 - 80 << "' y='" << H - 12 << "'>Arithmetic intensity (flop/byte)</text>\n"
+      << "<text transform='rotate(-90)' x='" << -(H / 2) - 40 << "' y='16'>GFLOP/s</text>\n";
+
+    // Ceiling: min(peak_gflops, peak_gbps · ai), bent at the ridge point.
+    const double ridge = peak_gflops / peak_gbps;
+    const double a_lo = std::pow(10.0, x0), a_hi = std::pow(10.0, x1);
+    f << "<polyline fill='none' stroke='black' stroke-width='2' points='"
+      << px(a_lo) << "," << py(peak_gbps * a_lo) << " " << px(ridge) << "," << py(peak_gflops) << " "
+      << px(a_hi) << "," << py(peak_gflops) << "'/>\n"
+      << "<text x='" << px(ridge) << "' y='" << py(peak_gflops) - 6 << "'>" << peak_gflops << " GF/s, "
+      << peak_gbps << " GB/s</text>\n";
+
+    static const char* colors[] = {"#1f77b4", "#ff7f0e", "#2ca02c", "#d62728", "#9467bd", "#8c564b"};
+    std::vector<std::string> ops;
+    for (const Result& r : rs) {
+        auto it = std::find(ops.begin(), ops.end(), r.c->op);
+        const size_t k = size_t(it - ops.begin());
+        if (it == ops.end()) ops.push_back(r.c->op);
+        const double ai = r.c->flops / r.c->bytes;
+        const char* fill = r.verdict == hpc::Verdict::slower ? "none" : colors[k % 6];
+        f << "<circle cx='" << px(ai) << "' cy='" << py(gflops_of(r)) << "' r='" << (r.c->threads > 1 ? 5 : 3.5)
+          << "' fill='" << fill << "' stroke='" << colors[k % 6] << "'><title>" << r.c->name << ": "
+          << gflops_of(r) << " GF/s</title></circle>\n";
+    }
+    for (size_t k = 0; k < ops.size(); ++k) {
+        const double y = T + 14.0 * double(k);
+        f << "<circle cx='" << W - R + 15 << "' cy='" << y << "' r='4' fill='" << colors[k % 6] << "'/>"
+          << "<text x='" << W - R + 25 << "' y='" << y + 4 << "'>" << ops[k] << "</text>\n";
+    }
+    f << "<text x='" << W - R + 10 << "' y='" << T + 14.0 * double(ops.size()) + 10
+      << "'>large: threaded; hollow: slower</text>\n</svg>\n";
+}
+
+std::string host_key(const std::vector<std::pair<std::string, std::string>>& meta) {
+    std::string h = "unknown";
+    for (const auto& kv : meta)
+        if (kv.first == "host") h = kv.second;
+    for (char& ch : h)
+        if (!std::isalnum(static_cast<unsigned char>(ch)) && ch != '-' && ch != '.') ch = '_';
+    return h;
+}
+
+void usage(std::ostream& os) {
+    os << "Usage: hpc_perf_suite [--baseline=file | --baseline-dir=dir] [--update-baseline] [--report=path] "
+          "[--roofline=file.svg] [--filter=text] [--threads=] [--rounds=] [--reps=] [--min-time=s] "
+          "[--alpha=] [--min-change=]\n"
+          "  Runs the fixed kernel matrix and compares each case with the baseline\n"
+          "  (default <--baseline-dir=perf/baselines>/<host>.csv). A case is slower when\n"
+          "  its rep times are significantly longer (one-sided Mann-Whitney,\n"
+          "  Holm-adjusted p < --alpha=0.01) and the median grew by more than\n"
+          "  --min-change=0.05 and than the spread between the --rounds=3 passes.\n"
+          "  --update-baseline records this run as the baseline (cases not run are kept).\n"
+          "  Exit status: 0 no slowdown, 1 slowdown(s), 2 usage or I/O error,\n"
+          "  3 no baseline for this host (rerun with --update-baseline).\n";
+}
+
+Options parse(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        try {
+            if (starts_with(argv[i], "--baseline=")) o.baseline = argv[i] + 11;
+            else if (starts_with(argv[i], "--baseline-dir=")) o.baseline_dir = argv[i] + 15;
+            else if (starts_with(argv[i], "--report=")) o.report = argv[i] + 9;
+            else if (starts_with(argv[i], "--roofline=")) o.roofline = argv[i] + 11;
+            else if (std::strcmp(argv[i], "--update-baseline") == 0) o.update = true;
+            else if (starts_with(argv[i], "--filter=")) o.filter = argv[i] + 9;
+            else if (starts_with(argv[i], "--threads=")) o.threads = to_count(argv[i] + 10);
+            else if (starts_with(argv[i], "--rounds=")) o.rounds = to_count(argv[i] + 9);
+            else if (starts_with(argv[i], "--reps=")) o.reps = to_count(argv[i] + 7);
+            else if (starts_with(argv[i], "--min-time=")) o.min_time = to_real(argv[i] + 11);
+            else if (starts_with(argv[i], "--alpha=")) o.cmp.alpha = to_real(argv[i] + 8);
+            else if (starts_with(argv[i], "--min-change=")) o.cmp.min_change = to_real(argv[i] + 13);
+            else if (std::strcmp(argv[i], "--help") == 0) {
+                usage(std::cout);
+                std::exit(0);
+            } else {
+                std::cerr << "Unknown arg: " << argv[i] << "\n";
+                usage(std::cerr);
+                std::exit(2);
+            }
+        } catch (const std::logic_error&) { // invalid_argument, out_of_range
+            std::cerr << "Bad value: " << argv[i] << "\n";
+            usage(std::cerr);
+            std::exit(2);
+        }
+    }
+    if (o.threads == 0) o.threads = hpc::hardware_threads();
+    return o;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o = parse(argc, argv);
+    auto meta = hpc::host_metadata();
+    const std::string run_id = meta.front().second;
+    if (o.baseline.empty()) o.baseline = (std::filesystem::path(o.baseline_dir) / (host_key(meta) + ".csv")).string();
+    if (o.roofline.empty())
+        o.roofline = std::filesystem::path(o.report).replace_extension(".roofline.svg").string();
+    const char* isa = hpc::isa_name(hpc::active_isa());
+
+    Baseline base;
+    try {
+        base = load_baseline(o.baseline);
+    } catch (const std::exception& e) {
+        std::cerr << "hpc_perf_suite: " << e.what() << "\n";
+        return 2;
+    }
+    if (base.empty() && !o.update) {
+        std::cerr << "hpc_perf_suite: no baseline at " << o.baseline << "; rerun with --update-baseline\n";
+        return 3;
+    }
+    std::cout << "[suite] baseline " << o.baseline << ": "
+              << (base.empty() ? "none, this run is recorded" : std::to_string(base.size()) + " cases") << "\n";
+
+    const std::vector<Case> cases = suite_cases(o.threads);
+    hpc::MeasureOptions mo;
+    mo.min_reps = std::max<size_t>(o.reps, 2);
+    mo.min_time_s = o.min_time;
+
+    std::vector<Result> rs;
+    for (const Case& c : cases)
+        if (o.filter.empty() || c.name.find(o.filter) != std::string::npos) {
+            Result r;
+            r.c = &c;
+            rs.push_back(std::move(r));
+        }
+
+    // Whole passes over the matrix, so each case's rounds lie far apart in time.
+    for (size_t k = 0; k < std::max<size_t>(o.rounds, 1); ++k) {
+        for (Result& r : rs) {
+            std::function<void()> run = r.c->prepare();
+            r.rounds.push_back(hpc::measure(mo, run).times);
+        }
+    }
+    for (Result& r : rs) {
+        r.stats = hpc::timing_stats(hpc::detail::pooled(r.rounds));
+        auto it = base.find(r.c->name);
+        r.has_base = it != base.end() && it->second.first == isa;
+        if (r.has_base) r.cmp = hpc::compare_timings(it->second.second, r.rounds);
+        std::cout << "  " << r.c->name << ": median " << r.stats.median * 1e3 << " ms, "
+                  << gflops_of(r) << " GF/s, " << gbps_of(r) << " GB/s";
+        if (r.has_base) std::cout << ", x" << r.cmp.ratio << " (noise " << r.cmp.noise * 100 << "%)";
+        std::cout << "\n";
+    }
+
+    // Holm over the cases that have a baseline, per direction.
+    std::vector<double> ps, pf;
+    for (const Result& r : rs)
+        if (r.has_base) { ps.push_back(r.cmp.p_slower); pf.push_back(r.cmp.p_faster); }
+    const std::vector<double> ps_adj = hpc::holm_adjust(ps), pf_adj = hpc::holm_adjust(pf);
+    size_t k = 0, slower = 0, faster = 0;
+    for (Result& r : rs) {
+        if (!r.has_base) continue;
+        r.p_slower_adj = ps_adj[k];
+        r.p_faster_adj = pf_adj[k++];
+        r.verdict = hpc::classify(r.cmp, r.p_slower_adj, r.p_faster_adj, o.cmp);
+        slower += r.verdict == hpc::Verdict::slower;
+        faster += r.verdict == hpc::Verdict::faster;
+    }
+
+    double peak_gflops = 0, peak_gbps = 0;
+    for (const Result& r : rs) {
+        peak_gflops = std::max(peak_gflops, gflops_of(r));
+        peak_gbps = std::max(peak_gbps, gbps_of(r));
+    }
+
+    try {
+        const std::filesystem::path report(o.report);
+        if (report.has_parent_path()) std::filesystem::create_directories(report.parent_path());
+        std::filesystem::remove(report);
+        hpc::ResultSink out(o.report, report_schema(), hpc::result_format_for(o.report));
+        for (const Result& r : rs) {
+            const Case& c = *r.c;
+            hpc::Row w(report_schema());
+            w.set("timestamp", std::time(nullptr)).set("op", c.op).set("dtype", c.dtype)
+             .set("M", c.M).set("N", c.N).set("K", c.K).set("size", c.size)
+             .set("reps", hpc::detail::pooled(r.rounds).size()).set("ns_per_rep", r.stats.median * 1e9)
+             .set("gflops", gflops_of(r)).set("gbps", gbps_of(r))
+             .set("threads", c.threads).set("isa", isa)
+             .set("ns_ci_lo", r.stats.ci_lo * 1e9).set("ns_ci_hi", r.stats.ci_hi * 1e9)
+             .set("run_id", run_id).set("case", c.name).set("verdict", hpc::verdict_name(r.verdict));
+            if (r.has_base) {
+                w.set("base_ns", r.cmp.base_median * 1e9).set("ratio", r.cmp.ratio).set("noise", r.cmp.noise)
+                 .set("p_slower", r.p_slower_adj).set("p_faster", r.p_faster_adj);
+            }
+            out.write(w);
+        }
+        meta.push_back({"baseline", o.baseline});
+        meta.push_back({"peak_gflops", std::to_string(peak_gflops)});
+        meta.push_back({"peak_gbps", std::to_string(peak_gbps)});
+        meta.push_back({"slower", std::to_string(slower)});
+        hpc::write_metadata_line(std::filesystem::path(o.report).replace_extension(".runs.jsonl").string(), meta);
+        if (!rs.empty())
+            write_roofline_svg(o.roofline, rs, peak_gflops, peak_gbps,
+                               "Roofline, " + host_key(meta) + " (" + isa + "), run " + run_id);
+        if (o.update) write_baseline(o.baseline, rs, isa, base);
+    } catch (const std::exception& e) {
+        std::cerr << "hpc_perf_suite: " << e.what() << "\n";
+        return 2;
+    }
+
+    for (const Result& r : rs) {
+        if (r.verdict != hpc::Verdict::slower && r.verdict != hpc::Verdict::faster) continue;
+        std::cout << "[" << hpc::verdict_name(r.verdict) << "] " << r.c->name << ": " << r.cmp.base_median * 1e3
+                  << " -> " << r.cmp.median * 1e3 << " ms (x" << r.cmp.ratio << ", p="
+                  << (r.verdict == hpc::Verdict::slower ? r.p_slower_adj : r.p_faster_adj) << ")\n";
+    }
+    std::cout << "[suite] " << rs.size() << " cases, " << slower << " slower, " << faster << " faster"
+              << " (alpha " << o.cmp.alpha << ", min change " << o.cmp.min_change * 100 << "%); report "
+              << o.report << ", roofline " << o.roofline
+              << (o.update ? ", baseline written" : "") << "\n";
+    return slower && !o.update ? 1 : 0;
+}
@@ -1,11 +1,56 @@
 #include <gtest/gtest.h>
 #include <vector>
+#include <atomic>
 #include <numeric>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
 
 #include "hpc/matmul.hpp"
+#include "hpc/matmul_packed.hpp"
+#include "hpc/matmul_fixed.hpp"
+#include "hpc/matmul_batched.hpp"
+#include "hpc/matmul_mixed.hpp"
+#include "hpc/matmul_int8.hpp"
+#include "hpc/matmul_strassen.hpp"
+#include "hpc/out_of_core.hpp"
+#include "hpc/half.hpp"
 #include "hpc/reduction.hpp"
 #include "hpc/scan.hpp"
+#include "hpc/scan_segmented.hpp"
+#include "hpc/sparse.hpp"
+#include "hpc/pipeline.hpp"
+#include "hpc/task_graph.hpp"
+#include "hpc/rand.hpp"
+#include "hpc/memory.hpp"
+#include "hpc/topology.hpp"
+#include "hpc/dispatch.hpp"
+#include "hpc/tune.hpp"
+#include "hpc/perf.hpp"
+#include "hpc/harness.hpp"
+#include "hpc/regression.hpp"
+#include "hpc/results.hpp"
+
+/// Runs f(isa) once with each ISA usable here active, under a trace naming
+/// it. The caller's ISA is restored on the way out, also when an ASSERT in
+/// f returns early, so a failure cannot leave later tests on another ISA.
+template <typename F>
+void for_each_usable_isa(F&& f) {
+    struct Restore {
+        hpc::Isa saved = hpc::active_isa();
+        ~Restore() { hpc::set_active_isa(saved); }
+    } restore;
+    for (hpc::Isa isa : {hpc::Isa::scalar, hpc::Isa::avx2, hpc::Isa::avx512, hpc::Isa::neon}) {
+        if (!hpc::set_active_isa(isa)) continue;
+        SCOPED_TRACE(hpc::isa_name(isa));
+        f(isa);
+    }
+}
 
 
 TEST(Matmul, Small3x4x2) {
@@ -38,6 +83,465 @@ TEST(Matmul, Small3x4x2) {
     }
 }
 
+TEST(Matmul, PackedMatchesNaiveOddShapes) {
+    using T = double;
+    // Odd sizes hit the MR/NR edge tiles; small blocking forces several MC/KC/NC steps.
+    std::size_t M = 37, N = 29, K = 45;
+
+    auto A = hpc::make_random<T>(M * K, 1);
+    auto B = hpc::make_random<T>(K * N, 2);
+
+    std::vector<T> ref, C;
+    hpc::matmul_naive<T>(M, N, K, A, B, ref);
+
+    hpc::GemmBlocking blk;
+    blk.MC = 12; blk.KC = 16; blk.NC = 16;
+    hpc::matmul_packed<T>(M, N, K, A, B, C, blk);
+
+    ASSERT_EQ(C.size(), ref.size());
+    for (size_t i = 0; i < C.size(); ++i) {
+        EXPECT_NEAR(C[i], ref[i], 1e-12);
+    }
+}
+
+TEST(Matmul, PackedFloatDefaultBlocking) {
+    using T = float;
+    std::size_t M = 130, N = 70, K = 300;
+
+    auto A = hpc::make_random<T>(M * K, 3);
+    auto B = hpc::make_random<T>(K * N, 4);
+
+    std::vector<T> ref, C(M * N, T(123)); // stale contents must be overwritten
+    hpc::matmul_naive<T>(M, N, K, A, B, ref);
+    hpc::matmul_packed<T>(M, N, K, A, B, C);
+
+    for (size_t i = 0; i < C.size(); ++i) {
+        EXPECT_NEAR(C[i], ref[i], 1e-3f);
+    }
+}
+
+TEST(Matmul, PackedThreadedMatchesSerial) {
+    using T = float;
+    std::size_t M = 101, N = 77, K = 90;
+
+    auto A = hpc::make_random<T>(M * K, 5);
+    auto B = hpc::make_random<T>(K * N, 6);
+
+    hpc::GemmBlocking blk;
+    blk.MC = 24; blk.KC = 32; blk.NC = 48;
+
+    std::vector<T> ref, C;
+    hpc::matmul_packed<T>(M, N, K, A, B, ref, blk, 1);
+
+    // Same blocking => same per-element summation order => bitwise equal.
+    for (std::size_t nt : {2u, 3u, 4u, 6u}) {
+        hpc::matmul_packed<T>(M, N, K, A, B, C, blk, nt);
+        EXPECT_EQ(C, ref) << "threads=" << nt;
+    }
+}
+
+TEST(ThreadPool, SplitRangeCoversAll) {
+    std::size_t covered = 0, prev_end = 0;
+    for (std::size_t p = 0; p < 5; ++p) {
+        auto r = hpc::split_range(103, 5, p, 8);
+        EXPECT_EQ(r.first, prev_end);
+        EXPECT_EQ(r.first % 8, 0u);
+        covered += r.second - r.first;
+        prev_end = r.second;
+    }
+    EXPECT_EQ(covered, 103u);
+}
+
+TEST(Matmul, GemmViewsTransposeAlphaBeta) {
+    using T = double;
+    const std::size_t M = 19, N = 23, K = 17;
+    const T alpha = 0.5, beta = -2.0;
+
+    // A stored col-major K×M with padding and used transposed -> op(A) is M×K.
+    const std::size_t lda = K + 3;
+    auto Abuf = hpc::make_random<T>(lda * M, 11);
+    // B stored col-major K×N with ld = K.
+    auto Bbuf = hpc::make_random<T>(K * N, 12);
+    // C row-major M×N with ldc = N + 5; padding must stay untouched.
+    const std::size_t ldc = N + 5;
+    auto C0 = hpc::make_random<T>(M * ldc, 13);
+    auto C = C0;
+
+    auto A = hpc::col_major_view<const T>(Abuf.data(), K, M, lda);
+    auto B = hpc::col_major_view<const T>(Bbuf.data(), K, N);
+    auto Cv = hpc::row_major_view<T>(C.data(), M, N, ldc);
+
+    hpc::GemmBlocking blk;
+    blk.MC = 12; blk.KC = 8; blk.NC = 16;
+    hpc::gemm<T>(hpc::Trans::transpose, hpc::Trans::none, alpha, A, B, beta, Cv, 2, blk);
+
+    for (std::size_t i = 0; i < M; ++i) {
+        for (std::size_t j = 0; j < ldc; ++j) {
+            if (j >= N) { EXPECT_EQ(C[i * ldc + j], C0[i * ldc + j]); continue; }
+            T ref = 0;
+            for (std::size_t k = 0; k < K; ++k) ref += A(k, i) * B(k, j);
+            ref = alpha * ref + beta * C0[i * ldc + j];
+            EXPECT_NEAR(C[i * ldc + j], ref, 1e-12);
+        }
+    }
+}
+
+TEST(Matmul, GemmBetaZeroIgnoresNaN) {
+    using T = float;
+    const std::size_t M = 8, N = 40, K = 5;
+
+    auto A = hpc::make_random<T>(M * K, 14);
+    auto B = hpc::make_random<T>(K * N, 15);
+    std::vector<T> C(M * N, std::numeric_limits<T>::quiet_NaN()), ref;
+
+    hpc::gemm<T>(hpc::Trans::none, hpc::Trans::none, 1.0f,
+                 hpc::row_major_view<const T>(A.data(), M, K),
+                 hpc::row_major_view<const T>(B.data(), K, N),
+                 0.0f, hpc::row_major_view<T>(C.data(), M, N));
+    hpc::matmul_naive<T>(M, N, K, A, B, ref);
+
+    for (std::size_t i = 0; i < C.size(); ++i) EXPECT_NEAR(C[i], ref[i], 1e-5f);
+}
+
+TEST(Matmul, NaiveBlockedLeadingDimension) {
+    using T = double;
+    const std::size_t M = 9, N = 7, K = 6, ldc = 10;
+
+    auto A = hpc::make_random<T>(M * K, 16);
+    auto B = hpc::make_random<T>(K * N, 17);
+    std::vector<T> ref;
+    hpc::matmul_naive<T>(M, N, K, A, B, ref);
+
+    std::vector<T> C1(M * ldc, T(-7)), C2(M * ldc, T(-7));
+    hpc::matmul_naive<T>(M, N, K, A.data(), K, B.data(), N, C1.data(), ldc);
+    hpc::matmul_blocked<T>(M, N, K, A.data(), K, B.data(), N, C2.data(), ldc, 4);
+
+    for (std::size_t i = 0; i < M; ++i) {
+        for (std::size_t j = 0; j < N; ++j) {
+            EXPECT_NEAR(C1[i * ldc + j], ref[i * N + j], 1e-12);
+            EXPECT_NEAR(C2[i * ldc + j], ref[i * N + j], 1e-12);
+        }
+        EXPECT_EQ(C1[i * ldc + N], T(-7));
+        EXPECT_EQ(C2[i * ldc + N], T(-7));
+    }
+}
+
+TEST(Matmul, FixedShapeMatchesNaive) {
+    using T = float;
+    constexpr std::size_t M = 5, N = 16, K = 7;
+
+    auto A = hpc::make_random<T>(M * K, 18);
+    auto B = hpc::make_random<T>(K * N, 19);
+    std::vector<T> ref, C(M * N);
+    hpc::matmul_naive<T>(M, N, K, A, B, ref);
+
+    hpc::matmul_fixed<M, N, K, T>(A.data(), B.data(), C.data());
+    for (std::size_t i = 0; i < C.size(); ++i) EXPECT_NEAR(C[i], ref[i], 1e-5f);
+}
+
+TEST(Matmul, SmallDispatcherShapes) {
+    using T = double;
+
+    // exact specialization, padded specialization, naive fallback
+    const std::size_t shapes[][3] = {{8, 8, 8}, {32, 32, 32}, {7, 8, 8}, {30, 31, 29}, {3, 40, 2}};
+    const bool fixed[] = {true, true, true, true, false};
+
+    for (std::size_t s = 0; s < 5; ++s) {
+        const std::size_t M = shapes[s][0], N = shapes[s][1], K = shapes[s][2];
+        auto A = hpc::make_random<T>(M * K, 20);
+        auto B = hpc::make_random<T>(K * N, 21);
+        std::vector<T> ref, C(M * N, T(99));
+        hpc::matmul_naive<T>(M, N, K, A, B, ref);
+
+        EXPECT_EQ(hpc::matmul_small<T>(M, N, K, A.data(), K, B.data(), N, C.data(), N), fixed[s]);
+        for (std::size_t i = 0; i < C.size(); ++i) EXPECT_NEAR(C[i], ref[i], 1e-12) << M << "x" << N << "x" << K;
+    }
+}
+
+TEST(Matmul, BatchedStridedSharedAndPerItemB) {
+    using T = double;
+    const std::size_t batch = 5, M = 37, N = 45, K = 300; // K spans two KC panels
+    const T alpha = 0.5, beta = -2.0;
+
+    auto A = hpc::make_random<T>(batch * M * K, 30);
+    auto B = hpc::make_random<T>(batch * K * N, 31);
+    auto C0 = hpc::make_random<T>(batch * M * N, 32);
+
+    for (std::size_t stride_b : {std::size_t(0), K * N}) {
+        for (std::size_t threads : {1, 3}) {
+            std::vector<T> C = C0;
+            hpc::matmul_batched<T>(batch, M, N, K, alpha, A.data(), K, M * K,
+                                   B.data(), N, stride_b, beta, C.data(), N, M * N, threads);
+
+            for (std::size_t b = 0; b < batch; ++b) {
+                std::vector<T> ref(M * N);
+                hpc::matmul_naive<T>(M, N, K, A.data() + b * M * K, K,
+                                     B.data() + b * stride_b, N, ref.data(), N);
+                for (std::size_t i = 0; i < M * N; ++i) {
+                    const T want = alpha * ref[i] + beta * C0[b * M * N + i];
+                    ASSERT_NEAR(C[b * M * N + i], want, 1e-11) << "stride_b=" << stride_b << " item " << b;
+                }
+            }
+        }
+    }
+}
+
+TEST(Matmul, BatchedPointerArraySmall) {
+    using T = float;
+    const std::size_t batch = 7, M = 12, N = 12, K = 12;
+
+    std::vector<std::vector<T>> A(batch), B(batch), C(batch, std::vector<T>(M * N));
+    std::vector<const T*> pa(batch), pb(batch);
+    std::vector<T*> pc(batch);
+    for (std::size_t b = 0; b < batch; ++b) {
+        A[b] = hpc::make_random<T>(M * K, 40 + unsigned(b));
+        B[b] = hpc::make_random<T>(K * N, 50 + unsigned(b));
+        pa[b] = A[b].data(); pb[b] = B[b].data(); pc[b] = C[b].data();
+    }
+
+    hpc::matmul_batched<T>(batch, M, N, K, 1.0f, pa.data(), K, pb.data(), N, 0.0f, pc.data(), N, 4);
+
+    for (std::size_t b = 0; b < batch; ++b) {
+        std::vector<T> ref;
+        hpc::matmul_naive<T>(M, N, K, A[b], B[b], ref);
+        for (std::size_t i = 0; i < M * N; ++i) EXPECT_NEAR(C[b][i], ref[i], 1e-4f);
+    }
+}
+
+TEST(Half, ConversionsRoundToNearestEven) {
+    EXPECT_EQ(hpc::bf16(1.0f).bits, 0x3f80);
+    EXPECT_EQ(hpc::bf16(-2.0f).bits, 0xc000);
+    // 1 + 2^-8 is a tie between 1 and 1 + 2^-7: even mantissa wins.
+    EXPECT_EQ(hpc::bf16(1.0f + 1.0f / 256).bits, 0x3f80);
+    EXPECT_EQ(hpc::bf16(1.0f + 3.0f / 256).bits, 0x3f82);
+    EXPECT_TRUE(std::isnan(float(hpc::bf16(std::numeric_limits<float>::quiet_NaN()))));
+    EXPECT_EQ(float(hpc::bf16(std::numeric_limits<float>::infinity())),
+              std::numeric_limits<float>::infinity());
+
+    EXPECT_EQ(hpc::fp16(1.0f).bits, 0x3c00);
+    EXPECT_EQ(float(hpc::fp16(65504.0f)), 65504.0f);
+    EXPECT_EQ(hpc::fp16(65520.0f).bits, 0x7c00);          // rounds up to inf
+    EXPECT_EQ(hpc::fp16(-65520.0f).bits, 0xfc00);
+    EXPECT_EQ(float(hpc::fp16(std::ldexp(1.0f, -24))), std::ldexp(1.0f, -24)); // smallest subnormal
+    EXPECT_EQ(hpc::fp16(std::ldexp(1.0f, -26)).bits, 0x0000);
+    EXPECT_EQ(hpc::fp16(1.0f + 1.0f / 2048).bits, 0x3c00);  // tie, even
+    EXPECT_TRUE(std::isnan(float(hpc::fp16(std::numeric_limits<float>::quiet_NaN()))));
+
+    // Every fp16 and every finite bf16 survives a round trip through float.
+    for (std::uint32_t h = 0; h < 0x10000; ++h) {
+        hpc::fp16 x;
+        x.bits = static_cast<std::uint16_t>(h);
+        const float f = float(x);
+        if (!std::isnan(f)) {
+            ASSERT_EQ(hpc::fp16(f).bits, x.bits) << h;
+        }
+        hpc::bf16 y;
+        y.bits = static_cast<std::uint16_t>(h);
+        if (!std::isnan(float(y))) {
+            ASSERT_EQ(hpc::bf16(float(y)).bits, y.bits) << h;
+        }
+    }
+}
+
+/// Mixed GEMM against a double reference: tight on the rounded inputs (only
+/// the fp32 accumulation differs), loose on the original float inputs.
+template <typename Lo>
+void check_mixed_gemm(double tol_input) {
+    const std::size_t M = 37, N = 45, K = 129;
+    const auto Af = hpc::make_random<float>(M * K, 70);
+    const auto Bf = hpc::make_random<float>(K * N, 71);
+    std::vector<Lo> A(M * K), B(K * N);
+    for (std::size_t i = 0; i < A.size(); ++i) A[i] = Lo(Af[i]);
+    for (std::size_t i = 0; i < B.size(); ++i) B[i] = Lo(Bf[i]);
+    EXPECT_EQ(float(hpc::make_random<Lo>(8, 70)[5]), float(A[5]));
+
+    const std::size_t ldc = N + 3;
+    const float alpha = 0.5f, beta = 2.0f;
+    std::vector<double> ref(M * N), ref_in(M * N);
+    for (std::size_t i = 0; i < M; ++i)
+        for (std::size_t j = 0; j < N; ++j) {
+            double s = 0.0, t = 0.0;
+            for (std::size_t k = 0; k < K; ++k) {
+                s += double(float(A[i * K + k])) * double(float(B[k * N + j]));
+                t += double(Af[i * K + k]) * double(Bf[k * N + j]);
+            }
+            ref[i * N + j] = alpha * s + beta * 1.0;
+            ref_in[i * N + j] = alpha * t + beta * 1.0;
+        }
+
+    for_each_usable_isa([&](hpc::Isa) {
+        for (hpc::MixedKernel k : {hpc::MixedKernel::widen, hpc::MixedKernel::dot}) {
+            SCOPED_TRACE(hpc::mixed_kernel_name<Lo>(k));
+            for (std::size_t threads : {1, 3}) {
+                std::vector<float> C(M * ldc, 1.0f);
+                hpc::matmul_mixed<Lo>(M, N, K, alpha, A.data(), K, B.data(), N, beta, C.data(), ldc,
+                                      threads, hpc::GemmBlocking{12, 33, 64}, k);
+                double err_in = 0.0;
+                for (std::size_t i = 0; i < M; ++i)
+                    for (std::size_t j = 0; j < N; ++j) {
+                        ASSERT_NEAR(C[i * ldc + j], ref[i * N + j], 1e-4);
+                        err_in = std::max(err_in, std::abs(C[i * ldc + j] - ref_in[i * N + j]));
+                    }
+                EXPECT_LT(err_in, tol_input);
+                EXPECT_EQ(C[ldc - 1], 1.0f); // padding untouched
+            }
+        }
+    });
+}
+
+TEST(Matmul, MixedPrecisionVsDouble) {
+    check_mixed_gemm<hpc::bf16>(0.1);
+    check_mixed_gemm<hpc::fp16>(0.01);
+}
+
+TEST(Matmul, Int8QuantizedMatchesExact) {
+    const std::size_t M = 29, N = 71, K = 203, lda = K + 5, ldc = N + 2;
+    const auto A = hpc::make_random<std::uint8_t>(M * lda, 80);
+    const auto B = hpc::make_random<std::int8_t>(K * N, 81);
+    EXPECT_EQ(*std::min_element(A.begin(), A.end()), 0);
+    EXPECT_EQ(*std::max_element(A.begin(), A.end()), 255);
+    EXPECT_EQ(*std::min_element(B.begin(), B.end()), -128);
+    EXPECT_EQ(*std::max_element(B.begin(), B.end()), 127);
+
+    std::vector<float> rs(M), cs(N);
+    std::vector<std::int32_t> rz(M), cz(N);
+    for (std::size_t i = 0; i < M; ++i) { rs[i] = 0.5f + i % 3; rz[i] = std::int32_t(A[i] ^ 0x5a); }
+    for (std::size_t j = 0; j < N; ++j) { cs[j] = 1.0f / (1 + j % 5); cz[j] = std::int32_t(j % 7) - 3; }
+
+    hpc::QuantParams per_tensor;
+    per_tensor.scale = 0.125f;
+    per_tensor.a_zero = 128;
+    hpc::QuantParams per_channel = per_tensor;
+    per_channel.row_scale = rs.data();
+    per_channel.col_scale = cs.data();
+    per_channel.row_zero = rz.data();
+    per_channel.col_zero = cz.data();
+
+    for (const hpc::QuantParams& q : {per_tensor, per_channel}) {
+        std::vector<double> ref(M * N);
+        for (std::size_t i = 0; i < M; ++i)
+            for (std::size_t j = 0; j < N; ++j) {
+                const std::int64_t za = q.row_zero ? q.row_zero[i] : q.a_zero;
+                const std::int64_t zb = q.col_zero ? q.col_zero[j] : 0;
+                std::int64_t v = 0;
+                for (std::size_t k = 0; k < K; ++k) v += (A[i * lda + k] - za) * (B[k * N + j] - zb);
+                ref[i * N + j] = double(q.scale) * (q.row_scale ? q.row_scale[i] : 1.0)
+                               * (q.col_scale ? q.col_scale[j] : 1.0) * double(v) + 3.0;
+            }
+
+        for_each_usable_isa([&](hpc::Isa) {
+            SCOPED_TRACE(hpc::quant_kernel_name());
+            for (std::size_t threads : {1, 3}) {
+                std::vector<float> C(M * ldc, 1.5f);
+                hpc::matmul_u8s8(M, N, K, A.data(), lda, B.data(), N, C.data(), ldc, q, 2.0f, threads,
+                                 hpc::GemmBlocking{10, 0, 40});
+                for (std::size_t i = 0; i < M; ++i)
+                    for (std::size_t j = 0; j < N; ++j)
+                        ASSERT_NEAR(C[i * ldc + j], ref[i * N + j], 1e-6 * std::abs(ref[i * N + j]) + 1e-6);
+                EXPECT_EQ(C[ldc - 1], 1.5f);
+            }
+        });
+    }
+}
+
+/// max |C - AB| / (K max|A| max|B|) of matmul_strassen against long double.
+template <typename T>
+double strassen_error(std::size_t M, std::size_t N, std::size_t K, std::size_t crossover, std::size_t threads) {
+    const std::size_t lda = K + 1, ldc = N + 2;
+    const auto A = hpc::make_random<T>(M * lda, 95);
+    const auto B = hpc::make_random<T>(K * N, 96);
+    std::vector<T> C(M * ldc, T(7));
+    hpc::matmul_strassen<T>(M, N, K, A.data(), lda, B.data(), N, C.data(), ldc, threads, crossover);
+
+    double err = 0.0;
+    for (std::size_t i = 0; i < M; ++i) {
+        EXPECT_EQ(C[i * ldc + N], T(7)); // padding untouched
+        for (std::size_t j = 0; j < N; ++j) {
+            long double s = 0.0L;
+            for (std::size_t k = 0; k < K; ++k) s += (long double)A[i * lda + k] * B[k * N + j];
+            err = std::max(err, double(std::abs(C[i * ldc + j] - s)));
+        }
+    }
+    return err / double(K); // entries of A and B are in [-1, 1)
+}
+
+TEST(Matmul, StrassenErrorBounded) {
+    // Odd sizes peel at every level: 3 levels below 97 with cutoff 12.
+    const double eps_d = std::numeric_limits<double>::epsilon();
+    const double eps_f = std::numeric_limits<float>::epsilon();
+    // The error roughly doubles per level (measured ~0.4 eps flat, ~2.6 eps deep).
+    EXPECT_LT(strassen_error<double>(131, 97, 150, 1000, 1), eps_d);
+    EXPECT_LT(strassen_error<double>(131, 97, 150, 12, 1), 8 * eps_d);
+    EXPECT_LT(strassen_error<double>(64, 64, 64, 8, 3), 8 * eps_d);
+    EXPECT_LT(strassen_error<float>(131, 97, 150, 12, 2), 8 * eps_f);
+    // Even shapes, and K smaller than the cutoff (no recursion).
+    EXPECT_LT(strassen_error<double>(96, 96, 8, 12, 1), eps_d);
+
+    std::vector<double> C;
+    hpc::matmul_strassen<double>(0, 5, 5, {}, std::vector<double>(25), C);
+    EXPECT_TRUE(C.empty());
+}
+
+/// Functor without a vector form: the kernels apply it lane by lane.
+struct ScaleRowsShiftCols {
+    float operator()(float v, std::size_t i, std::size_t j) const { return v * float(1 + i % 4) - float(j); }
+};
+
+template <typename Epi>
+void check_fused_epilogue(const Epi& epi, bool col_major_c) {
+    using T = float;
+    const std::size_t M = 29, N = 71, K = 37, ldc = N + 3;
+    const T alpha = 0.75f, beta = 0.5f;
+    const auto A = hpc::make_random<T>(M * K, 90);
+    const auto B = hpc::make_random<T>(K * N, 91);
+    const auto C0 = hpc::make_random<T>(M * ldc, 92);
+
+    std::vector<T> ref(M * N);
+    for (std::size_t i = 0; i < M; ++i)
+        for (std::size_t j = 0; j < N; ++j) {
+            double s = 0.0;
+            for (std::size_t k = 0; k < K; ++k) s += double(A[i * K + k]) * double(B[k * N + j]);
+            const T c0 = col_major_c ? C0[j * M + i] : C0[i * ldc + j];
+            ref[i * N + j] = epi(T(alpha * s + beta * c0), i, j);
+        }
+
+    for_each_usable_isa([&](hpc::Isa) {
+        for (std::size_t threads : {1, 3}) {
+            auto C = C0;
+            auto Cv = col_major_c ? hpc::col_major_view<T>(C.data(), M, N)
+                                  : hpc::row_major_view<T>(C.data(), M, N, ldc);
+            // KC < K: the epilogue must run once, on the last K panel only.
+            hpc::gemm<T>(hpc::Trans::none, hpc::Trans::none, alpha,
+                         hpc::row_major_view<const T>(A.data(), M, K),
+                         hpc::row_major_view<const T>(B.data(), K, N),
+                         beta, Cv, threads, hpc::GemmBlocking{12, 16, 64}, epi);
+            for (std::size_t i = 0; i < M; ++i)
+                for (std::size_t j = 0; j < N; ++j)
+                    ASSERT_NEAR(Cv(i, j), ref[i * N + j], 1e-4f * (1.0f + std::abs(ref[i * N + j])));
+            if (!col_major_c) {
+                EXPECT_EQ(C[ldc - 1], C0[ldc - 1]); // padding untouched
+            }
+        }
+    });
+}
+
+TEST(Matmul, GemmFusedEpilogues) {
+    namespace ep = hpc::epilogue;
+    const std::size_t M = 29, N = 71;
+    const auto bias = hpc::make_random<float>(N, 93);
+    const auto res = hpc::make_random<float>(M * (N + 1), 94);
+
+    const auto bias_relu_res = ep::make_chain(ep::bias<float>{bias.data()}, ep::relu{},
+                                              ep::residual<float>{res.data(), N + 1});
+    check_fused_epilogue(bias_relu_res, false);
+    check_fused_epilogue(bias_relu_res, true);
+    check_fused_epilogue(ep::make_chain(ep::bias<float>{bias.data()}, ep::gelu{}), false);
+    check_fused_epilogue(ScaleRowsShiftCols{}, false);
+
+    for (float x = -12.0f; x <= 12.0f; x += 1.0f / 64)
+        ASSERT_NEAR(ep::detail::tanh_rational(x), std::tanh(double(x)), 1e-6);
+}
+
 TEST(Reduction, KahanVsStd) {
     using T = double;
 
@@ -59,6 +563,162 @@ TEST(Reduction, KahanVsStd) {
     EXPECT_NEAR(s_kahan, s_naive, 1e4);
 }
 
+TEST(Reduction, SimdKahanMatchesLongDouble) {
+    using T = float;
+
+    auto x = hpc::make_random<T>(1000003, 7);
+    for (auto& v : x) v += 1.0f; // all positive: naive float drift is large here
+
+    long double ref = 0.0L;
+    for (auto v : x) ref += v;
+
+    const double tol = 1e-6 * static_cast<double>(ref); // a few float ulps
+    EXPECT_NEAR(hpc::kahan_sum_simd<T>(x), static_cast<double>(ref), tol);
+    EXPECT_NEAR(hpc::kahan_sum_parallel<T>(x, 3), static_cast<double>(ref), tol);
+}
+
+TEST(Reduction, ParallelBitwiseReproducible) {
+    using T = double;
+
+    std::vector<T> x(300001);
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        x[i] = (i % 2 == 0 ? 1e8 : -1e8) + 1.0 / (double)(i + 1);
+    }
+
+    const T s1 = hpc::kahan_sum_parallel<T>(x.data(), x.size(), 1, 4096);
+    for (std::size_t nt : {2u, 3u, 5u, 8u}) {
+        EXPECT_EQ(hpc::kahan_sum_parallel<T>(x.data(), x.size(), nt, 4096), s1) << "threads=" << nt;
+    }
+    EXPECT_NEAR(s1, hpc::kahan_sum<T>(x), 1e-6);
+}
+
+TEST(Reduction, PairwiseNeumaierBinnedVsExact) {
+    // Ill-conditioned: large cancelling terms around a small true sum.
+    std::vector<double> x(100003);
+    hpc::fill_random(x.data(), x.size(), 11);
+    for (std::size_t i = 0; i < x.size(); ++i) x[i] *= (i % 3 == 0 ? 1e12 : 1.0);
+    const double exact = hpc::exact_sum(x);
+    double abs_sum = 0;
+    for (double v : x) abs_sum += std::abs(v);
+    const double eps = std::numeric_limits<double>::epsilon();
+
+    EXPECT_EQ(hpc::exact_sum(std::vector<double>{1, 1e100, 1, -1e100}), 2.0);
+    EXPECT_EQ(hpc::neumaier_sum(std::vector<double>{1, 1e100, 1, -1e100}), 2.0);
+    EXPECT_EQ(hpc::binned_sum(std::vector<double>{0.1, 0.2, 0.3}), 0.6);
+
+    for_each_usable_isa([&](hpc::Isa) {
+        EXPECT_LE(std::abs(hpc::pairwise_sum(x) - exact), 2 * 17 * eps * abs_sum);
+        EXPECT_LE(std::abs(hpc::neumaier_sum(x) - exact), 2 * eps * std::abs(exact) + 4 * eps * eps * abs_sum);
+        EXPECT_LE(std::abs(hpc::binned_sum(x) - exact), eps * std::abs(exact));
+        EXPECT_EQ(hpc::neumaier_sum(std::vector<double>{1, 1e100, 1, -1e100}), 2.0);
+    });
+
+    std::vector<float> xf(x.begin(), x.end());
+    EXPECT_LE(std::abs(hpc::binned_sum(xf) - hpc::exact_sum(xf)),
+              std::numeric_limits<float>::epsilon() * std::abs(hpc::exact_sum(xf)));
+}
+
+TEST(Reduction, BinnedBitwiseAnyOrderThreadsIsa) {
+    std::vector<double> x(200001);
+    hpc::fill_random(x.data(), x.size(), 5);
+    for (std::size_t i = 0; i < x.size(); ++i) x[i] = std::ldexp(x[i], int(i % 61) - 30);
+
+    const double ref = hpc::binned_sum(x);
+    std::vector<double> y = x;
+    std::reverse(y.begin(), y.end());
+    for (std::size_t i = 0; i + 7 < y.size(); i += 7) std::swap(y[i], y[y.size() - 1 - i / 2]);
+
+    for_each_usable_isa([&](hpc::Isa) {
+        for (std::size_t nt : {1u, 2u, 3u, 7u}) {
+            for (std::size_t chunk : {std::size_t(1000), hpc::reduction_chunk}) {
+                EXPECT_EQ(hpc::binned_sum(x.data(), x.size(), nt, chunk), ref)
+                    << "threads=" << nt << " chunk=" << chunk;
+                EXPECT_EQ(hpc::binned_sum(y.data(), y.size(), nt, chunk), ref)
+                    << "permuted, threads=" << nt;
+            }
+        }
+    });
+
+    EXPECT_LE(std::abs(ref - hpc::exact_sum(x)), std::numeric_limits<double>::epsilon() * std::abs(ref));
+    const double inf = std::numeric_limits<double>::infinity();
+    EXPECT_EQ(hpc::binned_sum(std::vector<double>{1, inf, 2}), inf);
+    EXPECT_TRUE(std::isnan(hpc::binned_sum(std::vector<double>{inf, 1, -inf})));
+    EXPECT_EQ(hpc::binned_sum(std::vector<double>{1e308, 1e308, -1e308}), 1e308);
+}
+
+TEST(Reduction, FusedStatsMatchSeparatePasses) {
+    // Offset data: a one-pass sum of squares would lose the variance.
+    const std::size_t n = 100003;
+    std::vector<double> x(n), y(n);
+    hpc::fill_random(x.data(), n, 3);
+    hpc::fill_random(y.data(), n, 4);
+    for (double& v : x) v = 1e6 + v;
+
+    long double mean = 0, m2 = 0, dot = 0;
+    for (std::size_t i = 0; i < n; ++i) { mean += x[i]; dot += (long double)x[i] * y[i]; }
+    mean /= n;
+    for (double v : x) m2 += (v - mean) * (v - mean);
+
+    for_each_usable_isa([&](hpc::Isa) {
+        const hpc::Stats<double> s = hpc::fused_stats(x, y, 1);
+        EXPECT_EQ(s.count, n);
+        EXPECT_EQ(s.min, *std::min_element(x.begin(), x.end()));
+        EXPECT_EQ(s.max, *std::max_element(x.begin(), x.end()));
+        EXPECT_NEAR(s.total(), hpc::exact_sum(x), 1e-15 * std::abs(hpc::exact_sum(x)));
+        EXPECT_NEAR(s.mean, (double)mean, 1e-15 * (double)mean);
+        EXPECT_NEAR(s.variance(), (double)(m2 / n), 1e-10 * (double)(m2 / n));
+        EXPECT_NEAR(s.variance(1), (double)(m2 / (n - 1)), 1e-10 * (double)(m2 / n));
+        EXPECT_NEAR(s.dot_value(), (double)dot, 1e-12 * std::abs((double)dot));
+        for (std::size_t nt : {2u, 3u, 5u}) {
+            const hpc::Stats<double> p = hpc::fused_stats(x.data(), n, nt, y.data(), 4096);
+            const hpc::Stats<double> p1 = hpc::fused_stats(x.data(), n, 1, y.data(), 4096);
+            EXPECT_EQ(p.total(), p1.total()) << "threads=" << nt;
+            EXPECT_EQ(p.m2, p1.m2) << "threads=" << nt;
+            EXPECT_EQ(p.dot_value(), p1.dot_value()) << "threads=" << nt;
+        }
+        EXPECT_EQ(hpc::fused_stats(x).dot_value(), 0.0);
+    });
+
+    std::vector<float> xf(1000);
+    hpc::fill_random(xf.data(), xf.size(), 9);
+    const hpc::Stats<float> sf = hpc::fused_stats(xf, 2);
+    EXPECT_NEAR(sf.total(), hpc::exact_sum(xf), 1e-5);
+    EXPECT_EQ(sf.min, *std::min_element(xf.begin(), xf.end()));
+    EXPECT_EQ(hpc::fused_stats(std::vector<float>{}).count, 0u);
+}
+
+TEST(Reduction, FusedStatsDotIsCompensated) {
+    // The second half repeats the first with y negated and scaled by 1 + 2^-30:
+    // the dot is ~2^-30 of sum |x·y|, below a plain dot's rounding error.
+    const std::size_t h = 10001, n = 2 * h;
+    std::vector<double> x(n), y(n);
+    hpc::fill_random(x.data(), h, 13);
+    hpc::fill_random(y.data(), h, 14);
+    for (std::size_t i = 0; i < h; ++i) {
+        x[i] = std::ldexp(x[i], int(i % 40) - 20);
+        x[h + i] = x[i];
+        y[h + i] = -y[i] * (1.0 + std::ldexp(1.0, -30));
+    }
+    std::vector<double> terms; // x·y as exact product + error pairs
+    double abs_sum = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const double p = x[i] * y[i];
+        terms.push_back(p);
+        terms.push_back(std::fma(x[i], y[i], -p));
+        abs_sum += std::abs(p);
+    }
+    const double exact = hpc::exact_sum(terms);
+    const double eps = std::numeric_limits<double>::epsilon();
+    ASSERT_LT(std::abs(exact), 1e-8 * abs_sum);
+
+    for_each_usable_isa([&](hpc::Isa) {
+        for (std::size_t nt : {1u, 3u}) {
+            const double d = hpc::fused_stats(x.data(), n, nt, y.data(), 4096).dot_value();
+            EXPECT_LE(std::abs(d - exact), 2 * eps * std::abs(exact) + 1e-22 * abs_sum) << "threads=" << nt;
+        }
+    });
+}
+
 TEST(Scan, InclusiveSmall) {
     using T = int;
 
@@ -67,4 +727,752 @@ TEST(Scan, InclusiveSmall) {
 
     std::vector<T> ref = {1, 3, 6, 10, 15};
     EXPECT_EQ(x, ref);
-}
\ No newline at end of file
+}
+
+TEST(Scan, ParallelTwoPassMatchesSerial) {
+    using T = long long;
+
+    std::vector<T> x(200003);
+    for (std::size_t i = 0; i < x.size(); ++i) x[i] = (T)(i % 17) - 8;
+
+    std::vector<T> ref = x;
+    hpc::inclusive_scan_inplace<T>(ref);
+
+    for (std::size_t nt : {1u, 2u, 3u, 7u}) {
+        std::vector<T> out;
+        hpc::inclusive_scan<T>(x, out, nt);
+        EXPECT_EQ(out, ref) << "threads=" << nt;
+
+        std::vector<T> inplace = x;
+        hpc::inclusive_scan_inplace<T>(inplace, nt);
+        EXPECT_EQ(inplace, ref) << "threads=" << nt;
+    }
+}
+
+TEST(Scan, SegmentedMatchesPerSegment) {
+    using T = long long;
+    const std::size_t n = 200003;
+
+    // Short, empty and thread-spanning segments.
+    std::vector<std::size_t> off = {0};
+    for (std::size_t s = 0; off.back() < n; ++s) {
+        const std::size_t len = s % 97 == 5 ? 70000 : s % 11 == 0 ? 0 : s % 23;
+        off.push_back(std::min(n, off.back() + len));
+    }
+    std::vector<T> x(n);
+    std::vector<std::uint8_t> heads(n, 0);
+    for (std::size_t i = 0; i < n; ++i) x[i] = (T)(i % 13) - 6;
+    for (std::size_t s = 0; s + 1 < off.size(); ++s) if (off[s] < n) heads[off[s]] = 1;
+
+    std::vector<T> inc(n), exc(n);
+    for (std::size_t s = 0; s + 1 < off.size(); ++s) {
+        T acc = 0;
+        for (std::size_t i = off[s]; i < off[s + 1]; ++i) { exc[i] = 5 + acc; acc += x[i]; inc[i] = acc; }
+    }
+
+    for (std::size_t nt : {1u, 2u, 3u, 7u}) {
+        std::vector<T> out;
+        hpc::segmented_inclusive_scan<T>(x, out, off, nt);
+        EXPECT_EQ(out, inc) << "offsets, threads=" << nt;
+        hpc::segmented_exclusive_scan<T>(x, out, off, nt, 5);
+        EXPECT_EQ(out, exc) << "offsets exclusive, threads=" << nt;
+
+        std::vector<T> y = x;
+        hpc::segmented_inclusive_scan_flags<T>(y.data(), y.data(), n, heads.data(), nt);
+        EXPECT_EQ(y, inc) << "flags in place, threads=" << nt;
+        y = x;
+        hpc::segmented_exclusive_scan_flags<T>(y.data(), y.data(), n, heads.data(), nt, 5);
+        EXPECT_EQ(y, exc) << "flags exclusive in place, threads=" << nt;
+    }
+}
+
+TEST(Scan, RowsWithLeadingDimension) {
+    using T = int;
+    const std::size_t rows = 3001, cols = 37, ld = 40;
+
+    std::vector<T> a(rows * ld, -1), ref(rows * ld, -1);
+    for (std::size_t i = 0; i < rows; ++i) {
+        T acc = 0;
+        for (std::size_t j = 0; j < cols; ++j) {
+            a[i * ld + j] = T((i + j) % 7) - 3;
+            acc += a[i * ld + j];
+            ref[i * ld + j] = acc;
+        }
+    }
+    for (std::size_t nt : {1u, 4u}) {
+        std::vector<T> out(rows * cols);
+        hpc::exclusive_scan_rows<T>(a.data(), ld, out.data(), cols, rows, cols, nt, 1);
+        for (std::size_t i = 0; i < rows; ++i) {
+            ASSERT_EQ(out[i * cols], 1);
+            for (std::size_t j = 1; j < cols; ++j) ASSERT_EQ(out[i * cols + j], 1 + ref[i * ld + j - 1]);
+        }
+        std::vector<T> y = a;
+        hpc::inclusive_scan_rows<T>(y.data(), ld, y.data(), ld, rows, cols, nt);
+        EXPECT_EQ(y, ref) << "threads=" << nt; // padding untouched
+    }
+}
+
+TEST(Scan, ExclusiveWithInit) {
+    using T = int;
+
+    std::vector<T> x = {1, 2, 3, 4, 5};
+    std::vector<T> out;
+    hpc::exclusive_scan<T>(x, out, 1, 10);
+
+    std::vector<T> ref = {10, 11, 13, 16, 20};
+    EXPECT_EQ(out, ref);
+
+    hpc::exclusive_scan_inplace<T>(x);
+    EXPECT_EQ(x, (std::vector<T>{0, 1, 3, 6, 10}));
+}
+
+TEST(Scan, ParallelFloatWithinTolerance) {
+    using T = float;
+
+    auto x = hpc::make_random<T>(100000, 9);
+    std::vector<T> ref = x, out;
+    hpc::inclusive_scan_inplace<T>(ref);
+    hpc::inclusive_scan<T>(x, out, 4);
+
+    for (std::size_t i = 0; i < x.size(); i += 997) {
+        EXPECT_NEAR(out[i], ref[i], 1e-2f);
+    }
+}
+
+template <typename T>
+void expect_simd_scan_exact(std::size_t n) {
+    std::vector<T> x(n);
+    for (std::size_t i = 0; i < n; ++i) x[i] = T((i * 7919) % 101) - T(50);
+    std::vector<T> inc(n), exc(n);
+    T acc = 0;
+    for (std::size_t i = 0; i < n; ++i) { exc[i] = T(acc + 7); acc += x[i]; inc[i] = acc; }
+
+    std::vector<T> v = x, out;
+    hpc::inclusive_scan_inplace<T>(v);
+    EXPECT_EQ(v, inc) << "n=" << n;
+    hpc::exclusive_scan<T>(x, out, 1, T(7));
+    EXPECT_EQ(out, exc) << "n=" << n;
+    hpc::inclusive_scan<T>(x, out, 3); // per-block stage of the parallel scan
+    EXPECT_EQ(out, inc) << "n=" << n;
+}
+
+TEST(Scan, SimdKernelExactIntsFloatTolerance) {
+    for_each_usable_isa([&](hpc::Isa) {
+        // Lengths around the vector widths and with tails.
+        for (std::size_t n : {0u, 1u, 3u, 8u, 15u, 16u, 17u, 33u, 1000u, 70001u}) {
+            expect_simd_scan_exact<std::int32_t>(n);
+            expect_simd_scan_exact<std::int64_t>(n);
+            expect_simd_scan_exact<std::uint32_t>(n);
+            expect_simd_scan_exact<std::int16_t>(n);
+        }
+
+        auto xf = hpc::make_random<float>(10007, 11);
+        auto xd = hpc::make_random<double>(10007, 12);
+        std::vector<float> of;
+        std::vector<double> od;
+        hpc::exclusive_scan<float>(xf, of, 1, 1.0f);
+        hpc::inclusive_scan<double>(xd, od, 1);
+        double sf = 1.0, sd = 0.0;
+        for (std::size_t i = 0; i < xf.size(); ++i) {
+            ASSERT_NEAR(of[i], sf, 1e-3 * (1.0 + std::abs(sf)));
+            sf += xf[i];
+            sd += xd[i];
+            ASSERT_NEAR(od[i], sd, 1e-10 * (1.0 + std::abs(sd)));
+        }
+    });
+}
+
+TEST(Scan, LookbackMatchesSerialExactly) {
+    using T = std::int64_t;
+
+    std::vector<T> x(100003);
+    for (std::size_t i = 0; i < x.size(); ++i) x[i] = (T)((i * 7919) % 101) - 50;
+
+    std::vector<T> ref = x;
+    hpc::inclusive_scan_inplace<T>(ref);
+
+    // Small tiles => long look-back chains across many tiles.
+    for (std::size_t nt : {1u, 2u, 4u, 9u}) {
+        std::vector<T> out(x.size());
+        hpc::inclusive_scan_lookback<T>(x.data(), out.data(), x.size(), nt, 512);
+        EXPECT_EQ(out, ref) << "threads=" << nt;
+    }
+
+    std::vector<T> ex(x.size());
+    hpc::exclusive_scan_lookback<T>(x.data(), ex.data(), x.size(), 3, T(5), 1000);
+    EXPECT_EQ(ex[0], 5);
+    for (std::size_t i = 1; i < x.size(); i += 1231) EXPECT_EQ(ex[i], ref[i - 1] + 5);
+}
+
+TEST(Sparse, CooToCsrAndMatrixMarket) {
+    // Unsorted triplets with a duplicate (1, 2) and an empty row 2.
+    auto A = hpc::csr_from_coo<double>(4, 3, {1, 0, 1, 3, 1}, {2, 1, 0, 0, 2}, {1.0, 2.0, 3.0, 4.0, 5.0});
+    EXPECT_EQ(A.row_ptr, (std::vector<std::size_t>{0, 1, 3, 3, 4}));
+    EXPECT_EQ(A.col, (std::vector<std::uint32_t>{1, 0, 2, 0}));
+    EXPECT_EQ(A.val, (std::vector<double>{2.0, 3.0, 6.0, 4.0}));
+
+    const std::string path = ::testing::TempDir() + "hpc_sparse.mtx";
+    {
+        std::ofstream f(path);
+        f << "%%MatrixMarket matrix coordinate real symmetric\n% comment\n3 3 3\n1 1 2.5\n3 1 -1\n2 2 4\n";
+    }
+    auto S = hpc::read_matrix_market<float>(path);
+    EXPECT_EQ(S.rows, 3u);
+    EXPECT_EQ(S.row_ptr, (std::vector<std::size_t>{0, 2, 3, 4}));
+    EXPECT_EQ(S.col, (std::vector<std::uint32_t>{0, 2, 1, 0}));
+    EXPECT_EQ(S.val, (std::vector<float>{2.5f, -1.0f, 4.0f, -1.0f}));
+    std::remove(path.c_str());
+
+    EXPECT_THROW(hpc::read_matrix_market<float>(path), std::runtime_error);
+}
+
+TEST(Sparse, SpmvSpmmMatchReferenceAcrossThreadsIsa) {
+    using T = double;
+    // Skewed rows: two dense rows that span several threads' shares of the
+    // nonzeros, every tenth row empty, 1..40 entries elsewhere (short rows,
+    // whole registers and tails at every vector width).
+    const std::size_t rows = 20000, cols = 40000, n = 37, ldb = 40, ldc = 41;
+    std::vector<std::size_t> ri, ci;
+    std::vector<T> v;
+    std::uint64_t state = 7;
+    auto next = [&] { state = state * 6364136223846793005ull + 1442695040888963407ull; return state >> 33; };
+    for (std::size_t r = 0; r < rows; ++r) {
+        if (r % 10 == 3) continue;
+        const std::size_t len = r == 11 || r == 12345 ? cols : 1 + next() % 40;
+        for (std::size_t k = 0; k < len; ++k) {
+            ri.push_back(r);
+            ci.push_back(len == cols ? k : next() % cols);
+            v.push_back(T(next() % 2001) / 1000.0 - 1.0);
+        }
+    }
+    const auto A = hpc::csr_from_coo<T>(rows, cols, ri, ci, v);
+    const auto Af = hpc::csr_from_coo<float>(rows, cols, ri, ci, std::vector<float>(v.begin(), v.end()));
+    auto x = hpc::make_random<T>(cols, 3);
+    const std::vector<float> xf(x.begin(), x.end());
+    auto B = hpc::make_random<T>(cols * ldb, 4);
+
+    std::vector<T> y_ref(rows, 0.0), C_ref(rows * n, 0.0);
+    for (std::size_t r = 0; r < rows; ++r)
+        for (std::size_t k = A.row_ptr[r]; k < A.row_ptr[r + 1]; ++k) {
+            y_ref[r] += A.val[k] * x[A.col[k]];
+            for (std::size_t j = 0; j < n; ++j) C_ref[r * n + j] += A.val[k] * B[A.col[k] * ldb + j];
+        }
+
+    for_each_usable_isa([&](hpc::Isa) {
+        for (std::size_t threads : {1, 3, 7}) {
+            SCOPED_TRACE("threads=" + std::to_string(threads));
+            std::vector<T> y;
+            hpc::spmv(A, x, y, threads);
+            for (std::size_t r = 0; r < rows; ++r) ASSERT_NEAR(y[r], y_ref[r], 1e-9) << "row " << r;
+            std::vector<float> yf;
+            hpc::spmv(Af, xf, yf, threads);
+            for (std::size_t r = 0; r < rows; ++r) ASSERT_NEAR(yf[r], y_ref[r], 2e-3) << "row " << r;
+
+            std::vector<T> C(rows * ldc, -1.0);
+            hpc::spmm(A, B.data(), ldb, n, C.data(), ldc, threads);
+            for (std::size_t r = 0; r < rows; ++r) {
+                for (std::size_t j = 0; j < n; ++j) ASSERT_NEAR(C[r * ldc + j], C_ref[r * n + j], 1e-9);
+                ASSERT_EQ(C[r * ldc + n], -1.0); // padding untouched
+            }
+        }
+    });
+}
+
+TEST(TaskGraph, RunsAfterDependenciesAndReruns) {
+    // Layers of 40 tasks, each depending on three tasks of the layer before.
+    hpc::TaskGraph g;
+    std::atomic<std::size_t> clock{0};
+    std::vector<std::size_t> stamp(200);
+    std::vector<std::vector<hpc::TaskId>> deps(200);
+    for (std::size_t t = 0; t < 200; ++t) {
+        if (t >= 40)
+            for (std::size_t d : {t - 40, t - 40 + (t * 7) % 40 / 2, t - 1 - t % 40})
+                if (d < t && std::find(deps[t].begin(), deps[t].end(), d) == deps[t].end()) deps[t].push_back(d);
+        EXPECT_EQ(g.add([&, t] { stamp[t] = ++clock; }, deps[t]), t);
+    }
+
+    for (std::size_t threads : {1, 4, 4}) {
+        clock = 0;
+        g.run(threads);
+        EXPECT_EQ(clock.load(), 200u) << "threads=" << threads;
+        for (std::size_t t = 0; t < 200; ++t)
+            for (hpc::TaskId d : deps[t]) ASSERT_LT(stamp[d], stamp[t]) << t << " after " << d;
+    }
+}
+
+TEST(TaskGraph, PipelineMatchesBackToBackKernels) {
+    using T = float;
+    const std::size_t M = 150, N = 70, K = 90, BS = 32;
+    auto A = hpc::make_random<T>(M * K, 21);
+    auto B = hpc::make_random<T>(K * N, 22);
+
+    std::vector<T> C_ref(M * N);
+    hpc::matmul_blocked<T>(M, N, K, A.data(), K, B.data(), N, C_ref.data(), N, BS);
+    const T sum_ref = hpc::kahan_sum_parallel(C_ref.data(), C_ref.size(), 1, 1000);
+
+    std::vector<T> C(M * N), S(M * N);
+    T sum = 0;
+    hpc::TaskGraph g;
+    const auto c_parts = hpc::matmul_blocked_tasks<T>(g, M, N, K, A.data(), K, B.data(), N, C.data(), N, BS);
+    hpc::kahan_sum_tasks<T>(g, C.data(), C.size(), &sum, c_parts, 1000);
+    hpc::inclusive_scan_tasks<T>(g, C.data(), S.data(), C.size(), c_parts, 777);
+
+    for (std::size_t threads : {1, 3}) {
+        std::fill(C.begin(), C.end(), T(-1));
+        g.run(threads);
+        EXPECT_EQ(C, C_ref) << "threads=" << threads;
+        EXPECT_EQ(sum, sum_ref) << "threads=" << threads;
+        double acc = 0;
+        for (std::size_t i = 0; i < S.size(); ++i) {
+            acc += C_ref[i];
+            ASSERT_NEAR(S[i], acc, 1e-3 * (1.0 + std::abs(acc))) << i;
+        }
+    }
+
+    // In-place integer scan through the graph is exact.
+    std::vector<std::int64_t> x(10007);
+    for (std::size_t i = 0; i < x.size(); ++i) x[i] = std::int64_t((i * 7919) % 101) - 50;
+    std::vector<std::int64_t> ref = x;
+    hpc::inclusive_scan_inplace(ref);
+    hpc::TaskGraph h;
+    hpc::inclusive_scan_tasks<std::int64_t>(h, x.data(), x.data(), x.size(), {}, 100);
+    h.run(4);
+    EXPECT_EQ(x, ref);
+}
+
+TEST(Memory, ArenaBumpAndRelease) {
+    hpc::Arena arena(1024);
+
+    auto* a = arena.allocate<float>(3);
+    auto* b = arena.allocate<double>(5);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(a) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(b) % 64, 0u);
+    EXPECT_NE(static_cast<void*>(a), static_cast<void*>(b));
+
+    const auto m = arena.mark();
+    auto* c = arena.allocate<char>(100);
+    arena.release(m);
+    EXPECT_EQ(arena.allocate<char>(100), c); // same slot reused after release
+
+    // Overflow chains a block; a second pass with the same footprint reuses it.
+    arena.release(m);
+    auto* big = arena.allocate<char>(10000);
+    const std::size_t cap = arena.capacity();
+    arena.release(m);
+    EXPECT_EQ(arena.allocate<char>(10000), big);
+    EXPECT_EQ(arena.capacity(), cap);
+
+    arena.reset();
+    EXPECT_EQ(arena.used(), 0u);
+}
+
+TEST(Memory, AlignedBufferFirstTouchZeroes) {
+    hpc::BufferOptions opt;
+    opt.first_touch_threads = 3;
+
+    hpc::AlignedBuffer<double> buf(10007, opt);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buf.data()) % 64, 0u);
+    for (double v : buf) EXPECT_EQ(v, 0.0);
+
+    auto r = hpc::make_random_aligned<float>(100, 42);
+    EXPECT_EQ(std::vector<float>(r.begin(), r.end()), hpc::make_random<float>(100, 42));
+}
+
+TEST(OutOfCore, StreamedGemmAndScanMatchInMemory) {
+    const std::string path = ::testing::TempDir() + "hpc_ooc_test.bin";
+    const std::string out_path = path + ".out";
+    std::remove(path.c_str());
+    std::remove(out_path.c_str());
+    EXPECT_THROW(hpc::File(path, hpc::File::read), std::runtime_error);
+
+    // A (M×K) at a 24-byte offset, then B (K×N).
+    const std::size_t M = 37, N = 29, K = 45, off = 24;
+    const auto A = hpc::make_random<double>(M * K, 100);
+    const auto B = hpc::make_random<double>(K * N, 101);
+    std::vector<double> ref;
+    hpc::matmul_naive<double>(M, N, K, A, B, ref);
+    {
+        hpc::File f(path, hpc::File::write);
+        f.write_at(A.data(), A.size() * sizeof(double), off);
+        f.write_at(B.data(), B.size() * sizeof(double), off + A.size() * sizeof(double));
+        EXPECT_EQ(f.size(), off + (M * K + K * N) * sizeof(double));
+    }
+
+    const hpc::File in(path, hpc::File::read);
+    EXPECT_THROW(in.read_at(nullptr, 8, in.size()), std::runtime_error);
+    // Panels of 8 A rows / 12 B rows, and one panel holding all of B.
+    for (std::size_t panel : {std::size_t(8 * K * sizeof(double)), std::size_t(1) << 20}) {
+        hpc::File out(out_path, hpc::File::read_write);
+        hpc::StreamOptions opt;
+        opt.panel_bytes = panel;
+        opt.nthreads = 2;
+        const hpc::StreamStats st = hpc::matmul_stream<double>(M, N, K, in, off, in, off + M * K * sizeof(double),
+                                                               out, 0, opt);
+        std::vector<double> C(M * N);
+        out.read_at(C.data(), C.size() * sizeof(double), 0);
+        for (std::size_t i = 0; i < C.size(); ++i) ASSERT_NEAR(C[i], ref[i], 1e-12);
+        EXPECT_EQ(st.bytes_written, M * N * sizeof(double));
+        EXPECT_GE(st.bytes_read, (M * K + K * N) * sizeof(double));
+        EXPECT_GE(st.overlap(), 0.0);
+        EXPECT_LE(st.overlap(), 1.0);
+    }
+
+    // In-place scan across chunk boundaries; integers are exact.
+    const std::size_t n = 100003;
+    std::vector<std::int64_t> x(n);
+    for (std::size_t i = 0; i < n; ++i) x[i] = std::int64_t(i % 17) - 8;
+    {
+        hpc::File f(out_path, hpc::File::read_write);
+        f.write_at(x.data(), n * sizeof(std::int64_t), 0);
+        hpc::StreamOptions opt;
+        opt.panel_bytes = 4096;
+        hpc::inclusive_scan_stream<std::int64_t>(f, 0, f, 0, n, opt);
+        std::vector<std::int64_t> y(n);
+        f.read_at(y.data(), n * sizeof(std::int64_t), 0);
+        hpc::inclusive_scan_inplace(x, 1);
+        EXPECT_EQ(y, x);
+    }
+    std::remove(path.c_str());
+    std::remove(out_path.c_str());
+}
+
+TEST(Rand, PhiloxCounterStream) {
+    // Known-answer vectors of the Random123 reference implementation.
+    std::uint32_t c[4] = {0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u};
+    hpc::detail::philox4x32(c, 0xa4093822u, 0x299f31d0u);
+    EXPECT_EQ(c[0], 0xd16cfe09u);
+    EXPECT_EQ(c[1], 0x94fdccebu);
+    EXPECT_EQ(c[2], 0x5001e420u);
+    EXPECT_EQ(c[3], 0x24126ea1u);
+
+    const std::size_t n = 100003;
+    const auto ref = hpc::make_random<float>(n, 7);
+    for (float v : ref) ASSERT_TRUE(v >= -1.0f && v < 1.0f);
+
+    // Any thread count, any ISA, any offset: the same values.
+    for (std::size_t t : {2u, 3u, 8u}) {
+        hpc::AlignedBuffer<float> buf(n);
+        hpc::fill_random(buf.data(), n, 7, t);
+        EXPECT_EQ(std::vector<float>(buf.begin(), buf.end()), ref);
+    }
+    for_each_usable_isa([&](hpc::Isa) {
+        std::vector<float> part(777);
+        hpc::fill_random_range(part.data(), 12345, part.size(), 7);
+        EXPECT_TRUE(std::equal(part.begin(), part.end(), ref.begin() + 12345));
+        const auto shorter = hpc::make_random<double>(1001, 8);
+        const auto longer = hpc::make_random<double>(2001, 8);
+        EXPECT_TRUE(std::equal(shorter.begin(), shorter.end(), longer.begin()));
+    });
+
+    EXPECT_NE(hpc::make_random<float>(16, 7), hpc::make_random<float>(16, 8));
+}
+
+TEST(Topology, BindOrders) {
+    std::vector<int> ids;
+    EXPECT_TRUE(hpc::parse_cpu_list("0-3,8,10-11", ids));
+    EXPECT_EQ(ids, (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_FALSE(hpc::parse_cpu_list("3-1", ids));
+    EXPECT_FALSE(hpc::parse_cpu_list("a", ids));
+
+    // Two sockets = two nodes, two cores each, SMT2; siblings numbered last.
+    hpc::Topology t;
+    t.cpus = {{0, 0, 0, 0}, {1, 1, 0, 0}, {2, 0, 1, 1}, {3, 1, 1, 1},
+              {4, 0, 0, 0}, {5, 1, 0, 0}, {6, 0, 1, 1}, {7, 1, 1, 1}};
+    t.nodes = 2;
+    t.packages = 2;
+    EXPECT_EQ(t.cores(), 4u);
+    EXPECT_EQ(hpc::bind_cpus(t, hpc::BindPolicy::compact), (std::vector<int>{0, 4, 1, 5, 2, 6, 3, 7}));
+    EXPECT_EQ(hpc::bind_cpus(t, hpc::BindPolicy::scatter), (std::vector<int>{0, 2, 1, 3, 4, 6, 5, 7}));
+    EXPECT_TRUE(hpc::bind_cpus(t, hpc::BindPolicy::none).empty());
+
+    std::vector<int> cpus;
+    EXPECT_TRUE(hpc::parse_bind("node:1", t, cpus));
+    EXPECT_EQ(cpus, (std::vector<int>{2, 6, 3, 7}));
+    EXPECT_TRUE(hpc::parse_bind("7,0", t, cpus));
+    EXPECT_EQ(cpus, (std::vector<int>{7, 0}));
+    EXPECT_FALSE(hpc::parse_bind("9", t, cpus));
+    EXPECT_FALSE(hpc::parse_bind("node:2", t, cpus));
+}
+
+TEST(Topology, PinnedPoolAndPlacement) {
+    const hpc::Topology& t = hpc::topology();
+    ASSERT_FALSE(t.cpus.empty());
+    EXPECT_GE(t.nodes, 1);
+
+#if defined(__linux__)
+    const int cpu = t.cpus.back().id;
+    hpc::ThreadPool pool(2);
+    pool.set_affinity({cpu});
+    std::vector<int> ran(2, -1);
+    pool.run(2, [&](const hpc::ThreadContext& ctx) { ran[ctx.tid] = hpc::current_cpu(); });
+    EXPECT_EQ(ran, (std::vector<int>{cpu, cpu}));
+
+    hpc::BufferOptions opt;
+    opt.numa = hpc::NumaPolicy::bind;
+    opt.numa_node = t.cpus.back().node;
+    opt.first_touch_threads = 2;
+    hpc::AlignedBuffer<double> buf(100000, opt);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buf.data()) % hpc::detail::page_bytes(), 0u);
+    EXPECT_TRUE(hpc::detail::apply_numa(buf.data(), 100000 * sizeof(double), opt));
+    for (std::size_t i = 0; i < buf.size(); i += 4099) EXPECT_EQ(buf[i], 0.0);
+
+    // Restore the process-wide mask for the tests that follow.
+    cpu_set_t all;
+    CPU_ZERO(&all);
+    for (const hpc::Cpu& c : t.cpus) CPU_SET(c.id, &all);
+    ::sched_setaffinity(0, sizeof(all), &all);
+#endif
+
+    // First-touch shares are whole grains: reduction chunks here.
+    hpc::BufferOptions o;
+    o.touch_grain = sizeof(float) * hpc::reduction_chunk;
+    const auto r = hpc::detail::touch_range(o, 5 * hpc::reduction_chunk + 7, sizeof(float), 2, 0);
+    EXPECT_EQ(r.first, 0u);
+    EXPECT_EQ(r.second, 3 * hpc::reduction_chunk);
+}
+
+TEST(Dispatch, EveryUsableIsaMatchesReference) {
+    using T = double;
+    const std::size_t M = 23, N = 41, K = 300;
+    auto A = hpc::make_random<T>(M * K, 60);
+    auto B = hpc::make_random<T>(K * N, 61);
+    std::vector<T> ref;
+    hpc::matmul_naive<T>(M, N, K, A, B, ref);
+
+    auto x = hpc::make_random<T>(100003, 62);
+    long double exact = 0.0L;
+    for (T v : x) exact += v;
+    std::vector<T> scan_ref, y(x.size());
+    hpc::inclusive_scan<T>(x, scan_ref);
+
+    const hpc::Isa saved = hpc::active_isa();
+    EXPECT_TRUE(hpc::isa_usable(saved));
+    EXPECT_TRUE(hpc::isa_usable(hpc::Isa::scalar));
+
+    for_each_usable_isa([&](hpc::Isa isa) {
+        EXPECT_EQ(hpc::active_isa(), isa);
+
+        std::vector<T> C;
+        hpc::matmul_packed<T>(M, N, K, A, B, C, hpc::GemmBlocking{48, 128, 64});
+        for (std::size_t i = 0; i < C.size(); ++i) ASSERT_NEAR(C[i], ref[i], 1e-11);
+
+        EXPECT_NEAR(hpc::kahan_sum_simd<T>(x), (double)exact, 1e-12);
+
+        hpc::inclusive_scan_lookback<T>(x.data(), y.data(), x.size(), 3, 1000);
+        for (std::size_t i = 0; i < y.size(); i += 997) EXPECT_NEAR(y[i], scan_ref[i], 1e-9);
+    });
+    EXPECT_EQ(hpc::active_isa(), saved);
+}
+
+TEST(Tune, FileRoundTripDrivesDefaultBlocking) {
+    EXPECT_EQ(hpc::shape_class(64, 64, 64), hpc::ShapeClass::small);
+    EXPECT_EQ(hpc::shape_class(2048, 2048, 64), hpc::ShapeClass::skinny);
+    EXPECT_EQ(hpc::shape_class(512, 512, 512), hpc::ShapeClass::medium);
+    EXPECT_EQ(hpc::shape_class(2048, 2048, 2048), hpc::ShapeClass::large);
+
+    const std::string path = ::testing::TempDir() + "hpc_tune_test.csv";
+    std::vector<hpc::TuneRecord> recs;
+    hpc::tune_upsert(recs, {"other cpu", "avx2", "double", "medium", {12, 34, 56, 78}});
+    hpc::tune_upsert(recs, {hpc::cpu_model(), hpc::isa_name(hpc::active_isa()), "double", "medium", {48, 64, 96, 32}});
+    hpc::tune_upsert(recs, {hpc::cpu_model(), hpc::isa_name(hpc::active_isa()), "double", "medium", {48, 192, 96, 32}});
+    ASSERT_EQ(recs.size(), 2u);
+    hpc::write_tune_file(path, recs);
+    ASSERT_EQ(hpc::read_tune_file(path).size(), 2u);
+
+    hpc::tuning().load(path);
+    const hpc::GemmBlocking b = hpc::resolve_blocking<double>({}, 300, 300, 300);
+    EXPECT_EQ(b.MC, 48u);
+    EXPECT_EQ(b.KC, 192u);
+    EXPECT_EQ(b.NC, 96u);
+    EXPECT_EQ(hpc::resolve_blocking<double>({0, 100, 0}, 300, 300, 300).KC, 100u);
+    EXPECT_EQ(hpc::resolve_blocking<float>({}, 300, 300, 300).KC, hpc::default_blocking<float>().KC);
+
+    // Tuned blocking is picked up by the default arguments.
+    const std::size_t n = 300;
+    auto A = hpc::make_random<double>(n * n, 70);
+    auto B = hpc::make_random<double>(n * n, 71);
+    std::vector<double> C, ref;
+    hpc::matmul_packed<double>(n, n, n, A, B, C);
+    hpc::matmul_blocked<double>(n, n, n, A, B, ref);
+    for (std::size_t i = 0; i < C.size(); ++i) ASSERT_NEAR(C[i], ref[i], 1e-10);
+
+    hpc::tuning().load(path + ".missing"); // back to built-in defaults
+    EXPECT_EQ(hpc::resolve_blocking<double>({}, 300, 300, 300).KC, hpc::default_blocking<double>().KC);
+}
+
+TEST(Perf, CountersDegradeToNaN) {
+    hpc::PerfCounters c;
+    const bool any = c.open();
+    const hpc::PerfSample s0 = c.read();
+
+    volatile double x = 0.0;
+    for (int i = 0; i < 100000; ++i) x = x + 1.0;
+
+    const hpc::PerfSample d = c.read() - s0;
+    if (!any) {
+        EXPECT_TRUE(std::isnan(d.cycles));
+        EXPECT_TRUE(std::isnan(d.intensity()));
+    }
+    if (!std::isnan(d.instructions)) {
+        EXPECT_GT(d.instructions, 0.0);
+    }
+
+    hpc::PerfSample acc = hpc::PerfSample::zero();
+    acc += hpc::PerfSample{10, 20, 4, 2, 256};
+    acc /= 2.0;
+    EXPECT_DOUBLE_EQ(acc.dram_bytes(), 64.0);
+    EXPECT_DOUBLE_EQ(acc.intensity(), 2.0);
+}
+
+TEST(Harness, TimingStatsOrderStatistics) {
+    std::vector<double> t;
+    for (int i = 100; i >= 1; --i) t.push_back(i);
+    const hpc::TimingStats s = hpc::timing_stats(t);
+    EXPECT_DOUBLE_EQ(s.min, 1.0);
+    EXPECT_DOUBLE_EQ(s.median, 50.5);
+    EXPECT_DOUBLE_EQ(s.p95, 95.05);
+    EXPECT_DOUBLE_EQ(s.mean, 50.5);
+    EXPECT_LT(s.ci_lo, s.median);
+    EXPECT_GT(s.ci_hi, s.median);
+    EXPECT_DOUBLE_EQ(s.ci_lo, 41.0);
+    EXPECT_DOUBLE_EQ(s.ci_hi, 61.0);
+}
+
+TEST(Harness, MeasureRepsAndPrepare) {
+    hpc::MeasureOptions o;
+    o.min_reps = 5;
+    o.min_time_s = 0.0;
+    o.max_warmup = 2;
+
+    int prepared = 0, calls = 0;
+    const hpc::Measurement m = hpc::measure(o, [&] { ++prepared; }, [&] { ++calls; });
+    EXPECT_EQ(m.times.size(), 5u);
+    EXPECT_EQ(m.calls_per_rep, 1u);
+    EXPECT_LE(m.warmup.size(), 2u);
+    EXPECT_EQ(prepared, calls);
+    EXPECT_EQ(calls, static_cast<int>(m.warmup.size() + m.times.size()));
+
+    // Sub-microsecond calls are batched into reps of at least min_rep_s.
+    volatile int sink = 0;
+    const hpc::Measurement r = hpc::measure(o, [&] { sink = sink + 1; });
+    EXPECT_GT(r.calls_per_rep, 1u);
+    EXPECT_GE(r.stats.median, 0.0);
+    EXPECT_LE(r.stats.min, r.stats.median);
+    EXPECT_LE(r.stats.median, r.stats.p95);
+}
+
+TEST(Regression, MannWhitneyAndHolm) {
+    // a entirely below b: U = 25, z = 12 / sqrt(25 * 11 / 12), p ~ 0.0061.
+    const std::vector<double> a{1, 2, 3, 4, 5}, b{6, 7, 8, 9, 10};
+    EXPECT_NEAR(hpc::mann_whitney_p_greater(a, b), 0.00609, 1e-4);
+    EXPECT_GT(hpc::mann_whitney_p_greater(b, a), 0.99);
+    EXPECT_DOUBLE_EQ(hpc::mann_whitney_p_greater(a, {}), 1.0);
+    EXPECT_DOUBLE_EQ(hpc::mann_whitney_p_greater({2, 2, 2}, {2, 2}), 1.0);
+
+    // Interleaved samples: no shift in either direction.
+    const std::vector<double> even{0, 2, 4, 6, 8, 10, 12, 14}, odd{1, 3, 5, 7, 9, 11, 13, 15};
+    EXPECT_GT(hpc::mann_whitney_p_greater(even, odd), 0.2);
+    EXPECT_GT(hpc::mann_whitney_p_greater(odd, even), 0.2);
+
+    const std::vector<double> adj = hpc::holm_adjust({0.01, 0.04, 0.03, 0.5});
+    EXPECT_DOUBLE_EQ(adj[0], 0.04); // 4 * 0.01
+    EXPECT_DOUBLE_EQ(adj[2], 0.09); // 3 * 0.03
+    EXPECT_DOUBLE_EQ(adj[1], 0.09); // 2 * 0.04 = 0.08, raised to keep the order
+    EXPECT_DOUBLE_EQ(adj[3], 0.5);
+}
+
+TEST(Regression, VerdictNeedsSignificanceSizeAndMoreThanNoise) {
+    auto rounds = [](double base, double step, std::size_t n) {
+        std::vector<std::vector<double>> r(3);
+        for (std::size_t k = 0; k < r.size(); ++k)
+            for (std::size_t i = 0; i < n; ++i) r[k].push_back(base * (1.0 + step * double(k)) + 1e-3 * double(i));
+        return r;
+    };
+    const hpc::RegressionOptions o;
+
+    // 20% slower in every round, rounds within 1% of each other.
+    const auto c = hpc::compare_timings(rounds(1.0, 0.005, 20), rounds(1.2, 0.005, 20));
+    EXPECT_NEAR(c.ratio, 1.2, 0.01);
+    EXPECT_LT(c.noise, 0.02);
+    EXPECT_EQ(hpc::classify(c, c.p_slower, c.p_faster, o), hpc::Verdict::slower);
+    EXPECT_EQ(hpc::classify(c, 0.5, c.p_faster, o), hpc::Verdict::same);
+
+    // Significant but below min_change.
+    const auto small = hpc::compare_timings(rounds(1.0, 0.0, 20), rounds(1.03, 0.0, 20));
+    EXPECT_LT(small.p_slower, 1e-6);
+    EXPECT_EQ(hpc::classify(small, small.p_slower, small.p_faster, o), hpc::Verdict::same);
+
+    // The same 20% on a host whose rounds drift by 30%: within the noise.
+    const auto noisy = hpc::compare_timings(rounds(1.0, 0.15, 20), rounds(1.2, 0.15, 20));
+    EXPECT_GT(noisy.noise, 0.25);
+    EXPECT_EQ(hpc::classify(noisy, 0.0, 1.0, o), hpc::Verdict::same);
+
+    const auto faster = hpc::compare_timings(rounds(1.2, 0.0, 20), rounds(1.0, 0.0, 20));
+    EXPECT_EQ(hpc::classify(faster, faster.p_slower, faster.p_faster, o), hpc::Verdict::faster);
+}
+
+TEST(Results, SinkFormats) {
+    using T = hpc::ColumnType;
+    const hpc::Schema s{{"n", T::integer}, {"x", T::real, "%.2f"}, {"name", T::text}};
+    const std::string dir = ::testing::TempDir();
+    auto slurp = [](const std::string& path) {
+        std::ifstream f(path, std::ios::binary);
+        std::stringstream ss;
+        ss << f.rdbuf();
+        return ss.str();
+    };
+
+    hpc::Row r(s);
+    r.set("n", 3).set("x", 0.5).set("name", "a,b");
+    hpc::Row nul(s);
+    nul.set("n", 4).set("x", std::nan(""));
+    EXPECT_THROW(r.set("n", 1.5), std::invalid_argument);
+    EXPECT_THROW(r.set("name", 2), std::invalid_argument);
+    EXPECT_THROW(r.set("missing", 2), std::out_of_range);
+
+    const std::string csv = dir + "hpc_results_test.csv";
+    std::remove(csv.c_str());
+    for (int run = 0; run < 2; ++run) {
+        hpc::ResultSink sink(csv, s, hpc::ResultFormat::csv);
+        sink.write(r);
+        sink.write(nul);
+    }
+    EXPECT_EQ(slurp(csv), "n,x,name\n3,0.50,\"a,b\"\n4,,\n3,0.50,\"a,b\"\n4,,\n");
+    const hpc::Schema other{{"n", T::integer}};
+    EXPECT_THROW(hpc::ResultSink(csv, other, hpc::ResultFormat::csv), std::runtime_error);
+
+    const std::string jsonl = dir + "hpc_results_test.jsonl";
+    std::remove(jsonl.c_str());
+    {
+        hpc::ResultSink sink(jsonl, s, hpc::result_format_for(jsonl));
+        sink.write(r);
+        sink.write(nul);
+    }
+    EXPECT_EQ(slurp(jsonl), "{\"n\":3,\"x\":0.50,\"name\":\"a,b\"}\n"
+                            "{\"n\":4,\"x\":null,\"name\":null}\n");
+
+    const std::string bin = dir + "hpc_results_test.hpcr";
+    std::remove(bin.c_str());
+    {
+        hpc::ResultSink sink(bin, s, hpc::result_format_for(bin));
+        sink.write(r);
+    }
+    const std::string b = slurp(bin);
+    ASSERT_EQ(b.compare(0, 8, "HPCRES1\n"), 0);
+    // 'S' + count + 3 x (type, length, name), then 'R' + i64 + f64 + text.
+    const std::size_t schema_bytes = 1 + 4 + (5 + 1) + (5 + 1) + (5 + 4);
+    ASSERT_EQ(b.size(), 8 + schema_bytes + 1 + 9 + 9 + 8);
+    const char* row = b.data() + 8 + schema_bytes;
+    EXPECT_EQ(row[0], 'R');
+    std::int64_t n = 0;
+    double x = 0.0;
+    std::memcpy(&n, row + 2, 8);
+    std::memcpy(&x, row + 11, 8);
+    EXPECT_EQ(n, 3);
+    EXPECT_EQ(x, 0.5);
+    EXPECT_EQ(std::string(row + 24, 3), "a,b");
+
+    std::remove(csv.c_str());
+    std::remove(jsonl.c_str());
+    std::remove(bin.c_str());
+}
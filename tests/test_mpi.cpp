@@ -0,0 +1,140 @@
+// Distributed kernels (hpc/mpi.hpp); ctest runs this under mpiexec with
+// HPC_MPI_TEST_RANKS ranks. Every rank builds the same global operands and
+// checks its own part against the single-node kernels.
+#include <gtest/gtest.h>
+#include <mpi.h>
+#include <vector>
+#include <numeric>
+#include <cmath>
+#include <cstdint>
+
+#include "hpc/mpi.hpp"
+#include "hpc/matmul_packed.hpp"
+#include "hpc/reduction.hpp"
+#include "hpc/rand.hpp"
+
+static int world_rank() {
+    int r = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &r);
+    return r;
+}
+
+static int world_size() {
+    int s = 1;
+    MPI_Comm_size(MPI_COMM_WORLD, &s);
+    return s;
+}
+
+TEST(Mpi, GridCoversEveryRankOnce) {
+    for (int layers : {1, 2}) {
+        if (world_size() % layers) continue;
+        hpc::ProcessGrid g(MPI_COMM_WORLD, layers);
+        EXPECT_EQ(g.pr * g.pc * g.layers, g.size);
+        EXPECT_LE(g.pr, g.pc);
+        EXPECT_EQ(g.rank, (g.layer * g.pr + g.row) * g.pc + g.col);
+
+        int n = 0, rank = -1;
+        MPI_Comm_size(g.row_comm, &n);
+        MPI_Comm_rank(g.row_comm, &rank);
+        EXPECT_EQ(n, g.pc);
+        EXPECT_EQ(rank, g.col);
+        MPI_Comm_size(g.layer_comm, &n);
+        EXPECT_EQ(n, g.layers);
+    }
+    EXPECT_THROW(hpc::ProcessGrid(MPI_COMM_WORLD, world_size() + 1), std::runtime_error);
+}
+
+TEST(Mpi, SummaMatchesSingleNodeGemm) {
+    // Odd sizes and a small panel width: uneven blocks and panels split at block edges.
+    const std::size_t M = 37, N = 29, K = 53;
+    const auto A = hpc::make_random<double>(M * K, 1);
+    const auto B = hpc::make_random<double>(K * N, 2);
+    const auto C0 = hpc::make_random<double>(M * N, 3);
+    const double alpha = 0.5, beta = -2.0;
+
+    std::vector<double> ref = C0;
+    hpc::gemm<double>(hpc::Trans::none, hpc::Trans::none, alpha,
+                      hpc::row_major_view<const double>(A.data(), M, K),
+                      hpc::row_major_view<const double>(B.data(), K, N), beta,
+                      hpc::row_major_view<double>(ref.data(), M, N));
+
+    for (int layers : {1, 2}) {
+        if (world_size() % layers) continue;
+        for (std::size_t kb : {std::size_t(8), std::size_t(256)}) {
+            hpc::ProcessGrid g(MPI_COMM_WORLD, layers);
+            const hpc::SummaBlocks b = hpc::summa_blocks(g, M, N, K);
+            const std::size_t m = b.rows.second - b.rows.first, n = b.cols.second - b.cols.first;
+            const std::size_t ka = b.a_cols.second - b.a_cols.first, kr = b.b_rows.second - b.b_rows.first;
+            const std::size_t ldc = n + 3; // padded C exercises ldc
+
+            std::vector<double> a(m * ka), bl(kr * n), c(m * ldc, -7.0);
+            for (std::size_t i = 0; i < m; ++i)
+                for (std::size_t k = 0; k < ka; ++k) a[i * ka + k] = A[(b.rows.first + i) * K + b.a_cols.first + k];
+            for (std::size_t k = 0; k < kr; ++k)
+                for (std::size_t j = 0; j < n; ++j) bl[k * n + j] = B[(b.b_rows.first + k) * N + b.cols.first + j];
+            for (std::size_t i = 0; i < m; ++i)
+                for (std::size_t j = 0; j < n; ++j) c[i * ldc + j] = C0[(b.rows.first + i) * N + b.cols.first + j];
+
+            const hpc::MpiTimes t = hpc::summa_gemm<double>(g, M, N, K, alpha, a.data(), ka, bl.data(), n,
+                                                            beta, c.data(), ldc, 2, kb);
+            EXPECT_GE(t.compute, 0.0);
+            EXPECT_GE(t.comm, 0.0);
+            for (std::size_t i = 0; i < m; ++i) {
+                for (std::size_t j = 0; j < n; ++j)
+                    EXPECT_NEAR(c[i * ldc + j], ref[(b.rows.first + i) * N + b.cols.first + j], 1e-12)
+                        << "layers " << layers << " kb " << kb << " at " << b.rows.first + i << "," << b.cols.first + j;
+                for (std::size_t j = n; j < ldc; ++j) EXPECT_EQ(c[i * ldc + j], -7.0);
+            }
+        }
+    }
+}
+
+TEST(Mpi, KahanAllreduceIsAccurateAndSameOnEveryRank) {
+    // 1 + many tiny terms: a plain float sum drops every one of them.
+    const std::size_t n = 200000;
+    std::vector<float> x(n, 1e-8f);
+    x[0] = 1.0f;
+    const auto r = hpc::split_range(n, std::size_t(world_size()), std::size_t(world_rank()));
+
+    const float s = hpc::kahan_allreduce(x.data() + r.first, r.second - r.first, MPI_COMM_WORLD, 2, nullptr, 4096);
+    const double exact = 1.0 + double(n - 1) * double(1e-8f);
+    EXPECT_NEAR(s, exact, 1e-6);
+
+    float lo = s, hi = s;
+    MPI_Allreduce(MPI_IN_PLACE, &lo, 1, MPI_FLOAT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, &hi, 1, MPI_FLOAT, MPI_MAX, MPI_COMM_WORLD);
+    EXPECT_EQ(lo, hi);
+}
+
+TEST(Mpi, DistributedScanMatchesGlobalScan) {
+    const std::size_t n = 100003;
+    std::vector<std::int64_t> x(n);
+    for (std::size_t i = 0; i < n; ++i) x[i] = std::int64_t(i % 97) - 40;
+    std::vector<std::int64_t> ref(n);
+    std::partial_sum(x.begin(), x.end(), ref.begin());
+
+    const auto r = hpc::split_range(n, std::size_t(world_size()), std::size_t(world_rank()));
+    const std::size_t len = r.second - r.first;
+    for (std::size_t threads : {std::size_t(1), std::size_t(3)}) {
+        std::vector<std::int64_t> out(len);
+        hpc::MpiTimes t;
+        hpc::distributed_inclusive_scan(x.data() + r.first, out.data(), len, MPI_COMM_WORLD, threads, &t);
+        for (std::size_t i = 0; i < len; ++i) ASSERT_EQ(out[i], ref[r.first + i]) << "threads " << threads;
+        EXPECT_EQ(t.bytes, 2 * sizeof(std::int64_t));
+    }
+}
+
+// Every rank runs the tests; only rank 0 prints, and the exit code is the
+// worst of all ranks'.
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+    ::testing::InitGoogleTest(&argc, argv);
+    if (world_rank() != 0) {
+        auto& listeners = ::testing::UnitTest::GetInstance()->listeners();
+        delete listeners.Release(listeners.default_result_printer());
+    }
+    int rc = RUN_ALL_TESTS();
+    MPI_Allreduce(MPI_IN_PLACE, &rc, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Finalize();
+    return rc;
+}